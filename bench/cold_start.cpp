@@ -0,0 +1,384 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/constants.hpp"
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/common/tilize_untilize.hpp"
+#include "tt_metal/detail/tt_metal.hpp"
+#include "tt_metal/programming_examples/matmul_common/bmm_op.hpp"
+#include "tt_metal/impl/device/device.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../common/matmul_bench.hpp"
+#include "../common/matmul_variants.hpp"
+
+using namespace tt::constants;
+using namespace tt;
+using namespace tt::tt_metal;
+using std::string;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// Cold-start latency of one matmul variant: what a freshly started process
+// pays before its first result, phase by phase.
+//
+//   process start     exec, dynamic loading and static init up to main()
+//   inputs            random operands and tilize, host only
+//   device open       CreateDevice, firmware build and load included
+//   program           make_bench_runner: buffers, CBs, kernels, runtime args
+//   compile           detail::CompileProgram, the kernel JIT
+//   upload            EnqueueWriteBuffer of both operands
+//   first dispatch    first EnqueueProgram, until it returns
+//   first completion  Finish after it
+//   binary load       first dispatch + completion minus the second run: the
+//                     kernel binaries go to the cores with the first launch,
+//                     the host cannot time them on their own
+//   second run        EnqueueProgram + Finish again, the steady state
+//   teardown          CloseDevice
+//   process exit      end of main() until the parent reaps the process
+//
+// Every trial is a child process of this one (same binary, --child), so no
+// in-process cache survives from one trial to the next. Cache states:
+//   cold-disk     persistent kernel cache off, firmware and kernels are built
+//   warm-disk     persistent kernel cache on, the binaries are on disk from a
+//                 priming process that is not reported
+//   warm-process  warm-disk, then a second open / build / run / close cycle in
+//                 the same process, the one reported (no process start / exit)
+// The page cache of the libraries and of the JIT toolchain is warm in all of
+// them.
+//
+// Usage example:
+//   ./metal-matmul-cold-start
+//     --variant <default: multi_core_reuse_mcast>
+//     --m <size in elements> --n <size in elements> --k <size in elements>
+//     --trials <processes per cache state, default: 5>
+//     --caches <comma separated, default: cold-disk,warm-disk,warm-process>
+//     --csv <path> (default: matmul_cold_start.csv, one row per trial)
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+enum Phase {
+    ProcessStart,
+    Inputs,
+    DeviceOpen,
+    ProgramConstruction,
+    Compile,
+    Upload,
+    FirstDispatch,
+    FirstCompletion,
+    BinaryLoad,
+    SecondRun,
+    Teardown,
+    ProcessExit,
+    Total,
+    NumPhases
+};
+
+const char* PHASE_NAMES[NumPhases] = {
+    "process_start",
+    "inputs",
+    "device_open",
+    "program",
+    "compile",
+    "upload",
+    "first_dispatch",
+    "first_completion",
+    "binary_load",
+    "second_run",
+    "teardown",
+    "process_exit",
+    "total"};
+
+const vector<string> CACHE_STATES = {"cold-disk", "warm-disk", "warm-process"};
+
+// steady_clock is CLOCK_MONOTONIC, the same clock in the parent and in its children
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/*
+ * One open / build / run / close cycle, every phase but the process ones
+ */
+vector<double> run_cycle(matmul_bench::MakeRunner make_runner, uint32_t M, uint32_t N, uint32_t K) {
+    vector<double> phases_us(NumPhases, 0);
+
+    matmul_bench::MatmulInputs inputs{.M = M, .N = N, .K = K};
+    phases_us[Inputs] = matmul_bench::time_us([&] {
+        constexpr uint32_t single_tile_size = 2 * 1024;
+        inputs.a = create_random_vector_of_bfloat16_native(single_tile_size * M / 32 * K / 32, 1, 123, -0.5);
+        inputs.b = create_random_vector_of_bfloat16_native(single_tile_size * K / 32 * N / 32, 1, 12522, -0.5);
+        tilize(inputs.a, M, K);
+        tilize(inputs.b, K, N);
+    });
+
+    constexpr int device_id = 0;
+    Device* device = nullptr;
+    phases_us[DeviceOpen] = matmul_bench::time_us([&] { device = CreateDevice(device_id); });
+    {
+        // The runner owns the buffers, they go before the device
+        CommandQueue& cq = device->command_queue();
+        matmul_bench::MatmulRunner runner;
+        phases_us[ProgramConstruction] = matmul_bench::time_us([&] { runner = make_runner(device, inputs); });
+        phases_us[Compile] = matmul_bench::time_us(runner.compile);
+        phases_us[Upload] = matmul_bench::time_us([&] {
+            runner.write_in0();
+            runner.write_in1();
+        });
+        phases_us[FirstDispatch] = matmul_bench::time_us(runner.enqueue);
+        phases_us[FirstCompletion] = matmul_bench::time_us([&] { Finish(cq); });
+        phases_us[SecondRun] = matmul_bench::time_us([&] {
+            runner.enqueue();
+            Finish(cq);
+        });
+        phases_us[BinaryLoad] =
+            std::max(0.0, phases_us[FirstDispatch] + phases_us[FirstCompletion] - phases_us[SecondRun]);
+    }
+    phases_us[Teardown] = matmul_bench::time_us([&] { TT_FATAL(CloseDevice(device), "CloseDevice failed"); });
+    return phases_us;
+}
+
+/*
+ * Child side of a trial: the phases go to result_fd as "<main entry ns> <end ns> <phase us>..."
+ */
+int run_child(
+    const string& cache,
+    matmul_bench::MakeRunner make_runner,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    int result_fd,
+    int64_t main_entry_ns) {
+    if (cache == "cold-disk") {
+        detail::DisablePersistentKernelCache();
+    } else {
+        detail::EnablePersistentKernelCache();
+    }
+    vector<double> phases_us = run_cycle(make_runner, M, N, K);
+    if (cache == "warm-process") {
+        phases_us = run_cycle(make_runner, M, N, K);
+    }
+
+    std::ostringstream line;
+    line << main_entry_ns << " " << now_ns();
+    for (double phase_us : phases_us) {
+        line << " " << phase_us;
+    }
+    line << "\n";
+    string result = line.str();
+    return write(result_fd, result.data(), result.size()) == ssize_t(result.size()) ? 0 : 1;
+}
+
+/*
+ * Parent side: runs this binary with --child and adds the process phases it measures from here
+ */
+bool run_trial(const vector<string>& child_args, const string& cache, vector<double>& phases_us) {
+    int fds[2];
+    TT_FATAL(pipe(fds) == 0, "pipe failed");
+
+    int64_t spawn_ns = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        vector<string> args = {"/proc/self/exe", "--child", cache, "--result-fd", std::to_string(fds[1])};
+        args.insert(args.end(), child_args.begin(), child_args.end());
+        vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(fds[1]);
+    TT_FATAL(pid > 0, "fork failed");
+
+    string result;
+    char buffer[512];
+    ssize_t num_read;
+    while ((num_read = read(fds[0], buffer, sizeof(buffer))) > 0) {
+        result.append(buffer, num_read);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    int64_t exit_ns = now_ns();
+    if (not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+        log_error(tt::LogTest, "{} trial exited with status {}", cache, status);
+        return false;
+    }
+
+    std::istringstream line(result);
+    int64_t main_entry_ns = 0, end_ns = 0;
+    phases_us.assign(NumPhases, 0);
+    line >> main_entry_ns >> end_ns;
+    for (auto& phase_us : phases_us) {
+        line >> phase_us;
+    }
+    if (not line) {
+        log_error(tt::LogTest, "{} trial returned no phases", cache);
+        return false;
+    }
+
+    if (cache == "warm-process") {
+        // Already running: only the cycle counts
+        phases_us[Total] = 0;
+        for (uint32_t phase = Inputs; phase <= Teardown; phase++) {
+            if (phase != BinaryLoad) {
+                phases_us[Total] += phases_us[phase];
+            }
+        }
+    } else {
+        phases_us[ProcessStart] = (main_entry_ns - spawn_ns) / 1e3;
+        phases_us[ProcessExit] = (exit_ns - end_ns) / 1e3;
+        phases_us[Total] = (exit_ns - spawn_ns) / 1e3;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int64_t main_entry_ns = now_ns();
+    bool pass = true;
+
+    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
+        TT_THROW("Test not supported w/ slow dispatch, exiting");
+    }
+
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+
+    try {
+        string variant_name = get_option("--variant", "multi_core_reuse_mcast");
+        uint32_t M = std::stoul(get_option("--m", "1024"));
+        uint32_t N = std::stoul(get_option("--n", "1024"));
+        uint32_t K = std::stoul(get_option("--k", "1024"));
+        TT_FATAL(M % TILE_HEIGHT == 0 and N % TILE_WIDTH == 0 and K % TILE_WIDTH == 0, "M, N, K must be whole tiles");
+
+        const auto& all_variants = matmul_bench::all_variants();
+        auto variant = std::find_if(all_variants.begin(), all_variants.end(), [&variant_name](const auto& v) {
+            return v.first == variant_name;
+        });
+        TT_FATAL(variant != all_variants.end(), "Unknown variant {}", variant_name);
+
+        string child_cache = get_option("--child", "");
+        if (not child_cache.empty()) {
+            int result_fd = std::stoi(get_option("--result-fd", "1"));
+            return run_child(child_cache, variant->second, M, N, K, result_fd, main_entry_ns);
+        }
+
+        uint32_t trials = std::stoul(get_option("--trials", "5"));
+        string csv_path = get_option("--csv", "matmul_cold_start.csv");
+        vector<string> caches;
+        std::stringstream cache_list(get_option("--caches", ""));
+        string cache_name;
+        while (std::getline(cache_list, cache_name, ',')) {
+            TT_FATAL(
+                std::find(CACHE_STATES.begin(), CACHE_STATES.end(), cache_name) != CACHE_STATES.end(),
+                "Unknown cache state {}",
+                cache_name);
+            caches.push_back(cache_name);
+        }
+        if (caches.empty()) {
+            caches = CACHE_STATES;
+        }
+        vector<string> child_args = {
+            "--variant", variant_name, "--m", std::to_string(M), "--n", std::to_string(N), "--k", std::to_string(K)};
+
+        std::ofstream csv;
+        if (not csv_path.empty()) {
+            csv.open(csv_path);
+            csv << "variant,m,n,k,cache,trial";
+            for (const char* name : PHASE_NAMES) {
+                csv << "," << name << "_ms";
+            }
+            csv << "\n";
+        }
+
+        for (const auto& cache : caches) {
+            vector<double> phases_us;
+            if (cache != "cold-disk") {
+                log_info(tt::LogTest, "{}: priming the persistent kernel cache", cache);
+                pass &= run_trial(child_args, "warm-disk", phases_us);
+            }
+
+            vector<vector<double>> samples_us(NumPhases);
+            for (uint32_t trial = 0; trial < trials; trial++) {
+                if (not run_trial(child_args, cache, phases_us)) {
+                    pass = false;
+                    continue;
+                }
+                for (uint32_t phase = 0; phase < NumPhases; phase++) {
+                    samples_us[phase].push_back(phases_us[phase]);
+                }
+                if (csv.is_open()) {
+                    csv << variant_name << "," << M << "," << N << "," << K << "," << cache << "," << trial;
+                    for (double phase_us : phases_us) {
+                        csv << "," << phase_us / 1e3;
+                    }
+                    csv << "\n";
+                }
+            }
+
+            log_info(
+                tt::LogTest,
+                "{} {}x{}x{}, {}: {} of {} trials, median (min - max)",
+                variant_name,
+                M,
+                N,
+                K,
+                cache,
+                samples_us[Total].size(),
+                trials);
+            for (uint32_t phase = 0; phase < NumPhases and not samples_us[Total].empty(); phase++) {
+                auto stats = matmul_bench::compute_stats(samples_us[phase]);
+                log_info(
+                    tt::LogTest,
+                    "  {:<16} {:10.3f} ms ({:.3f} - {:.3f})",
+                    PHASE_NAMES[phase],
+                    stats.median / 1e3,
+                    stats.min / 1e3,
+                    stats.max / 1e3);
+            }
+        }
+
+        if (csv.is_open()) {
+            log_info(tt::LogTest, "Trials written to {}", csv_path);
+        }
+
+    } catch (const std::exception& e) {
+        tt::log_error(tt::LogTest, "Test failed with exception!");
+        tt::log_error(tt::LogTest, "{}", e.what());
+
+        throw;
+    }
+
+    if (pass) {
+        tt::log_info(tt::LogTest, "Test Passed");
+    } else {
+        TT_THROW("Test Failed");
+    }
+
+    TT_ASSERT(pass);
+
+    return 0;
+}
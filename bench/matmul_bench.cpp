@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/constants.hpp"
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/common/tilize_untilize.hpp"
+#include "tt_metal/programming_examples/matmul_common/bmm_op.hpp"
+#include "tt_metal/impl/device/device.hpp"
+#include "tests/tt_metal/tt_metal/perf_microbenchmark/common/util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../common/matmul_validation.hpp"
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+
+using namespace tt::constants;
+using namespace tt;
+using namespace tt::tt_metal;
+using std::string;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// One benchmark harness for the five matmul variants: the same random inputs,
+// warmup and repetitions for each of them, statistics and TFLOPS / utilization
+// written with the host-perf columns of test_mm_op.py.
+//
+// Usage example:
+//   ./metal-matmul-bench
+//     --variants <comma separated, default: all of
+//                 single_core,multi_core,multi_core_reuse,multi_core_reuse_mcast,test_compute_mm,block_sparse>
+//     --m <size in elements> --n <size in elements> --k <size in elements>
+//     --warmup <untimed runs after the first one>
+//     --repetitions <timed runs>
+//     --csv <path> (default: matmul_bench.csv)
+//     --json <path>
+//     --no-validate (skip the sampled PCC of every variant's output)
+// MATMUL_TRACE=<path> also writes a Chrome trace of the host phases.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+string arch_name(tt::ARCH arch) {
+    if (arch == tt::ARCH::WORMHOLE_B0) {
+        return "wormhole_b0";
+    } else if (arch == tt::ARCH::GRAYSKULL) {
+        return "grayskull";
+    } else if (arch == tt::ARCH::BLACKHOLE) {
+        return "blackhole";
+    }
+    return "unknown";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool pass = true;
+
+    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
+        TT_THROW("Test not supported w/ slow dispatch, exiting");
+    }
+
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+    auto has_option = [&args](const string& name) { return std::find(args.begin(), args.end(), name) != args.end(); };
+    string trace_path = timeline::enable_from_env();
+
+    try {
+        uint32_t M = std::stoul(get_option("--m", "1024"));
+        uint32_t N = std::stoul(get_option("--n", "1024"));
+        uint32_t K = std::stoul(get_option("--k", "1024"));
+        uint32_t warmup = std::stoul(get_option("--warmup", "2"));
+        uint32_t repetitions = std::stoul(get_option("--repetitions", "20"));
+        string csv_path = get_option("--csv", "matmul_bench.csv");
+        string json_path = get_option("--json", "");
+        bool validate = not has_option("--no-validate");
+        TT_FATAL(M % TILE_HEIGHT == 0 and N % TILE_WIDTH == 0 and K % TILE_WIDTH == 0, "M, N, K must be whole tiles");
+        TT_FATAL(repetitions > 0, "At least one timed repetition");
+
+        const auto& all_variants = matmul_bench::all_variants();
+        vector<std::pair<string, matmul_bench::MakeRunner>> variants;
+        std::stringstream variant_list(get_option("--variants", ""));
+        string name;
+        while (std::getline(variant_list, name, ',')) {
+            auto it = std::find_if(all_variants.begin(), all_variants.end(), [&name](const auto& variant) {
+                return variant.first == name;
+            });
+            TT_FATAL(it != all_variants.end(), "Unknown variant {}", name);
+            variants.push_back(*it);
+        }
+        if (variants.empty()) {
+            variants = all_variants;
+        }
+
+        /* Silicon accelerator setup */
+        constexpr int device_id = 0;
+        Device* device = CreateDevice(device_id);
+        auto full_grid = device->compute_with_storage_grid_size();
+        double clock_mhz = get_tt_npu_clock(device);
+
+        /* Same inputs for every variant, zero centered so the PCC is not dominated by the mean */
+        constexpr uint32_t single_tile_size = 2 * 1024;
+        matmul_bench::MatmulInputs inputs{.M = M, .N = N, .K = K};
+        vector<bfloat16> a =
+            create_random_vector_of_bfloat16_native(single_tile_size * M / 32 * K / 32, 1, 123, -0.5);
+        vector<bfloat16> b =
+            create_random_vector_of_bfloat16_native(single_tile_size * K / 32 * N / 32, 1, 12522, -0.5);
+        inputs.a = a;
+        inputs.b = b;
+        {
+            TRACE_ZONE("tilize");
+            tilize(inputs.a, M, K);
+            tilize(inputs.b, K, N);
+        }
+
+        vector<matmul_bench::BenchResult> results;
+        for (const auto& [variant_name, make_runner] : variants) {
+            log_info(
+                tt::LogTest, "{}: {}x{}x{}, {} warmup, {} repetitions", variant_name, M, N, K, warmup, repetitions);
+            matmul_bench::MatmulRunner runner = [&] {
+                TRACE_ZONE("plan");
+                return make_runner(device, inputs);
+            }();
+            matmul_bench::BenchCase bench_case = runner.bench_case;
+            bench_case.conf = variant_name;
+            bench_case.arch = arch_name(device->arch());
+            bench_case.M = M;
+            bench_case.N = N;
+            bench_case.K = K;
+            bench_case.full_grid_x = full_grid.x;
+            bench_case.full_grid_y = full_grid.y;
+            bench_case.clock_mhz = clock_mhz;
+
+            double transfer_in0_us = matmul_bench::time_us(runner.write_in0);
+            double transfer_in1_us = matmul_bench::time_us(runner.write_in1);
+            matmul_bench::BenchSamples samples = matmul_bench::time_runs(warmup, repetitions, runner.run);
+            samples.transfer_in0_us = transfer_in0_us;
+            samples.transfer_in1_us = transfer_in1_us;
+            results.push_back(matmul_bench::summarize(bench_case, samples));
+
+            const auto& result = results.back();
+            log_info(
+                tt::LogTest,
+                "{}: first run {:.2f} us, median {:.2f} us, p99 {:.2f} us, stddev {:.2f} us, {:.3f} TFLOPS, "
+                "{:.2f}% of Rpeak ({}x{} grid)",
+                variant_name,
+                result.samples.first_run_us,
+                result.stats.median,
+                result.stats.p99,
+                result.stats.stddev,
+                result.tflops,
+                result.util_user_grid * 100,
+                bench_case.grid_x,
+                bench_case.grid_y);
+
+            if (validate) {
+                vector<bfloat16> output = runner.output();
+                {
+                    TRACE_ZONE("untilize");
+                    untilize(output, M, N);
+                }
+                TRACE_ZONE("validate");
+                double pcc = matmul::sampled_pcc(a, b, output, M, N, K);
+                if (pcc < matmul::VALIDATION_PCC) {
+                    log_error(tt::LogTest, "{}: PCC {:.5f} < {}", variant_name, pcc, matmul::VALIDATION_PCC);
+                    pass = false;
+                } else {
+                    log_info(tt::LogTest, "{}: PCC {:.5f}", variant_name, pcc);
+                }
+            }
+        }
+
+        if (not csv_path.empty()) {
+            std::ofstream csv(csv_path);
+            matmul_bench::write_host_perf_csv(csv, results);
+            log_info(tt::LogTest, "Results written to {}", csv_path);
+        }
+        if (not json_path.empty()) {
+            std::ofstream json(json_path);
+            matmul_bench::write_json(json, results);
+            log_info(tt::LogTest, "Results written to {}", json_path);
+        }
+
+        pass &= CloseDevice(device);
+
+        if (not trace_path.empty() and timeline::write_host_trace(trace_path)) {
+            log_info(tt::LogTest, "Host trace written to {}", trace_path);
+        }
+
+    } catch (const std::exception& e) {
+        tt::log_error(tt::LogTest, "Test failed with exception!");
+        tt::log_error(tt::LogTest, "{}", e.what());
+
+        throw;
+    }
+
+    if (pass) {
+        tt::log_info(tt::LogTest, "Test Passed");
+    } else {
+        TT_THROW("Test Failed");
+    }
+
+    TT_ASSERT(pass);
+
+    return 0;
+}
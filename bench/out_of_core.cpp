@@ -0,0 +1,175 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/constants.hpp"
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/impl/device/device.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/matmul_out_of_core.hpp"
+#include "../common/matmul_validation.hpp"
+#include "../common/trace_zones.hpp"
+
+using namespace tt::constants;
+using namespace tt;
+using namespace tt::tt_metal;
+using std::string;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// Out-of-core matmul (common/matmul_out_of_core.hpp) on row-major bfloat16
+// files: A [M, K], B [K, N] in, C [M, N] out. Input files that don't exist are
+// created with uniform random values, one row at a time, so the shape is only
+// bounded by the disk. The result is checked against an fp32 CPU reference on
+// a random sample of output elements.
+//
+// Usage example:
+//   ./metal-matmul-out-of-core
+//     --m <size in elements> --n <size in elements> --k <size in elements> (default: 16384 each)
+//     --a <path> --b <path> --c <path> (default: ooc_a.bin, ooc_b.bin, ooc_c.bin)
+//     --variant <default: multi_core_reuse_mcast>
+//     --panel-m <elements> --panel-n <elements> --panel-k <elements> (default: planned)
+//     --dram-fraction <of the device DRAM for the panels, default: 0.75>
+//     --samples <output elements checked, default: 256, 0 to skip>
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+void create_random_matrix_file(const string& path, uint32_t rows, uint32_t cols, uint32_t seed) {
+    TRACE_ZONE("create input");
+    log_info(tt::LogTest, "Creating {} ({} x {} bfloat16)", path, rows, cols);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    std::ofstream file(path, std::ios::binary);
+    vector<bfloat16> row(cols);
+    for (uint32_t r = 0; r < rows; r++) {
+        for (auto& value : row) {
+            value = bfloat16(dist(rng));
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(bfloat16));
+    }
+    TT_FATAL(file.good(), "Cannot write {}", path);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool pass = true;
+
+    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
+        TT_THROW("Test not supported w/ slow dispatch, exiting");
+    }
+
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+
+    std::string trace_path = timeline::enable_from_env();
+
+    try {
+        uint32_t M = std::stoul(get_option("--m", "16384"));
+        uint32_t N = std::stoul(get_option("--n", "16384"));
+        uint32_t K = std::stoul(get_option("--k", "16384"));
+        string a_path = get_option("--a", "ooc_a.bin");
+        string b_path = get_option("--b", "ooc_b.bin");
+        string c_path = get_option("--c", "ooc_c.bin");
+        uint32_t samples = std::stoul(get_option("--samples", "256"));
+
+        matmul::OutOfCoreOptions options;
+        options.variant = get_option("--variant", options.variant);
+        options.panel_m = std::stoul(get_option("--panel-m", "0"));
+        options.panel_n = std::stoul(get_option("--panel-n", "0"));
+        options.panel_k = std::stoul(get_option("--panel-k", "0"));
+        options.dram_fraction = std::stod(get_option("--dram-fraction", std::to_string(options.dram_fraction)));
+
+        if (access(a_path.c_str(), F_OK) != 0) {
+            create_random_matrix_file(a_path, M, K, 123);
+        }
+        if (access(b_path.c_str(), F_OK) != 0) {
+            create_random_matrix_file(b_path, K, N, 12522);
+        }
+        matmul::MappedMatrix a = matmul::map_matrix(a_path, M, K, false);
+        matmul::MappedMatrix b = matmul::map_matrix(b_path, K, N, false);
+        matmul::MappedMatrix c = matmul::map_matrix(c_path, M, N, true);
+
+        /* Silicon accelerator setup */
+        constexpr int device_id = 0;
+        Device* device = CreateDevice(device_id);
+        device->enable_program_cache();
+
+        matmul::OutOfCoreStats stats = matmul::matmul_out_of_core(device, a, b, c, options);
+        double num_ops = 2.0 * M * N * K;
+        log_info(
+            tt::LogTest,
+            "{} x {} x {}: {:.1f} ms, {:.3f} TFLOPS, plan {:.1f} ms",
+            M,
+            N,
+            K,
+            stats.total_ms,
+            num_ops / (stats.total_ms / 1000) / 1e12,
+            stats.plan_ms);
+        log_info(
+            tt::LogTest,
+            "  uploads: {} A + {} B panels, {:.2f} GB",
+            stats.a_uploads,
+            stats.b_uploads,
+            stats.upload_bytes / 1e9);
+        log_info(
+            tt::LogTest,
+            "  host blocked on panel reads {:.1f} ms, on the device {:.1f} ms, accumulate {:.1f} ms",
+            stats.prepare_wait_ms,
+            stats.device_wait_ms,
+            stats.accumulate_ms);
+
+        pass &= CloseDevice(device);
+
+        if (samples > 0) {
+            TRACE_ZONE("validate");
+            double pcc = matmul::sampled_pcc(
+                [&a](uint32_t m, uint32_t k) { return a.row(m)[k].to_float(); },
+                [&b](uint32_t k, uint32_t n) { return b.row(k)[n].to_float(); },
+                [&c](uint32_t m, uint32_t n) { return c.row(m)[n].to_float(); },
+                M,
+                N,
+                K,
+                samples);
+            log_info(tt::LogTest, "PCC against CPU reference ({} samples): {}", samples, pcc);
+            pass &= pcc >= matmul::VALIDATION_PCC;
+        }
+
+        if (not trace_path.empty() and timeline::write_host_trace(trace_path)) {
+            log_info(tt::LogTest, "Host trace written to {}", trace_path);
+        }
+
+    } catch (const std::exception& e) {
+        tt::log_error(tt::LogTest, "Test failed with exception!");
+        tt::log_error(tt::LogTest, "{}", e.what());
+
+        throw;
+    }
+
+    if (pass) {
+        tt::log_info(tt::LogTest, "Test Passed");
+    } else {
+        TT_THROW("Test Failed");
+    }
+
+    TT_ASSERT(pass);
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+#include <cstddef>
+#include <ttnn/core.hpp>
+#include <ttnn/operations/eltwise/unary/unary.hpp>
+#include <ttnn/device.hpp>
+#include <ttnn/operations/data_movement/tilize_with_val_padding/tilize_with_val_padding.hpp>
+
+#include "common/bfloat16.hpp"
+
+#include <vector>
+#include <iostream>
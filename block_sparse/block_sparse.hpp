@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Tile sparsity of the in1 (weight) operand of matmul_block_sparse, and the
+// split of its work over the cores.
+//
+// A pruned weight matrix B [K, N] is Kt x Nt tiles of 32 x 32. TileOccupancy
+// keeps which of them hold a non-zero value, as a bitmap (tile (k, n) is bit
+// k * Nt + n) and as CSC over the tile columns: the non-zero tiles of column n
+// are k = row_index[col_ptr[n]] ... row_index[col_ptr[n + 1] - 1], ascending.
+// The device keeps only those tiles, packed in the same order.
+//
+// Output tile (m, n) costs one in0 x in1 tile product per non-zero tile of
+// column n and one tile write. The work is cut into items of one tile column
+// over a range of output rows, and the items go to the cores longest first,
+// each to the least loaded core (LPT). Items are sized so there are about
+// ITEMS_PER_CORE of them per core, enough to even the load out while the
+// runtime args of a core hold at most MAX_ITEMS_PER_CORE items: adjacent
+// ranges of a column on one core are merged, and a core over the cap makes
+// the items coarser.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace block_sparse {
+
+constexpr uint32_t OUTPUT_TILE_COST_STEPS = 1;
+constexpr uint32_t ITEMS_PER_CORE = 4;
+constexpr uint32_t MAX_ITEMS_PER_CORE = 48;
+
+struct TileOccupancy {
+    uint32_t Kt = 0;
+    uint32_t Nt = 0;
+    std::vector<uint64_t> bitmap;      // Kt * Nt bits
+    std::vector<uint32_t> col_ptr;     // Nt + 1
+    std::vector<uint32_t> row_index;   // one per non-zero tile
+
+    bool occupied(uint32_t k, uint32_t n) const {
+        uint64_t bit = uint64_t(k) * Nt + n;
+        return (bitmap[bit / 64] >> (bit % 64)) & 1;
+    }
+    uint32_t nnz() const { return row_index.size(); }
+    uint32_t column_nnz(uint32_t n) const { return col_ptr[n + 1] - col_ptr[n]; }
+    uint32_t max_column_nnz() const {
+        uint32_t max_nnz = 0;
+        for (uint32_t n = 0; n < Nt; n++) {
+            max_nnz = std::max(max_nnz, column_nnz(n));
+        }
+        return max_nnz;
+    }
+    double density() const { return Kt * Nt ? double(nnz()) / (double(Kt) * Nt) : 0; }
+};
+
+// CSC of the tiles for which is_nonzero(k, n) holds
+inline TileOccupancy make_tile_occupancy(
+    uint32_t Kt, uint32_t Nt, const std::function<bool(uint32_t, uint32_t)>& is_nonzero) {
+    TileOccupancy occupancy;
+    occupancy.Kt = Kt;
+    occupancy.Nt = Nt;
+    occupancy.bitmap.assign((uint64_t(Kt) * Nt + 63) / 64, 0);
+    for (uint32_t k = 0; k < Kt; k++) {
+        for (uint32_t n = 0; n < Nt; n++) {
+            if (is_nonzero(k, n)) {
+                uint64_t bit = uint64_t(k) * Nt + n;
+                occupancy.bitmap[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+    occupancy.col_ptr.push_back(0);
+    for (uint32_t n = 0; n < Nt; n++) {
+        for (uint32_t k = 0; k < Kt; k++) {
+            if (occupancy.occupied(k, n)) {
+                occupancy.row_index.push_back(k);
+            }
+        }
+        occupancy.col_ptr.push_back(occupancy.row_index.size());
+    }
+    return occupancy;
+}
+
+inline TileOccupancy dense_tile_occupancy(uint32_t Kt, uint32_t Nt) {
+    return make_tile_occupancy(Kt, Nt, [](uint32_t, uint32_t) { return true; });
+}
+
+// Output tiles (m, n) for m in [m_begin, m_end)
+struct WorkItem {
+    uint32_t n = 0;
+    uint32_t m_begin = 0;
+    uint32_t m_end = 0;
+};
+
+struct CoreSchedule {
+    std::vector<WorkItem> items;
+    uint64_t cost = 0;  // tile steps
+};
+
+struct SparseSchedule {
+    uint32_t grid_cores = 0;
+    uint64_t total_cost = 0;
+    std::vector<CoreSchedule> cores;  // active cores only, most loaded first
+
+    uint64_t makespan() const { return cores.empty() ? 0 : cores.front().cost; }
+    // makespan over the perfectly even split of total_cost, 1 is ideal
+    double imbalance() const {
+        return total_cost ? double(makespan()) * grid_cores / total_cost : 1;
+    }
+};
+
+inline uint64_t item_cost(const TileOccupancy& occupancy, const WorkItem& item) {
+    return uint64_t(item.m_end - item.m_begin) * (occupancy.column_nnz(item.n) + OUTPUT_TILE_COST_STEPS);
+}
+
+// Adjacent row ranges of one tile column on a core become one item, at the same cost
+inline void merge_core_items(std::vector<WorkItem>& items) {
+    std::sort(items.begin(), items.end(), [](const WorkItem& a, const WorkItem& b) {
+        return a.n != b.n ? a.n < b.n : a.m_begin < b.m_begin;
+    });
+    std::vector<WorkItem> merged;
+    for (const auto& item : items) {
+        if (not merged.empty() and merged.back().n == item.n and merged.back().m_end == item.m_begin) {
+            merged.back().m_end = item.m_end;
+        } else {
+            merged.push_back(item);
+        }
+    }
+    items = std::move(merged);
+}
+
+// LPT over the items of row_splits row ranges per tile column
+inline SparseSchedule schedule_row_splits(
+    const TileOccupancy& occupancy, uint32_t Mt, uint32_t grid_cores, uint32_t row_splits) {
+    std::vector<WorkItem> items;
+    for (uint32_t n = 0; n < occupancy.Nt; n++) {
+        for (uint32_t s = 0; s < row_splits; s++) {
+            uint32_t m_begin = uint64_t(Mt) * s / row_splits;
+            uint32_t m_end = uint64_t(Mt) * (s + 1) / row_splits;
+            if (m_end > m_begin) {
+                items.push_back({n, m_begin, m_end});
+            }
+        }
+    }
+    std::stable_sort(items.begin(), items.end(), [&occupancy](const WorkItem& a, const WorkItem& b) {
+        return item_cost(occupancy, a) > item_cost(occupancy, b);
+    });
+
+    SparseSchedule schedule;
+    schedule.grid_cores = grid_cores;
+    std::vector<CoreSchedule> cores(std::min<size_t>(grid_cores, items.size()));
+    // (cost, core) min-heap
+    using Load = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+    for (uint32_t i = 0; i < cores.size(); i++) {
+        loads.push({0, i});
+    }
+    for (const auto& item : items) {
+        auto [cost, core] = loads.top();
+        loads.pop();
+        uint64_t added = item_cost(occupancy, item);
+        cores[core].items.push_back(item);
+        cores[core].cost += added;
+        schedule.total_cost += added;
+        loads.push({cost + added, core});
+    }
+    for (auto& core : cores) {
+        merge_core_items(core.items);
+    }
+    std::stable_sort(cores.begin(), cores.end(), [](const CoreSchedule& a, const CoreSchedule& b) {
+        return a.cost > b.cost;
+    });
+    schedule.cores = std::move(cores);
+    return schedule;
+}
+
+inline size_t max_core_items(const SparseSchedule& schedule) {
+    size_t max_items = 0;
+    for (const auto& core : schedule.cores) {
+        max_items = std::max(max_items, core.items.size());
+    }
+    return max_items;
+}
+
+/*
+ * Row ranges per column so that there are about ITEMS_PER_CORE items per core. A core that still holds more
+ * than MAX_ITEMS_PER_CORE items once its adjacent ranges are merged gets coarser items: the row ranges are
+ * halved until every core fits, one range per column at the coarsest.
+ */
+inline SparseSchedule schedule_block_sparse(const TileOccupancy& occupancy, uint32_t Mt, uint32_t grid_cores) {
+    uint32_t wanted_items = grid_cores * ITEMS_PER_CORE;
+    uint32_t row_splits = std::clamp<uint32_t>((wanted_items + occupancy.Nt - 1) / occupancy.Nt, 1, Mt);
+    SparseSchedule schedule = schedule_row_splits(occupancy, Mt, grid_cores, row_splits);
+    while (row_splits > 1 and max_core_items(schedule) > MAX_ITEMS_PER_CORE) {
+        row_splits /= 2;
+        schedule = schedule_row_splits(occupancy, Mt, grid_cores, row_splits);
+    }
+    return schedule;
+}
+
+}  // namespace block_sparse
@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+
+#include "compute_kernel_api/matmul.h"
+
+// bmm over the work items of reader_bmm_block_sparse: one output tile per row of an item, accumulated over the
+// non-zero tiles of its B column only. Items of an all-zero column are skipped, the writer fills them with zeros.
+namespace NAMESPACE {
+void MAIN {
+    uint32_t num_items = get_arg_val<uint32_t>(0);
+    constexpr uint32_t first_item_arg = 1;  // then rows, nnz per item
+
+    constexpr uint32_t onetile = 1;
+
+    mm_init();
+
+    for (uint32_t item = 0; item < num_items; item++) {
+        uint32_t rows = get_arg_val<uint32_t>(first_item_arg + 2 * item);
+        uint32_t nnz = get_arg_val<uint32_t>(first_item_arg + 2 * item + 1);
+        if (nnz == 0) {
+            continue;
+        }
+
+        for (uint32_t m = 0; m < rows; m++) {
+            tile_regs_acquire();
+            for (uint32_t p = 0; p < nnz; p++) {
+                cb_wait_front(tt::CBIndex::c_0, onetile);
+                cb_wait_front(tt::CBIndex::c_1, onetile);
+
+                matmul_tiles(tt::CBIndex::c_0, tt::CBIndex::c_1, 0, 0, 0, false);
+
+                cb_pop_front(tt::CBIndex::c_0, onetile);
+                cb_pop_front(tt::CBIndex::c_1, onetile);
+            }
+            tile_regs_commit();
+
+            cb_reserve_back(tt::CBIndex::c_16, onetile);
+            tile_regs_wait();
+            pack_tile(0, tt::CBIndex::c_16);
+            tile_regs_release();
+            cb_push_back(tt::CBIndex::c_16, onetile);
+        }
+    }
+}
+}  // namespace NAMESPACE
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// reader_bmm_8bank_output_tiles_partitioned over the non-zero tiles of B only. B holds its non-zero tiles packed
+// column after column (CSC), page n of the index buffer is {first packed tile of column n, number of them, their
+// k ...}. Each work item is the output tiles (m, n) for m in [m_begin, m_end): per output tile, the A tiles (m, k)
+// and the B tiles of column n are read in pairs for every non-zero k, nothing for an all-zero column.
+void kernel_main() {
+    uint32_t src0_addr = get_arg_val<uint32_t>(0);
+    uint32_t src1_addr = get_arg_val<uint32_t>(1);
+    uint32_t index_addr = get_arg_val<uint32_t>(2);
+    uint32_t index_page_bytes = get_arg_val<uint32_t>(3);
+    uint32_t Kt = get_arg_val<uint32_t>(4);
+    uint32_t num_items = get_arg_val<uint32_t>(5);
+    constexpr uint32_t first_item_arg = 6;  // then n, m_begin, m_end per item
+
+    constexpr bool src0_is_dram = get_compile_time_arg_val(0) == 1;
+    constexpr bool src1_is_dram = get_compile_time_arg_val(1) == 1;
+
+    constexpr uint32_t cb_id_in0 = 0;
+    constexpr uint32_t cb_id_in1 = 1;
+    constexpr uint32_t cb_id_index = 2;
+    constexpr uint32_t onetile = 1;
+
+    const uint32_t in0_tile_bytes = get_tile_size(cb_id_in0);
+    const DataFormat in0_data_format = get_dataformat(cb_id_in0);
+    const uint32_t in1_tile_bytes = get_tile_size(cb_id_in1);
+    const DataFormat in1_data_format = get_dataformat(cb_id_in1);
+
+    const InterleavedAddrGenFast<src0_is_dram> s0 = {
+        .bank_base_address = src0_addr, .page_size = in0_tile_bytes, .data_format = in0_data_format};
+    const InterleavedAddrGenFast<src1_is_dram> s1 = {
+        .bank_base_address = src1_addr, .page_size = in1_tile_bytes, .data_format = in1_data_format};
+    const InterleavedAddrGen<true> s_index = {.bank_base_address = index_addr, .page_size = index_page_bytes};
+
+    // Scratch for the index page of the current column, never pushed
+    cb_reserve_back(cb_id_index, onetile);
+    uint32_t l1_index_addr = get_write_ptr(cb_id_index);
+    volatile tt_l1_ptr uint32_t* index = reinterpret_cast<volatile tt_l1_ptr uint32_t*>(l1_index_addr);
+
+    for (uint32_t item = 0; item < num_items; item++) {
+        uint32_t n = get_arg_val<uint32_t>(first_item_arg + 3 * item);
+        uint32_t m_begin = get_arg_val<uint32_t>(first_item_arg + 3 * item + 1);
+        uint32_t m_end = get_arg_val<uint32_t>(first_item_arg + 3 * item + 2);
+
+        noc_async_read(get_noc_addr(n, s_index), l1_index_addr, index_page_bytes);
+        noc_async_read_barrier();
+        uint32_t nnz_begin = index[0];
+        uint32_t nnz = index[1];
+
+        for (uint32_t m = m_begin; m < m_end; m++) {
+            uint32_t itileA_row = m * Kt;
+            for (uint32_t p = 0; p < nnz; p++) {
+                cb_reserve_back(cb_id_in0, onetile);
+                noc_async_read_tile(itileA_row + index[2 + p], s0, get_write_ptr(cb_id_in0));
+                cb_reserve_back(cb_id_in1, onetile);
+                noc_async_read_tile(nnz_begin + p, s1, get_write_ptr(cb_id_in1));
+                noc_async_read_barrier();
+                cb_push_back(cb_id_in0, onetile);
+                cb_push_back(cb_id_in1, onetile);
+            }
+        }
+    }
+}
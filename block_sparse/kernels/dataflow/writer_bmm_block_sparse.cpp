@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// writer_unary_interleaved_start_id over the work items of reader_bmm_block_sparse: output tile m * Nt + n for
+// every row of an item. The compute kernel skips the items of an all-zero B column, their tiles are written from
+// a tile of zeros in L1 instead.
+void kernel_main() {
+    uint32_t dst_addr = get_arg_val<uint32_t>(0);
+    uint32_t Nt = get_arg_val<uint32_t>(1);
+    uint32_t num_items = get_arg_val<uint32_t>(2);
+    constexpr uint32_t first_item_arg = 3;  // then n, m_begin, m_end, nnz per item
+
+    constexpr uint32_t cb_id_out = get_compile_time_arg_val(0);
+    constexpr bool dst_is_dram = get_compile_time_arg_val(1) == 1;
+    constexpr uint32_t cb_id_zeros = get_compile_time_arg_val(2);
+    constexpr uint32_t onetile = 1;
+
+    const uint32_t tile_bytes = get_tile_size(cb_id_out);
+    const DataFormat data_format = get_dataformat(cb_id_out);
+
+    const InterleavedAddrGenFast<dst_is_dram> s = {
+        .bank_base_address = dst_addr, .page_size = tile_bytes, .data_format = data_format};
+
+    // Fill tile with zeros, never pushed
+    cb_reserve_back(cb_id_zeros, onetile);
+    uint32_t l1_zeros_addr = get_write_ptr(cb_id_zeros);
+    volatile tt_l1_ptr uint32_t* zeros = reinterpret_cast<volatile tt_l1_ptr uint32_t*>(l1_zeros_addr);
+    for (uint32_t i = 0; i < tile_bytes / sizeof(uint32_t); i++) {
+        zeros[i] = 0;
+    }
+
+    for (uint32_t item = 0; item < num_items; item++) {
+        uint32_t n = get_arg_val<uint32_t>(first_item_arg + 4 * item);
+        uint32_t m_begin = get_arg_val<uint32_t>(first_item_arg + 4 * item + 1);
+        uint32_t m_end = get_arg_val<uint32_t>(first_item_arg + 4 * item + 2);
+        uint32_t nnz = get_arg_val<uint32_t>(first_item_arg + 4 * item + 3);
+
+        for (uint32_t m = m_begin; m < m_end; m++) {
+            if (nnz == 0) {
+                noc_async_write_tile(m * Nt + n, s, l1_zeros_addr);
+                continue;
+            }
+            cb_wait_front(cb_id_out, onetile);
+            uint32_t l1_read_addr = get_read_ptr(cb_id_out);
+            noc_async_write_tile(m * Nt + n, s, l1_read_addr);
+            noc_async_write_barrier();
+            cb_pop_front(cb_id_out, onetile);
+        }
+        noc_async_write_barrier();
+    }
+}
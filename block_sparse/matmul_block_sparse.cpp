@@ -0,0 +1,476 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/constants.hpp"
+#include "tt_metal/detail/tt_metal.hpp"
+#include "tt_metal/detail/util.hpp"
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/common/test_tiles.hpp"
+#include "tt_metal/impl/dispatch/command_queue.hpp"
+#include "tt_metal/common/work_split.hpp"
+#include "tt_metal/common/tilize_untilize.hpp"
+#include "tt_metal/impl/device/device.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "../common/matmul_validation.hpp"
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+#include "block_sparse.hpp"
+
+using namespace tt::constants;
+using namespace std;
+using namespace tt;
+using namespace tt::tt_metal;
+
+using std::chrono::high_resolution_clock;
+using std::chrono::duration;
+
+////////////////////////////////////////////////////////////////////////////////
+// Block-sparse matmul: C = A * B with B pruned at tile granularity, only the
+// non-zero 32 x 32 tiles of B are stored, read and multiplied.
+//
+// The occupancy of B (block_sparse.hpp) is fixed by the plan: B is kept on the
+// device as its non-zero tiles packed column after column, and an index buffer
+// holds one page per tile column, {first packed tile, count, k of each}. The
+// reader fetches an A tile only when the B tile it pairs with is non-zero, the
+// compute kernel accumulates each output tile over those pairs alone, and the
+// tiles of an all-zero B column never reach the compute kernel: the writer
+// fills them from a tile of zeros. The work is balanced over the cores on the
+// non-zero tiles (schedule_block_sparse), so the runtime follows the density.
+//
+// Usage example:
+//   ./metal-matmul-block-sparse
+//     --m <size in elements> --n <size in elements> --k <size in elements> (default: 2048 each)
+//     --densities <comma separated fractions of non-zero B tiles, default: 1,0.5,0.25,0.1>
+//     --repetitions <timed runs per density, default: 10>
+//     --samples <output elements checked per density, default: 256, 0 to skip>
+////////////////////////////////////////////////////////////////////////////////
+
+namespace block_sparse {
+
+constexpr uint32_t single_tile_size = 2 * 32 * 32;
+constexpr uint32_t INDEX_PAGE_HEADER_WORDS = 2;  // first packed tile, count
+
+duration<double, std::milli> calc_duration(
+    std::chrono::time_point<std::chrono::high_resolution_clock> t1,
+    std::chrono::time_point<std::chrono::high_resolution_clock> t2,
+    string message) {
+    duration<double, std::milli> dur = t2 - t1;
+    tt::log_info(tt::LogVerif, "T {}: {} ms", message, dur.count());
+    return dur;
+}
+
+// Index page of a tile column, padded to the 32 B DRAM alignment
+uint32_t index_page_bytes(uint32_t Kt) {
+    uint32_t bytes = (INDEX_PAGE_HEADER_WORDS + Kt) * sizeof(uint32_t);
+    return (bytes + 31) / 32 * 32;
+}
+
+std::vector<uint32_t> make_index_pages(const TileOccupancy& occupancy) {
+    uint32_t page_words = index_page_bytes(occupancy.Kt) / sizeof(uint32_t);
+    std::vector<uint32_t> pages(size_t(occupancy.Nt) * page_words, 0);
+    for (uint32_t n = 0; n < occupancy.Nt; n++) {
+        uint32_t* page = pages.data() + size_t(n) * page_words;
+        page[0] = occupancy.col_ptr[n];
+        page[1] = occupancy.column_nnz(n);
+        std::copy(
+            occupancy.row_index.begin() + occupancy.col_ptr[n],
+            occupancy.row_index.begin() + occupancy.col_ptr[n + 1],
+            page + INDEX_PAGE_HEADER_WORDS);
+    }
+    return pages;
+}
+
+/*
+ * Occupancy of a tilized [K, N] B: tile (k, n) is the TILE_HW values at (k * Nt + n) * TILE_HW, non-zero when
+ * any of them is.
+ */
+TileOccupancy occupancy_of_tiles(const std::vector<bfloat16>& b, uint32_t Kt, uint32_t Nt) {
+    return make_tile_occupancy(Kt, Nt, [&b, Nt](uint32_t k, uint32_t n) {
+        const bfloat16* tile = b.data() + (size_t(k) * Nt + n) * TILE_HW;
+        return std::any_of(tile, tile + TILE_HW, [](bfloat16 value) { return value.to_float() != 0; });
+    });
+}
+
+void log_schedule(const SparseSchedule& schedule, const TileOccupancy& occupancy) {
+    size_t num_items = 0;
+    for (const auto& core : schedule.cores) {
+        num_items += core.items.size();
+    }
+    log_info(
+        tt::LogVerif,
+        "Block-sparse B: {} of {} tiles non-zero ({:.1f}%), {} work items on {} of {} cores",
+        occupancy.nnz(),
+        occupancy.Kt * occupancy.Nt,
+        100 * occupancy.density(),
+        num_items,
+        schedule.cores.size(),
+        schedule.grid_cores);
+    log_info(
+        tt::LogVerif,
+        "  expected finish {} steps (ideal {:.1f}), {:.2f}x the even split",
+        schedule.makespan(),
+        double(schedule.total_cost) / schedule.grid_cores,
+        schedule.imbalance());
+}
+
+struct BlockSparseMatmul {
+    Program program;
+    std::shared_ptr<tt::tt_metal::Buffer> src0_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> src1_dram_buffer;  // non-zero tiles only
+    std::shared_ptr<tt::tt_metal::Buffer> index_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> dst_dram_buffer;
+    TileOccupancy occupancy;
+    SparseSchedule schedule;
+    uint32_t num_cores;
+    std::vector<bfloat16> b_packed;  // scratch of the non-blocking B upload
+};
+
+BlockSparseMatmul create_matmul_block_sparse(
+    uint32_t M, uint32_t N, uint32_t K, TileOccupancy occupancy, MathFidelity math_fidelity, Device* device) {
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
+    TT_FATAL(
+        occupancy.Kt == Kt and occupancy.Nt == Nt,
+        "Occupancy of {} x {} tiles for a {} x {} B",
+        occupancy.Kt,
+        occupancy.Nt,
+        K,
+        N);
+
+    BlockSparseMatmul mm;
+    Program& program = mm.program;
+    mm.occupancy = std::move(occupancy);
+
+    /*
+     * Work split on the non-zero tiles
+     */
+    auto compute_with_storage_grid_size = device->compute_with_storage_grid_size();
+    uint32_t num_cores_x = compute_with_storage_grid_size.x;
+    uint32_t num_cores_y = compute_with_storage_grid_size.y;
+    mm.schedule = schedule_block_sparse(mm.occupancy, Mt, num_cores_x * num_cores_y);
+    for (const auto& core : mm.schedule.cores) {
+        TT_FATAL(
+            core.items.size() <= MAX_ITEMS_PER_CORE,
+            "{} work items on a core at the coarsest split, the runtime args hold {}",
+            core.items.size(),
+            MAX_ITEMS_PER_CORE);
+    }
+    log_schedule(mm.schedule, mm.occupancy);
+    mm.num_cores = mm.schedule.cores.size();
+    CoreRangeSet all_cores = num_cores_to_corerangeset(mm.num_cores, compute_with_storage_grid_size);
+
+    /*
+     * DRAM buffers: B and the index are sized by the non-zero tiles, an all-zero B keeps one tile
+     */
+    uint32_t index_page_size = index_page_bytes(Kt);
+    auto dram_buffer = [device](uint32_t size, uint32_t page_size) {
+        tt_metal::InterleavedBufferConfig dram_config{
+            .device = device, .size = size, .page_size = page_size, .buffer_type = tt_metal::BufferType::DRAM};
+        return CreateBuffer(dram_config);
+    };
+    mm.src0_dram_buffer = dram_buffer(single_tile_size * Mt * Kt, single_tile_size);
+    mm.src1_dram_buffer = dram_buffer(single_tile_size * std::max(mm.occupancy.nnz(), 1u), single_tile_size);
+    mm.index_dram_buffer = dram_buffer(index_page_size * Nt, index_page_size);
+    mm.dst_dram_buffer = dram_buffer(single_tile_size * Mt * Nt, single_tile_size);
+
+    std::vector<uint32_t> index_pages = make_index_pages(mm.occupancy);
+    EnqueueWriteBuffer(device->command_queue(), mm.index_dram_buffer, index_pages.data(), true);
+
+    /*
+     * Circular buffers: double-buffered in0 / in1 / output tiles as in multi_core, plus the reader's index page
+     * and the writer's tile of zeros
+     */
+    tt::DataFormat cb_data_format = tt::DataFormat::Float16_b;
+    uint32_t num_input_tiles = 2;
+    uint32_t output_cb_index = tt::CBIndex::c_16;
+    for (uint32_t cb_index : {uint32_t(tt::CBIndex::c_0), uint32_t(tt::CBIndex::c_1), output_cb_index}) {
+        CircularBufferConfig cb_config =
+            CircularBufferConfig(num_input_tiles * single_tile_size, {{cb_index, cb_data_format}})
+                .set_page_size(cb_index, single_tile_size);
+        tt_metal::CreateCircularBuffer(program, all_cores, cb_config);
+    }
+    uint32_t index_cb_index = tt::CBIndex::c_2;
+    CircularBufferConfig cb_index_config =
+        CircularBufferConfig(index_page_size, {{index_cb_index, tt::DataFormat::UInt32}})
+            .set_page_size(index_cb_index, index_page_size);
+    tt_metal::CreateCircularBuffer(program, all_cores, cb_index_config);
+    uint32_t zeros_cb_index = tt::CBIndex::c_3;
+    CircularBufferConfig cb_zeros_config =
+        CircularBufferConfig(single_tile_size, {{zeros_cb_index, cb_data_format}})
+            .set_page_size(zeros_cb_index, single_tile_size);
+    tt_metal::CreateCircularBuffer(program, all_cores, cb_zeros_config);
+
+    /*
+     * Kernels, the work items of each core are runtime args
+     */
+    std::vector<uint32_t> reader_compile_time_args = {1, 1};  // src0, src1 in DRAM
+    std::vector<uint32_t> writer_compile_time_args = {output_cb_index, 1, zeros_cb_index};
+
+    auto reader_id = tt_metal::CreateKernel(
+        program,
+        std::string(BLOCK_SPARSE_KERNELS_DIR) + "dataflow/reader_bmm_block_sparse.cpp",
+        all_cores,
+        tt_metal::DataMovementConfig{
+            .processor = DataMovementProcessor::RISCV_1,
+            .noc = NOC::RISCV_1_default,
+            .compile_args = reader_compile_time_args});
+
+    auto writer_id = tt_metal::CreateKernel(
+        program,
+        std::string(BLOCK_SPARSE_KERNELS_DIR) + "dataflow/writer_bmm_block_sparse.cpp",
+        all_cores,
+        tt_metal::DataMovementConfig{
+            .processor = DataMovementProcessor::RISCV_0,
+            .noc = NOC::RISCV_0_default,
+            .compile_args = writer_compile_time_args});
+
+    auto compute_id = tt_metal::CreateKernel(
+        program,
+        std::string(BLOCK_SPARSE_KERNELS_DIR) + "compute/bmm_block_sparse.cpp",
+        all_cores,
+        tt_metal::ComputeConfig{.math_fidelity = math_fidelity});
+
+    for (uint32_t i = 0; i < mm.num_cores; i++) {
+        CoreCoord core = {i / num_cores_y, i % num_cores_y};
+        const auto& items = mm.schedule.cores[i].items;
+
+        std::vector<uint32_t> reader_args = {
+            mm.src0_dram_buffer->address(),
+            mm.src1_dram_buffer->address(),
+            mm.index_dram_buffer->address(),
+            index_page_size,
+            Kt,
+            uint32_t(items.size())};
+        std::vector<uint32_t> writer_args = {mm.dst_dram_buffer->address(), Nt, uint32_t(items.size())};
+        std::vector<uint32_t> compute_args = {uint32_t(items.size())};
+        for (const WorkItem& item : items) {
+            uint32_t nnz = mm.occupancy.column_nnz(item.n);
+            reader_args.insert(reader_args.end(), {item.n, item.m_begin, item.m_end});
+            writer_args.insert(writer_args.end(), {item.n, item.m_begin, item.m_end, nnz});
+            compute_args.insert(compute_args.end(), {item.m_end - item.m_begin, nnz});
+        }
+
+        tt_metal::SetRuntimeArgs(program, reader_id, core, reader_args);
+        tt_metal::SetRuntimeArgs(program, writer_id, core, writer_args);
+        tt_metal::SetRuntimeArgs(program, compute_id, core, compute_args);
+    }
+
+    return mm;
+}
+
+/*
+ * Plan of a block-sparse B with the given occupancy. write_b takes the full tilized B and uploads its non-zero
+ * tiles only: values in the tiles the occupancy marks zero are dropped.
+ */
+matmul::MatmulPlan make_plan(
+    Device* device,
+    const matmul::MatmulShape& shape,
+    TileOccupancy occupancy,
+    MathFidelity math_fidelity = MathFidelity::HiFi4) {
+    TT_FATAL(shape.B == 1, "block_sparse: batch {} not supported", shape.B);
+    auto mm = std::make_shared<BlockSparseMatmul>(
+        create_matmul_block_sparse(shape.M, shape.N, shape.K, std::move(occupancy), math_fidelity, device));
+
+    uint32_t num_cores_y = device->compute_with_storage_grid_size().y;
+    matmul::MatmulPlan plan;
+    plan.variant = "block_sparse";
+    plan.shape = shape;
+    plan.device = device;
+    plan.grid_x = (mm->num_cores - 1) / num_cores_y + 1;
+    plan.grid_y = std::min(mm->num_cores, num_cores_y);
+    plan.math_fidelity = math_fidelity;
+    plan.state = mm;
+    plan.program = &mm->program;
+    plan.write_a = [mm = mm.get()](CommandQueue& cq, const std::vector<bfloat16>& a) {
+        matmul::write_bfloat16(cq, mm->src0_dram_buffer, a);
+    };
+    plan.write_b = [mm = mm.get()](CommandQueue& cq, const std::vector<bfloat16>& b) {
+        TRACE_ZONE("pack non-zero tiles");
+        const TileOccupancy& occupancy = mm->occupancy;
+        mm->b_packed.resize(size_t(std::max(occupancy.nnz(), 1u)) * TILE_HW);
+        for (uint32_t n = 0; n < occupancy.Nt; n++) {
+            for (uint32_t p = occupancy.col_ptr[n]; p < occupancy.col_ptr[n + 1]; p++) {
+                const bfloat16* tile = b.data() + (size_t(occupancy.row_index[p]) * occupancy.Nt + n) * TILE_HW;
+                std::copy(tile, tile + TILE_HW, mm->b_packed.begin() + size_t(p) * TILE_HW);
+            }
+        }
+        matmul::write_bfloat16(cq, mm->src1_dram_buffer, mm->b_packed);
+    };
+    plan.read_c = [mm = mm.get()](CommandQueue& cq, std::vector<bfloat16>& output) {
+        matmul::read_bfloat16(cq, mm->dst_dram_buffer, output);
+    };
+    return plan;
+}
+
+// Occupancy taken from the bench B, dense unless it was pruned
+matmul_bench::MatmulRunner make_bench_runner(Device* device, const matmul_bench::MatmulInputs& inputs) {
+    TileOccupancy occupancy = occupancy_of_tiles(inputs.b, inputs.K / TILE_WIDTH, inputs.N / TILE_WIDTH);
+    return matmul_bench::make_plan_runner(
+        make_plan(device, {.M = inputs.M, .N = inputs.N, .K = inputs.K}, std::move(occupancy)), inputs);
+}
+
+/*
+ * Row-major B with each tile kept with probability `density`, the others zeroed, and its occupancy.
+ * At least one tile is kept.
+ */
+TileOccupancy prune_tiles(std::vector<bfloat16>& b, uint32_t K, uint32_t N, double density, uint32_t seed) {
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution keep(density);
+    std::vector<bool> kept(size_t(Kt) * Nt);
+    for (size_t t = 0; t < kept.size(); t++) {
+        kept[t] = keep(rng);
+    }
+    if (std::none_of(kept.begin(), kept.end(), [](bool k) { return k; })) {
+        kept[0] = true;
+    }
+    for (uint32_t r = 0; r < K; r++) {
+        for (uint32_t c = 0; c < N; c++) {
+            if (not kept[size_t(r / TILE_HEIGHT) * Nt + c / TILE_WIDTH]) {
+                b[size_t(r) * N + c] = bfloat16(0.0f);
+            }
+        }
+    }
+    return make_tile_occupancy(Kt, Nt, [&kept, Nt](uint32_t k, uint32_t n) { return kept[size_t(k) * Nt + n]; });
+}
+
+}  // namespace block_sparse
+
+using namespace block_sparse;
+
+///////////////////////////////////////
+
+#ifndef MATMUL_NO_MAIN
+int main(int argc, char** argv) {
+    bool pass = true;
+
+    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
+        TT_THROW("Test not supported w/ slow dispatch, exiting");
+    }
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const std::string& name, const std::string& default_value) -> std::string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+
+    std::string trace_path = timeline::enable_from_env();
+
+    try {
+        uint32_t M = std::stoul(get_option("--m", "2048"));
+        uint32_t N = std::stoul(get_option("--n", "2048"));
+        uint32_t K = std::stoul(get_option("--k", "2048"));
+        uint32_t repetitions = std::stoul(get_option("--repetitions", "10"));
+        uint32_t samples = std::stoul(get_option("--samples", "256"));
+        std::vector<double> densities;
+        std::stringstream densities_list(get_option("--densities", "1,0.5,0.25,0.1"));
+        for (std::string density; std::getline(densities_list, density, ',');) {
+            densities.push_back(std::stod(density));
+        }
+        TT_FATAL(M % TILE_HEIGHT == 0 and N % TILE_WIDTH == 0 and K % TILE_WIDTH == 0, "Sizes must be tile aligned");
+        TT_FATAL(not densities.empty() and repetitions > 0, "Need at least one density and one repetition");
+
+        /* Silicon accelerator setup */
+        constexpr int device_id = 0;
+        Device* device = CreateDevice(device_id);
+        CommandQueue& cq = device->command_queue();
+
+        /* input vectors with various ranges of values */
+        std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(size_t(M) * K * 2, 1, 123, -0.5);
+        std::vector<bfloat16> a_tilized = a;
+        tilize(a_tilized, M, K);
+
+        double num_ops = 2.0 * M * N * K;
+        double baseline_ms = 0;
+        for (double density : densities) {
+            std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(size_t(K) * N * 2, 1, 12522, -0.5);
+            TileOccupancy occupancy = prune_tiles(b, K, N, density, 7);
+            std::vector<bfloat16> b_tilized = b;
+            tilize(b_tilized, K, N);
+
+            auto t1 = high_resolution_clock::now();
+            matmul::MatmulPlan plan = [&] {
+                TRACE_ZONE("plan");
+                return make_plan(device, {.M = M, .N = N, .K = K}, occupancy);
+            }();
+            auto t2 = high_resolution_clock::now();
+            calc_duration(t1, t2, "config");
+
+            /* Weights and activations written once, the first run compiles the kernels */
+            std::vector<bfloat16> result_vec;
+            matmul::write_inputs(plan, a_tilized, b_tilized);
+            matmul::run(plan, result_vec);
+
+            t1 = high_resolution_clock::now();
+            for (uint32_t r = 0; r < repetitions; r++) {
+                TRACE_ZONE("enqueue");
+                EnqueueProgram(cq, *plan.program, false);
+            }
+            Finish(cq);
+            t2 = high_resolution_clock::now();
+            double ms = duration<double, std::milli>(t2 - t1).count() / repetitions;
+            if (baseline_ms == 0) {
+                baseline_ms = ms;
+            }
+            log_info(
+                tt::LogTest,
+                "density {:.3f} ({} of {} tiles): {:.3f} ms, {:.3f} dense-equivalent TFLOPS, {:.2f}x the first",
+                occupancy.density(),
+                occupancy.nnz(),
+                occupancy.Kt * occupancy.Nt,
+                ms,
+                num_ops / (ms / 1000) / 1e12,
+                baseline_ms / ms);
+
+            if (samples > 0) {
+                {
+                    TRACE_ZONE("untilize");
+                    untilize(result_vec, M, N);
+                }
+                double pcc;
+                {
+                    TRACE_ZONE("validate");
+                    pcc = matmul::sampled_pcc(a, b, result_vec, M, N, K, samples);
+                }
+                log_info(tt::LogTest, "  PCC against CPU reference ({} samples): {}", samples, pcc);
+                pass &= pcc >= matmul::VALIDATION_PCC;
+            }
+        }
+
+        pass &= CloseDevice(device);
+
+        if (not trace_path.empty() and timeline::write_host_trace(trace_path)) {
+            log_info(tt::LogTest, "Host trace written to {}", trace_path);
+        }
+
+    } catch (const std::exception& e) {
+        tt::log_error(tt::LogTest, "Test failed with exception!");
+        tt::log_error(tt::LogTest, "{}", e.what());
+
+        throw;
+    }
+
+    if (pass) {
+        tt::log_info(tt::LogTest, "Test Passed");
+    } else {
+        TT_THROW("Test Failed");
+    }
+
+    TT_ASSERT(pass);
+
+    return 0;
+}
+#endif  // MATMUL_NO_MAIN
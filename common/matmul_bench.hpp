@@ -0,0 +1,323 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark harness shared by the matmul variants (single_core, multi_core,
+// multi_core_reuse, multi_core_reuse_mcast, test_compute_mm).
+//
+// Every variant sets its program and buffers up once and hands the harness a
+// callable that runs one matmul (EnqueueProgram + blocking output read). The
+// first call is reported on its own (first_run_time: kernel compilation and
+// program upload), then warmup calls, then the timed repetitions.
+//
+// Results are written with the columns of the host-perf CSV of test_mm_op.py,
+// followed by the distribution of the repetitions and the repetitions
+// themselves, which regression_gate/ compares against its history.
+// Utilization is computed the same way: ideal cycles of the fidelity over the
+// measured cycles.
+//
+// Host-only: no tt_metal headers, so the variants can include it as is and
+// build their own binary, or be linked into bench/ with MATMUL_NO_MAIN.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace matmul_bench {
+
+// Cycles per 32x32x32 tile op, as in test_mm_op.py
+constexpr uint32_t LOFI_CYCLES = 16;
+
+inline uint32_t fidelity_cycles_per_tile(const std::string& math_fidelity) {
+    if (math_fidelity == "LoFi") {
+        return LOFI_CYCLES;
+    } else if (math_fidelity == "HiFi2") {
+        return LOFI_CYCLES * 2;
+    } else if (math_fidelity == "HiFi3") {
+        return LOFI_CYCLES * 3;
+    }
+    return LOFI_CYCLES * 4;
+}
+
+struct BenchCase {
+    std::string conf;  // variant name
+    std::string arch;  // grayskull / wormhole_b0 / blackhole, part of the regression_gate key
+    uint32_t M = 0;
+    uint32_t N = 0;
+    uint32_t K = 0;
+    std::string dtype = "BFLOAT16";        // BFLOAT16 / BFLOAT8_B / BFLOAT4_B
+    std::string math_fidelity = "HiFi4";  // LoFi / HiFi2 / HiFi3 / HiFi4
+    uint32_t grid_x = 1;                   // cores used by the variant
+    uint32_t grid_y = 1;
+    uint32_t full_grid_x = 1;  // compute_with_storage_grid_size of the device
+    uint32_t full_grid_y = 1;
+    double clock_mhz = 1000;
+    bool in0_sharded = false;
+    bool out_sharded = false;
+    std::string in0_storage_type = "DRAM";
+    std::string in1_storage_type = "DRAM";
+    std::string out_storage_type = "DRAM";
+};
+
+struct BenchSamples {
+    double first_run_us = 0;
+    double transfer_in0_us = 0;
+    double transfer_in1_us = 0;
+    std::vector<double> run_us;
+};
+
+struct BenchStats {
+    double min = 0;
+    double median = 0;
+    double p99 = 0;
+    double max = 0;
+    double mean = 0;
+    double stddev = 0;
+};
+
+struct BenchResult {
+    BenchCase bench_case;
+    BenchSamples samples;
+    BenchStats stats;     // of samples.run_us
+    double tflops = 0;    // on the mean, like "TFLOPs (avg)"
+    double util_user_grid = 0;
+    double util_full_grid = 0;
+};
+
+inline double elapsed_us(std::chrono::steady_clock::time_point t1, std::chrono::steady_clock::time_point t2) {
+    return std::chrono::duration<double, std::micro>(t2 - t1).count();
+}
+
+template <typename F>
+double time_us(F&& f) {
+    auto t1 = std::chrono::steady_clock::now();
+    f();
+    auto t2 = std::chrono::steady_clock::now();
+    return elapsed_us(t1, t2);
+}
+
+/*
+ * First call, warmup calls, then every repetition timed on its own.
+ * run must block until the output is back on the host.
+ */
+template <typename F>
+BenchSamples time_runs(uint32_t warmup, uint32_t repetitions, F&& run) {
+    BenchSamples samples;
+    samples.first_run_us = time_us(run);
+    for (uint32_t i = 0; i < warmup; i++) {
+        run();
+    }
+    samples.run_us.reserve(repetitions);
+    for (uint32_t i = 0; i < repetitions; i++) {
+        samples.run_us.push_back(time_us(run));
+    }
+    return samples;
+}
+
+inline BenchStats compute_stats(std::vector<double> values) {
+    BenchStats stats;
+    if (values.empty()) {
+        return stats;
+    }
+    std::sort(values.begin(), values.end());
+    // Nearest rank
+    auto percentile = [&values](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    };
+    stats.min = values.front();
+    stats.max = values.back();
+    stats.median = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    double sum = 0;
+    for (double value : values) {
+        sum += value;
+    }
+    stats.mean = sum / values.size();
+    double sq_sum = 0;
+    for (double value : values) {
+        sq_sum += (value - stats.mean) * (value - stats.mean);
+    }
+    stats.stddev = values.size() > 1 ? std::sqrt(sq_sum / (values.size() - 1)) : 0;
+    return stats;
+}
+
+inline BenchResult summarize(const BenchCase& bench_case, const BenchSamples& samples) {
+    BenchResult result;
+    result.bench_case = bench_case;
+    result.samples = samples;
+    result.stats = compute_stats(samples.run_us);
+    if (result.stats.mean <= 0) {
+        return result;
+    }
+    double m = bench_case.M, n = bench_case.N, k = bench_case.K;
+    double mean_s = result.stats.mean * 1e-6;
+    result.tflops = 2 * m * k * n / 1e12 / mean_s;
+
+    double tile_ops = m * k * n / 32 / 32 / 32;
+    double cycles_per_tile = fidelity_cycles_per_tile(bench_case.math_fidelity);
+    double measured_cycles = mean_s * bench_case.clock_mhz * 1e6;
+    double user_cores = bench_case.grid_x * bench_case.grid_y;
+    double full_cores = bench_case.full_grid_x * bench_case.full_grid_y;
+    result.util_user_grid = tile_ops * cycles_per_tile / user_cores / measured_cycles;
+    result.util_full_grid = tile_ops * cycles_per_tile / full_cores / measured_cycles;
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Output
+////////////////////////////////////////////////////////////////////////////////
+inline std::string format_double(const char* format, double value) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), format, value);
+    return buf;
+}
+
+inline std::string grid_string(uint32_t x, uint32_t y) {
+    return "(" + std::to_string(x) + ", " + std::to_string(y) + ")";
+}
+
+inline std::string csv_field(const std::string& field) {
+    if (field.find_first_of(",\"") == std::string::npos) {
+        return field;
+    }
+    std::string quoted = "\"";
+    for (char c : field) {
+        quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+    }
+    return quoted + "\"";
+}
+
+/*
+ * test_mm_op.py host-perf columns (its header line leaves out k and n, the rows have them),
+ * then the distribution of the repetitions. Times in us.
+ */
+inline void write_host_perf_csv(std::ostream& out, const std::vector<BenchResult>& results) {
+    if (results.empty()) {
+        return;
+    }
+    const BenchCase& first = results.front().bench_case;
+    std::vector<std::string> header = {
+        "conf",
+        "m",
+        "k",
+        "n",
+        "use_trace",
+        "grid_size",
+        "in0_sharded",
+        "out_sharded",
+        "in0_storage_type",
+        "in1_storage_type",
+        "out_storage_type",
+        "dtype",
+        "math_fidelity",
+        "first_run_time",
+        "inference_time_avg",
+        "trace_time",
+        "transfer_time_in0",
+        "transfer_time_in1",
+        "TFLOPs (avg)",
+        "Utilization (vs " + grid_string(first.grid_x, first.grid_y) + " user grid)",
+        "Utilization (vs " + std::to_string(first.full_grid_y) + "x" + std::to_string(first.full_grid_x) +
+            " full grid)",
+        "inference_time_min",
+        "inference_time_median",
+        "inference_time_p99",
+        "inference_time_stddev",
+        "repetitions",
+        "arch",
+        "inference_time_samples"};
+    for (size_t i = 0; i < header.size(); i++) {
+        out << (i == 0 ? "" : ",") << csv_field(header[i]);
+    }
+    out << "\n";
+
+    for (const auto& result : results) {
+        const BenchCase& c = result.bench_case;
+        const BenchStats& s = result.stats;
+        std::string samples;
+        for (double run_us : result.samples.run_us) {
+            samples += (samples.empty() ? "" : " ") + format_double("%.2f", run_us);
+        }
+        std::vector<std::string> row = {
+            c.conf,
+            std::to_string(c.M),
+            std::to_string(c.K),
+            std::to_string(c.N),
+            "False",
+            grid_string(c.grid_x, c.grid_y),
+            c.in0_sharded ? "True" : "False",
+            c.out_sharded ? "True" : "False",
+            c.in0_storage_type,
+            c.in1_storage_type,
+            c.out_storage_type,
+            "DataType." + c.dtype,
+            "MathFidelity." + c.math_fidelity,
+            format_double("%.2f", result.samples.first_run_us),
+            format_double("%.2f", s.mean),
+            format_double("%.2f", 0),
+            format_double("%.2f", result.samples.transfer_in0_us),
+            format_double("%.2f", result.samples.transfer_in1_us),
+            format_double("%.2f", result.tflops),
+            format_double("%.2f%%", result.util_user_grid * 100),
+            format_double("%.2f%%", result.util_full_grid * 100),
+            format_double("%.2f", s.min),
+            format_double("%.2f", s.median),
+            format_double("%.2f", s.p99),
+            format_double("%.2f", s.stddev),
+            std::to_string(result.samples.run_us.size()),
+            c.arch,
+            samples};
+        for (size_t i = 0; i < row.size(); i++) {
+            out << (i == 0 ? "" : ",") << csv_field(row[i]);
+        }
+        out << "\n";
+    }
+}
+
+inline std::string json_number(double value) {
+    return std::isfinite(value) ? format_double("%.6g", value) : "null";
+}
+
+inline void write_json(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "[";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        const BenchCase& c = result.bench_case;
+        const BenchStats& s = result.stats;
+        out << (i == 0 ? "\n" : ",\n") << "  {\"conf\": \"" << c.conf << "\", \"arch\": \"" << c.arch << "\""
+            << ", \"m\": " << c.M << ", \"k\": " << c.K
+            << ", \"n\": " << c.N << ", \"grid_size\": [" << c.grid_x << ", " << c.grid_y << "]"
+            << ", \"full_grid_size\": [" << c.full_grid_x << ", " << c.full_grid_y << "]"
+            << ", \"in0_storage_type\": \"" << c.in0_storage_type << "\", \"in1_storage_type\": \""
+            << c.in1_storage_type << "\", \"out_storage_type\": \"" << c.out_storage_type << "\""
+            << ", \"dtype\": \"" << c.dtype << "\", \"math_fidelity\": \"" << c.math_fidelity << "\""
+            << ", \"clock_mhz\": " << json_number(c.clock_mhz)
+            << ", \"first_run_time_us\": " << json_number(result.samples.first_run_us)
+            << ", \"transfer_time_in0_us\": " << json_number(result.samples.transfer_in0_us)
+            << ", \"transfer_time_in1_us\": " << json_number(result.samples.transfer_in1_us)
+            << ", \"repetitions\": " << result.samples.run_us.size() << ", \"time_us\": {\"min\": "
+            << json_number(s.min) << ", \"median\": " << json_number(s.median) << ", \"p99\": " << json_number(s.p99)
+            << ", \"max\": " << json_number(s.max) << ", \"mean\": " << json_number(s.mean)
+            << ", \"stddev\": " << json_number(s.stddev) << "}"
+            << ", \"tflops\": " << json_number(result.tflops)
+            << ", \"utilization_user_grid\": " << json_number(result.util_user_grid)
+            << ", \"utilization_full_grid\": " << json_number(result.util_full_grid) << ", \"samples_us\": [";
+        for (size_t r = 0; r < result.samples.run_us.size(); r++) {
+            out << (r == 0 ? "" : ", ") << json_number(result.samples.run_us[r]);
+        }
+        out << "]}";
+    }
+    out << "\n]\n";
+}
+
+}  // namespace matmul_bench
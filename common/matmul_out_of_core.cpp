@@ -0,0 +1,363 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "matmul_out_of_core.hpp"
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/constants.hpp"
+#include "tt_metal/common/tilize_untilize.hpp"
+#include "tt_metal/impl/dispatch/command_queue.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "trace_zones.hpp"
+
+using namespace tt::constants;
+using namespace tt;
+using namespace tt::tt_metal;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace matmul {
+
+MappedMatrix::MappedMatrix(MappedMatrix&& other) noexcept { *this = std::move(other); }
+
+MappedMatrix& MappedMatrix::operator=(MappedMatrix&& other) noexcept {
+    std::swap(path, other.path);
+    std::swap(rows, other.rows);
+    std::swap(cols, other.cols);
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    return *this;
+}
+
+MappedMatrix::~MappedMatrix() {
+    if (data != nullptr) {
+        munmap(data, size);
+    }
+}
+
+MappedMatrix map_matrix(const std::string& path, uint32_t rows, uint32_t cols, bool writable) {
+    size_t size = size_t(rows) * cols * sizeof(bfloat16);
+    int fd = open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    TT_FATAL(fd >= 0, "Cannot open {}: {}", path, std::strerror(errno));
+    // errno of a failed call, read before close() can overwrite it
+    auto fail = [fd, &path](const char* what) {
+        int error = errno;
+        close(fd);
+        TT_THROW("Cannot {} {}: {}", what, path, std::strerror(error));
+    };
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        fail("stat");
+    }
+    if (writable) {
+        if (ftruncate(fd, size) != 0) {
+            fail("resize");
+        }
+    } else if (size_t(file_stat.st_size) != size) {
+        close(fd);
+        TT_THROW("{} has {} bytes, expected {} x {} bfloat16", path, file_stat.st_size, rows, cols);
+    }
+    void* mapping = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        fail("map");
+    }
+    close(fd);  // the mapping keeps the file
+
+    MappedMatrix matrix;
+    matrix.path = path;
+    matrix.rows = rows;
+    matrix.cols = cols;
+    matrix.data = static_cast<bfloat16*>(mapping);
+    matrix.size = size;
+    return matrix;
+}
+
+namespace {
+
+// Largest divisor of total below value, 1 at the least
+uint32_t next_smaller_divisor(uint32_t total, uint32_t value) {
+    for (uint32_t d = value - 1; d > 1; d--) {
+        if (total % d == 0) {
+            return d;
+        }
+    }
+    return 1;
+}
+
+uint64_t panel_device_bytes(uint32_t pm, uint32_t pn, uint32_t pk) {
+    return uint64_t(TILE_HW) * sizeof(bfloat16) * (uint64_t(pm) * pk + uint64_t(pk) * pn + uint64_t(pm) * pn);
+}
+
+}  // namespace
+
+OutOfCoreLayout plan_out_of_core(
+    const MatmulShape& shape,
+    uint64_t device_dram_bytes,
+    const OutOfCoreOptions& options,
+    const std::function<bool(const MatmulShape&)>& supports_panel) {
+    TT_FATAL(
+        shape.M % TILE_HEIGHT == 0 and shape.N % TILE_WIDTH == 0 and shape.K % TILE_WIDTH == 0,
+        "M, N and K must be multiples of the tile size");
+    TT_FATAL(shape.B == 1, "Out-of-core matmul is batch 1");
+    uint32_t Mt = shape.M / TILE_HEIGHT;
+    uint32_t Nt = shape.N / TILE_WIDTH;
+    uint32_t Kt = shape.K / TILE_WIDTH;
+
+    // Panel sizes in tiles, fixed by the options or shrunk from the full dimension
+    auto fixed_tiles = [](uint32_t elements, uint32_t total_tiles, const char* name) {
+        if (elements == 0) {
+            return 0u;
+        }
+        uint32_t tiles = elements / TILE_WIDTH;
+        TT_FATAL(
+            elements % TILE_WIDTH == 0 and tiles > 0 and total_tiles % tiles == 0,
+            "--panel-{} {} must be a multiple of {} dividing the full dimension",
+            name,
+            elements,
+            TILE_WIDTH);
+        return tiles;
+    };
+    uint32_t fixed_m = fixed_tiles(options.panel_m, Mt, "m");
+    uint32_t fixed_n = fixed_tiles(options.panel_n, Nt, "n");
+    uint32_t fixed_k = fixed_tiles(options.panel_k, Kt, "k");
+    uint32_t pm = fixed_m ? fixed_m : Mt;
+    uint32_t pn = fixed_n ? fixed_n : Nt;
+    uint32_t pk = fixed_k ? fixed_k : Kt;
+
+    // Two plans are on the device at once. Panels the variant cannot plan are shrunk further, as the budget
+    auto panel_shape = [&pm, &pn, &pk]() {
+        return MatmulShape{.M = pm * TILE_HEIGHT, .N = pn * TILE_WIDTH, .K = pk * TILE_WIDTH};
+    };
+    uint64_t budget = uint64_t(options.dram_fraction * device_dram_bytes / 2);
+    while (panel_device_bytes(pm, pn, pk) > budget or uint64_t(pm) * pn > options.max_output_tiles or
+           not supports_panel(panel_shape())) {
+        bool too_many_output_tiles = uint64_t(pm) * pn > options.max_output_tiles;
+        // Largest free dimension, K only for the memory budget and the variant
+        uint32_t* largest = nullptr;
+        uint32_t largest_total = 0;
+        for (auto [panel, total, fixed, output] : {std::tuple{&pm, Mt, fixed_m, true},
+                                                   std::tuple{&pn, Nt, fixed_n, true},
+                                                   std::tuple{&pk, Kt, fixed_k, false}}) {
+            if (fixed or *panel == 1 or (too_many_output_tiles and not output)) {
+                continue;
+            }
+            if (largest == nullptr or *panel > *largest) {
+                largest = panel;
+                largest_total = total;
+            }
+        }
+        TT_FATAL(
+            largest != nullptr,
+            "No panel of {} x {} x {} fits in {} bytes of device DRAM with at most {} output tiles and is "
+            "supported by {}",
+            shape.M,
+            shape.N,
+            shape.K,
+            budget,
+            options.max_output_tiles,
+            options.variant);
+        *largest = next_smaller_divisor(largest_total, *largest);
+    }
+
+    OutOfCoreLayout layout;
+    layout.shape = shape;
+    layout.panel = panel_shape();
+    layout.num_m = Mt / pm;
+    layout.num_n = Nt / pn;
+    layout.num_k = Kt / pk;
+    layout.panel_bytes = panel_device_bytes(pm, pn, pk);
+    return layout;
+}
+
+namespace {
+
+// Tilized operand panels of one step, empty when the panel is already on the plan
+struct HostPanels {
+    std::vector<bfloat16> a;
+    std::vector<bfloat16> b;
+};
+
+// rows x cols block at (row0, col0) of a row-major matrix, tilized
+std::vector<bfloat16> read_panel(
+    const MappedMatrix& matrix, uint32_t row0, uint32_t col0, uint32_t rows, uint32_t cols) {
+    std::vector<bfloat16> panel(size_t(rows) * cols);
+    for (uint32_t r = 0; r < rows; r++) {
+        std::memcpy(&panel[size_t(r) * cols], matrix.row(row0 + r) + col0, cols * sizeof(bfloat16));
+    }
+    tilize(panel, rows, cols);
+    return panel;
+}
+
+}  // namespace
+
+OutOfCoreStats matmul_out_of_core(
+    Device* device, const MappedMatrix& a, const MappedMatrix& b, MappedMatrix& c, const OutOfCoreOptions& options) {
+    TT_FATAL(a.cols == b.rows, "A is {} x {}, B is {} x {}", a.rows, a.cols, b.rows, b.cols);
+    TT_FATAL(c.rows == a.rows and c.cols == b.cols, "C is {} x {}, expected {} x {}", c.rows, c.cols, a.rows, b.cols);
+    auto start = high_resolution_clock::now();
+
+    OutOfCoreStats stats;
+    uint64_t device_dram_bytes = uint64_t(device->num_dram_channels()) * device->dram_size_per_channel();
+    SupportsShape supports_shape = plan_variant(options.variant).supports_shape;
+    auto supports_panel = [device, supports_shape](const MatmulShape& panel) { return supports_shape(device, panel); };
+    const OutOfCoreLayout layout =
+        plan_out_of_core({.M = a.rows, .N = b.cols, .K = a.cols}, device_dram_bytes, options, supports_panel);
+    stats.layout = layout;
+    const MatmulShape& panel = layout.panel;
+    log_info(
+        tt::LogVerif,
+        "Out-of-core {} x {} x {}: panels of {} x {} x {} ({} MB on the device), {} x {} x {} steps",
+        a.rows,
+        b.cols,
+        a.cols,
+        panel.M,
+        panel.N,
+        panel.K,
+        layout.panel_bytes >> 20,
+        layout.num_m,
+        layout.num_n,
+        layout.num_k);
+
+    auto t1 = high_resolution_clock::now();
+    std::array<MatmulPlan, 2> plans = {
+        create_plan(device, options.variant, panel), create_plan(device, options.variant, panel)};
+    stats.plan_ms = duration<double, std::milli>(high_resolution_clock::now() - t1).count();
+
+    // Step n is panel (i, j, k), k fastest; the A / B panel ids on each plan skip repeated uploads
+    auto step_ijk = [&layout](uint64_t n) {
+        return std::tuple<uint32_t, uint32_t, uint32_t>{
+            n / (uint64_t(layout.num_n) * layout.num_k), n / layout.num_k % layout.num_n, n % layout.num_k};
+    };
+    auto a_id = [&layout](uint32_t i, uint32_t k) { return int64_t(i) * layout.num_k + k; };
+    auto b_id = [&layout](uint32_t k, uint32_t j) { return int64_t(k) * layout.num_n + j; };
+    std::array<int64_t, 2> resident_a = {-1, -1};
+    std::array<int64_t, 2> resident_b = {-1, -1};
+
+    // Host thread: reads the panels a step needs from the mapped files. need_a / need_b are taken from the
+    // resident ids when the read starts, the plan of the step is not written between then and the upload
+    auto prepare = [&](uint64_t n, bool need_a, bool need_b) {
+        return std::async(std::launch::async, [&, n, need_a, need_b] {
+            TRACE_ZONE("read panels");
+            auto [i, j, k] = step_ijk(n);
+            HostPanels panels;
+            if (need_a) {
+                panels.a = read_panel(a, i * panel.M, k * panel.K, panel.M, panel.K);
+            }
+            if (need_b) {
+                panels.b = read_panel(b, k * panel.K, j * panel.N, panel.K, panel.N);
+            }
+            return panels;
+        });
+    };
+    auto launch_prepare = [&](uint64_t n) {
+        auto [i, j, k] = step_ijk(n);
+        return prepare(n, resident_a[n % 2] != a_id(i, k), resident_b[n % 2] != b_id(k, j));
+    };
+
+    CommandQueue& cq = device->command_queue();
+    std::array<HostPanels, 2> uploaded;  // kept until the output read of their step
+    auto upload = [&](uint64_t n, HostPanels panels) {
+        TRACE_ZONE("upload");
+        auto [i, j, k] = step_ijk(n);
+        MatmulPlan& plan = plans[n % 2];
+        if (not panels.a.empty()) {
+            plan.write_a(cq, panels.a);
+            resident_a[n % 2] = a_id(i, k);
+            stats.a_uploads++;
+            stats.upload_bytes += panels.a.size() * sizeof(bfloat16);
+        }
+        if (not panels.b.empty()) {
+            plan.write_b(cq, panels.b);
+            resident_b[n % 2] = b_id(k, j);
+            stats.b_uploads++;
+            stats.upload_bytes += panels.b.size() * sizeof(bfloat16);
+        }
+        uploaded[n % 2] = std::move(panels);
+    };
+    auto wait_prepared = [&stats](std::future<HostPanels>& future) {
+        auto t1 = high_resolution_clock::now();
+        HostPanels panels = future.get();
+        stats.prepare_wait_ms += duration<double, std::milli>(high_resolution_clock::now() - t1).count();
+        return panels;
+    };
+    auto enqueue_program = [&](uint64_t n) {
+        TRACE_ZONE("enqueue");
+        EnqueueProgram(cq, *plans[n % 2].program, false);
+    };
+
+    uint64_t steps = layout.steps();
+    std::vector<bfloat16> c_panel(size_t(panel.M) * panel.N);
+    std::vector<float> c_sum(layout.num_k > 1 ? c_panel.size() : 0);
+
+    std::future<HostPanels> next = launch_prepare(0);
+    upload(0, wait_prepared(next));
+    enqueue_program(0);
+    if (steps > 1) {
+        next = launch_prepare(1);
+    }
+    for (uint64_t n = 0; n < steps; n++) {
+        // Uploads of step n + 1 go behind the program of step n, the output read of step n behind them
+        if (n + 1 < steps) {
+            upload(n + 1, wait_prepared(next));
+        }
+        t1 = high_resolution_clock::now();
+        {
+            TRACE_ZONE("readback");
+            plans[n % 2].read_c(cq, c_panel);
+        }
+        stats.device_wait_ms += duration<double, std::milli>(high_resolution_clock::now() - t1).count();
+        if (n + 1 < steps) {
+            enqueue_program(n + 1);
+        }
+        if (n + 2 < steps) {
+            next = launch_prepare(n + 2);
+        }
+
+        // Accumulate step n while the device runs step n + 1
+        t1 = high_resolution_clock::now();
+        {
+            TRACE_ZONE("accumulate");
+            auto [i, j, k] = step_ijk(n);
+            untilize(c_panel, panel.M, panel.N);
+            if (layout.num_k > 1) {
+                for (size_t e = 0; e < c_panel.size(); e++) {
+                    c_sum[e] = (k == 0 ? 0.0f : c_sum[e]) + c_panel[e].to_float();
+                }
+            }
+            if (k + 1 == layout.num_k) {
+                for (uint32_t r = 0; r < panel.M; r++) {
+                    bfloat16* c_row = c.row(i * panel.M + r) + j * panel.N;
+                    if (layout.num_k > 1) {
+                        for (uint32_t e = 0; e < panel.N; e++) {
+                            c_row[e] = bfloat16(c_sum[size_t(r) * panel.N + e]);
+                        }
+                    } else {
+                        std::memcpy(c_row, &c_panel[size_t(r) * panel.N], panel.N * sizeof(bfloat16));
+                    }
+                }
+            }
+        }
+        stats.accumulate_ms += duration<double, std::milli>(high_resolution_clock::now() - t1).count();
+    }
+    stats.total_ms = duration<double, std::milli>(high_resolution_clock::now() - start).count();
+    return stats;
+}
+
+}  // namespace matmul
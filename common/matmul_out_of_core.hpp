@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/impl/device/device.hpp"
+
+#include "matmul_plan.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Out-of-core matmul: C = A * B for operands larger than the device DRAM, read
+// from and written to memory mapped host files, so neither the device nor the
+// host RAM bounds the problem size.
+//
+// The M x N x K problem is cut into panels of PM x PN x PK, each dimension a
+// divisor of the full one in tiles: step (i, j, k) multiplies the A panel
+// (i, k) by the B panel (k, j) with one MatmulPlan of the panel shape. Panels
+// are shrunk, the largest dimension first, until the operands of two panels
+// fit in dram_fraction of the device DRAM and a panel has at most
+// max_output_tiles output tiles (the 30,720 tiles of the mcast program).
+//
+// Two plans of the panel shape alternate over the steps, so the uploads of
+// step n + 1 are queued behind the program of step n and the dispatcher moves
+// them while it runs. A host thread reads and tilizes the panels of step n + 2
+// meanwhile. A panel already on the plan from an earlier step is not uploaded
+// again (e.g. A when K is not split and N has one panel).
+//
+// When K is split the partial C panels are added on the host in fp32 and the
+// sum is rounded to bfloat16 once, after the last K panel.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace matmul {
+
+// Row-major bfloat16 matrix in a file, mapped read-only, or read-write and sized by open()
+struct MappedMatrix {
+    std::string path;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    bfloat16* data = nullptr;
+    size_t size = 0;  // bytes
+
+    MappedMatrix() = default;
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+    MappedMatrix(MappedMatrix&& other) noexcept;
+    MappedMatrix& operator=(MappedMatrix&& other) noexcept;
+    ~MappedMatrix();
+
+    const bfloat16* row(uint32_t r) const { return data + size_t(r) * cols; }
+    bfloat16* row(uint32_t r) { return data + size_t(r) * cols; }
+};
+
+// Throws when a read-only file does not hold rows x cols bfloat16 values
+MappedMatrix map_matrix(const std::string& path, uint32_t rows, uint32_t cols, bool writable);
+
+struct OutOfCoreOptions {
+    std::string variant = "multi_core_reuse_mcast";  // plan_variants() name
+    uint32_t panel_m = 0;                            // elements, 0: planned
+    uint32_t panel_n = 0;
+    uint32_t panel_k = 0;
+    double dram_fraction = 0.75;        // of the device DRAM, for the operands of both plans
+    uint32_t max_output_tiles = 30720;  // per panel
+};
+
+struct OutOfCoreLayout {
+    MatmulShape shape;
+    MatmulShape panel;
+    uint32_t num_m = 1;  // panels along each dimension
+    uint32_t num_n = 1;
+    uint32_t num_k = 1;
+    uint64_t panel_bytes = 0;  // A, B and C of one panel on the device
+
+    uint64_t steps() const { return uint64_t(num_m) * num_n * num_k; }
+};
+
+/*
+ * Panels of at most options.dram_fraction of the device DRAM for two plans, shrunk further until
+ * supports_panel (the supports_shape of options.variant on the device) accepts them
+ */
+OutOfCoreLayout plan_out_of_core(
+    const MatmulShape& shape,
+    uint64_t device_dram_bytes,
+    const OutOfCoreOptions& options,
+    const std::function<bool(const MatmulShape&)>& supports_panel);
+
+struct OutOfCoreStats {
+    OutOfCoreLayout layout;
+    uint64_t a_uploads = 0;
+    uint64_t b_uploads = 0;
+    uint64_t upload_bytes = 0;
+    double total_ms = 0;
+    double plan_ms = 0;
+    double prepare_wait_ms = 0;  // waiting for the host thread to read and tilize panels
+    double device_wait_ms = 0;   // blocked on the output reads
+    double accumulate_ms = 0;    // untilize, fp32 accumulation and stores to C
+};
+
+/*
+ * C = A * B with A [M, K], B [K, N] and C [M, N] row-major in mapped files. C is written panel by panel, only
+ * once its last K panel is in.
+ */
+OutOfCoreStats matmul_out_of_core(
+    tt::tt_metal::Device* device,
+    const MappedMatrix& a,
+    const MappedMatrix& b,
+    MappedMatrix& c,
+    const OutOfCoreOptions& options);
+
+}  // namespace matmul
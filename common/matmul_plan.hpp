@@ -0,0 +1,217 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/assert.hpp"
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/impl/device/device.hpp"
+#include "tt_metal/impl/dispatch/command_queue.hpp"
+
+#include "trace_zones.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Plan / execute API of the matmul variants, linked as the tt_matmul library
+// (bench/CMakeLists.txt).
+//
+// A MatmulPlan is created once per shape, data formats and core grid: it owns
+// the program with its kernels, circular buffers and runtime args, and the
+// DRAM buffers the runtime args point at. execute() only moves data and runs
+// the program, so a plan reused over many calls pays for the program build and
+// the kernel compilation once.
+//
+// Host operands are bfloat16 in tile layout (tilize() of tilize_untilize.hpp)
+// unless the plan takes row-major ones (multi_core_reuse_mcast tilize_in /
+// untilize_out). Variants with Bfp operands pack and unpack them in their
+// hooks, the caller always sees bfloat16.
+//
+// Usage example:
+//     auto plan = matmul::create_plan(device, "multi_core_reuse_mcast", {.M = 1024, .N = 1024, .K = 1024});
+//     for (auto& [a, b] : batches) {
+//         matmul::execute(plan, a, b, c);
+//     }
+////////////////////////////////////////////////////////////////////////////////
+
+namespace matmul {
+
+struct MatmulShape {
+    uint32_t M = 0;
+    uint32_t N = 0;
+    uint32_t K = 0;
+    uint32_t B = 1;            // batches of in0 and the output
+    bool bcast_batch = false;  // one in1 for all the batches
+};
+
+struct MatmulPlan {
+    std::string variant;
+    MatmulShape shape;
+    tt::tt_metal::Device* device = nullptr;
+    uint32_t grid_x = 1;  // cores used by the program
+    uint32_t grid_y = 1;
+    tt::DataFormat in0_format = tt::DataFormat::Float16_b;
+    tt::DataFormat in1_format = tt::DataFormat::Float16_b;
+    tt::DataFormat out_format = tt::DataFormat::Float16_b;
+    MathFidelity math_fidelity = MathFidelity::HiFi4;
+
+    std::shared_ptr<void> state;               // variant program, buffers and packing scratch
+    tt::tt_metal::Program* program = nullptr;  // owned by state
+
+    // Non-blocking uploads: the host vectors must live until the next blocking read
+    std::function<void(tt::tt_metal::CommandQueue&, const std::vector<bfloat16>&)> write_a;
+    std::function<void(tt::tt_metal::CommandQueue&, const std::vector<bfloat16>&)> write_b;
+    std::function<void(tt::tt_metal::CommandQueue&, const std::vector<bfloat16>&)> write_bias;  // fused bias only
+    // Blocking read of the output, after the program
+    std::function<void(tt::tt_metal::CommandQueue&, std::vector<bfloat16>&)> read_c;
+};
+
+inline const char* dtype_name(tt::DataFormat data_format) {
+    switch (data_format) {
+        case tt::DataFormat::Float16_b: return "BFLOAT16";
+        case tt::DataFormat::Bfp8_b: return "BFLOAT8_B";
+        case tt::DataFormat::Bfp4_b: return "BFLOAT4_B";
+        default: return "other";
+    }
+}
+
+inline const char* math_fidelity_name(MathFidelity math_fidelity) {
+    switch (math_fidelity) {
+        case MathFidelity::LoFi: return "LoFi";
+        case MathFidelity::HiFi2: return "HiFi2";
+        case MathFidelity::HiFi3: return "HiFi3";
+        case MathFidelity::HiFi4: return "HiFi4";
+        default: return "other";
+    }
+}
+
+// Plain bfloat16 operand hooks
+inline void write_bfloat16(
+    tt::tt_metal::CommandQueue& cq,
+    const std::shared_ptr<tt::tt_metal::Buffer>& buffer,
+    const std::vector<bfloat16>& host) {
+    tt::tt_metal::EnqueueWriteBuffer(cq, buffer, host.data(), false);
+}
+inline void read_bfloat16(
+    tt::tt_metal::CommandQueue& cq,
+    const std::shared_ptr<tt::tt_metal::Buffer>& buffer,
+    std::vector<bfloat16>& host) {
+    tt::tt_metal::EnqueueReadBuffer(cq, buffer, host.data(), true);
+}
+
+/*
+ * Uploads both operands without waiting for them. Weights that don't change between calls can be written once
+ * with plan.write_b and followed by run() alone.
+ */
+inline void write_inputs(MatmulPlan& plan, const std::vector<bfloat16>& a, const std::vector<bfloat16>& b) {
+    const MatmulShape& shape = plan.shape;
+    TT_FATAL(
+        a.size() == size_t(shape.B) * shape.M * shape.K,
+        "{}: A has {} values, expected {}",
+        plan.variant,
+        a.size(),
+        size_t(shape.B) * shape.M * shape.K);
+    TT_FATAL(
+        b.size() == size_t(shape.bcast_batch ? 1 : shape.B) * shape.K * shape.N,
+        "{}: B has {} values, expected {}",
+        plan.variant,
+        b.size(),
+        size_t(shape.bcast_batch ? 1 : shape.B) * shape.K * shape.N);
+    tt::tt_metal::CommandQueue& cq = plan.device->command_queue();
+    TRACE_ZONE("upload");
+    plan.write_a(cq, a);
+    plan.write_b(cq, b);
+}
+
+// Tilized [32, N] bias, row 0 used, of plans with a fused bias epilogue
+inline void write_bias(MatmulPlan& plan, const std::vector<bfloat16>& bias) {
+    TT_FATAL(plan.write_bias, "{}: the plan has no fused bias", plan.variant);
+    TRACE_ZONE("upload");
+    plan.write_bias(plan.device->command_queue(), bias);
+}
+
+// EnqueueProgram on the operands already on the device, then the blocking output read
+inline void run(MatmulPlan& plan, std::vector<bfloat16>& c) {
+    tt::tt_metal::CommandQueue& cq = plan.device->command_queue();
+    c.resize(size_t(plan.shape.B) * plan.shape.M * plan.shape.N);
+    {
+        TRACE_ZONE("enqueue");
+        tt::tt_metal::EnqueueProgram(cq, *plan.program, false);
+    }
+    TRACE_ZONE("readback");  // waits for the uploads and the program
+    plan.read_c(cq, c);
+}
+
+// C = A * B with the program, buffers and runtime args of the plan
+inline void execute(
+    MatmulPlan& plan, const std::vector<bfloat16>& a, const std::vector<bfloat16>& b, std::vector<bfloat16>& c) {
+    write_inputs(plan, a, b);
+    run(plan, c);
+}
+
+}  // namespace matmul
+
+// Default plans of the variants: bfloat16 operands, HiFi4, the variant's own grid. supports_shape tells whether
+// the default plan of a shape can be built on the device, so callers that pick shapes (out-of-core panels) can
+// check them up front instead of failing in make_plan
+namespace single_core {
+matmul::MatmulPlan make_plan(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+bool supports_shape(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+}
+namespace multi_core {
+matmul::MatmulPlan make_plan(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+bool supports_shape(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+}
+namespace multi_core_reuse {
+matmul::MatmulPlan make_plan(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+bool supports_shape(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+}
+namespace multi_core_reuse_mcast {
+matmul::MatmulPlan make_plan(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+bool supports_shape(tt::tt_metal::Device* device, const matmul::MatmulShape& shape);
+}
+
+namespace matmul {
+
+using MakePlan = MatmulPlan (*)(tt::tt_metal::Device*, const MatmulShape&);
+using SupportsShape = bool (*)(tt::tt_metal::Device*, const MatmulShape&);
+
+struct PlanVariant {
+    std::string name;
+    MakePlan make_plan;
+    SupportsShape supports_shape;
+};
+
+inline const std::vector<PlanVariant>& plan_variants() {
+    static const std::vector<PlanVariant> variants = {
+        {"single_core", single_core::make_plan, single_core::supports_shape},
+        {"multi_core", multi_core::make_plan, multi_core::supports_shape},
+        {"multi_core_reuse", multi_core_reuse::make_plan, multi_core_reuse::supports_shape},
+        {"multi_core_reuse_mcast", multi_core_reuse_mcast::make_plan, multi_core_reuse_mcast::supports_shape},
+    };
+    return variants;
+}
+
+inline const PlanVariant& plan_variant(const std::string& variant) {
+    for (const auto& plan_variant : plan_variants()) {
+        if (plan_variant.name == variant) {
+            return plan_variant;
+        }
+    }
+    TT_THROW("Unknown matmul variant {}", variant);
+}
+
+// Default plan of a variant by name, only for binaries that link all of them (tt_matmul)
+inline MatmulPlan create_plan(tt::tt_metal::Device* device, const std::string& variant, const MatmulShape& shape) {
+    const PlanVariant& plan_variant = matmul::plan_variant(variant);
+    TRACE_ZONE("plan");
+    return plan_variant.make_plan(device, shape);
+}
+
+}  // namespace matmul
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "tt_metal/common/bfloat16.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Sampled CPU reference of the matmul drivers. A full host reference of a
+// 3072^3 (or an out-of-core) matmul is too slow, so the expected output is
+// computed in fp32 on a random sample of output elements only, and compared
+// with the device output by Pearson correlation (PCC).
+//
+// The operands are read through accessors a(m, k), b(k, n) and c(m, n) of the
+// row-major values, so the same check serves bfloat16 vectors, unpacked Bfp
+// values and memory mapped files. The sample is drawn from a fixed seed: two
+// runs of a driver check the same elements.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace matmul {
+
+constexpr float VALIDATION_PCC = 0.99f;
+constexpr uint32_t VALIDATION_SAMPLES = 4096;
+
+// Maps the fp32 dot product of output column n to the expected output, e.g. bias and activation
+using ReferenceEpilogue = std::function<float(float acc, uint32_t n)>;
+
+// PCC of the sampled reference against the sampled output, 1 when both are the same constant
+inline double pearson(const std::vector<double>& golden, const std::vector<double>& result) {
+    double golden_mean = 0, result_mean = 0;
+    for (size_t i = 0; i < golden.size(); i++) {
+        golden_mean += golden[i] / golden.size();
+        result_mean += result[i] / result.size();
+    }
+    double cov = 0, golden_var = 0, result_var = 0;
+    for (size_t i = 0; i < golden.size(); i++) {
+        cov += (golden[i] - golden_mean) * (result[i] - result_mean);
+        golden_var += (golden[i] - golden_mean) * (golden[i] - golden_mean);
+        result_var += (result[i] - result_mean) * (result[i] - result_mean);
+    }
+    if (golden_var == 0 or result_var == 0) {
+        return golden == result ? 1.0 : 0.0;
+    }
+    return cov / std::sqrt(golden_var * result_var);
+}
+
+/*
+ * PCC of C = epilogue(A * B) on num_samples random output elements, A [M, K], B [K, N] and C [M, N] read through
+ * a(m, k), b(k, n) and c(m, n)
+ */
+template <typename InA, typename InB, typename Out>
+double sampled_pcc(
+    const InA& a,
+    const InB& b,
+    const Out& c,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t num_samples = VALIDATION_SAMPLES,
+    const ReferenceEpilogue& epilogue = {}) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<uint32_t> row_dist(0, M - 1);
+    std::uniform_int_distribution<uint32_t> col_dist(0, N - 1);
+    std::vector<double> golden(num_samples);
+    std::vector<double> result(num_samples);
+    for (uint32_t i = 0; i < num_samples; i++) {
+        uint32_t m = row_dist(rng);
+        uint32_t n = col_dist(rng);
+        float acc = 0;
+        for (uint32_t k = 0; k < K; k++) {
+            acc += float(a(m, k)) * float(b(k, n));
+        }
+        golden[i] = epilogue ? epilogue(acc, n) : acc;
+        result[i] = float(c(m, n));
+    }
+    return pearson(golden, result);
+}
+
+// Row-major bfloat16 operands of one batch
+inline double sampled_pcc(
+    const std::vector<bfloat16>& a,
+    const std::vector<bfloat16>& b,
+    const std::vector<bfloat16>& c,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t num_samples = VALIDATION_SAMPLES,
+    const ReferenceEpilogue& epilogue = {}) {
+    return sampled_pcc(
+        [&a, K](uint32_t m, uint32_t k) { return a[size_t(m) * K + k].to_float(); },
+        [&b, N](uint32_t k, uint32_t n) { return b[size_t(k) * N + n].to_float(); },
+        [&c, N](uint32_t m, uint32_t n) { return c[size_t(m) * N + n].to_float(); },
+        M,
+        N,
+        K,
+        num_samples,
+        epilogue);
+}
+
+}  // namespace matmul
@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/detail/tt_metal.hpp"
+#include "tt_metal/impl/device/device.hpp"
+
+#include "matmul_bench.hpp"
+#include "matmul_plan.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Entry points of the matmul variants for the benchmark harness (bench/).
+// Each variant lives in its own namespace so all of them link into one binary;
+// their main() is left out when MATMUL_NO_MAIN is defined.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace matmul_bench {
+
+// Operands shared by every variant: batch 1, bfloat16, tilized with tilize() of tilize_untilize.hpp
+struct MatmulInputs {
+    uint32_t M = 0;
+    uint32_t N = 0;
+    uint32_t K = 0;
+    std::vector<bfloat16> a;
+    std::vector<bfloat16> b;
+};
+
+/*
+ * One matmul set up on the device: program, buffers and runtime args are created by make_bench_runner,
+ * the callables only move data and run the program. All of them block until the device is done.
+ * The runner keeps a reference to the inputs, they must outlive it.
+ */
+struct MatmulRunner {
+    BenchCase bench_case;  // grid, dtype, fidelity and storage filled in by the variant
+    std::function<void()> write_in0;
+    std::function<void()> write_in1;
+    std::function<void()> compile;                  // JIT build of the kernels, the first run does it otherwise
+    std::function<void()> enqueue;                  // EnqueueProgram alone, non-blocking
+    std::function<void()> run;                      // EnqueueProgram + output read
+    std::function<std::vector<bfloat16>()> output;  // tilized, after run
+};
+
+// Runner on a plan of the variant, the uploads wait for the device
+inline MatmulRunner make_plan_runner(matmul::MatmulPlan plan, const MatmulInputs& inputs) {
+    auto shared_plan = std::make_shared<matmul::MatmulPlan>(std::move(plan));
+    auto output = std::make_shared<std::vector<bfloat16>>(inputs.M * inputs.N);
+    tt::tt_metal::CommandQueue& cq = shared_plan->device->command_queue();
+
+    MatmulRunner runner;
+    runner.bench_case.grid_x = shared_plan->grid_x;
+    runner.bench_case.grid_y = shared_plan->grid_y;
+    runner.bench_case.dtype = matmul::dtype_name(shared_plan->in1_format);
+    runner.bench_case.math_fidelity = matmul::math_fidelity_name(shared_plan->math_fidelity);
+    runner.write_in0 = [&cq, shared_plan, &inputs] {
+        TRACE_ZONE("upload");
+        shared_plan->write_a(cq, inputs.a);
+        tt::tt_metal::Finish(cq);
+    };
+    runner.write_in1 = [&cq, shared_plan, &inputs] {
+        TRACE_ZONE("upload");
+        shared_plan->write_b(cq, inputs.b);
+        tt::tt_metal::Finish(cq);
+    };
+    runner.compile = [shared_plan] {
+        tt::tt_metal::detail::CompileProgram(shared_plan->device, *shared_plan->program);
+    };
+    runner.enqueue = [&cq, shared_plan] {
+        TRACE_ZONE("enqueue");
+        tt::tt_metal::EnqueueProgram(cq, *shared_plan->program, false);
+    };
+    runner.run = [shared_plan, output] { matmul::run(*shared_plan, *output); };
+    runner.output = [output] { return *output; };
+    return runner;
+}
+
+}  // namespace matmul_bench
+
+namespace single_core {
+matmul_bench::MatmulRunner make_bench_runner(tt::tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs);
+}
+namespace multi_core {
+matmul_bench::MatmulRunner make_bench_runner(tt::tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs);
+}
+namespace multi_core_reuse {
+matmul_bench::MatmulRunner make_bench_runner(tt::tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs);
+}
+namespace multi_core_reuse_mcast {
+matmul_bench::MatmulRunner make_bench_runner(tt::tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs);
+}
+namespace compute_mm {
+matmul_bench::MatmulRunner make_bench_runner(tt::tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs);
+}
+namespace block_sparse {
+// Tile occupancy of B taken from inputs.b
+matmul_bench::MatmulRunner make_bench_runner(tt::tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs);
+}
+
+namespace matmul_bench {
+
+using MakeRunner = MatmulRunner (*)(tt::tt_metal::Device*, const MatmulInputs&);
+
+// Every variant by name, only for binaries that link all of them (bench/)
+inline const std::vector<std::pair<std::string, MakeRunner>>& all_variants() {
+    static const std::vector<std::pair<std::string, MakeRunner>> variants = {
+        {"single_core", single_core::make_bench_runner},
+        {"multi_core", multi_core::make_bench_runner},
+        {"multi_core_reuse", multi_core_reuse::make_bench_runner},
+        {"multi_core_reuse_mcast", multi_core_reuse_mcast::make_bench_runner},
+        {"test_compute_mm", compute_mm::make_bench_runner},
+        {"block_sparse", block_sparse::make_bench_runner},
+    };
+    return variants;
+}
+
+}  // namespace matmul_bench
@@ -0,0 +1,343 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Scoped timeline zones of the host phases (plan, tilize, upload, enqueue,
+// finish, readback, untilize, validate), exported as a Chrome trace JSON that
+// opens in Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+//   TRACE_ZONE("tilize");  // from here to the end of the scope, on this thread
+//
+// Tracing is off unless enable() is called, e.g. by enable_from_env() when
+// MATMUL_TRACE=<path> is set. A disabled zone costs one relaxed atomic load;
+// building with MATMUL_TRACE_OFF removes the zones altogether. Enabled zones
+// are appended to a buffer of their own thread, the lock is only contended
+// while the trace is written.
+//
+// Host zones are on pid 0 in microseconds since the start of the process.
+// profiler-analyzer --chrome-trace merges them with the device zones of
+// profile_log_device.csv (see profiler_analyzer/chrome_trace.hpp).
+////////////////////////////////////////////////////////////////////////////////
+
+namespace timeline {
+
+constexpr uint32_t HOST_PID = 0;
+
+struct TraceEvent {
+    std::string name;
+    std::string category;
+    uint32_t pid = HOST_PID;
+    uint32_t tid = 0;
+    double ts_us = 0;
+    double dur_us = 0;
+};
+
+// Name of a timeline row, Chrome trace "process_name" / "thread_name" metadata
+struct TraceTrack {
+    uint32_t pid = HOST_PID;
+    uint32_t tid = 0;
+    std::string process_name;
+    std::string thread_name;
+};
+
+inline std::atomic<bool> tracing_enabled{false};
+inline const std::chrono::steady_clock::time_point trace_epoch = std::chrono::steady_clock::now();
+
+inline bool enabled() { return tracing_enabled.load(std::memory_order_relaxed); }
+
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_epoch)
+        .count();
+}
+
+class TraceRecorder {
+   public:
+    static TraceRecorder& instance() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    void record(const char* name, const char* category, int64_t start_ns, int64_t end_ns) {
+        ThreadBuffer& buffer = thread_buffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.zones.push_back({name, category, start_ns, end_ns});
+    }
+
+    void set_thread_name(const std::string& name) {
+        ThreadBuffer& buffer = thread_buffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.name = name;
+    }
+
+    // Zones of every thread so far, by start time
+    std::vector<TraceEvent> events() {
+        std::vector<TraceEvent> events;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            for (const Zone& zone : buffer->zones) {
+                events.push_back(
+                    {zone.name, zone.category, HOST_PID, buffer->tid, zone.start_ns / 1e3,
+                     (zone.end_ns - zone.start_ns) / 1e3});
+            }
+        }
+        std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+            return a.ts_us < b.ts_us;
+        });
+        return events;
+    }
+
+    std::vector<TraceTrack> tracks() {
+        std::vector<TraceTrack> tracks;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            tracks.push_back({HOST_PID, buffer->tid, "host", buffer->name});
+        }
+        return tracks;
+    }
+
+   private:
+    struct Zone {
+        const char* name;
+        const char* category;
+        int64_t start_ns;
+        int64_t end_ns;
+    };
+    struct ThreadBuffer {
+        uint32_t tid = 0;
+        std::string name;
+        std::vector<Zone> zones;
+        std::mutex mutex;
+    };
+
+    // Buffers are owned by the recorder so the zones of a thread outlive it
+    ThreadBuffer& thread_buffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>());
+            buffer = buffers_.back().get();
+            buffer->tid = buffers_.size();
+            buffer->name = "thread " + std::to_string(buffer->tid);
+        }
+        return *buffer;
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+inline void enable(bool on = true) { tracing_enabled.store(on, std::memory_order_relaxed); }
+
+/*
+ * Turns tracing on when MATMUL_TRACE is set, returns the path the trace should be written to (empty otherwise).
+ * Call it from the main thread, before any worker records a zone, so that the main thread is the first row.
+ */
+inline std::string enable_from_env() {
+    const char* path = std::getenv("MATMUL_TRACE");
+    if (path == nullptr or *path == '\0') {
+        return "";
+    }
+    enable();
+    TraceRecorder::instance().set_thread_name("main");
+    return path;
+}
+
+inline void set_thread_name(const std::string& name) {
+    if (enabled()) {
+        TraceRecorder::instance().set_thread_name(name);
+    }
+}
+
+class TraceZone {
+   public:
+    explicit TraceZone(const char* name, const char* category = "host") {
+        if (enabled()) {
+            name_ = name;
+            category_ = category;
+            start_ns_ = now_ns();
+        }
+    }
+    ~TraceZone() {
+        if (name_ != nullptr) {
+            TraceRecorder::instance().record(name_, category_, start_ns_, now_ns());
+        }
+    }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+   private:
+    const char* name_ = nullptr;  // string literals only, they are kept as pointers until the export
+    const char* category_ = nullptr;
+    int64_t start_ns_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Chrome trace JSON
+////////////////////////////////////////////////////////////////////////////////
+inline std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' or c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+/*
+ * One event per line, so read_chrome_trace can load the files written here without a JSON parser.
+ * Complete ("X") events in microseconds, metadata ("M") events name the rows.
+ */
+inline void write_chrome_trace(
+    std::ostream& out, const std::vector<TraceEvent>& events, const std::vector<TraceTrack>& tracks) {
+    char buf[64];
+    bool first = true;
+    auto begin_event = [&out, &first]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    std::vector<uint32_t> named_pids;
+    for (const TraceTrack& track : tracks) {
+        if (std::find(named_pids.begin(), named_pids.end(), track.pid) == named_pids.end()) {
+            named_pids.push_back(track.pid);
+            begin_event();
+            out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << track.pid
+                << ", \"tid\": 0, \"args\": {\"name\": " << json_string(track.process_name) << "}}";
+        }
+        begin_event();
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << track.pid << ", \"tid\": " << track.tid
+            << ", \"args\": {\"name\": " << json_string(track.thread_name) << "}}";
+        begin_event();
+        out << "{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": " << track.pid
+            << ", \"tid\": " << track.tid << ", \"args\": {\"sort_index\": " << track.tid << "}}";
+    }
+    for (const TraceEvent& event : events) {
+        begin_event();
+        out << "{\"name\": " << json_string(event.name) << ", \"cat\": " << json_string(event.category)
+            << ", \"ph\": \"X\", \"pid\": " << event.pid << ", \"tid\": " << event.tid;
+        std::snprintf(buf, sizeof(buf), ", \"ts\": %.3f, \"dur\": %.3f}", event.ts_us, event.dur_us);
+        out << buf;
+    }
+    out << "\n]}\n";
+}
+
+inline bool write_host_trace(const std::string& path) {
+    std::ofstream out(path);
+    if (not out) {
+        return false;
+    }
+    TraceRecorder& recorder = TraceRecorder::instance();
+    write_chrome_trace(out, recorder.events(), recorder.tracks());
+    return static_cast<bool>(out);
+}
+
+namespace detail {
+
+// Value of "key": in a line written by write_chrome_trace, unescaped
+inline bool find_field(const std::string& line, const std::string& key, std::string& value) {
+    size_t pos = line.find("\"" + key + "\": ");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos += key.size() + 4;
+    value.clear();
+    if (pos < line.size() and line[pos] == '"') {
+        for (pos++; pos < line.size() and line[pos] != '"'; pos++) {
+            if (line[pos] == '\\' and pos + 1 < line.size()) {
+                pos++;
+            }
+            value += line[pos];
+        }
+        return true;
+    }
+    size_t end = line.find_first_of(",}", pos);
+    value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    return true;
+}
+
+}  // namespace detail
+
+/*
+ * Loads a trace written by write_chrome_trace (one event per line). Other Chrome traces are not supported.
+ */
+inline bool read_chrome_trace(std::istream& in, std::vector<TraceEvent>& events, std::vector<TraceTrack>& tracks) {
+    std::string line, name, ph, value;
+    std::vector<std::pair<uint32_t, std::string>> process_names;  // written before the threads of the process
+    bool any = false;
+    while (std::getline(in, line)) {
+        if (not detail::find_field(line, "ph", ph) or not detail::find_field(line, "name", name)) {
+            continue;
+        }
+        any = true;
+        std::string pid, tid;
+        detail::find_field(line, "pid", pid);
+        detail::find_field(line, "tid", tid);
+        uint32_t pid_value = std::strtoul(pid.c_str(), nullptr, 10);
+        uint32_t tid_value = std::strtoul(tid.c_str(), nullptr, 10);
+        if (ph == "X") {
+            TraceEvent event;
+            event.name = name;
+            detail::find_field(line, "cat", event.category);
+            event.pid = pid_value;
+            event.tid = tid_value;
+            detail::find_field(line, "ts", value);
+            event.ts_us = std::strtod(value.c_str(), nullptr);
+            detail::find_field(line, "dur", value);
+            event.dur_us = std::strtod(value.c_str(), nullptr);
+            events.push_back(std::move(event));
+        } else if (ph == "M" and (name == "process_name" or name == "thread_name")) {
+            // args are {"name": ...}, the last "name" of the line
+            size_t args = line.find("\"args\"");
+            if (args == std::string::npos or not detail::find_field(line.substr(args), "name", value)) {
+                continue;
+            }
+            if (name == "process_name") {
+                process_names.push_back({pid_value, value});
+                continue;
+            }
+            auto process = std::find_if(process_names.begin(), process_names.end(), [pid_value](const auto& p) {
+                return p.first == pid_value;
+            });
+            tracks.push_back({pid_value, tid_value, process != process_names.end() ? process->second : "", value});
+        }
+    }
+    return any;
+}
+
+}  // namespace timeline
+
+#ifdef MATMUL_TRACE_OFF
+#define TRACE_ZONE(...)
+#else
+#define TRACE_ZONE_CONCAT_(a, b) a##b
+#define TRACE_ZONE_CONCAT(a, b) TRACE_ZONE_CONCAT_(a, b)
+#define TRACE_ZONE(...) ::timeline::TraceZone TRACE_ZONE_CONCAT(trace_zone_, __LINE__)(__VA_ARGS__)
+#endif
@@ -0,0 +1,791 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// Discrete-event performance model of the 2D multicast matmul
+// (matmul_multicore_reuse_mcast). It replays the dataflow of the
+// reader_bmm_tile_layout_in0_{sender,receiver}_in1_{sender,receiver} kernels,
+// bmm_large_block_zm and writer_bmm_tile_layout on every core:
+//
+//   - left column reads in0 blocks from DRAM and multicasts them along its row,
+//     top row reads in1 blocks from DRAM and multicasts them down its column;
+//   - receivers reserve CB space, increment the sender semaphore and wait for
+//     the VALID flag; senders wait for all receivers before multicasting;
+//   - in0/in1 CBs hold `cb_depth` blocks (2 = double buffer), compute pops a
+//     block only after the whole in0_block_w x per_core_M x per_core_N update;
+//   - DRAM banks and per-core NOC links are FIFO servers with a fixed
+//     bandwidth, so cores contend for the same banks in time order.
+//
+// Times are in device cycles. With --profile-log the prediction is compared
+// with a device profiler log (profile_log_device.csv), using the same
+// "t0 to any riscfw end" definition as test_compute_mm.
+//
+// Usage example:
+//   ./mcast-sim --m 3072 --n 3072 --k 3072 --arch wormhole_b0 --dtype bf16 --fidelity hifi4
+//   ./mcast-sim --preset compute_mm_gs --profile-log <path>/profile_log_device.csv
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr uint32_t TILE_HW = 32;
+
+enum class Fidelity : uint32_t { LoFi = 1, HiFi2 = 2, HiFi3 = 3, HiFi4 = 4 };
+
+struct ArchParams {
+    string name;
+    double clock_mhz;
+    uint32_t num_dram_banks;
+    double dram_bank_bytes_per_cycle;
+    uint32_t dram_latency_cycles;
+    double noc_bytes_per_cycle;
+    uint32_t noc_hop_cycles;
+    uint32_t semaphore_cycles;
+    uint32_t lofi_cycles_per_tile;  // one 32x32x32 tile matmul, multiplied by the number of fidelity phases
+    uint32_t pack_cycles_per_tile;  // spill or reload of one partial tile through c_24
+};
+
+struct SimConfig {
+    ArchParams arch;
+    uint32_t Mt = 0;
+    uint32_t Nt = 0;
+    uint32_t Kt = 0;
+    uint32_t num_cores_r = 8;
+    uint32_t num_cores_c = 8;
+    uint32_t per_core_M = 0;
+    uint32_t per_core_N = 0;
+    uint32_t in0_block_w = 0;
+    uint32_t out_subblock_h = 1;
+    uint32_t out_subblock_w = 1;
+    uint32_t tile_size = 2048;
+    uint32_t cb_depth = 2;
+    Fidelity fidelity = Fidelity::HiFi4;
+    // Operand blocks are already resident in local L1 (test_compute_mm trick): no DRAM reads, no mcast
+    bool l1_resident = false;
+};
+
+ArchParams get_arch_params(const string& arch) {
+    // Bank bandwidth/latency are sustained numbers for interleaved tile reads, not datasheet peaks
+    if (arch == "grayskull") {
+        return {"grayskull", 1000, 8, 12.0, 350, 32.0, 9, 120, 32, 16};
+    } else if (arch == "blackhole") {
+        return {"blackhole", 1350, 8, 48.0, 300, 64.0, 9, 100, 16, 8};
+    }
+    return {"wormhole_b0", 1000, 12, 20.0, 300, 32.0, 9, 100, 16, 8};
+}
+
+uint32_t get_tile_size(const string& dtype) {
+    if (dtype == "bfp8") {
+        return 1088;
+    } else if (dtype == "bfp4") {
+        return 576;
+    }
+    return 2048;
+}
+
+Fidelity get_fidelity(const string& fidel) {
+    if (fidel == "lofi") {
+        return Fidelity::LoFi;
+    } else if (fidel == "hifi2") {
+        return Fidelity::HiFi2;
+    } else if (fidel == "hifi3") {
+        return Fidelity::HiFi3;
+    }
+    return Fidelity::HiFi4;
+}
+
+constexpr std::array<std::tuple<uint32_t, uint32_t>, 20> SUBBLOCK_HW_CHOICES = {{
+    {4, 2}, {2, 4}, {8, 1}, {1, 8}, {7, 1}, {1, 7}, {3, 2}, {2, 3}, {6, 1}, {1, 6},
+    {5, 1}, {1, 5}, {2, 2}, {4, 1}, {1, 4}, {3, 1}, {1, 3}, {2, 1}, {1, 2}, {1, 1},
+}};
+
+std::tuple<uint32_t, uint32_t> get_subblock_sizes(uint32_t m_tiles_per_core, uint32_t n_tiles_per_core) {
+    for (auto& subblock_hw : SUBBLOCK_HW_CHOICES) {
+        auto out_subblock_h = std::get<0>(subblock_hw);
+        auto out_subblock_w = std::get<1>(subblock_hw);
+        if (m_tiles_per_core % out_subblock_h == 0 and n_tiles_per_core % out_subblock_w == 0) {
+            return {out_subblock_h, out_subblock_w};
+        }
+    }
+    return {1, 1};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Event Engine
+////////////////////////////////////////////////////////////////////////////////
+class EventQueue {
+public:
+    void schedule(double time, std::function<void()> fn) { events_.push({time, seq_++, std::move(fn)}); }
+
+    double now() const { return now_; }
+
+    void run() {
+        while (not events_.empty()) {
+            Event event = events_.top();
+            events_.pop();
+            now_ = event.time;
+            event.fn();
+        }
+    }
+
+private:
+    struct Event {
+        double time;
+        uint64_t seq;
+        std::function<void()> fn;
+        bool operator>(const Event& other) const {
+            return time != other.time ? time > other.time : seq > other.seq;
+        }
+    };
+    std::priority_queue<Event, vector<Event>, std::greater<Event>> events_;
+    double now_ = 0;
+    uint64_t seq_ = 0;
+};
+
+// Waiters re-check their own condition when notified
+struct Signal {
+    vector<std::function<void()>> waiters;
+    void wait(std::function<void()> fn) { waiters.push_back(std::move(fn)); }
+    void notify() {
+        auto pending = std::move(waiters);
+        waiters.clear();
+        for (auto& fn : pending) {
+            fn();
+        }
+    }
+};
+
+struct CircularBuffer {
+    uint32_t capacity = 2;  // in blocks
+    uint32_t reserved = 0;
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    Signal space;
+    Signal data;
+
+    bool can_reserve() const { return reserved - popped < capacity; }
+};
+
+enum class Role { Sender, Receiver, Local };
+
+struct CoreStats {
+    double compute_busy = 0;
+    double stall_in0 = 0;  // compute waiting on in0 block
+    double stall_in1 = 0;  // compute waiting on in1 block
+    double reader_cb_full = 0;
+    double reader_sem_wait = 0;  // senders: waiting for receivers ready, receivers: waiting for VALID
+    double reader_dram = 0;
+    double writer = 0;
+    double compute_end = 0;
+    double kernel_end = 0;
+};
+
+struct CoreState {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    Role role[2] = {Role::Receiver, Role::Receiver};
+    CircularBuffer cb[2];
+    // mcast semaphores, indexed by operand
+    uint32_t sender_sem[2] = {0, 0};
+    Signal sender_sem_signal[2];
+    bool receiver_valid[2] = {false, false};
+    Signal receiver_valid_signal[2];
+    // reader program counter
+    uint32_t reader_block = 0;
+    uint32_t reader_op = 0;
+    uint32_t reader_phase = 0;
+    double wait_start = 0;
+    // compute program counter
+    uint32_t compute_block = 0;
+    bool compute_waiting = false;
+    uint32_t compute_wait_op = 0;
+    double compute_wait_start = 0;
+    // writer
+    double writer_free = 0;
+    // NOC links
+    double ingress_free = 0;
+    double egress_free = 0;
+    CoreStats stats;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Simulator
+////////////////////////////////////////////////////////////////////////////////
+class McastMatmulSim {
+public:
+    explicit McastMatmulSim(const SimConfig& config) : cfg_(config) {
+        num_blocks_ = cfg_.Kt / cfg_.in0_block_w;
+        bank_free_.assign(cfg_.arch.num_dram_banks, 0.0);
+        cores_.resize(cfg_.num_cores_r * cfg_.num_cores_c);
+        for (uint32_t y = 0; y < cfg_.num_cores_r; y++) {
+            for (uint32_t x = 0; x < cfg_.num_cores_c; x++) {
+                CoreState& core = get_core(x, y);
+                core.x = x;
+                core.y = y;
+                if (cfg_.l1_resident) {
+                    core.role[0] = Role::Local;
+                    core.role[1] = Role::Local;
+                } else {
+                    core.role[0] = x == 0 ? Role::Sender : Role::Receiver;
+                    core.role[1] = y == 0 ? Role::Sender : Role::Receiver;
+                }
+                core.cb[0].capacity = cfg_.cb_depth;
+                core.cb[1].capacity = cfg_.cb_depth;
+            }
+        }
+    }
+
+    void run() {
+        for (auto& core : cores_) {
+            CoreState* c = &core;
+            queue_.schedule(0, [this, c] { reader_step(*c); });
+            queue_.schedule(0, [this, c] { compute_step(*c); });
+        }
+        queue_.run();
+    }
+
+    const vector<CoreState>& cores() const { return cores_; }
+    uint32_t num_blocks() const { return num_blocks_; }
+
+    double end_to_end() const {
+        double end = 0;
+        for (const auto& core : cores_) {
+            end = std::max(end, core.stats.kernel_end);
+        }
+        return end;
+    }
+
+private:
+    CoreState& get_core(uint32_t x, uint32_t y) { return cores_[y * cfg_.num_cores_c + x]; }
+
+    uint32_t block_tiles(uint32_t op) const {
+        return op == 0 ? cfg_.per_core_M * cfg_.in0_block_w : cfg_.per_core_N * cfg_.in0_block_w;
+    }
+
+    uint32_t num_dests(uint32_t op) const { return op == 0 ? cfg_.num_cores_c - 1 : cfg_.num_cores_r - 1; }
+
+    CoreState& sender_of(const CoreState& core, uint32_t op) {
+        return op == 0 ? get_core(0, core.y) : get_core(core.x, 0);
+    }
+
+    // Same tile ids as the reader kernels: in0 rows of Kt tiles, in1 rows of Nt tiles
+    vector<uint32_t> block_tile_ids(const CoreState& core, uint32_t op, uint32_t block) const {
+        vector<uint32_t> ids;
+        ids.reserve(block_tiles(op));
+        if (op == 0) {
+            uint32_t start = cfg_.Kt * cfg_.per_core_M * core.y + block * cfg_.in0_block_w;
+            for (uint32_t h = 0; h < cfg_.per_core_M; h++) {
+                for (uint32_t w = 0; w < cfg_.in0_block_w; w++) {
+                    ids.push_back(start + h * cfg_.Kt + w);
+                }
+            }
+        } else {
+            uint32_t start = cfg_.per_core_N * core.x + block * cfg_.in0_block_w * cfg_.Nt;
+            for (uint32_t h = 0; h < cfg_.in0_block_w; h++) {
+                for (uint32_t w = 0; w < cfg_.per_core_N; w++) {
+                    ids.push_back(start + h * cfg_.Nt + w);
+                }
+            }
+        }
+        return ids;
+    }
+
+    // Tiles are issued back to back; each one occupies its bank and then the core's ingress link
+    double dram_read(CoreState& core, const vector<uint32_t>& tile_ids, double now) {
+        const double tile_bank_cycles = cfg_.tile_size / cfg_.arch.dram_bank_bytes_per_cycle;
+        const double tile_link_cycles = cfg_.tile_size / cfg_.arch.noc_bytes_per_cycle;
+        double done = now;
+        for (uint32_t id : tile_ids) {
+            double& bank = bank_free_[id % cfg_.arch.num_dram_banks];
+            bank = std::max(bank, now) + tile_bank_cycles;
+            double arrival = std::max(bank + cfg_.arch.dram_latency_cycles, core.ingress_free + tile_link_cycles);
+            core.ingress_free = arrival;
+            done = std::max(done, arrival);
+        }
+        return done;
+    }
+
+    double dram_write(CoreState& core, const vector<uint32_t>& tile_ids, double now) {
+        const double tile_bank_cycles = cfg_.tile_size / cfg_.arch.dram_bank_bytes_per_cycle;
+        const double tile_link_cycles = cfg_.tile_size / cfg_.arch.noc_bytes_per_cycle;
+        double done = now;
+        for (uint32_t id : tile_ids) {
+            core.egress_free = std::max(core.egress_free, now) + tile_link_cycles;
+            double& bank = bank_free_[id % cfg_.arch.num_dram_banks];
+            bank = std::max(bank, core.egress_free) + tile_bank_cycles;
+            done = std::max(done, bank + cfg_.arch.dram_latency_cycles);
+        }
+        return done;
+    }
+
+    void wake(Signal& signal, CoreState& core, void (McastMatmulSim::*step)(CoreState&)) {
+        CoreState* c = &core;
+        signal.wait([this, c, step] { (this->*step)(*c); });
+    }
+
+    void advance_reader(CoreState& core) {
+        core.reader_phase = 0;
+        if (core.reader_op == 0) {
+            core.reader_op = 1;
+        } else {
+            core.reader_op = 0;
+            core.reader_block++;
+        }
+    }
+
+    // One reader kernel per core handles in0 then in1 for every block, like the mcast reader kernels
+    void reader_step(CoreState& core) {
+        while (core.reader_block < num_blocks_) {
+            const uint32_t op = core.reader_op;
+            CircularBuffer& cb = core.cb[op];
+            const double now = queue_.now();
+            const Role role = core.role[op];
+
+            if (core.reader_phase == 0) {  // cb_reserve_back
+                if (not cb.can_reserve()) {
+                    core.wait_start = now;
+                    core.reader_phase = 10;
+                    wake(cb.space, core, &McastMatmulSim::reader_step);
+                    return;
+                }
+                cb.reserved++;
+                core.reader_phase = 1;
+            } else if (core.reader_phase == 10) {  // woken on CB space
+                if (not cb.can_reserve()) {
+                    wake(cb.space, core, &McastMatmulSim::reader_step);
+                    return;
+                }
+                core.stats.reader_cb_full += now - core.wait_start;
+                core.reader_phase = 0;
+            } else if (role == Role::Local) {
+                if (core.reader_phase == 1) {
+                    double done = now + block_tiles(op) * cfg_.tile_size / cfg_.arch.noc_bytes_per_cycle;
+                    core.reader_phase = 2;
+                    CoreState* c = &core;
+                    queue_.schedule(done, [this, c] { reader_step(*c); });
+                    return;
+                }
+                push_block(core, op);
+                advance_reader(core);
+            } else if (role == Role::Sender) {
+                if (core.reader_phase == 1) {  // read block from DRAM + noc_async_read_barrier
+                    double done = dram_read(core, block_tile_ids(core, op, core.reader_block), now);
+                    core.stats.reader_dram += done - now;
+                    core.reader_phase = 2;
+                    core.wait_start = done;
+                    CoreState* c = &core;
+                    queue_.schedule(done, [this, c] { reader_step(*c); });
+                    return;
+                } else if (core.reader_phase == 2) {  // noc_semaphore_wait(sender_sem, num_dests)
+                    if (core.sender_sem[op] < num_dests(op)) {
+                        wake(core.sender_sem_signal[op], core, &McastMatmulSim::reader_step);
+                        return;
+                    }
+                    core.stats.reader_sem_wait += now - core.wait_start;
+                    core.sender_sem[op] = 0;
+                    multicast(core, op, now);
+                    push_block(core, op);
+                    advance_reader(core);
+                }
+            } else {  // Receiver
+                if (core.reader_phase == 1) {  // set INVALID, noc_semaphore_inc on the sender
+                    core.receiver_valid[op] = false;
+                    CoreState* sender = &sender_of(core, op);
+                    queue_.schedule(now + cfg_.arch.semaphore_cycles, [sender, op] {
+                        sender->sender_sem[op]++;
+                        sender->sender_sem_signal[op].notify();
+                    });
+                    core.wait_start = now;
+                    core.reader_phase = 2;
+                } else if (core.reader_phase == 2) {  // noc_semaphore_wait(receiver_sem, VALID)
+                    if (not core.receiver_valid[op]) {
+                        wake(core.receiver_valid_signal[op], core, &McastMatmulSim::reader_step);
+                        return;
+                    }
+                    core.stats.reader_sem_wait += now - core.wait_start;
+                    push_block(core, op);
+                    advance_reader(core);
+                }
+            }
+        }
+    }
+
+    // Data and VALID flag go out on the sender's egress link; the kernel does not block on them
+    void multicast(CoreState& sender, uint32_t op, double now) {
+        const uint32_t dests = num_dests(op);
+        if (dests == 0) {
+            return;
+        }
+        double bytes = static_cast<double>(block_tiles(op)) * cfg_.tile_size;
+        sender.egress_free = std::max(sender.egress_free, now) + bytes / cfg_.arch.noc_bytes_per_cycle;
+        double flag_arrival = sender.egress_free + dests * cfg_.arch.noc_hop_cycles + cfg_.arch.semaphore_cycles;
+        for (uint32_t i = 1; i <= dests; i++) {
+            CoreState* receiver = op == 0 ? &get_core(i, sender.y) : &get_core(sender.x, i);
+            queue_.schedule(flag_arrival, [receiver, op] {
+                receiver->receiver_valid[op] = true;
+                receiver->receiver_valid_signal[op].notify();
+            });
+        }
+    }
+
+    void push_block(CoreState& core, uint32_t op) {
+        core.cb[op].pushed++;
+        core.cb[op].data.notify();
+    }
+
+    void compute_step(CoreState& core) {
+        if (core.compute_block >= num_blocks_) {
+            return;
+        }
+        const double now = queue_.now();
+        const uint32_t b = core.compute_block;
+        if (core.compute_waiting) {
+            core.compute_waiting = false;
+            double waited = now - core.compute_wait_start;
+            (core.compute_wait_op == 0 ? core.stats.stall_in0 : core.stats.stall_in1) += waited;
+        }
+        // cb_wait_front(in0) then cb_wait_front(in1): a stall is charged to the operand being waited on
+        for (uint32_t op = 0; op < 2; op++) {
+            if (core.cb[op].pushed <= b) {
+                core.compute_waiting = true;
+                core.compute_wait_op = op;
+                core.compute_wait_start = now;
+                wake(core.cb[op].data, core, &McastMatmulSim::compute_step);
+                return;
+            }
+        }
+
+        const uint32_t out_tiles = cfg_.per_core_M * cfg_.per_core_N;
+        double cycles = static_cast<double>(out_tiles) * cfg_.in0_block_w * cfg_.arch.lofi_cycles_per_tile *
+                        static_cast<uint32_t>(cfg_.fidelity);
+        // bmm_large_block_zm spills partials to c_24 on every block but the last and reloads on every block but the first
+        if (num_blocks_ > 1) {
+            if (b != num_blocks_ - 1) {
+                cycles += out_tiles * cfg_.arch.pack_cycles_per_tile;
+            }
+            if (b != 0) {
+                cycles += out_tiles * cfg_.arch.pack_cycles_per_tile;
+            }
+        } else {
+            cycles += out_tiles * cfg_.arch.pack_cycles_per_tile;
+        }
+        core.stats.compute_busy += cycles;
+        double done = now + cycles;
+
+        if (b == num_blocks_ - 1) {
+            schedule_writer(core, now, done);
+        }
+
+        CoreState* c = &core;
+        queue_.schedule(done, [this, c] {
+            for (uint32_t op = 0; op < 2; op++) {
+                c->cb[op].popped++;
+                c->cb[op].space.notify();
+            }
+            c->compute_block++;
+            if (c->compute_block == num_blocks_) {
+                c->stats.compute_end = queue_.now();
+            }
+            compute_step(*c);
+        });
+    }
+
+    // Output subblocks are produced evenly over the last block and drained by the writer one subblock at a time
+    void schedule_writer(CoreState& core, double start, double done) {
+        const uint32_t num_subblocks_h = cfg_.per_core_M / cfg_.out_subblock_h;
+        const uint32_t num_subblocks_w = cfg_.per_core_N / cfg_.out_subblock_w;
+        const uint32_t num_subblocks = num_subblocks_h * num_subblocks_w;
+        const double per_subblock = (done - start) / num_subblocks;
+        const uint32_t out_start = core.x * cfg_.per_core_N + core.y * cfg_.per_core_M * cfg_.Nt;
+        CoreState* c = &core;
+        for (uint32_t sb = 0; sb < num_subblocks; sb++) {
+            uint32_t sbh = sb / num_subblocks_w;
+            uint32_t sbw = sb % num_subblocks_w;
+            vector<uint32_t> ids;
+            for (uint32_t h = 0; h < cfg_.out_subblock_h; h++) {
+                for (uint32_t w = 0; w < cfg_.out_subblock_w; w++) {
+                    ids.push_back(
+                        out_start + (sbh * cfg_.out_subblock_h + h) * cfg_.Nt + sbw * cfg_.out_subblock_w + w);
+                }
+            }
+            queue_.schedule(start + per_subblock * (sb + 1), [this, c, ids] {
+                double now = queue_.now();
+                double begin = std::max(now, c->writer_free);
+                double end = cfg_.l1_resident
+                                 ? begin + ids.size() * cfg_.tile_size / cfg_.arch.noc_bytes_per_cycle
+                                 : dram_write(*c, ids, begin);
+                c->stats.writer += end - begin;
+                c->writer_free = end;
+                c->stats.kernel_end = std::max(c->stats.kernel_end, end);
+            });
+        }
+    }
+
+    SimConfig cfg_;
+    uint32_t num_blocks_ = 0;
+    EventQueue queue_;
+    vector<CoreState> cores_;
+    vector<double> bank_free_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Device Profiler Log
+////////////////////////////////////////////////////////////////////////////////
+struct ProfiledRun {
+    uint64_t t0 = UINT64_MAX;
+    uint64_t fw_end = 0;
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> core_kernel_cycles;
+};
+
+struct ProfileLog {
+    string arch;
+    double clock_mhz = 0;
+    vector<ProfiledRun> runs;
+    uint32_t num_cores = 0;
+};
+
+// Runs are not reliably tagged (run ID is 0 for every launch of test_compute_mm), so the n-th
+// START/END pair of a (core, RISC, zone) belongs to the n-th run.
+bool read_profile_log(const string& path, ProfileLog& log) {
+    std::ifstream file(path);
+    if (not file) {
+        return false;
+    }
+    string line;
+    std::getline(file, line);
+    auto arch_pos = line.find("ARCH: ");
+    auto freq_pos = line.find("CHIP_FREQ[MHz]: ");
+    if (arch_pos != string::npos) {
+        log.arch = line.substr(arch_pos + 6, line.find(',', arch_pos) - arch_pos - 6);
+    }
+    if (freq_pos != string::npos) {
+        log.clock_mhz = std::stod(line.substr(freq_pos + 16));
+    }
+    std::getline(file, line);  // column names
+
+    std::map<std::tuple<uint32_t, uint32_t, string, string>, std::pair<uint32_t, uint32_t>> occurrences;
+    std::map<std::tuple<uint32_t, uint32_t, string, string, uint32_t>, uint64_t> starts;
+    std::map<std::pair<uint32_t, uint32_t>, bool> cores;
+    while (std::getline(file, line)) {
+        vector<string> fields;
+        std::stringstream ss(line);
+        string field;
+        while (std::getline(ss, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 11) {
+            continue;
+        }
+        uint32_t core_x = std::stoul(fields[1]);
+        uint32_t core_y = std::stoul(fields[2]);
+        const string& risc = fields[3];
+        uint64_t time = std::stoull(fields[5]);
+        const string& zone = fields[9];
+        const string& type = fields[10];
+        cores[{core_x, core_y}] = true;
+
+        auto& [num_starts, num_ends] = occurrences[{core_x, core_y, risc, zone}];
+        uint32_t run = type == "ZONE_START" ? num_starts++ : num_ends++;
+        if (log.runs.size() <= run) {
+            log.runs.resize(run + 1);
+        }
+        ProfiledRun& profiled = log.runs[run];
+        bool is_fw = zone.size() > 3 and zone.compare(zone.size() - 3, 3, "-FW") == 0;
+        bool is_kernel = zone.size() > 7 and zone.compare(zone.size() - 7, 7, "-KERNEL") == 0;
+        if (type == "ZONE_START") {
+            starts[{core_x, core_y, risc, zone, run}] = time;
+            if (is_fw) {
+                profiled.t0 = std::min(profiled.t0, time);
+            }
+        } else {
+            if (is_fw) {
+                profiled.fw_end = std::max(profiled.fw_end, time);
+            }
+            auto it = starts.find({core_x, core_y, risc, zone, run});
+            if (is_kernel and it != starts.end()) {
+                auto& cycles = profiled.core_kernel_cycles[{core_x, core_y}];
+                cycles = std::max(cycles, time - it->second);
+            }
+        }
+    }
+    log.num_cores = cores.size();
+    return not log.runs.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Main
+////////////////////////////////////////////////////////////////////////////////
+const char* role_name(Role in0, Role in1) {
+    if (in0 == Role::Local) {
+        return "local";
+    }
+    if (in0 == Role::Sender) {
+        return in1 == Role::Sender ? "in0S_in1S" : "in0S_in1R";
+    }
+    return in1 == Role::Sender ? "in0R_in1S" : "in0R_in1R";
+}
+
+int main(int argc, char** argv) {
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+    auto has_option = [&args](const string& name) { return std::find(args.begin(), args.end(), name) != args.end(); };
+
+    string preset = get_option("--preset", "");
+    string arch = get_option("--arch", preset == "compute_mm_gs" ? "grayskull" : "wormhole_b0");
+    uint32_t M = std::stoul(get_option("--m", preset == "compute_mm_gs" ? "4096" : "3072"));
+    uint32_t N = std::stoul(get_option("--n", preset == "compute_mm_gs" ? "4096" : "3072"));
+    uint32_t K = std::stoul(get_option("--k", preset == "compute_mm_gs" ? "4096" : "3072"));
+    uint32_t grid_x = std::stoul(get_option("--grid-x", preset == "compute_mm_gs" ? "11" : "8"));
+    uint32_t grid_y = std::stoul(get_option("--grid-y", "8"));
+    uint32_t in0_block_w_div = std::stoul(get_option("--in0-block-w-div", "1"));
+    string dtype = get_option("--dtype", preset == "compute_mm_gs" ? "bfp8" : "bf16");
+    string fidel = get_option("--fidelity", "hifi4");
+    string profile_log_path = get_option("--profile-log", "");
+    double tolerance = std::stod(get_option("--tolerance", "0.15"));
+    bool per_core = has_option("--per-core");
+
+    SimConfig cfg;
+    cfg.arch = get_arch_params(arch);
+    cfg.Mt = M / TILE_HW;
+    cfg.Nt = N / TILE_HW;
+    cfg.Kt = K / TILE_HW;
+    cfg.tile_size = get_tile_size(dtype);
+    cfg.fidelity = get_fidelity(fidel);
+    cfg.cb_depth = std::stoul(get_option("--cb-depth", "2"));
+    cfg.l1_resident = has_option("--l1-resident") or preset == "compute_mm_gs";
+
+    if (cfg.l1_resident) {
+        // test_compute_mm sizing: ceil split over the grid, in0_block_w from the L1 budget
+        cfg.per_core_M = (cfg.Mt - 1) / grid_y + 1;
+        cfg.per_core_N = (cfg.Nt - 1) / grid_x + 1;
+        cfg.num_cores_r = (cfg.Mt - 1) / cfg.per_core_M + 1;
+        cfg.num_cores_c = (cfg.Nt - 1) / cfg.per_core_N + 1;
+        cfg.in0_block_w = std::stoul(get_option("--in0-block-w", "4"));
+    } else {
+        // matmul_multicore_reuse_mcast sizing
+        cfg.num_cores_r = grid_y;
+        cfg.num_cores_c = grid_x;
+        cfg.per_core_M = cfg.Mt / grid_y;
+        cfg.per_core_N = cfg.Nt / grid_x;
+        cfg.in0_block_w = std::stoul(get_option("--in0-block-w", std::to_string(cfg.Kt / grid_x / in0_block_w_div)));
+    }
+    if (cfg.per_core_M == 0 or cfg.per_core_N == 0 or cfg.in0_block_w == 0 or cfg.Kt % cfg.in0_block_w != 0) {
+        std::fprintf(stderr, "Invalid sizing: per_core_M=%u per_core_N=%u in0_block_w=%u Kt=%u\n",
+            cfg.per_core_M, cfg.per_core_N, cfg.in0_block_w, cfg.Kt);
+        return 1;
+    }
+    std::tie(cfg.out_subblock_h, cfg.out_subblock_w) = get_subblock_sizes(cfg.per_core_M, cfg.per_core_N);
+
+    McastMatmulSim sim(cfg);
+    sim.run();
+
+    const double cycles = sim.end_to_end();
+    const double us = cycles / cfg.arch.clock_mhz;
+    const double flops = 2.0 * cfg.Mt * cfg.Nt * cfg.Kt * TILE_HW * TILE_HW * TILE_HW;
+
+    std::printf("arch %s, %u x %u cores, M/N/K tiles %u/%u/%u, per_core %ux%u, in0_block_w %u, subblock %ux%u\n",
+        cfg.arch.name.c_str(), cfg.num_cores_c, cfg.num_cores_r, cfg.Mt, cfg.Nt, cfg.Kt, cfg.per_core_M,
+        cfg.per_core_N, cfg.in0_block_w, cfg.out_subblock_h, cfg.out_subblock_w);
+    std::printf("tile %u B, fidelity phases %u, cb depth %u blocks, num_blocks %u%s\n", cfg.tile_size,
+        static_cast<uint32_t>(cfg.fidelity), cfg.cb_depth, sim.num_blocks(), cfg.l1_resident ? ", L1 resident" : "");
+
+    const CoreState* critical = &sim.cores().front();
+    CoreStats total;
+    for (const auto& core : sim.cores()) {
+        if (core.stats.kernel_end > critical->stats.kernel_end) {
+            critical = &core;
+        }
+        total.compute_busy += core.stats.compute_busy;
+        total.stall_in0 += core.stats.stall_in0;
+        total.stall_in1 += core.stats.stall_in1;
+        total.reader_cb_full += core.stats.reader_cb_full;
+        total.reader_sem_wait += core.stats.reader_sem_wait;
+        total.reader_dram += core.stats.reader_dram;
+        total.writer += core.stats.writer;
+    }
+
+    if (per_core) {
+        std::printf("\n%-6s %-10s %12s %12s %12s %12s %12s %12s %12s %12s\n", "core", "role", "compute", "stall_in0",
+            "stall_in1", "rd_cb_full", "rd_sem_wait", "rd_dram", "writer", "end");
+        for (const auto& core : sim.cores()) {
+            const auto& s = core.stats;
+            std::printf("%2u,%-3u %-10s %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f\n", core.x, core.y,
+                role_name(core.role[0], core.role[1]), s.compute_busy, s.stall_in0, s.stall_in1, s.reader_cb_full,
+                s.reader_sem_wait, s.reader_dram, s.writer, s.kernel_end);
+        }
+    }
+
+    const double num_cores = sim.cores().size();
+    std::printf("\nmean per core (cycles): compute %.0f, stall in0 %.0f, stall in1 %.0f, reader cb full %.0f, "
+                "reader sem wait %.0f, reader dram %.0f, writer %.0f\n",
+        total.compute_busy / num_cores, total.stall_in0 / num_cores, total.stall_in1 / num_cores,
+        total.reader_cb_full / num_cores, total.reader_sem_wait / num_cores, total.reader_dram / num_cores,
+        total.writer / num_cores);
+    std::printf("critical core %u,%u (%s)\n", critical->x, critical->y, role_name(critical->role[0], critical->role[1]));
+    std::printf("predicted end-to-end: %.0f cycles, %.2f us, %.2f TFLOPS, compute utilization %.1f%%\n", cycles, us,
+        flops / (us * 1e-6) / 1e12, 100.0 * total.compute_busy / num_cores / cycles);
+
+    if (profile_log_path.empty()) {
+        return 0;
+    }
+
+    ProfileLog log;
+    if (not read_profile_log(profile_log_path, log)) {
+        std::fprintf(stderr, "Cannot read device profiler log %s\n", profile_log_path.c_str());
+        return 1;
+    }
+    if (not log.arch.empty() and log.arch != cfg.arch.name) {
+        std::printf("warning: log arch %s differs from simulated arch %s\n", log.arch.c_str(), cfg.arch.name.c_str());
+    }
+    if (log.num_cores != sim.cores().size()) {
+        std::printf("warning: log has %u cores, simulation has %zu\n", log.num_cores, sim.cores().size());
+    }
+
+    double measured_sum = 0;
+    double kernel_max_sum = 0;
+    for (size_t i = 0; i < log.runs.size(); i++) {
+        const auto& run = log.runs[i];
+        uint64_t t0_to_any_riscfw_end = run.fw_end - run.t0;
+        uint64_t kernel_max = 0;
+        for (const auto& [core, kernel_cycles] : run.core_kernel_cycles) {
+            kernel_max = std::max(kernel_max, kernel_cycles);
+        }
+        measured_sum += t0_to_any_riscfw_end;
+        kernel_max_sum += kernel_max;
+        std::printf("run %zu: t0 to any riscfw end %lu cycles, slowest core kernel %lu cycles\n", i,
+            static_cast<unsigned long>(t0_to_any_riscfw_end), static_cast<unsigned long>(kernel_max));
+    }
+    const double measured = measured_sum / log.runs.size();
+    const double error = (cycles - measured) / measured;
+    std::printf("measured mean %.0f cycles (%.2f us @ %.0f MHz), predicted %.0f cycles, error %+.1f%%\n", measured,
+        measured / (log.clock_mhz > 0 ? log.clock_mhz : cfg.arch.clock_mhz), log.clock_mhz, cycles, error * 100);
+
+    if (std::abs(error) > tolerance) {
+        std::printf("prediction outside tolerance of %.0f%%\n", tolerance * 100);
+        return 1;
+    }
+    std::printf("prediction within tolerance of %.0f%%\n", tolerance * 100);
+    return 0;
+}
@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+
+#include "compute_kernel_api/matmul.h"
+
+// bmm over the step range of reader_bmm_stream_k: one output tile per run of consecutive K steps of the same tile,
+// so the first and the last tile of the range may only accumulate part of their K. The range is a runtime arg,
+// one kernel serves every core whatever its share of the work.
+namespace NAMESPACE {
+void MAIN {
+    uint32_t Kt = get_arg_val<uint32_t>(0);
+    uint32_t step_begin = get_arg_val<uint32_t>(1);
+    uint32_t step_end = get_arg_val<uint32_t>(2);
+
+    constexpr uint32_t onetile = 1;
+
+    mm_init();
+
+    uint32_t step = step_begin;
+    while (step < step_end) {
+        uint32_t tile_end = (step / Kt + 1) * Kt;
+        uint32_t k_end = step_end < tile_end ? step_end : tile_end;
+
+        tile_regs_acquire();
+        for (; step < k_end; step++) {
+            cb_wait_front(tt::CBIndex::c_0, onetile);
+            cb_wait_front(tt::CBIndex::c_1, onetile);
+
+            matmul_tiles(tt::CBIndex::c_0, tt::CBIndex::c_1, 0, 0, 0, false);
+
+            cb_pop_front(tt::CBIndex::c_0, onetile);
+            cb_pop_front(tt::CBIndex::c_1, onetile);
+        }
+        tile_regs_commit();
+
+        cb_reserve_back(tt::CBIndex::c_16, onetile);
+        tile_regs_wait();
+        pack_tile(0, tt::CBIndex::c_16);
+        tile_regs_release();
+        cb_push_back(tt::CBIndex::c_16, onetile);
+    }
+}
+}  // namespace NAMESPACE
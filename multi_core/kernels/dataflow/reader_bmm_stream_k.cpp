@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// reader_bmm_8bank_output_tiles_partitioned over a range of tile steps instead of whole output tiles:
+// step = output tile * Kt + k, the first and the last output tile of the range may only get part of their K.
+// Same runtime args, with the start tile id / number of output tiles replaced by the step range.
+void kernel_main() {
+    uint32_t src0_addr = get_arg_val<uint32_t>(0);
+    uint32_t src1_addr = get_arg_val<uint32_t>(1);
+    // 2 Mt, 7 batch: the step range already bounds the output tiles
+    uint32_t Kt = get_arg_val<uint32_t>(3);
+    uint32_t Nt = get_arg_val<uint32_t>(4);
+    uint32_t MtKt = get_arg_val<uint32_t>(5);
+    uint32_t KtNt = get_arg_val<uint32_t>(6);
+    uint32_t bcast_B = get_arg_val<uint32_t>(8);  // if 1 we broadcast B to batch
+    uint32_t step_begin = get_arg_val<uint32_t>(9);
+    uint32_t step_end = get_arg_val<uint32_t>(10);
+    uint32_t MtNt = get_arg_val<uint32_t>(11);
+
+    constexpr bool src0_is_dram = get_compile_time_arg_val(0) == 1;
+    constexpr bool src1_is_dram = get_compile_time_arg_val(1) == 1;
+
+    constexpr uint32_t cb_id_in0 = 0;
+    constexpr uint32_t cb_id_in1 = 1;
+    constexpr uint32_t onetile = 1;
+
+    const uint32_t in0_tile_bytes = get_tile_size(cb_id_in0);
+    const DataFormat in0_data_format = get_dataformat(cb_id_in0);
+    const uint32_t in1_tile_bytes = get_tile_size(cb_id_in1);
+    const DataFormat in1_data_format = get_dataformat(cb_id_in1);
+
+    const InterleavedAddrGenFast<src0_is_dram> s0 = {
+        .bank_base_address = src0_addr, .page_size = in0_tile_bytes, .data_format = in0_data_format};
+    const InterleavedAddrGenFast<src1_is_dram> s1 = {
+        .bank_base_address = src1_addr, .page_size = in1_tile_bytes, .data_format = in1_data_format};
+
+    uint32_t step = step_begin;
+    while (step < step_end) {
+        uint32_t output_tile = step / Kt;
+        uint32_t k_begin = step - output_tile * Kt;
+        uint32_t k_end = step_end - output_tile * Kt < Kt ? step_end - output_tile * Kt : Kt;
+
+        uint32_t b = output_tile / MtNt;
+        uint32_t mt = output_tile % MtNt / Nt;
+        uint32_t nt = output_tile % Nt;
+        uint32_t itileA = b * MtKt + mt * Kt + k_begin;
+        uint32_t itileB = (bcast_B ? 0 : b * KtNt) + k_begin * Nt + nt;
+
+        for (uint32_t kt = k_begin; kt < k_end; kt++) {
+            cb_reserve_back(cb_id_in0, onetile);
+            noc_async_read_tile(itileA, s0, get_write_ptr(cb_id_in0));
+            cb_reserve_back(cb_id_in1, onetile);
+            noc_async_read_tile(itileB, s1, get_write_ptr(cb_id_in1));
+            noc_async_read_barrier();
+            cb_push_back(cb_id_in0, onetile);
+            cb_push_back(cb_id_in1, onetile);
+
+            itileA += 1;   // A is MK
+            itileB += Nt;  // B is KN, so to get k++ we stride by Nt
+        }
+        step += k_end - k_begin;
+    }
+}
@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// writer_unary_interleaved_start_id over the step range of reader_bmm_stream_k: output tiles that got all their
+// K steps go to the output, the first / last tile of the range when it only got part of them goes to slot
+// partial_slot / partial_slot + 1 of the partials buffer, the host adds them up.
+void kernel_main() {
+    uint32_t dst_addr = get_arg_val<uint32_t>(0);
+    uint32_t partials_addr = get_arg_val<uint32_t>(1);
+    uint32_t Kt = get_arg_val<uint32_t>(2);
+    uint32_t step_begin = get_arg_val<uint32_t>(3);
+    uint32_t step_end = get_arg_val<uint32_t>(4);
+    uint32_t partial_slot = get_arg_val<uint32_t>(5);
+
+    constexpr uint32_t cb_id_out = get_compile_time_arg_val(0);
+    constexpr bool dst_is_dram = get_compile_time_arg_val(1) == 1;
+    constexpr uint32_t onetile = 1;
+
+    const uint32_t tile_bytes = get_tile_size(cb_id_out);
+    const DataFormat data_format = get_dataformat(cb_id_out);
+
+    const InterleavedAddrGenFast<dst_is_dram> s = {
+        .bank_base_address = dst_addr, .page_size = tile_bytes, .data_format = data_format};
+    const InterleavedAddrGenFast<dst_is_dram> s_partials = {
+        .bank_base_address = partials_addr, .page_size = tile_bytes, .data_format = data_format};
+
+    uint32_t step = step_begin;
+    while (step < step_end) {
+        uint32_t output_tile = step / Kt;
+        uint32_t k_begin = step - output_tile * Kt;
+        uint32_t k_end = step_end - output_tile * Kt < Kt ? step_end - output_tile * Kt : Kt;
+
+        cb_wait_front(cb_id_out, onetile);
+        uint32_t l1_read_addr = get_read_ptr(cb_id_out);
+        if (k_begin == 0 and k_end == Kt) {
+            noc_async_write_tile(output_tile, s, l1_read_addr);
+        } else {
+            noc_async_write_tile(partial_slot + (step == step_begin ? 0 : 1), s_partials, l1_read_addr);
+        }
+        noc_async_write_barrier();
+        cb_pop_front(cb_id_out, onetile);
+
+        step += k_end - k_begin;
+    }
+}
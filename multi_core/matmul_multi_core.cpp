@@ -4,6 +4,7 @@
 
 #include "tt_metal/host_api.hpp"
 #include "tt_metal/common/constants.hpp"
+#include "tt_metal/detail/tt_metal.hpp"
 #include "tt_metal/detail/util.hpp"
 #include "tt_metal/common/bfloat16.hpp"
 #include "tt_metal/common/test_tiles.hpp"
@@ -13,9 +14,15 @@
 #include "tt_metal/common/tilize_untilize.hpp"
 #include "tt_metal/impl/device/device.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <tuple>
 
+#include "../common/matmul_validation.hpp"
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+#include "work_distribution.hpp"
+
 using namespace tt::constants;
 using namespace std;
 using namespace tt;
@@ -25,6 +32,8 @@ using std::chrono::high_resolution_clock;
 using std::chrono::duration;
 using std::chrono::milliseconds;
 
+namespace multi_core {
+
 constexpr uint32_t dim = 256;
 
 /* Create source data */
@@ -201,7 +210,7 @@ tuple<KernelHandle, KernelHandle, KernelHandle, KernelHandle> create_kernels(
         };  // bmm compute kernel the B, Mt, Nt are just 3 for loops that technically act as 1 large loop, so only set
             // Nt for simplicity
 
-        KernelHandle matmul_multi_core_kernel_group_2_id = tt_metal::CreateKernel(
+        matmul_multi_core_kernel_group_2_id = tt_metal::CreateKernel(
             program,
             "tt_metal/programming_examples/matmul_common/kernels/compute/bmm.cpp",
             core_group_2,
@@ -212,27 +221,104 @@ tuple<KernelHandle, KernelHandle, KernelHandle, KernelHandle> create_kernels(
 
 }
 
+tuple<KernelHandle, KernelHandle, KernelHandle> create_stream_k_kernels(
+    Program& program,
+    std::shared_ptr<tt::tt_metal::Buffer> src0_dram_buffer,
+    std::shared_ptr<tt::tt_metal::Buffer> src1_dram_buffer,
+    std::shared_ptr<tt::tt_metal::Buffer> dst_dram_buffer,
+    uint32_t output_cb_index,
+    CoreRangeSet all_cores,
+    MathFidelity math_fidelity
+    ){
+    /*
+     * Same compile time args as create_kernels, the step range of each core is a runtime arg of all three
+     * kernels so one compute kernel serves every core
+     */
+    bool src0_is_dram = src0_dram_buffer->buffer_type() == tt_metal::BufferType::DRAM ? 1 : 0;
+    bool src1_is_dram = src1_dram_buffer->buffer_type() == tt_metal::BufferType::DRAM ? 1 : 0;
+    std::vector<uint32_t> reader_compile_time_args = {(uint32_t)src0_is_dram, (uint32_t)src1_is_dram};
 
-void matmul_multi_core(
-    std::vector<bfloat16>& a,
-    std::vector<bfloat16>& b,
-    std::vector<bfloat16>& output,
+    bool dst_is_dram = dst_dram_buffer->buffer_type() == tt_metal::BufferType::DRAM ? 1 : 0;
+    std::vector<uint32_t> writer_compile_time_args = {(std::uint32_t)output_cb_index, (uint32_t)dst_is_dram};
+
+    auto reader_id = tt_metal::CreateKernel(
+        program,
+        std::string(MULTI_CORE_KERNELS_DIR) + "dataflow/reader_bmm_stream_k.cpp",
+        all_cores,
+        tt_metal::DataMovementConfig{
+            .processor = DataMovementProcessor::RISCV_1,
+            .noc = NOC::RISCV_1_default,
+            .compile_args = reader_compile_time_args});
+
+    auto writer_id = tt_metal::CreateKernel(
+        program,
+        std::string(MULTI_CORE_KERNELS_DIR) + "dataflow/writer_bmm_stream_k.cpp",
+        all_cores,
+        tt_metal::DataMovementConfig{
+            .processor = DataMovementProcessor::RISCV_0,
+            .noc = NOC::RISCV_0_default,
+            .compile_args = writer_compile_time_args});
+
+    auto compute_id = tt_metal::CreateKernel(
+        program,
+        std::string(MULTI_CORE_KERNELS_DIR) + "compute/bmm_stream_k.cpp",
+        all_cores,
+        tt_metal::ComputeConfig{.math_fidelity = math_fidelity});
+
+    return std::make_tuple(reader_id, writer_id, compute_id);
+}
+
+void log_work_distribution(const WorkDistribution& work) {
+    auto report = report_work_distribution(work);
+    log_info(
+        tt::LogVerif,
+        "Work split {}: {} output tiles x {} K steps on {} of {} cores",
+        work_split_name(work.split),
+        work.num_output_tiles,
+        work.Kt,
+        report.active_cores,
+        report.grid_cores);
+    for (auto [steps, cores] : report.cores_by_steps) {
+        log_info(tt::LogVerif, "  {} cores x {} steps ({:.2f} output tiles)", cores, steps, double(steps) / work.Kt);
+    }
+    log_info(
+        tt::LogVerif,
+        "  expected finish {} steps (ideal {:.1f}), spread {:.1f}%, idle cores {:.1f}%, idle core time {:.1f}%, "
+        "{} output tiles split along K",
+        report.makespan,
+        report.ideal_steps,
+        100 * report.finish_spread,
+        100 * report.idle_core_fraction,
+        100 * report.idle_time_fraction,
+        report.split_tiles);
+}
+
+
+struct MultiCoreMatmul {
+    Program program;
+    std::shared_ptr<tt::tt_metal::Buffer> src0_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> src1_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> dst_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> partials_dram_buffer;  // stream-K tiles split along K, null without
+    uint32_t num_cores;
+    WorkDistribution work;
+};
+
+MultiCoreMatmul create_matmul_multi_core(
     bool bcast_batch,
     uint32_t M,
     uint32_t N,
-    uint32_t K,  
+    uint32_t K,
     uint32_t B,
     tt::DataFormat cb_data_format,
     MathFidelity math_fidelity,
-    Device* device) {
-    
-    auto t1 = high_resolution_clock::now();
-
+    Device* device,
+    WorkSplit work_split = DEFAULT_WORK_SPLIT) {
     /*
      * Setup program to execute along with its buffers and kernels to use
      */
-    CommandQueue& cq = device->command_queue();
-    Program program{};
+    MultiCoreMatmul mm;
+    Program& program = mm.program;
 
     /*
      * Multi-Core prep
@@ -266,6 +352,61 @@ void matmul_multi_core(
         src1_dram_buffer, 
         dst_dram_buffer] = create_DRAM_buffers(device, single_tile_size, Mt, Kt, Nt);
 
+    mm.src0_dram_buffer = src0_dram_buffer;
+    mm.src1_dram_buffer = src1_dram_buffer;
+    mm.dst_dram_buffer = dst_dram_buffer;
+
+    uint32_t output_cb_index = tt::CBIndex::c_16;
+
+    mm.work = distribute_work(work_split, num_output_tiles_total, Kt, num_cores_x * num_cores_y);
+    if (work_split == WorkSplit::Auto) {
+        log_info(
+            tt::LogVerif,
+            "Work split auto: {} steps with tiles, {} with stream-k",
+            distribute_output_tiles(num_output_tiles_total, Kt, num_cores_x * num_cores_y).makespan(),
+            distribute_stream_k(num_output_tiles_total, Kt, num_cores_x * num_cores_y).makespan());
+    }
+    log_work_distribution(mm.work);
+
+    if (mm.work.split == WorkSplit::StreamK) {
+        /*
+         * One contiguous range of (output tile, k) steps per core, the partials of the tiles split along K
+         * are written to two slots per core
+         */
+        uint32_t num_cores = mm.work.cores.size();
+        CoreRangeSet all_cores = num_cores_to_corerangeset(num_cores, compute_with_storage_grid_size);
+        uint32_t partials_addr = 0;
+        if (mm.work.has_partials()) {
+            tt_metal::InterleavedBufferConfig dram_config_partials{
+                .device = device,
+                .size = single_tile_size * 2 * num_cores,
+                .page_size = single_tile_size,
+                .buffer_type = tt_metal::BufferType::DRAM};
+            mm.partials_dram_buffer = CreateBuffer(dram_config_partials);
+            partials_addr = mm.partials_dram_buffer->address();
+        }
+
+        configurate_L1_CBs(program, single_tile_size, cb_data_format, all_cores, output_cb_index);
+        auto [reader_id, writer_id, compute_id] = create_stream_k_kernels(
+            program, src0_dram_buffer, src1_dram_buffer, dst_dram_buffer, output_cb_index, all_cores, math_fidelity);
+
+        for (uint32_t i = 0; i < num_cores; i++) {
+            CoreCoord core = {i / num_cores_y, i % num_cores_y};
+            const CoreWork& work = mm.work.cores[i];
+
+            tt_metal::SetRuntimeArgs(program, reader_id, core, {src0_addr, src1_addr, Mt, Kt, Nt, MtKt, KtNt,
+                 B, uint32_t(bcast_batch), work.step_begin, work.step_end, MtNt});
+
+            tt_metal::SetRuntimeArgs(program, writer_id, core,
+                 {dst_addr, partials_addr, Kt, work.step_begin, work.step_end, 2 * i});
+
+            tt_metal::SetRuntimeArgs(program, compute_id, core, {Kt, work.step_begin, work.step_end});
+        }
+
+        mm.num_cores = num_cores;
+        return mm;
+    }
+
     /*
      * Use a helper function to deduce the splits needed to co-operatively do
      * this matmul.
@@ -277,8 +418,8 @@ void matmul_multi_core(
         core_group_2,
         num_output_tiles_per_core_group_1,
         num_output_tiles_per_core_group_2] = split_work_to_cores(compute_with_storage_grid_size, num_output_tiles_total);
+    TT_ASSERT(num_cores == mm.work.cores.size(), "Work distribution does not match split_work_to_cores");
 
-    uint32_t output_cb_index = tt::CBIndex::c_16;
     auto[cb_src0, cb_src1, cb_output] = configurate_L1_CBs(program, single_tile_size, cb_data_format, all_cores, output_cb_index);
 
     auto [
@@ -288,7 +429,7 @@ void matmul_multi_core(
         matmul_multi_core_kernel_group_2_id] = create_kernels(program, 
                                                                 src0_dram_buffer, src1_dram_buffer, dst_dram_buffer, 
                                                                 src0_addr, src1_addr, dst_addr, output_cb_index,
-                                                                all_cores, core_group_1, core_group_2, num_output_tiles_per_core_group_1, num_output_tiles_per_core_group_1,
+                                                                all_cores, core_group_1, core_group_2, num_output_tiles_per_core_group_1, num_output_tiles_per_core_group_2,
                                                                 Kt, math_fidelity);
 
     /*
@@ -314,33 +455,152 @@ void matmul_multi_core(
         num_tiles_written += num_output_tiles_per_core;
     }
 
+    mm.num_cores = num_cores;
+    return mm;
+}
+
+/*
+ * Adds the partials of the stream-K tiles split along K into their output tiles (see sum_partials)
+ */
+void reduce_partials(
+    const WorkDistribution& work, const std::vector<bfloat16>& partials, std::vector<bfloat16>& output) {
+    auto sums = sum_partials(
+        work, TILE_HW, [&partials](uint32_t slot, uint32_t i) { return partials[slot * TILE_HW + i].to_float(); });
+    for (const auto& [output_tile, sum] : sums) {
+        for (uint32_t i = 0; i < TILE_HW; i++) {
+            output[output_tile * TILE_HW + i] = bfloat16(sum[i]);
+        }
+    }
+}
+
+// Blocking read of the tilized output, stream-K partials included
+void read_output(CommandQueue& cq, MultiCoreMatmul& mm, std::vector<bfloat16>& output) {
+    EnqueueReadBuffer(cq, mm.dst_dram_buffer, output.data(), true);
+    if (mm.partials_dram_buffer) {
+        std::vector<bfloat16> partials(mm.partials_dram_buffer->size() / sizeof(bfloat16));
+        EnqueueReadBuffer(cq, mm.partials_dram_buffer, partials.data(), true);
+        TRACE_ZONE("reduce partials");
+        reduce_partials(mm.work, partials, output);
+    }
+}
+
+matmul::MatmulPlan make_plan(
+    Device* device,
+    const matmul::MatmulShape& shape,
+    tt::DataFormat cb_data_format,
+    MathFidelity math_fidelity,
+    WorkSplit work_split) {
+    auto mm = std::make_shared<MultiCoreMatmul>(create_matmul_multi_core(
+        shape.bcast_batch,
+        shape.M,
+        shape.N,
+        shape.K,
+        shape.B,
+        cb_data_format,
+        math_fidelity,
+        device,
+        work_split));
+
+    // Output tiles (or stream-K step ranges) are split over the cores column by column
+    uint32_t num_cores_y = device->compute_with_storage_grid_size().y;
+    matmul::MatmulPlan plan;
+    plan.variant = "multi_core";
+    plan.shape = shape;
+    plan.device = device;
+    plan.grid_x = (mm->num_cores - 1) / num_cores_y + 1;
+    plan.grid_y = std::min(mm->num_cores, num_cores_y);
+    plan.in0_format = plan.in1_format = plan.out_format = cb_data_format;
+    plan.math_fidelity = math_fidelity;
+    plan.state = mm;
+    plan.program = &mm->program;
+    plan.write_a = [mm = mm.get()](CommandQueue& cq, const std::vector<bfloat16>& a) {
+        matmul::write_bfloat16(cq, mm->src0_dram_buffer, a);
+    };
+    plan.write_b = [mm = mm.get()](CommandQueue& cq, const std::vector<bfloat16>& b) {
+        matmul::write_bfloat16(cq, mm->src1_dram_buffer, b);
+    };
+    plan.read_c = [mm = mm.get()](CommandQueue& cq, std::vector<bfloat16>& output) { read_output(cq, *mm, output); };
+    return plan;
+}
+
+matmul::MatmulPlan make_plan(Device* device, const matmul::MatmulShape& shape) {
+    return make_plan(device, shape, tt::DataFormat::Float16_b, MathFidelity::HiFi4, DEFAULT_WORK_SPLIT);
+}
+
+bool supports_shape(Device* device, const matmul::MatmulShape& shape) {
+    return shape.M % TILE_HEIGHT == 0 and shape.N % TILE_WIDTH == 0 and shape.K % TILE_WIDTH == 0;
+}
+
+void matmul_multi_core(
+    std::vector<bfloat16>& a,
+    std::vector<bfloat16>& b,
+    std::vector<bfloat16>& output,
+    bool bcast_batch,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t B,
+    tt::DataFormat cb_data_format,
+    MathFidelity math_fidelity,
+    Device* device,
+    WorkSplit work_split = DEFAULT_WORK_SPLIT) {
+    auto t1 = high_resolution_clock::now();
+    matmul::MatmulPlan plan = [&] {
+        TRACE_ZONE("plan");
+        return make_plan(
+            device,
+            {.M = M, .N = N, .K = K, .B = B, .bcast_batch = bcast_batch},
+            cb_data_format,
+            math_fidelity,
+            work_split);
+    }();
     auto t2 = high_resolution_clock::now();
     calc_duration(t1, t2, "config");
 
     /* Input vector tilizing */
     t1 = high_resolution_clock::now();
-    tilize(a, M, K);
-    tilize(b, K, N);
+    {
+        TRACE_ZONE("tilize");
+        tilize(a, M, K);
+        tilize(b, K, N);
+    }
     t2 = high_resolution_clock::now();
     calc_duration(t1, t2, "tilizing");
 
     /* Launch program & read in output buffer result into the host vector */
     t1 = high_resolution_clock::now();
-    EnqueueWriteBuffer(cq, src0_dram_buffer, a.data(), false);
-    EnqueueWriteBuffer(cq, src1_dram_buffer, b.data(), false);
+    matmul::write_inputs(plan, a, b);
     t2 = high_resolution_clock::now();
     calc_duration(t1, t2, "write buffer");
 
     t1 = high_resolution_clock::now();
-    EnqueueProgram(cq, program, false);
+    matmul::run(plan, output);
     t2 = high_resolution_clock::now();
-    calc_duration(t1, t2, "matmul");
-    
-    t1 = high_resolution_clock::now();
-    EnqueueReadBuffer(cq, dst_dram_buffer, output.data(), true);
-    t2 = high_resolution_clock::now();
-    calc_duration(t1, t2, "read buffer");
-    
+    calc_duration(t1, t2, "matmul + read buffer");
+}
+
+/*
+ * Sampled PCC of one matmul_multi_core run on random M x N x K inputs against the CPU reference.
+ * matmul_multi_core tilizes its inputs in place, the reference reads row-major copies
+ */
+float validate_work_split(Device* device, uint32_t M, uint32_t N, uint32_t K, WorkSplit work_split) {
+    constexpr uint32_t single_tile_size = 2 * 32 * 32;
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
+    std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+    std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.2);
+    std::vector<bfloat16> a_rm = a;
+    std::vector<bfloat16> b_rm = b;
+    std::vector<bfloat16> output(single_tile_size * Mt * Nt / sizeof(bfloat16));
+    matmul_multi_core(
+        a, b, output, false, M, N, K, 1, tt::DataFormat::Float16_b, MathFidelity::HiFi4, device, work_split);
+    untilize(output, M, N);
+    return matmul::sampled_pcc(a_rm, b_rm, output, M, N, K);
+}
+
+matmul_bench::MatmulRunner make_bench_runner(Device* device, const matmul_bench::MatmulInputs& inputs) {
+    return matmul_bench::make_plan_runner(make_plan(device, {.M = inputs.M, .N = inputs.N, .K = inputs.K}), inputs);
 }
 
 void print_tensor(std::vector<bfloat16> data, Device* device){
@@ -349,15 +609,36 @@ void print_tensor(std::vector<bfloat16> data, Device* device){
     }
 }
 
+}  // namespace multi_core
+
+using namespace multi_core;
+
 ///////////////////////////////////////
 
+#ifndef MATMUL_NO_MAIN
+// metal-matmul [--work-split <tiles|stream-k|auto>]
 int main(int argc, char** argv) {
     bool pass = true;
 
+    std::vector<std::string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const std::string& name, const std::string& default_value) -> std::string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+    WorkSplit work_split;
+    if (not parse_work_split(get_option("--work-split", work_split_name(DEFAULT_WORK_SPLIT)), work_split)) {
+        TT_THROW("--work-split must be tiles, stream-k or auto");
+    }
+
     if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
         TT_THROW("Test not supported w/ slow dispatch, exiting");
     }
 
+    std::string trace_path = timeline::enable_from_env();
+
     try {
 
         /* Silicon accelerator setup */
@@ -376,7 +657,8 @@ int main(int argc, char** argv) {
         /* input vectors with various ranges of values */
         std::vector<bfloat16> src0_vec = create_random_vector_of_bfloat16_native(dram_buffer_A_size, 1, 123, -0.4);
         std::vector<bfloat16> src1_vec = create_random_vector_of_bfloat16_native(dram_buffer_B_size, 1, 12522, -0.2);
-        
+        std::vector<bfloat16> src0_rm = src0_vec;
+        std::vector<bfloat16> src1_rm = src1_vec;
 
         tt::DataFormat cb_data_format = tt::DataFormat::Float16_b;
         MathFidelity math_fidelity = MathFidelity::HiFi4;
@@ -384,16 +666,48 @@ int main(int argc, char** argv) {
         /* Calling the MatMul host program. Read in result into a host vector */
         std::vector<bfloat16> result_vec(dram_buffer_C_size / sizeof(bfloat16));
         auto t1 = high_resolution_clock::now();
-        matmul_multi_core(src0_vec, src1_vec, result_vec, false, M, N, K, B, cb_data_format, math_fidelity, device);
+        matmul_multi_core(
+            src0_vec, src1_vec, result_vec, false, M, N, K, B, cb_data_format, math_fidelity, device, work_split);
         auto t2 = high_resolution_clock::now();
         calc_duration(t1, t2, "tot matmul");
 
-        untilize(result_vec, M, N);
+        {
+            TRACE_ZONE("untilize");
+            untilize(result_vec, M, N);
+        }
 
         log_info(tt::LogVerif, "Output vector of size {}", result_vec.size());
+        float pcc = matmul::sampled_pcc(src0_rm, src1_rm, result_vec, M, N, K);
+        log_info(tt::LogVerif, "{} split: PCC against CPU reference {}", work_split_name(work_split), pcc);
+        pass &= pcc >= matmul::VALIDATION_PCC;
+
+        // Both splits whatever --work-split picked, then stream-K on 16 output tiles of Kt = 8 over the full grid,
+        // where every tile is cut between cores and reduced from partials
+        struct SplitCase {
+            WorkSplit split;
+            uint32_t M, N, K;
+        };
+        for (const SplitCase& c : {SplitCase{WorkSplit::OutputTiles, M, N, K},
+                                   SplitCase{WorkSplit::StreamK, M, N, K},
+                                   SplitCase{WorkSplit::StreamK, 4 * TILE_HEIGHT, 4 * TILE_WIDTH, 8 * TILE_WIDTH}}) {
+            pcc = validate_work_split(device, c.M, c.N, c.K, c.split);
+            log_info(
+                tt::LogVerif,
+                "{} split, {}x{}x{}: PCC against CPU reference {}",
+                work_split_name(c.split),
+                c.M,
+                c.N,
+                c.K,
+                pcc);
+            pass &= pcc >= matmul::VALIDATION_PCC;
+        }
 
         pass &= CloseDevice(device);
 
+        if (not trace_path.empty() and timeline::write_host_trace(trace_path)) {
+            log_info(tt::LogVerif, "Host trace written to {}", trace_path);
+        }
+
     } catch (const std::exception& e) {
         tt::log_error(tt::LogTest, "Test failed with exception!");
         tt::log_error(tt::LogTest, "{}", e.what());
@@ -411,3 +725,4 @@ int main(int argc, char** argv) {
 
     return 0;
 }
+#endif  // MATMUL_NO_MAIN
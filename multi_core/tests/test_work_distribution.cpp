@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "../work_distribution.hpp"
+
+using namespace multi_core;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// Work split of matmul_multi_core and the host reduction of the stream-K
+// partials, no device. Each check covers a case where a split mistake shows:
+// - a tile count that does not divide the cores;
+// - fewer output tiles than cores;
+// - step ranges that start and end inside a tile, several cores on one tile.
+// The partials are made by summing, per core, a known value for each of its
+// steps. The reduced tiles must then equal the sum of the tile's Kt steps.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr uint32_t TILE_HW = 4;  // small tiles, the reduction does not depend on the size
+
+// Consecutive step ranges, from 0 to T * Kt, on at most grid_cores cores
+bool check_cover(const char* name, const WorkDistribution& work) {
+    uint32_t step = 0;
+    for (const auto& core : work.cores) {
+        if (core.step_begin != step or core.step_end <= core.step_begin) {
+            std::fprintf(
+                stderr, "%s: core range [%u, %u) after step %u\n", name, core.step_begin, core.step_end, step);
+            return false;
+        }
+        step = core.step_end;
+    }
+    if (step != work.num_output_tiles * work.Kt or work.cores.size() > work.grid_cores) {
+        std::fprintf(stderr, "%s: %u steps on %zu cores\n", name, step, work.cores.size());
+        return false;
+    }
+    return true;
+}
+
+// split_work_to_cores: the first T % C cores one tile more, no partials
+bool check_output_tiles(uint32_t num_output_tiles, uint32_t Kt, uint32_t grid_cores) {
+    auto work = distribute_work(WorkSplit::OutputTiles, num_output_tiles, Kt, grid_cores);
+    bool pass = check_cover("tiles", work) and not work.has_partials();
+    uint32_t num_cores = std::min(num_output_tiles, grid_cores);
+    pass &= work.cores.size() == num_cores;
+    for (uint32_t i = 0; pass and i < num_cores; i++) {
+        uint32_t num_tiles = num_output_tiles / num_cores + (i < num_output_tiles % num_cores ? 1 : 0);
+        pass &= work.cores[i].steps() == num_tiles * Kt;
+    }
+    pass &= work.makespan() == (num_output_tiles + num_cores - 1) / num_cores * Kt;
+    if (not pass) {
+        std::fprintf(
+            stderr, "tiles: wrong split of %u tiles x %u steps on %u cores\n", num_output_tiles, Kt, grid_cores);
+    }
+    return pass;
+}
+
+// Steps within one of each other, partials only on the tiles whose steps are on several cores
+bool check_stream_k(uint32_t num_output_tiles, uint32_t Kt, uint32_t grid_cores) {
+    auto work = distribute_work(WorkSplit::StreamK, num_output_tiles, Kt, grid_cores);
+    if (not check_cover("stream-k", work)) {
+        return false;
+    }
+    bool pass = true;
+    vector<uint32_t> cores_per_tile(num_output_tiles, 0);
+    for (const auto& core : work.cores) {
+        pass &= core.steps() + 1 >= work.cores.front().steps() and core.steps() <= work.cores.front().steps();
+        for (uint32_t tile = core.step_begin / Kt; tile <= (core.step_end - 1) / Kt; tile++) {
+            cores_per_tile[tile]++;
+        }
+    }
+    for (const auto& core : work.cores) {
+        pass &= work.first_tile_partial(core) == (cores_per_tile[core.step_begin / Kt] > 1);
+        pass &= work.last_tile_partial(core) ==
+                ((core.step_end - 1) / Kt != core.step_begin / Kt and cores_per_tile[(core.step_end - 1) / Kt] > 1);
+    }
+    if (not pass) {
+        std::fprintf(
+            stderr, "stream-k: wrong split of %u tiles x %u steps on %u cores\n", num_output_tiles, Kt, grid_cores);
+    }
+    return pass;
+}
+
+/*
+ * Value i of step s is s * TILE_HW + i + 1. A core writes the sum of its steps of a tile to the output when it
+ * has all Kt of them, else to its partials slot. sum_partials must give every split tile its full sum.
+ */
+bool check_partials(uint32_t num_output_tiles, uint32_t Kt, uint32_t grid_cores) {
+    auto work = distribute_work(WorkSplit::StreamK, num_output_tiles, Kt, grid_cores);
+    vector<float> output(num_output_tiles * TILE_HW, 0);
+    vector<float> partials(2 * work.cores.size() * TILE_HW, -1000);
+    auto step_sum = [Kt](uint32_t tile, uint32_t begin, uint32_t end, uint32_t i) {
+        float sum = 0;
+        for (uint32_t s = std::max(begin, tile * Kt); s < std::min(end, (tile + 1) * Kt); s++) {
+            sum += s * TILE_HW + i + 1;
+        }
+        return sum;
+    };
+    for (uint32_t c = 0; c < work.cores.size(); c++) {
+        const auto& core = work.cores[c];
+        uint32_t first_tile = core.step_begin / Kt;
+        uint32_t last_tile = (core.step_end - 1) / Kt;
+        for (uint32_t tile = first_tile; tile <= last_tile; tile++) {
+            for (uint32_t i = 0; i < TILE_HW; i++) {
+                float sum = step_sum(tile, core.step_begin, core.step_end, i);
+                if (tile == first_tile and work.first_tile_partial(core)) {
+                    partials[2 * c * TILE_HW + i] = sum;
+                } else if (tile == last_tile and work.last_tile_partial(core)) {
+                    partials[(2 * c + 1) * TILE_HW + i] = sum;
+                } else {
+                    output[tile * TILE_HW + i] = sum;
+                }
+            }
+        }
+    }
+
+    auto sums =
+        sum_partials(work, TILE_HW, [&partials](uint32_t slot, uint32_t i) { return partials[slot * TILE_HW + i]; });
+    for (const auto& [tile, sum] : sums) {
+        for (uint32_t i = 0; i < TILE_HW; i++) {
+            output[tile * TILE_HW + i] = sum[i];
+        }
+    }
+    for (uint32_t tile = 0; tile < num_output_tiles; tile++) {
+        for (uint32_t i = 0; i < TILE_HW; i++) {
+            float expected = step_sum(tile, 0, num_output_tiles * Kt, i);
+            if (output[tile * TILE_HW + i] != expected) {
+                std::fprintf(
+                    stderr,
+                    "partials: %u tiles x %u steps on %u cores, tile %u value %u is %.1f, expected %.1f\n",
+                    num_output_tiles,
+                    Kt,
+                    grid_cores,
+                    tile,
+                    i,
+                    output[tile * TILE_HW + i],
+                    expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    bool pass = true;
+    // {output tiles, Kt, grid cores}
+    vector<std::array<uint32_t, 3>> cases = {{100, 8, 64}, {16, 32, 64}, {7, 5, 3}, {1, 9, 4}, {64, 4, 64}, {3, 1, 8}};
+    for (const auto& [num_output_tiles, Kt, grid_cores] : cases) {
+        pass &= check_output_tiles(num_output_tiles, Kt, grid_cores);
+        pass &= check_stream_k(num_output_tiles, Kt, grid_cores);
+        pass &= check_partials(num_output_tiles, Kt, grid_cores);
+    }
+
+    // 16 tiles on 64 cores leave 48 idle with whole tiles, Auto takes stream-K. An even split stays on tiles.
+    pass &= distribute_work(WorkSplit::Auto, 16, 32, 64).split == WorkSplit::StreamK;
+    pass &= distribute_work(WorkSplit::Auto, 128, 32, 64).split == WorkSplit::OutputTiles;
+    pass &= distribute_work(DEFAULT_WORK_SPLIT, 16, 32, 64).split == WorkSplit::StreamK;
+    if (not pass) {
+        std::fprintf(stderr, "Work distribution does not match the expected split\n");
+        return 1;
+    }
+    std::printf("Work distribution matches\n");
+    return 0;
+}
@@ -0,0 +1,253 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Distribution of the output tiles of matmul_multi_core over the cores, and a
+// report of how evenly it loads them.
+//
+// The work is counted in tile steps: one in0 x in1 tile product with the reads
+// of its two tiles, Kt of them per output tile. Every core runs the same loop,
+// so its expected finish time is proportional to its steps.
+//
+// OutputTiles is split_work_to_cores: whole output tiles, the first cores get
+// one more when they don't divide evenly. With T output tiles on C cores the
+// runtime is ceil(T / C) * Kt while the average core is busy T * Kt / C, e.g.
+// 16 tiles on a 64 core grid leave 48 cores idle.
+//
+// StreamK cuts the T * Kt steps into equal contiguous ranges, one per core. A
+// range may start or end in the middle of an output tile: that tile is split
+// along K and each of its cores writes a partial tile to a partials buffer,
+// slot 2 * core + 0 for the first tile of the range and + 1 for the last.
+// The host adds the partials of a split tile after the readback. Every partial
+// costs an extra tile write, counted as PARTIAL_TILE_COST_STEPS, so ranges are
+// kept at least min_steps long.
+//
+// Cores are numbered as in the runtime args loop: core {i / num_cores_y,
+// i % num_cores_y}.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace multi_core {
+
+enum class WorkSplit { OutputTiles, StreamK, Auto };
+
+// Of metal-matmul and of the variant plan the bench runs, so both measure the same split
+constexpr WorkSplit DEFAULT_WORK_SPLIT = WorkSplit::Auto;
+
+constexpr uint32_t PARTIAL_TILE_COST_STEPS = 1;
+
+inline const char* work_split_name(WorkSplit split) {
+    switch (split) {
+        case WorkSplit::OutputTiles: return "tiles";
+        case WorkSplit::StreamK: return "stream-k";
+        case WorkSplit::Auto: return "auto";
+    }
+    return "?";
+}
+
+inline bool parse_work_split(const std::string& name, WorkSplit& split) {
+    for (auto candidate : {WorkSplit::OutputTiles, WorkSplit::StreamK, WorkSplit::Auto}) {
+        if (name == work_split_name(candidate)) {
+            split = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Steps [step_begin, step_end) of one core, step = output tile * Kt + k
+struct CoreWork {
+    uint32_t step_begin = 0;
+    uint32_t step_end = 0;
+
+    uint32_t steps() const { return step_end - step_begin; }
+};
+
+struct WorkDistribution {
+    WorkSplit split = WorkSplit::OutputTiles;
+    uint32_t num_output_tiles = 0;
+    uint32_t Kt = 0;
+    uint32_t grid_cores = 0;
+    std::vector<CoreWork> cores;  // active cores only
+
+    // Output tile t of the first / last tile of a core range when it only holds part of its K steps
+    bool first_tile_partial(const CoreWork& work) const {
+        uint32_t tile = work.step_begin / Kt;
+        return work.step_begin != tile * Kt or work.step_end < (tile + 1) * Kt;
+    }
+    bool last_tile_partial(const CoreWork& work) const {
+        uint32_t tile = (work.step_end - 1) / Kt;
+        return tile != work.step_begin / Kt and work.step_end != (tile + 1) * Kt;
+    }
+    uint32_t num_partials(const CoreWork& work) const {
+        return first_tile_partial(work) + last_tile_partial(work);
+    }
+    // Expected finish time of a core, in tile steps
+    uint32_t cost(const CoreWork& work) const {
+        return work.steps() + num_partials(work) * PARTIAL_TILE_COST_STEPS;
+    }
+    uint32_t makespan() const {
+        uint32_t max_cost = 0;
+        for (const auto& work : cores) {
+            max_cost = std::max(max_cost, cost(work));
+        }
+        return max_cost;
+    }
+    bool has_partials() const {
+        return std::any_of(cores.begin(), cores.end(), [this](const CoreWork& w) { return num_partials(w) > 0; });
+    }
+};
+
+/*
+ * split_work_to_cores on a grid of grid_cores: min(T, C) cores, the first T % C of them (core_group_1) with
+ * T / C + 1 output tiles, the others (core_group_2) with T / C.
+ */
+inline WorkDistribution distribute_output_tiles(uint32_t num_output_tiles, uint32_t Kt, uint32_t grid_cores) {
+    WorkDistribution distribution;
+    distribution.split = WorkSplit::OutputTiles;
+    distribution.num_output_tiles = num_output_tiles;
+    distribution.Kt = Kt;
+    distribution.grid_cores = grid_cores;
+    uint32_t num_cores = std::min(num_output_tiles, grid_cores);
+    if (num_cores == 0) {
+        return distribution;
+    }
+    uint32_t tiles_per_core = num_output_tiles / num_cores;
+    uint32_t num_cores_with_more_work = num_output_tiles % num_cores;
+    for (uint32_t i = 0, tile = 0; i < num_cores; i++) {
+        uint32_t num_tiles = tiles_per_core + (i < num_cores_with_more_work ? 1 : 0);
+        distribution.cores.push_back({tile * Kt, (tile + num_tiles) * Kt});
+        tile += num_tiles;
+    }
+    return distribution;
+}
+
+/*
+ * T * Kt steps in equal contiguous ranges of at least min_steps over at most grid_cores cores,
+ * the first cores get one step more when they don't divide evenly.
+ */
+inline WorkDistribution distribute_stream_k(
+    uint32_t num_output_tiles, uint32_t Kt, uint32_t grid_cores, uint32_t min_steps = 2) {
+    WorkDistribution distribution;
+    distribution.split = WorkSplit::StreamK;
+    distribution.num_output_tiles = num_output_tiles;
+    distribution.Kt = Kt;
+    distribution.grid_cores = grid_cores;
+    uint32_t total_steps = num_output_tiles * Kt;
+    uint32_t num_cores = std::min(grid_cores, total_steps / std::max(min_steps, 1u));
+    num_cores = std::max(num_cores, std::min(total_steps, 1u));
+    if (num_cores == 0) {
+        return distribution;
+    }
+    uint32_t steps_per_core = total_steps / num_cores;
+    uint32_t num_cores_with_more_work = total_steps % num_cores;
+    for (uint32_t i = 0, step = 0; i < num_cores; i++) {
+        uint32_t num_steps = steps_per_core + (i < num_cores_with_more_work ? 1 : 0);
+        distribution.cores.push_back({step, step + num_steps});
+        step += num_steps;
+    }
+    return distribution;
+}
+
+/*
+ * Auto takes StreamK when its expected runtime, partial writes included, is at least min_gain shorter than the
+ * one of split_work_to_cores.
+ */
+inline WorkDistribution distribute_work(
+    WorkSplit split, uint32_t num_output_tiles, uint32_t Kt, uint32_t grid_cores, double min_gain = 0.1) {
+    auto output_tiles = distribute_output_tiles(num_output_tiles, Kt, grid_cores);
+    if (split == WorkSplit::OutputTiles) {
+        return output_tiles;
+    }
+    auto stream_k = distribute_stream_k(num_output_tiles, Kt, grid_cores);
+    if (split == WorkSplit::StreamK or stream_k.makespan() <= (1 - min_gain) * output_tiles.makespan()) {
+        return stream_k;
+    }
+    return output_tiles;
+}
+
+/*
+ * Sums the partials of the tiles split along K, in fp32: output tile -> its tile_hw values. partial(slot, i) is
+ * value i of partials slot slot, every tile is tile_hw contiguous values whatever the face order.
+ */
+template <typename Partial>
+std::map<uint32_t, std::vector<float>> sum_partials(
+    const WorkDistribution& work, uint32_t tile_hw, const Partial& partial) {
+    std::map<uint32_t, std::vector<float>> sums;
+    auto add = [&](uint32_t output_tile, uint32_t slot) {
+        auto& sum = sums[output_tile];
+        sum.resize(tile_hw);
+        for (uint32_t i = 0; i < tile_hw; i++) {
+            sum[i] += float(partial(slot, i));
+        }
+    };
+    for (uint32_t i = 0; i < work.cores.size(); i++) {
+        const CoreWork& core_work = work.cores[i];
+        if (work.first_tile_partial(core_work)) {
+            add(core_work.step_begin / work.Kt, 2 * i);
+        }
+        if (work.last_tile_partial(core_work)) {
+            add((core_work.step_end - 1) / work.Kt, 2 * i + 1);
+        }
+    }
+    return sums;
+}
+
+struct WorkDistributionReport {
+    uint32_t active_cores = 0;
+    uint32_t grid_cores = 0;
+    uint32_t min_steps = 0;  // of the active cores
+    uint32_t max_steps = 0;
+    double mean_steps = 0;
+    uint32_t makespan = 0;                 // max expected finish time, partial writes included
+    double ideal_steps = 0;                // T * Kt / grid cores
+    double finish_spread = 0;              // (max - min) / max expected finish time of the active cores
+    double idle_core_fraction = 0;         // grid cores without work
+    double idle_time_fraction = 0;         // of grid cores x makespan, waiting on the last core
+    uint32_t split_tiles = 0;              // output tiles reduced from partials
+    std::map<uint32_t, uint32_t> cores_by_steps;  // steps -> cores
+};
+
+inline WorkDistributionReport report_work_distribution(const WorkDistribution& distribution) {
+    WorkDistributionReport report;
+    report.active_cores = distribution.cores.size();
+    report.grid_cores = distribution.grid_cores;
+    if (distribution.cores.empty() or distribution.grid_cores == 0) {
+        return report;
+    }
+    report.min_steps = UINT32_MAX;
+    uint32_t min_cost = UINT32_MAX;
+    uint64_t busy = 0;
+    std::map<uint32_t, uint32_t> partials_per_tile;
+    for (const auto& work : distribution.cores) {
+        report.min_steps = std::min(report.min_steps, work.steps());
+        report.max_steps = std::max(report.max_steps, work.steps());
+        min_cost = std::min(min_cost, distribution.cost(work));
+        busy += distribution.cost(work);
+        report.cores_by_steps[work.steps()]++;
+        if (distribution.first_tile_partial(work)) {
+            partials_per_tile[work.step_begin / distribution.Kt]++;
+        }
+        if (distribution.last_tile_partial(work)) {
+            partials_per_tile[(work.step_end - 1) / distribution.Kt]++;
+        }
+    }
+    report.makespan = distribution.makespan();
+    report.mean_steps = double(distribution.num_output_tiles) * distribution.Kt / report.active_cores;
+    report.ideal_steps = double(distribution.num_output_tiles) * distribution.Kt / report.grid_cores;
+    report.finish_spread = double(report.makespan - min_cost) / report.makespan;
+    report.idle_core_fraction = 1 - double(report.active_cores) / report.grid_cores;
+    report.idle_time_fraction = 1 - double(busy) / (double(report.grid_cores) * report.makespan);
+    report.split_tiles = partials_per_tile.size();
+    return report;
+}
+
+}  // namespace multi_core
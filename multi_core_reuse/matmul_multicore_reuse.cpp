@@ -6,6 +6,8 @@
 #include "tt_metal/common/constants.hpp"
 #include "tt_metal/detail/util.hpp"
 #include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/common/bfloat8.hpp"
+#include "tt_metal/common/bfloat4.hpp"
 #include "tt_metal/common/test_tiles.hpp"
 #include "tt_metal/impl/device/device.hpp"
 #include "tt_metal/impl/dispatch/command_queue.hpp"
@@ -14,8 +16,13 @@
 #include "tt_metal/common/tilize_untilize.hpp"
 
 
+#include <algorithm>
 #include <chrono>
 
+#include "../common/matmul_validation.hpp"
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+
 using namespace tt::constants;
 using namespace std;
 using namespace tt;
@@ -25,6 +32,15 @@ using std::chrono::high_resolution_clock;
 using std::chrono::duration;
 using std::chrono::milliseconds;
 
+namespace multi_core_reuse {
+
+// Data formats of the operands, e.g. Float16_b activations against pre-quantised Bfp8_b / Bfp4_b weights
+struct MatmulDataFormats {
+    tt::DataFormat in0 = tt::DataFormat::Float16_b;
+    tt::DataFormat in1 = tt::DataFormat::Float16_b;
+    tt::DataFormat out = tt::DataFormat::Float16_b;
+};
+
 void golden_matmul(
     std::vector<bfloat16>& a,
     std::vector<bfloat16>& b,
@@ -58,30 +74,68 @@ void golden_matmul(
     }
 }
 
-void matmul_multicore_reuse(
-    std::vector<bfloat16>& a,
-    std::vector<bfloat16>& b,
-    std::vector<bfloat16>& output,
+/*
+ * Host vectors are bfloat16 in tile layout, Bfp operands are packed per tile before the upload (pre-quantised
+ * weights would come packed already)
+ */
+std::vector<uint32_t> pack_bfloat16_tiles(const std::vector<bfloat16>& tiles, tt::DataFormat data_format) {
+    std::vector<float> tiles_fp32(tiles.size());
+    std::transform(tiles.begin(), tiles.end(), tiles_fp32.begin(), [](bfloat16 x) { return x.to_float(); });
+    switch (data_format) {
+        case tt::DataFormat::Float16_b: return pack_bfloat16_vec_into_uint32_vec(tiles);
+        case tt::DataFormat::Bfp8_b:
+            return pack_fp32_vec_as_bfp8_tiles(tiles_fp32, /*row_major_input=*/false, /*is_exp_a=*/false);
+        case tt::DataFormat::Bfp4_b:
+            return pack_fp32_vec_as_bfp4_tiles(tiles_fp32, /*row_major_input=*/false, /*is_exp_a=*/false);
+        default: TT_THROW("Unsupported operand data format {}", (uint32_t)data_format);
+    }
+}
+
+std::vector<bfloat16> unpack_bfloat16_tiles(const std::vector<uint32_t>& packed, tt::DataFormat data_format) {
+    std::vector<float> tiles_fp32;
+    switch (data_format) {
+        case tt::DataFormat::Float16_b: return unpack_uint32_vec_into_bfloat16_vec(packed);
+        case tt::DataFormat::Bfp8_b:
+            tiles_fp32 = unpack_bfp8_tiles_into_float_vec(packed, /*row_major_output=*/false, /*is_exp_a=*/false);
+            break;
+        case tt::DataFormat::Bfp4_b:
+            tiles_fp32 = unpack_bfp4_tiles_into_float_vec(packed, /*row_major_output=*/false, /*is_exp_a=*/false);
+            break;
+        default: TT_THROW("Unsupported operand data format {}", (uint32_t)data_format);
+    }
+    return std::vector<bfloat16>(tiles_fp32.begin(), tiles_fp32.end());
+}
+
+struct MulticoreReuseMatmul {
+    Program program;
+    std::shared_ptr<Buffer> src0_dram_buffer;
+    std::shared_ptr<Buffer> src1_dram_buffer;
+    std::shared_ptr<Buffer> dst_dram_buffer;
+    uint32_t num_blocks_x;
+    uint32_t num_blocks_y;
+};
+
+MulticoreReuseMatmul create_matmul_multicore_reuse(
     bool bcast_batch,
     uint32_t M,
     uint32_t N,
     uint32_t K,
     uint32_t B,
-    tt::DataFormat cb_data_format,
+    const MatmulDataFormats& data_formats,
     MathFidelity math_fidelity,
     Device* device,
-    uint32_t repeat_n=1,
     bool verbose=false) {
     /*
      * Setup program to execute along with its buffers and kernels to use
      * Core range is just single core
      */
     auto t1 = high_resolution_clock::now();
-    CommandQueue& cq = device->command_queue();
-    Program program{};
+    MulticoreReuseMatmul mm;
+    Program& program = mm.program;
 
-    uint32_t single_tile_size = detail::TileSize(cb_data_format);
-    // uint32_t single_tile_size = 2 * 1024;
+    uint32_t in0_single_tile_size = detail::TileSize(data_formats.in0);
+    uint32_t in1_single_tile_size = detail::TileSize(data_formats.in1);
+    uint32_t out_single_tile_size = detail::TileSize(data_formats.out);
 
     auto compute_with_storage_grid_size = device->compute_with_storage_grid_size();
     uint32_t num_cores_x = compute_with_storage_grid_size.x;
@@ -138,13 +192,13 @@ void matmul_multicore_reuse(
 
     uint32_t in0_block_tiles = per_core_M * in0_block_w;
     uint32_t in0_CB_tiles = in0_block_tiles * 2;  // double buffer
-    uint32_t in0_CB_size = in0_CB_tiles * single_tile_size;
+    uint32_t in0_CB_size = in0_CB_tiles * in0_single_tile_size;
     uint32_t in1_block_tiles = per_core_N * in0_block_w;
     uint32_t in1_CB_tiles = in1_block_tiles * 2;  // double buffer
-    uint32_t in1_CB_size = in1_CB_tiles * single_tile_size;
+    uint32_t in1_CB_size = in1_CB_tiles * in1_single_tile_size;
     uint32_t out_block_tiles = per_core_M * per_core_N;
     uint32_t out_CB_tiles = out_block_tiles;  // No double buffer
-    uint32_t out_CB_size = out_CB_tiles * single_tile_size;
+    uint32_t out_CB_size = out_CB_tiles * out_single_tile_size;
 
     // Compute kernel compile time args
     uint32_t num_blocks = (Kt / in0_block_w);
@@ -208,29 +262,26 @@ void matmul_multicore_reuse(
      */
     t1 = high_resolution_clock::now();
   
-    uint32_t dram_buffer_A_size =
-        single_tile_size * Mt * Kt;  // num_tiles of FP16_B, hard-coded in the reader/writer kernels
-    uint32_t dram_buffer_B_size =
-        single_tile_size * Nt * Kt;  // num_tiles of FP16_B, hard-coded in the reader/writer kernels
-    uint32_t dram_buffer_C_size =
-        single_tile_size * Mt * Nt;  // num_tiles of FP16_B, hard-coded in the reader/writer kernels
+    uint32_t dram_buffer_A_size = in0_single_tile_size * Mt * Kt;
+    uint32_t dram_buffer_B_size = in1_single_tile_size * Nt * Kt;
+    uint32_t dram_buffer_C_size = out_single_tile_size * Mt * Nt;
 
     tt_metal::InterleavedBufferConfig dram_config_A{
         .device = device,
         .size = dram_buffer_A_size,
-        .page_size = single_tile_size,
+        .page_size = in0_single_tile_size,
         .buffer_type = tt_metal::BufferType::DRAM};
 
     tt_metal::InterleavedBufferConfig dram_config_B{
         .device = device,
         .size = dram_buffer_B_size,
-        .page_size = single_tile_size,
+        .page_size = in1_single_tile_size,
         .buffer_type = tt_metal::BufferType::DRAM};
 
     tt_metal::InterleavedBufferConfig dram_config_C{
         .device = device,
         .size = dram_buffer_C_size,
-        .page_size = single_tile_size,
+        .page_size = out_single_tile_size,
         .buffer_type = tt_metal::BufferType::DRAM};
 
     auto src0_dram_buffer = CreateBuffer(dram_config_A);
@@ -245,22 +296,22 @@ void matmul_multicore_reuse(
      * input tiles count is = 2 because it's single tile process, and double-buffer
      */
     uint32_t src0_cb_index = CBIndex::c_0;  // 0
-    CircularBufferConfig cb_src0_config = CircularBufferConfig(in0_CB_size, {{src0_cb_index, cb_data_format}})
-                                              .set_page_size(src0_cb_index, single_tile_size);
+    CircularBufferConfig cb_src0_config = CircularBufferConfig(in0_CB_size, {{src0_cb_index, data_formats.in0}})
+                                              .set_page_size(src0_cb_index, in0_single_tile_size);
     auto cb_src0 = tt_metal::CreateCircularBuffer(program, all_cores, cb_src0_config);
 
     uint32_t src1_cb_index = CBIndex::c_1;  // 1
-    CircularBufferConfig cb_src1_config = CircularBufferConfig(in1_CB_size, {{src1_cb_index, cb_data_format}})
-                                              .set_page_size(src1_cb_index, single_tile_size);
+    CircularBufferConfig cb_src1_config = CircularBufferConfig(in1_CB_size, {{src1_cb_index, data_formats.in1}})
+                                              .set_page_size(src1_cb_index, in1_single_tile_size);
     auto cb_src1 = tt_metal::CreateCircularBuffer(program, all_cores, cb_src1_config);
 
     uint32_t output_cb_index = tt::CBIndex::c_16;
     uint32_t interm0_cb_index = 24;
     std::map<uint8_t, tt::DataFormat> output_cb_data_format_spec{
-        {output_cb_index, cb_data_format}, {interm0_cb_index, cb_data_format}};
+        {output_cb_index, data_formats.out}, {interm0_cb_index, data_formats.out}};
     CircularBufferConfig cb_output_config = CircularBufferConfig(out_CB_size, output_cb_data_format_spec)
-                                                .set_page_size(output_cb_index, single_tile_size)
-                                                .set_page_size(interm0_cb_index, single_tile_size);
+                                                .set_page_size(output_cb_index, out_single_tile_size)
+                                                .set_page_size(interm0_cb_index, out_single_tile_size);
     auto cb_output = tt_metal::CreateCircularBuffer(program, all_cores, cb_output_config);
 
     t2 = high_resolution_clock::now();
@@ -304,10 +355,15 @@ void matmul_multicore_reuse(
             .noc = NOC::RISCV_0_default,
             .compile_args = writer_compile_time_args});
 
-    // Create compute kernel
+    // Create compute kernel. bmm_large_block_zm reloads the partials without reconfiguring srcA from the in1
+    // format, the fused kernel (same compile args, no defines) does
+    std::string mm_kernel_path = "tt_metal/programming_examples/matmul_common/kernels/compute/bmm_large_block_zm.cpp";
+    if (data_formats.in0 != data_formats.in1 or data_formats.in0 != data_formats.out) {
+        mm_kernel_path = std::string(COMPUTE_MM_KERNELS_DIR) + "bmm_large_block_zm_fused_bias_activation.cpp";
+    }
     auto mm_kernel_id = tt_metal::CreateKernel(
         program,
-        "tt_metal/programming_examples/matmul_common/kernels/compute/bmm_large_block_zm.cpp",
+        mm_kernel_path,
         all_cores,
         tt_metal::ComputeConfig{.math_fidelity = math_fidelity, .compile_args = compute_kernel_args});
 
@@ -380,30 +436,151 @@ void matmul_multicore_reuse(
     if (verbose){
         log_info(tt::LogVerif, "Kernel compilation: {} ms", duration.count());
     }
-    /* Launch program & read in output buffer result into the host vector */
-    // LaunchProgram(device, program);
-    // ReadFromBuffer(dst_dram_buffer, output);
-    // ReadFromBuffer(src0_dram_buffer, output);
 
+    mm.src0_dram_buffer = src0_dram_buffer;
+    mm.src1_dram_buffer = src1_dram_buffer;
+    mm.dst_dram_buffer = dst_dram_buffer;
+    mm.num_blocks_x = num_blocks_x;
+    mm.num_blocks_y = num_blocks_y;
+    return mm;
+}
+
+// Program of create_matmul_multicore_reuse with the packed Bfp operands of the last upload
+struct MulticoreReusePlanState {
+    MulticoreReuseMatmul mm;
+    MatmulDataFormats data_formats;
+    std::vector<uint32_t> a_packed;
+    std::vector<uint32_t> b_packed;
+    std::vector<uint32_t> output_packed;
+};
+
+matmul::MatmulPlan make_plan(
+    Device* device,
+    const matmul::MatmulShape& shape,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    bool verbose) {
+    auto state = std::make_shared<MulticoreReusePlanState>(MulticoreReusePlanState{
+        .mm = create_matmul_multicore_reuse(
+            shape.bcast_batch, shape.M, shape.N, shape.K, shape.B, data_formats, math_fidelity, device, verbose),
+        .data_formats = data_formats});
+    uint32_t dram_buffer_C_size = detail::TileSize(data_formats.out) * (shape.M / TILE_HEIGHT) * (shape.N / TILE_WIDTH);
+
+    matmul::MatmulPlan plan;
+    plan.variant = "multi_core_reuse";
+    plan.shape = shape;
+    plan.device = device;
+    plan.grid_x = state->mm.num_blocks_x;
+    plan.grid_y = state->mm.num_blocks_y;
+    plan.in0_format = data_formats.in0;
+    plan.in1_format = data_formats.in1;
+    plan.out_format = data_formats.out;
+    plan.math_fidelity = math_fidelity;
+    plan.state = state;
+    plan.program = &state->mm.program;
+
+    // Bfp operands are packed on the host, the packed vectors stay in the state until the next upload
+    auto write_operand = [](CommandQueue& cq,
+                            std::shared_ptr<Buffer>& buffer,
+                            const std::vector<bfloat16>& host,
+                            tt::DataFormat data_format,
+                            std::vector<uint32_t>& packed) {
+        if (data_format == tt::DataFormat::Float16_b) {
+            matmul::write_bfloat16(cq, buffer, host);
+        } else {
+            packed = pack_bfloat16_tiles(host, data_format);
+            EnqueueWriteBuffer(cq, buffer, packed.data(), false);
+        }
+    };
+    plan.write_a = [state = state.get(), write_operand](CommandQueue& cq, const std::vector<bfloat16>& a) {
+        write_operand(cq, state->mm.src0_dram_buffer, a, state->data_formats.in0, state->a_packed);
+    };
+    plan.write_b = [state = state.get(), write_operand](CommandQueue& cq, const std::vector<bfloat16>& b) {
+        write_operand(cq, state->mm.src1_dram_buffer, b, state->data_formats.in1, state->b_packed);
+    };
+    plan.read_c = [state = state.get(), dram_buffer_C_size](CommandQueue& cq, std::vector<bfloat16>& output) {
+        if (state->data_formats.out == tt::DataFormat::Float16_b) {
+            matmul::read_bfloat16(cq, state->mm.dst_dram_buffer, output);
+            return;
+        }
+        state->output_packed.resize(dram_buffer_C_size / sizeof(uint32_t));
+        EnqueueReadBuffer(cq, state->mm.dst_dram_buffer, state->output_packed.data(), true);
+        output = unpack_bfloat16_tiles(state->output_packed, state->data_formats.out);
+    };
+    return plan;
+}
+
+matmul::MatmulPlan make_plan(Device* device, const matmul::MatmulShape& shape) {
+    return make_plan(device, shape, {}, MathFidelity::HiFi4, false);
+}
+
+// The blocking of create_matmul_multicore_reuse: get_large_matmul_params must find one that fits the grid
+bool supports_shape(Device* device, const matmul::MatmulShape& shape) {
+    if (shape.M % TILE_HEIGHT != 0 or shape.N % TILE_WIDTH != 0 or shape.K % TILE_WIDTH != 0) {
+        return false;
+    }
+    uint32_t Mt = shape.M / TILE_HEIGHT;
+    uint32_t Nt = shape.N / TILE_WIDTH;
+    uint32_t Kt = shape.K / TILE_WIDTH;
+    uint32_t in0_block_w = 2;
+    auto grid = device->compute_with_storage_grid_size();
+    auto [per_core_M, per_core_N, out_subblock_h, out_subblock_w] =
+        bmm_op_utils::get_large_matmul_params(Mt, Nt, grid.y, grid.x, in0_block_w);
+    return Kt % in0_block_w == 0 and per_core_M > 0 and per_core_N > 0 and Mt % per_core_M == 0 and
+           Nt % per_core_N == 0 and (Mt / per_core_M) * (Nt / per_core_N) <= grid.x * grid.y;
+}
+
+/*
+ * Mean time of repeat_n executions of a plan: uploads, program and output read. The plan is built once,
+ * outside the timed loop
+ */
+double matmul_multicore_reuse(
+    matmul::MatmulPlan& plan,
+    const std::vector<bfloat16>& a,
+    const std::vector<bfloat16>& b,
+    std::vector<bfloat16>& output,
+    uint32_t repeat_n=1) {
     std::chrono::duration<double, std::milli> tot_duration(0);
-    
     for (int i = 0; i < repeat_n; i++){
-        t1 = high_resolution_clock::now();
-        EnqueueWriteBuffer(cq, src0_dram_buffer, a.data(), false);
-        EnqueueWriteBuffer(cq, src1_dram_buffer, b.data(), false);
-        EnqueueProgram(cq, program, false);
-        EnqueueReadBuffer(cq, dst_dram_buffer, output.data(), true);
-        t2 = high_resolution_clock::now();
-        duration = t2 - t1;
-        tot_duration = duration + tot_duration;
+        auto t1 = high_resolution_clock::now();
+        matmul::execute(plan, a, b, output);
+        auto t2 = high_resolution_clock::now();
+        tot_duration += t2 - t1;
     }
-    // if (verbose){
     log_info(tt::LogVerif, "Program duration mean over {} repeats: {} ms", repeat_n, tot_duration.count() / repeat_n);
-    // }
+    return tot_duration.count() / repeat_n;
+}
+
+void matmul_multicore_reuse(
+    std::vector<bfloat16>& a,
+    std::vector<bfloat16>& b,
+    std::vector<bfloat16>& output,
+    bool bcast_batch,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t B,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    Device* device,
+    uint32_t repeat_n=1,
+    bool verbose=false) {
+    matmul::MatmulPlan plan = make_plan(
+        device, {.M = M, .N = N, .K = K, .B = B, .bcast_batch = bcast_batch}, data_formats, math_fidelity, verbose);
+    matmul_multicore_reuse(plan, a, b, output, repeat_n);
+}
+
+matmul_bench::MatmulRunner make_bench_runner(Device* device, const matmul_bench::MatmulInputs& inputs) {
+    return matmul_bench::make_plan_runner(make_plan(device, {.M = inputs.M, .N = inputs.N, .K = inputs.K}), inputs);
 }
 
+}  // namespace multi_core_reuse
+
+using namespace multi_core_reuse;
+
 ///////////////////////////////////////
 
+#ifndef MATMUL_NO_MAIN
 int main(int argc, char** argv) {
     bool pass = true;
 
@@ -453,6 +630,10 @@ int main(int argc, char** argv) {
         golden_matmul(src0_vec, src1_vec, golden_vec, M, N, K, B);
         */ 
 
+        /* Row major copies for the CPU reference */
+        std::vector<bfloat16> src0_rm = src0_vec;
+        std::vector<bfloat16> src1_rm = src1_vec;
+
         /* Input vector tilizing */
         t1 = high_resolution_clock::now();
         tilize(src0_vec, M, K);
@@ -462,7 +643,9 @@ int main(int argc, char** argv) {
         log_info(tt::LogVerif, "Time tilizing of vectors: {} ms", duration.count());
 
 
-        tt::DataFormat cb_data_format = tt::DataFormat::Float16_b;
+        // Bfp8_b / Bfp4_b weights (in1) halve / quarter the weight DRAM traffic
+        MatmulDataFormats data_formats = {
+            .in0 = tt::DataFormat::Float16_b, .in1 = tt::DataFormat::Float16_b, .out = tt::DataFormat::Float16_b};
         MathFidelity math_fidelity = MathFidelity::HiFi4;
 
         /* Calling the MatMul host program. Read in result into a host vector */
@@ -470,14 +653,21 @@ int main(int argc, char** argv) {
         std::chrono::duration<double, std::milli> tot_duration(0);
         
         t1 = high_resolution_clock::now();
-        matmul_multicore_reuse(src0_vec, src1_vec, result_vec, false, M, N, K, B, cb_data_format, math_fidelity, device);
+        matmul::MatmulPlan plan =
+            make_plan(device, {.M = M, .N = N, .K = K, .B = B}, data_formats, math_fidelity, /*verbose=*/false);
+        t2 = high_resolution_clock::now();
+        duration = t2 - t1;
+        log_info(tt::LogVerif, "Plan: {} ms", duration.count());
+
+        t1 = high_resolution_clock::now();
+        matmul_multicore_reuse(plan, src0_vec, src1_vec, result_vec);
         t2 = high_resolution_clock::now();
         duration = t2 - t1;
         log_info(tt::LogVerif, "First execution mm: {} ms", duration.count());
 
         // for (int i = 0; i < NUMBER_OF_EXECUTIONS; i++){
         t1 = high_resolution_clock::now();
-        matmul_multicore_reuse(src0_vec, src1_vec, result_vec, false, M, N, K, B, cb_data_format, math_fidelity, device, 100);
+        matmul_multicore_reuse(plan, src0_vec, src1_vec, result_vec, NUMBER_OF_EXECUTIONS);
         t2 = high_resolution_clock::now();
         duration = t2 - t1;
         // log_info(tt::LogVerif, "Time mm: {} ms", duration.count());
@@ -488,6 +678,26 @@ int main(int argc, char** argv) {
         log_info(tt::LogVerif, "Tot duration mean: {} ms", (tot_duration.count() / NUMBER_OF_EXECUTIONS));
         log_info(tt::LogVerif, "Output vector of size {}", result_vec.size());
 
+        // The Bfp8_b weights and output take the fused compute kernel (mixed formats), checked against the CPU
+        float pcc = matmul::sampled_pcc(src0_rm, src1_rm, result_vec, M, N, K);
+        log_info(tt::LogVerif, "Float16_b: PCC against CPU reference {}", pcc);
+        pass &= pcc >= matmul::VALIDATION_PCC;
+        for (MatmulDataFormats mixed_formats :
+             {MatmulDataFormats{.in1 = tt::DataFormat::Bfp8_b}, MatmulDataFormats{.out = tt::DataFormat::Bfp8_b}}) {
+            matmul::MatmulPlan mixed_plan =
+                make_plan(device, {.M = M, .N = N, .K = K, .B = B}, mixed_formats, math_fidelity, false);
+            matmul_multicore_reuse(mixed_plan, src0_vec, src1_vec, result_vec);
+            untilize(result_vec, M, N);
+            pcc = matmul::sampled_pcc(src0_rm, src1_rm, result_vec, M, N, K);
+            log_info(
+                tt::LogVerif,
+                "in1 {} out {}: PCC against CPU reference {}",
+                mixed_formats.in1 == tt::DataFormat::Bfp8_b ? "Bfp8_b" : "Float16_b",
+                mixed_formats.out == tt::DataFormat::Bfp8_b ? "Bfp8_b" : "Float16_b",
+                pcc);
+            pass &= pcc >= matmul::VALIDATION_PCC;
+        }
+
         pass &= CloseDevice(device);
 
     } catch (const std::exception& e) {
@@ -507,3 +717,4 @@ int main(int argc, char** argv) {
 
     return 0;
 }
+#endif  // MATMUL_NO_MAIN
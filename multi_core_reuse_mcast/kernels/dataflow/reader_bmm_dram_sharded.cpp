@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+#include "hostdevcommon/common_values.hpp"
+
+// Weight-streaming reader for small M: in1 is width-sharded over the DRAM banks and every worker streams the
+// shard of its bank, one contiguous K-block at a time. in0 (all of M) is read by the first worker and mcasted
+// to the bounding box of the workers, sender included. Cores of the box that are not workers only take part
+// in the handshake, the mcast lands in their (unused) in0 CB.
+
+constexpr uint32_t IN0_SENDER = 0;
+constexpr uint32_t IN0_RECEIVER = 1;
+constexpr uint32_t IDLE = 2;
+
+void kernel_main() {
+    // in0 tensor args
+    uint32_t in0_tensor_addr = get_arg_val<uint32_t>(0);
+    uint32_t in0_tensor_stride_h = get_arg_val<uint32_t>(1);  // Kt
+    uint32_t in0_block_w = get_arg_val<uint32_t>(2);
+    uint32_t in0_block_h = get_arg_val<uint32_t>(3);
+    uint32_t in0_block_num_tiles = get_arg_val<uint32_t>(4);
+    uint32_t num_blocks = get_arg_val<uint32_t>(5);
+
+    // in1 shard args
+    uint32_t in1_tensor_addr = get_arg_val<uint32_t>(6);
+    uint32_t in1_dram_bank_id = get_arg_val<uint32_t>(7);
+    uint32_t in1_block_num_tiles = get_arg_val<uint32_t>(8);
+
+    // in0 mcast args
+    uint32_t in0_mcast_dest_noc_start_x = get_arg_val<uint32_t>(9);
+    uint32_t in0_mcast_dest_noc_start_y = get_arg_val<uint32_t>(10);
+    uint32_t in0_mcast_dest_noc_end_x = get_arg_val<uint32_t>(11);
+    uint32_t in0_mcast_dest_noc_end_y = get_arg_val<uint32_t>(12);
+    uint32_t in0_mcast_num_dests = get_arg_val<uint32_t>(13);  // the sender is not counted
+    uint32_t in0_mcast_sender_noc_x = get_arg_val<uint32_t>(14);
+    uint32_t in0_mcast_sender_noc_y = get_arg_val<uint32_t>(15);
+    uint32_t in0_mcast_sender_semaphore_addr = get_semaphore(get_arg_val<uint32_t>(16));
+    uint32_t in0_mcast_receiver_semaphore_addr = get_semaphore(get_arg_val<uint32_t>(17));
+
+    constexpr bool in0_is_dram = get_compile_time_arg_val(0) == 1;
+    constexpr uint32_t role = get_compile_time_arg_val(1);
+
+    constexpr uint32_t cb_id_in0 = 0;
+    constexpr uint32_t cb_id_in1 = 1;
+
+    const uint32_t in0_single_tile_size_bytes = get_tile_size(cb_id_in0);
+    const DataFormat in0_data_format = get_dataformat(cb_id_in0);
+    const uint32_t in0_block_size_bytes = in0_block_num_tiles * in0_single_tile_size_bytes;
+
+    volatile tt_l1_ptr uint32_t* in0_mcast_sender_semaphore_addr_ptr =
+        reinterpret_cast<volatile tt_l1_ptr uint32_t*>(in0_mcast_sender_semaphore_addr);
+    volatile tt_l1_ptr uint32_t* in0_mcast_receiver_semaphore_addr_ptr =
+        reinterpret_cast<volatile tt_l1_ptr uint32_t*>(in0_mcast_receiver_semaphore_addr);
+
+    const InterleavedAddrGenFast<in0_is_dram> s0 = {
+        .bank_base_address = in0_tensor_addr,
+        .page_size = in0_single_tile_size_bytes,
+        .data_format = in0_data_format};
+
+    uint64_t in0_multicast_noc_addr = get_noc_multicast_addr(
+        in0_mcast_dest_noc_end_x, in0_mcast_dest_noc_end_y, in0_mcast_dest_noc_start_x, in0_mcast_dest_noc_start_y, 0);
+    uint64_t in0_mcast_receiver_semaphore_noc_addr = in0_multicast_noc_addr | in0_mcast_receiver_semaphore_addr;
+    uint64_t in0_mcast_sender_semaphore_noc_addr =
+        get_noc_addr(in0_mcast_sender_noc_x, in0_mcast_sender_noc_y, in0_mcast_sender_semaphore_addr);
+
+    // Local VALID value, mcasted to the receivers flag address after the data
+    if constexpr (role == IN0_SENDER) {
+        *(in0_mcast_receiver_semaphore_addr_ptr) = VALID;
+    }
+
+    uint32_t in1_single_tile_size_bytes = 0;
+    uint32_t in1_block_size_bytes = 0;
+    uint32_t in1_bank_read_addr = in1_tensor_addr;
+    if constexpr (role != IDLE) {
+        in1_single_tile_size_bytes = get_tile_size(cb_id_in1);
+        in1_block_size_bytes = in1_block_num_tiles * in1_single_tile_size_bytes;
+    }
+
+    uint32_t in0_tensor_current_block_start_tile_id = 0;
+    for (uint32_t block = 0; block < num_blocks; block++) {
+        // Operand 1 first, the shard read streams while in0 is exchanged
+        if constexpr (role != IDLE) {
+            cb_reserve_back(cb_id_in1, in1_block_num_tiles);
+            uint64_t in1_shard_noc_addr = get_noc_addr_from_bank_id<true>(in1_dram_bank_id, in1_bank_read_addr);
+            noc_async_read(in1_shard_noc_addr, get_write_ptr(cb_id_in1), in1_block_size_bytes);
+            in1_bank_read_addr += in1_block_size_bytes;
+
+            cb_reserve_back(cb_id_in0, in0_block_num_tiles);
+        }
+
+        // Operand 0
+        uint32_t in0_start_address = get_write_ptr(cb_id_in0);
+        if constexpr (role == IN0_SENDER) {
+            uint32_t l1_write_addr_in0 = in0_start_address;
+            uint32_t in0_tensor_row_start_tile_id = in0_tensor_current_block_start_tile_id;
+            for (uint32_t h = 0; h < in0_block_h; h++) {
+                for (uint32_t w = 0; w < in0_block_w; w++) {
+                    noc_async_read_tile(in0_tensor_row_start_tile_id + w, s0, l1_write_addr_in0);
+                    l1_write_addr_in0 += in0_single_tile_size_bytes;
+                }
+                in0_tensor_row_start_tile_id += in0_tensor_stride_h;
+            }
+            noc_async_read_barrier();
+
+            noc_semaphore_wait(in0_mcast_sender_semaphore_addr_ptr, in0_mcast_num_dests);
+            noc_semaphore_set(in0_mcast_sender_semaphore_addr_ptr, 0);
+
+            // The sender is in the box, its copy lands on itself
+            noc_async_write_multicast_loopback_src(
+                in0_start_address,
+                in0_multicast_noc_addr | in0_start_address,
+                in0_block_size_bytes,
+                in0_mcast_num_dests + 1);
+            // No write barrier needed, the data and the flag go out on the same noc, vc and cmd_buf
+            noc_semaphore_set_multicast_loopback_src(
+                in0_mcast_receiver_semaphore_addr, in0_mcast_receiver_semaphore_noc_addr, in0_mcast_num_dests + 1);
+        } else {
+            noc_semaphore_set(in0_mcast_receiver_semaphore_addr_ptr, INVALID);
+            noc_semaphore_inc(in0_mcast_sender_semaphore_noc_addr, 1);
+            noc_semaphore_wait(in0_mcast_receiver_semaphore_addr_ptr, VALID);
+        }
+        in0_tensor_current_block_start_tile_id += in0_block_w;
+
+        if constexpr (role != IDLE) {
+            noc_async_read_barrier();
+            cb_push_back(cb_id_in0, in0_block_num_tiles);
+            cb_push_back(cb_id_in1, in1_block_num_tiles);
+        }
+    }
+}
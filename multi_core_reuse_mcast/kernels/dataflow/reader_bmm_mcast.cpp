@@ -0,0 +1,365 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+#include "hostdevcommon/common_values.hpp"
+
+// The four reader_bmm_tile_layout_in0_{sender,receiver}_in1_{sender,receiver} kernels in one, with the same
+// runtime args. The mcast role is a compile time arg, and so is the layout of each input: a row-major operand
+// is read as block_h rows of 32 sticks into its staging CB, mcasted as is and tilized by the compute kernel
+// (TILIZE_IN0 / TILIZE_IN1), so it never goes back to DRAM.
+// The mcast mode of each input covers the 1D layouts: a sender with MCAST_NONE only reads for itself, and
+// MCAST_LOOPBACK mcasts to a rectangle that contains the sender (num_dests still excludes it).
+// A block-sharded in0 is already in L1: core x of a row holds K-block x of the row's in0 blocks, so the sender
+// rotates along the row and mcasts its shard (CB c_2) to the whole row, itself included. The row's physical x
+// coordinates follow the 39 common runtime args.
+// The per-core output can be split into out_num_blocks_h x out_num_blocks_w output blocks: in0_block_h and
+// in1_block_w are then those of one output block, and the K loop runs once per output block, re-reading the
+// in0 rows and in1 columns of the block (not with a sharded in0).
+
+constexpr uint32_t MCAST_NONE = 0;
+constexpr uint32_t MCAST_OTHERS = 1;
+constexpr uint32_t MCAST_LOOPBACK = 2;
+
+// Reads a block_h x block_w tile block of a row-major tensor (one page per row) starting at tile start_tile_id
+template <bool is_dram>
+FORCE_INLINE void read_row_major_block(
+    const InterleavedAddrGen<is_dram>& s,
+    uint32_t start_tile_id,
+    uint32_t stride_h,
+    uint32_t block_w,
+    uint32_t block_h,
+    uint32_t element_size_bytes,
+    uint32_t l1_write_addr) {
+    constexpr uint32_t tile_hw = 32;
+    uint32_t row = start_tile_id / stride_h * tile_hw;
+    uint32_t col_offset_bytes = start_tile_id % stride_h * tile_hw * element_size_bytes;
+    uint32_t stick_size_bytes = block_w * tile_hw * element_size_bytes;
+    for (uint32_t r = 0; r < block_h * tile_hw; r++) {
+        noc_async_read(get_noc_addr(row + r, s, col_offset_bytes), l1_write_addr, stick_size_bytes);
+        l1_write_addr += stick_size_bytes;
+    }
+}
+
+// Reads a block_h x block_w tile block of a tile layout tensor
+template <bool is_dram>
+FORCE_INLINE void read_tile_block(
+    const InterleavedAddrGenFast<is_dram>& s,
+    uint32_t start_tile_id,
+    uint32_t stride_w,
+    uint32_t stride_h,
+    uint32_t block_w,
+    uint32_t block_h,
+    uint32_t single_tile_size_bytes,
+    uint32_t l1_write_addr) {
+    uint32_t row_start_tile_id = start_tile_id;
+    for (uint32_t h = 0; h < block_h; h++) {
+        uint32_t tile_id = row_start_tile_id;
+        for (uint32_t w = 0; w < block_w; w++) {
+            noc_async_read_tile(tile_id, s, l1_write_addr);
+            l1_write_addr += single_tile_size_bytes;
+            tile_id += stride_w;
+        }
+        row_start_tile_id += stride_h;
+    }
+}
+
+// Sender: wait for every receiver to be ready, mcast the block and then the VALID flag
+template <uint32_t mcast_mode>
+FORCE_INLINE void mcast_block(
+    uint32_t l1_start_addr,
+    uint32_t l1_dest_addr,
+    uint32_t block_size_bytes,
+    uint32_t dest_noc_start_x,
+    uint32_t dest_noc_start_y,
+    uint32_t dest_noc_end_x,
+    uint32_t dest_noc_end_y,
+    uint32_t num_dests,
+    volatile tt_l1_ptr uint32_t* sender_semaphore_addr_ptr,
+    uint32_t receiver_semaphore_addr) {
+    noc_semaphore_wait(sender_semaphore_addr_ptr, num_dests);
+    noc_semaphore_set(sender_semaphore_addr_ptr, 0);
+
+    uint64_t multicast_data_addr =
+        get_noc_multicast_addr(dest_noc_end_x, dest_noc_end_y, dest_noc_start_x, dest_noc_start_y, l1_dest_addr);
+    uint64_t receiver_semaphore_noc_addr = get_noc_multicast_addr(
+        dest_noc_end_x, dest_noc_end_y, dest_noc_start_x, dest_noc_start_y, receiver_semaphore_addr);
+    // No write barrier needed, the data and the flag go out on the same noc, vc and cmd_buf
+    if constexpr (mcast_mode == MCAST_LOOPBACK) {
+        // The sender is in the rectangle, its copy lands on itself
+        noc_async_write_multicast_loopback_src(l1_start_addr, multicast_data_addr, block_size_bytes, num_dests + 1);
+        noc_semaphore_set_multicast_loopback_src(receiver_semaphore_addr, receiver_semaphore_noc_addr, num_dests + 1);
+    } else {
+        // num_dests must not include source, since we are NOT really doing a local copy!
+        noc_async_write_multicast(l1_start_addr, multicast_data_addr, block_size_bytes, num_dests);
+        noc_semaphore_set_multicast(receiver_semaphore_addr, receiver_semaphore_noc_addr, num_dests);
+    }
+}
+
+// Receiver: tell the sender we are ready and wait for the block to land
+FORCE_INLINE void receive_block(
+    volatile tt_l1_ptr uint32_t* receiver_semaphore_addr_ptr,
+    uint32_t sender_noc_x,
+    uint32_t sender_noc_y,
+    uint32_t sender_semaphore_addr) {
+    noc_semaphore_set(receiver_semaphore_addr_ptr, INVALID);
+    uint64_t sender_semaphore_noc_addr = get_noc_addr(sender_noc_x, sender_noc_y, sender_semaphore_addr);
+    noc_semaphore_inc(sender_semaphore_noc_addr, 1);
+    noc_semaphore_wait(receiver_semaphore_addr_ptr, VALID);
+}
+
+void kernel_main() {
+    // in0 tensor args
+    uint32_t in0_tensor_addr = get_arg_val<uint32_t>(0);
+    uint32_t in0_tensor_start_tile_id = get_arg_val<uint32_t>(1);
+    uint32_t in0_tensor_stride_w = get_arg_val<uint32_t>(2);
+    uint32_t in0_tensor_stride_h = get_arg_val<uint32_t>(3);
+    uint32_t in0_tensor_next_block_stride = get_arg_val<uint32_t>(4);
+
+    // in0 block args
+    uint32_t in0_block_w = get_arg_val<uint32_t>(5);
+    uint32_t in0_block_h = get_arg_val<uint32_t>(6);
+    uint32_t in0_block_num_tiles = get_arg_val<uint32_t>(7);
+
+    // in1 tensor args
+    uint32_t in1_tensor_addr = get_arg_val<uint32_t>(8);
+    uint32_t in1_tensor_start_tile_id = get_arg_val<uint32_t>(9);
+    uint32_t in1_tensor_stride_w = get_arg_val<uint32_t>(10);
+    uint32_t in1_tensor_stride_h = get_arg_val<uint32_t>(11);
+    uint32_t in1_tensor_next_block_stride = get_arg_val<uint32_t>(12);
+
+    // in1 block args
+    uint32_t in1_block_w = get_arg_val<uint32_t>(13);
+    uint32_t in1_block_h = get_arg_val<uint32_t>(14);
+    uint32_t in1_block_num_tiles = get_arg_val<uint32_t>(15);
+
+    // in0/in1 common args
+    uint32_t num_blocks = get_arg_val<uint32_t>(16);
+
+    // in0 mcast args
+    uint32_t in0_mcast_dest_noc_start_x = get_arg_val<uint32_t>(17);
+    uint32_t in0_mcast_dest_noc_start_y = get_arg_val<uint32_t>(18);
+    uint32_t in0_mcast_dest_noc_end_x = get_arg_val<uint32_t>(19);
+    uint32_t in0_mcast_dest_noc_end_y = get_arg_val<uint32_t>(20);
+    uint32_t in0_mcast_num_dests = get_arg_val<uint32_t>(21);
+    uint32_t in0_mcast_sender_noc_x = get_arg_val<uint32_t>(22);
+    uint32_t in0_mcast_sender_noc_y = get_arg_val<uint32_t>(23);
+    uint32_t in0_mcast_sender_semaphore_addr = get_semaphore(get_arg_val<uint32_t>(24));
+    uint32_t in0_mcast_receiver_semaphore_addr = get_semaphore(get_arg_val<uint32_t>(25));
+
+    // in1 mcast args
+    uint32_t in1_mcast_dest_noc_start_x = get_arg_val<uint32_t>(26);
+    uint32_t in1_mcast_dest_noc_start_y = get_arg_val<uint32_t>(27);
+    uint32_t in1_mcast_dest_noc_end_x = get_arg_val<uint32_t>(28);
+    uint32_t in1_mcast_dest_noc_end_y = get_arg_val<uint32_t>(29);
+    uint32_t in1_mcast_num_dests = get_arg_val<uint32_t>(30);
+    uint32_t in1_mcast_sender_noc_x = get_arg_val<uint32_t>(31);
+    uint32_t in1_mcast_sender_noc_y = get_arg_val<uint32_t>(32);
+    uint32_t in1_mcast_sender_semaphore_addr = get_semaphore(get_arg_val<uint32_t>(33));
+    uint32_t in1_mcast_receiver_semaphore_addr = get_semaphore(get_arg_val<uint32_t>(34));
+
+    // batch args
+    uint32_t MtKt = get_arg_val<uint32_t>(35);  // if 0
+    uint32_t KtNt = get_arg_val<uint32_t>(36);
+    uint32_t batch = get_arg_val<uint32_t>(37);
+    uint32_t bcast_B = get_arg_val<uint32_t>(38);
+
+    constexpr bool in0_is_dram = get_compile_time_arg_val(0) == 1;
+    constexpr bool in1_is_dram = get_compile_time_arg_val(1) == 1;
+    constexpr bool in0_sender = get_compile_time_arg_val(2) == 1;
+    constexpr bool in1_sender = get_compile_time_arg_val(3) == 1;
+    constexpr bool in0_row_major = get_compile_time_arg_val(4) == 1;
+    constexpr bool in1_row_major = get_compile_time_arg_val(5) == 1;
+    constexpr uint32_t in0_mcast_mode = get_compile_time_arg_val(6);
+    constexpr uint32_t in1_mcast_mode = get_compile_time_arg_val(7);
+    constexpr bool in0_sharded = get_compile_time_arg_val(8) == 1;
+    constexpr uint32_t out_num_blocks_h = get_compile_time_arg_val(9);
+    constexpr uint32_t out_num_blocks_w = get_compile_time_arg_val(10);
+
+    // Row-major operands land in their staging CB, the compute kernel tilizes them into c_0 / c_1
+    constexpr uint32_t cb_id_in0 = in0_row_major ? 4 : 0;
+    constexpr uint32_t cb_id_in1 = in1_row_major ? 5 : 1;
+    constexpr uint32_t cb_id_in0_shard = 2;
+
+    const uint32_t in0_single_tile_size_bytes = get_tile_size(cb_id_in0);
+    const DataFormat in0_data_format = get_dataformat(cb_id_in0);
+    const uint32_t in0_element_size_bytes = in0_single_tile_size_bytes / (32 * 32);
+    const uint32_t in0_block_size_bytes = in0_block_num_tiles * in0_single_tile_size_bytes;
+    const uint32_t in1_single_tile_size_bytes = get_tile_size(cb_id_in1);
+    const DataFormat in1_data_format = get_dataformat(cb_id_in1);
+    const uint32_t in1_element_size_bytes = in1_single_tile_size_bytes / (32 * 32);
+    const uint32_t in1_block_size_bytes = in1_block_num_tiles * in1_single_tile_size_bytes;
+
+    volatile tt_l1_ptr uint32_t* in0_mcast_sender_semaphore_addr_ptr =
+        reinterpret_cast<volatile tt_l1_ptr uint32_t*>(in0_mcast_sender_semaphore_addr);
+    volatile tt_l1_ptr uint32_t* in0_mcast_receiver_semaphore_addr_ptr =
+        reinterpret_cast<volatile tt_l1_ptr uint32_t*>(in0_mcast_receiver_semaphore_addr);
+    volatile tt_l1_ptr uint32_t* in1_mcast_sender_semaphore_addr_ptr =
+        reinterpret_cast<volatile tt_l1_ptr uint32_t*>(in1_mcast_sender_semaphore_addr);
+    volatile tt_l1_ptr uint32_t* in1_mcast_receiver_semaphore_addr_ptr =
+        reinterpret_cast<volatile tt_l1_ptr uint32_t*>(in1_mcast_receiver_semaphore_addr);
+
+    // Local VALID value, mcasted to the receivers flag address after the data
+    if constexpr (in0_sender and in0_mcast_mode != MCAST_NONE and not in0_sharded) {
+        *(in0_mcast_receiver_semaphore_addr_ptr) = VALID;
+    }
+    if constexpr (in1_sender and in1_mcast_mode != MCAST_NONE) {
+        *(in1_mcast_receiver_semaphore_addr_ptr) = VALID;
+    }
+
+    // Row-major tensors have one page per row: stride_h tiles of 32 elements
+    const InterleavedAddrGenFast<in0_is_dram> s0 = {
+        .bank_base_address = in0_tensor_addr,
+        .page_size = in0_single_tile_size_bytes,
+        .data_format = in0_data_format};
+    const InterleavedAddrGen<in0_is_dram> s0_row_major = {
+        .bank_base_address = in0_tensor_addr, .page_size = in0_tensor_stride_h * 32 * in0_element_size_bytes};
+    const InterleavedAddrGenFast<in1_is_dram> s1 = {
+        .bank_base_address = in1_tensor_addr,
+        .page_size = in1_single_tile_size_bytes,
+        .data_format = in1_data_format};
+    const InterleavedAddrGen<in1_is_dram> s1_row_major = {
+        .bank_base_address = in1_tensor_addr, .page_size = in1_tensor_stride_h * 32 * in1_element_size_bytes};
+
+    for (uint32_t b = 0; b < batch; b++) {
+        for (uint32_t bh = 0; bh < out_num_blocks_h; bh++) {
+            for (uint32_t bw = 0; bw < out_num_blocks_w; bw++) {
+                uint32_t in0_tensor_current_block_start_tile_id =
+                    in0_tensor_start_tile_id + bh * in0_block_h * in0_tensor_stride_h;
+                uint32_t in1_tensor_current_block_start_tile_id =
+                    in1_tensor_start_tile_id + bw * in1_block_w * in1_tensor_stride_w;
+                for (uint32_t block = 0; block < num_blocks; block++) {
+                    // Operand 0
+                    cb_reserve_back(cb_id_in0, in0_block_num_tiles);
+                    if constexpr (in0_sharded) {
+                        uint32_t in0_shard_core_idx = get_arg_val<uint32_t>(39);
+                        if (block == in0_shard_core_idx) {
+                            // The flag was reset while this core was a receiver
+                            *(in0_mcast_receiver_semaphore_addr_ptr) = VALID;
+                            mcast_block<MCAST_LOOPBACK>(
+                                get_read_ptr(cb_id_in0_shard),
+                                get_write_ptr(cb_id_in0),
+                                in0_block_size_bytes,
+                                in0_mcast_dest_noc_start_x,
+                                in0_mcast_dest_noc_start_y,
+                                in0_mcast_dest_noc_end_x,
+                                in0_mcast_dest_noc_end_y,
+                                in0_mcast_num_dests,
+                                in0_mcast_sender_semaphore_addr_ptr,
+                                in0_mcast_receiver_semaphore_addr);
+                            // The local copy must land before the compute kernel reads it
+                            noc_async_write_barrier();
+                        } else {
+                            receive_block(
+                                in0_mcast_receiver_semaphore_addr_ptr,
+                                get_arg_val<uint32_t>(40 + block),
+                                in0_mcast_sender_noc_y,
+                                in0_mcast_sender_semaphore_addr);
+                        }
+                    } else if constexpr (in0_sender) {
+                        uint32_t in0_start_address = get_write_ptr(cb_id_in0);
+                        if constexpr (in0_row_major) {
+                            read_row_major_block(
+                                s0_row_major,
+                                in0_tensor_current_block_start_tile_id,
+                                in0_tensor_stride_h,
+                                in0_block_w,
+                                in0_block_h,
+                                in0_element_size_bytes,
+                                in0_start_address);
+                        } else {
+                            read_tile_block(
+                                s0,
+                                in0_tensor_current_block_start_tile_id,
+                                in0_tensor_stride_w,
+                                in0_tensor_stride_h,
+                                in0_block_w,
+                                in0_block_h,
+                                in0_single_tile_size_bytes,
+                                in0_start_address);
+                        }
+                        noc_async_read_barrier();
+
+                        if constexpr (in0_mcast_mode != MCAST_NONE) {
+                            mcast_block<in0_mcast_mode>(
+                                in0_start_address,
+                                in0_start_address,
+                                in0_block_size_bytes,
+                                in0_mcast_dest_noc_start_x,
+                                in0_mcast_dest_noc_start_y,
+                                in0_mcast_dest_noc_end_x,
+                                in0_mcast_dest_noc_end_y,
+                                in0_mcast_num_dests,
+                                in0_mcast_sender_semaphore_addr_ptr,
+                                in0_mcast_receiver_semaphore_addr);
+                        }
+                    } else {
+                        receive_block(
+                            in0_mcast_receiver_semaphore_addr_ptr,
+                            in0_mcast_sender_noc_x,
+                            in0_mcast_sender_noc_y,
+                            in0_mcast_sender_semaphore_addr);
+                    }
+                    cb_push_back(cb_id_in0, in0_block_num_tiles);
+                    in0_tensor_current_block_start_tile_id += in0_tensor_next_block_stride;
+
+                    // Operand 1
+                    cb_reserve_back(cb_id_in1, in1_block_num_tiles);
+                    if constexpr (in1_sender) {
+                        uint32_t in1_start_address = get_write_ptr(cb_id_in1);
+                        if constexpr (in1_row_major) {
+                            read_row_major_block(
+                                s1_row_major,
+                                in1_tensor_current_block_start_tile_id,
+                                in1_tensor_stride_h,
+                                in1_block_w,
+                                in1_block_h,
+                                in1_element_size_bytes,
+                                in1_start_address);
+                        } else {
+                            read_tile_block(
+                                s1,
+                                in1_tensor_current_block_start_tile_id,
+                                in1_tensor_stride_w,
+                                in1_tensor_stride_h,
+                                in1_block_w,
+                                in1_block_h,
+                                in1_single_tile_size_bytes,
+                                in1_start_address);
+                        }
+                        noc_async_read_barrier();
+
+                        if constexpr (in1_mcast_mode != MCAST_NONE) {
+                            mcast_block<in1_mcast_mode>(
+                                in1_start_address,
+                                in1_start_address,
+                                in1_block_size_bytes,
+                                in1_mcast_dest_noc_start_x,
+                                in1_mcast_dest_noc_start_y,
+                                in1_mcast_dest_noc_end_x,
+                                in1_mcast_dest_noc_end_y,
+                                in1_mcast_num_dests,
+                                in1_mcast_sender_semaphore_addr_ptr,
+                                in1_mcast_receiver_semaphore_addr);
+                        }
+                    } else {
+                        receive_block(
+                            in1_mcast_receiver_semaphore_addr_ptr,
+                            in1_mcast_sender_noc_x,
+                            in1_mcast_sender_noc_y,
+                            in1_mcast_sender_semaphore_addr);
+                    }
+                    cb_push_back(cb_id_in1, in1_block_num_tiles);
+                    in1_tensor_current_block_start_tile_id += in1_tensor_next_block_stride;
+                }
+            }
+        }
+        if (bcast_B == 0) {
+            in1_tensor_start_tile_id += KtNt;
+        }
+        in0_tensor_start_tile_id += MtKt;
+    }
+}
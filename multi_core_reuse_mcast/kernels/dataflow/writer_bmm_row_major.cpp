@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// Same runtime args as writer_bmm_tile_layout, but the out CB holds rows of untilized tiles (compute kernel built
+// with UNTILIZE_OUT) and the output tensor is row major, one page per row of M.
+// OUT_NUM_BLOCKS_H x OUT_NUM_BLOCKS_W output blocks per core as in writer_bmm_tile_layout_bias.
+#ifndef OUT_NUM_BLOCKS_H
+#define OUT_NUM_BLOCKS_H 1
+#endif
+#ifndef OUT_NUM_BLOCKS_W
+#define OUT_NUM_BLOCKS_W 1
+#endif
+
+void kernel_main() {
+    // out tensor args
+    uint32_t out_tensor_addr = get_arg_val<uint32_t>(0);
+    uint32_t out_tensor_start_tile_id = get_arg_val<uint32_t>(1);
+    uint32_t out_tensor_stride_w = get_arg_val<uint32_t>(2);
+    uint32_t out_tensor_stride_h = get_arg_val<uint32_t>(3);  // Nt
+    uint32_t out_tensor_next_subblock_stride_w = get_arg_val<uint32_t>(4);
+    uint32_t out_tensor_next_subblock_stride_h = get_arg_val<uint32_t>(5);
+
+    // out subblock args
+    uint32_t out_subblock_w = get_arg_val<uint32_t>(6);
+    uint32_t out_subblock_h = get_arg_val<uint32_t>(7);
+    uint32_t out_subblock_tile_count = get_arg_val<uint32_t>(8);
+    uint32_t out_num_subblocks_w = get_arg_val<uint32_t>(9);
+    uint32_t out_num_subblocks_h = get_arg_val<uint32_t>(10);
+
+    // batch args
+    uint32_t MtNt = get_arg_val<uint32_t>(11);  // if 0
+    uint32_t batch = get_arg_val<uint32_t>(12);
+
+    constexpr bool out_is_dram = get_compile_time_arg_val(0) == 1;
+
+    constexpr uint32_t cb_id_out0 = 16;
+    constexpr uint32_t tile_hw = 32;
+
+    const uint32_t element_size_bytes = get_tile_size(cb_id_out0) / (tile_hw * tile_hw);
+
+#ifdef FUSE_BIAS
+    // bias tensor args: one tile row, broadcast over the rows of every output tile by the compute kernel
+    uint32_t bias_tensor_addr = get_arg_val<uint32_t>(13);
+    uint32_t bias_tensor_start_tile_id = get_arg_val<uint32_t>(14);
+    uint32_t bias_num_tiles = get_arg_val<uint32_t>(15);
+
+    constexpr bool bias_is_dram = get_compile_time_arg_val(1) == 1;
+
+    constexpr uint32_t cb_id_bias = 3;
+    const uint32_t bias_single_tile_size_bytes = get_tile_size(cb_id_bias);
+    const DataFormat bias_data_format = get_dataformat(cb_id_bias);
+
+    const InterleavedAddrGenFast<bias_is_dram> s_bias = {
+        .bank_base_address = bias_tensor_addr,
+        .page_size = bias_single_tile_size_bytes,
+        .data_format = bias_data_format};
+
+    // Same bias for every batch, the compute kernel never pops it
+    cb_reserve_back(cb_id_bias, bias_num_tiles);
+    uint32_t l1_write_addr_bias = get_write_ptr(cb_id_bias);
+    for (uint32_t w = 0; w < bias_num_tiles; w++) {
+        noc_async_read_tile(bias_tensor_start_tile_id + w, s_bias, l1_write_addr_bias);
+        l1_write_addr_bias += bias_single_tile_size_bytes;
+    }
+    noc_async_read_barrier();
+    cb_push_back(cb_id_bias, bias_num_tiles);
+#endif
+
+    // Output block in tiles, the compute kernel pushes one row of tiles of the block at a time
+    uint32_t block_w = out_subblock_w * out_num_subblocks_w;
+    uint32_t block_h = out_subblock_h * out_num_subblocks_h;
+    uint32_t Mt = MtNt / out_tensor_stride_h;
+    uint32_t start_row = out_tensor_start_tile_id / out_tensor_stride_h * tile_hw;
+    uint32_t start_col_offset_bytes = out_tensor_start_tile_id % out_tensor_stride_h * tile_hw * element_size_bytes;
+    uint32_t block_row_size_bytes = block_w * tile_hw * element_size_bytes;
+
+    const InterleavedAddrGen<out_is_dram> s = {
+        .bank_base_address = out_tensor_addr, .page_size = out_tensor_stride_h * tile_hw * element_size_bytes};
+
+    for (uint32_t b = 0; b < batch; b++) {
+        for (uint32_t bh = 0; bh < OUT_NUM_BLOCKS_H; bh++) {
+            for (uint32_t bw = 0; bw < OUT_NUM_BLOCKS_W; bw++) {
+                uint32_t row = (b * Mt + bh * block_h) * tile_hw + start_row;
+                uint32_t col_offset_bytes = start_col_offset_bytes + bw * block_row_size_bytes;
+                for (uint32_t h = 0; h < block_h; h++) {
+                    cb_wait_front(cb_id_out0, block_w);
+                    uint32_t l1_read_addr = get_read_ptr(cb_id_out0);
+
+                    for (uint32_t r = 0; r < tile_hw; r++) {
+                        uint64_t dst_noc_addr = get_noc_addr(row, s, col_offset_bytes);
+                        noc_async_write(l1_read_addr, dst_noc_addr, block_row_size_bytes);
+                        l1_read_addr += block_row_size_bytes;
+                        row++;
+                    }
+
+                    noc_async_write_barrier();
+                    cb_pop_front(cb_id_out0, block_w);
+                }
+            }
+        }
+    }
+}
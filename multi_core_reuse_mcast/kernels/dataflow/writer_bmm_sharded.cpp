@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// Same runtime args as writer_bmm_tile_layout, for a block-sharded L1 output: the out CB is the core's shard,
+// so nothing is written. The writer only waits for the whole block, which then stays in place for the next op.
+// Needs out_subblock_w == block_w or out_subblock_h == 1, so the subblocks land in row-major tile order.
+void kernel_main() {
+    // out subblock args
+    uint32_t out_subblock_tile_count = get_arg_val<uint32_t>(8);
+    uint32_t out_num_subblocks_w = get_arg_val<uint32_t>(9);
+    uint32_t out_num_subblocks_h = get_arg_val<uint32_t>(10);
+
+    // batch args
+    uint32_t batch = get_arg_val<uint32_t>(12);
+
+    constexpr uint32_t cb_id_out0 = 16;
+
+#ifdef FUSE_BIAS
+    // bias tensor args: one tile row, broadcast over the rows of every output tile by the compute kernel
+    uint32_t bias_tensor_addr = get_arg_val<uint32_t>(13);
+    uint32_t bias_tensor_start_tile_id = get_arg_val<uint32_t>(14);
+    uint32_t bias_num_tiles = get_arg_val<uint32_t>(15);
+
+    constexpr bool bias_is_dram = get_compile_time_arg_val(1) == 1;
+
+    constexpr uint32_t cb_id_bias = 3;
+    const uint32_t bias_single_tile_size_bytes = get_tile_size(cb_id_bias);
+    const DataFormat bias_data_format = get_dataformat(cb_id_bias);
+
+    const InterleavedAddrGenFast<bias_is_dram> s_bias = {
+        .bank_base_address = bias_tensor_addr,
+        .page_size = bias_single_tile_size_bytes,
+        .data_format = bias_data_format};
+
+    // Same bias for every batch, the compute kernel never pops it
+    cb_reserve_back(cb_id_bias, bias_num_tiles);
+    uint32_t l1_write_addr_bias = get_write_ptr(cb_id_bias);
+    for (uint32_t w = 0; w < bias_num_tiles; w++) {
+        noc_async_read_tile(bias_tensor_start_tile_id + w, s_bias, l1_write_addr_bias);
+        l1_write_addr_bias += bias_single_tile_size_bytes;
+    }
+    noc_async_read_barrier();
+    cb_push_back(cb_id_bias, bias_num_tiles);
+#endif
+
+    cb_wait_front(cb_id_out0, batch * out_num_subblocks_h * out_num_subblocks_w * out_subblock_tile_count);
+}
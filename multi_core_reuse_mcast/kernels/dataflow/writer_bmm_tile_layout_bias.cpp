@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "dataflow_api.h"
+
+// writer_bmm_tile_layout with the bias row of the core's output columns read into CB c_3 first (FUSE_BIAS).
+// The per-core output can come as OUT_NUM_BLOCKS_H x OUT_NUM_BLOCKS_W output blocks, row by row: the subblock
+// args are then those of one output block.
+#ifndef OUT_NUM_BLOCKS_H
+#define OUT_NUM_BLOCKS_H 1
+#endif
+#ifndef OUT_NUM_BLOCKS_W
+#define OUT_NUM_BLOCKS_W 1
+#endif
+
+void kernel_main() {
+    // out tensor args
+    uint32_t out_tensor_addr = get_arg_val<uint32_t>(0);
+    uint32_t out_tensor_start_tile_id = get_arg_val<uint32_t>(1);
+    uint32_t out_tensor_stride_w = get_arg_val<uint32_t>(2);
+    uint32_t out_tensor_stride_h = get_arg_val<uint32_t>(3);
+    uint32_t out_tensor_next_subblock_stride_w = get_arg_val<uint32_t>(4);
+    uint32_t out_tensor_next_subblock_stride_h = get_arg_val<uint32_t>(5);
+
+    // out subblock args
+    uint32_t out_subblock_w = get_arg_val<uint32_t>(6);
+    uint32_t out_subblock_h = get_arg_val<uint32_t>(7);
+    uint32_t out_subblock_tile_count = get_arg_val<uint32_t>(8);
+    uint32_t out_num_subblocks_w = get_arg_val<uint32_t>(9);
+    uint32_t out_num_subblocks_h = get_arg_val<uint32_t>(10);
+
+    // batch args
+    uint32_t MtNt = get_arg_val<uint32_t>(11);  // if 0
+    uint32_t batch = get_arg_val<uint32_t>(12);
+
+    constexpr bool out_is_dram = get_compile_time_arg_val(0) == 1;
+
+    constexpr uint32_t cb_id_out0 = 16;
+
+    // single-tile
+    const uint32_t single_tile_size_bytes = get_tile_size(cb_id_out0);
+    const DataFormat data_format = get_dataformat(cb_id_out0);
+
+#ifdef FUSE_BIAS
+    // bias tensor args: one tile row, broadcast over the rows of every output tile by the compute kernel
+    uint32_t bias_tensor_addr = get_arg_val<uint32_t>(13);
+    uint32_t bias_tensor_start_tile_id = get_arg_val<uint32_t>(14);
+    uint32_t bias_num_tiles = get_arg_val<uint32_t>(15);
+
+    constexpr bool bias_is_dram = get_compile_time_arg_val(1) == 1;
+
+    constexpr uint32_t cb_id_bias = 3;
+    const uint32_t bias_single_tile_size_bytes = get_tile_size(cb_id_bias);
+    const DataFormat bias_data_format = get_dataformat(cb_id_bias);
+
+    const InterleavedAddrGenFast<bias_is_dram> s_bias = {
+        .bank_base_address = bias_tensor_addr,
+        .page_size = bias_single_tile_size_bytes,
+        .data_format = bias_data_format};
+
+    // Same bias for every batch, the compute kernel never pops it
+    cb_reserve_back(cb_id_bias, bias_num_tiles);
+    uint32_t l1_write_addr_bias = get_write_ptr(cb_id_bias);
+    for (uint32_t w = 0; w < bias_num_tiles; w++) {
+        noc_async_read_tile(bias_tensor_start_tile_id + w, s_bias, l1_write_addr_bias);
+        l1_write_addr_bias += bias_single_tile_size_bytes;
+    }
+    noc_async_read_barrier();
+    cb_push_back(cb_id_bias, bias_num_tiles);
+#endif
+
+    const InterleavedAddrGenFast<out_is_dram> s = {
+        .bank_base_address = out_tensor_addr, .page_size = single_tile_size_bytes, .data_format = data_format};
+
+    uint32_t out_block_w = out_subblock_w * out_num_subblocks_w;
+    uint32_t out_block_h = out_subblock_h * out_num_subblocks_h;
+    for (uint32_t b = 0; b < batch; b++) {
+        for (uint32_t bh = 0; bh < OUT_NUM_BLOCKS_H; bh++) {
+            for (uint32_t bw = 0; bw < OUT_NUM_BLOCKS_W; bw++) {
+                uint32_t out_tensor_sbh_start_tile_id = out_tensor_start_tile_id +
+                                                        bh * out_block_h * out_tensor_stride_h +
+                                                        bw * out_block_w * out_tensor_stride_w;
+                for (uint32_t sbh = 0; sbh < out_num_subblocks_h; sbh++) {
+                    uint32_t out_tensor_sbw_start_tile_id = out_tensor_sbh_start_tile_id;
+                    for (uint32_t sbw = 0; sbw < out_num_subblocks_w; sbw++) {
+                        uint32_t out_tensor_sb_row_start_tile_id = out_tensor_sbw_start_tile_id;
+
+                        cb_wait_front(cb_id_out0, out_subblock_tile_count);
+                        uint32_t l1_read_addr = get_read_ptr(cb_id_out0);
+
+                        for (uint32_t h = 0; h < out_subblock_h; h++) {
+                            uint32_t out_tensor_tile_id = out_tensor_sb_row_start_tile_id;
+                            for (uint32_t w = 0; w < out_subblock_w; w++) {
+                                noc_async_write_tile(out_tensor_tile_id, s, l1_read_addr);
+                                l1_read_addr += single_tile_size_bytes;
+                                out_tensor_tile_id += out_tensor_stride_w;
+                            }
+                            out_tensor_sb_row_start_tile_id += out_tensor_stride_h;
+                        }
+
+                        noc_async_write_barrier();
+                        cb_pop_front(cb_id_out0, out_subblock_tile_count);
+                        out_tensor_sbw_start_tile_id += out_tensor_next_subblock_stride_w;
+                    }
+                    out_tensor_sbh_start_tile_id += out_tensor_next_subblock_stride_h;
+                }
+            }
+        }
+        out_tensor_start_tile_id += MtNt;
+    }
+}
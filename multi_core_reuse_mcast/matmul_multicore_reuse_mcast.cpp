@@ -6,6 +6,8 @@
 #include "tt_metal/common/constants.hpp"
 #include "tt_metal/detail/util.hpp"
 #include "tt_metal/common/bfloat16.hpp"
+#include "tt_metal/common/bfloat8.hpp"
+#include "tt_metal/common/bfloat4.hpp"
 #include "tt_metal/common/test_tiles.hpp"
 #include "tt_metal/impl/dispatch/command_queue.hpp"
 #include "tt_metal/impl/device/device.hpp"
@@ -13,7 +15,24 @@
 #include "tt_metal/programming_examples/matmul_common/bmm_op.hpp"
 #include <algorithm>
 #include "tt_metal/common/tilize_untilize.hpp"
+#include "ttnn/operations/eltwise/unary/common/unary_op_utils.hpp"
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <numeric>
+#include <random>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#include "../common/matmul_validation.hpp"
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+#include "mcast_runtime_args.hpp"
 
 using namespace tt::constants;
 using namespace std;
@@ -23,17 +42,66 @@ using namespace tt::tt_metal;
 using chrono::duration;
 using chrono::high_resolution_clock;
 
+namespace multi_core_reuse_mcast {
+
 ////////////////////////////////////////////////////////////////////////////
 //                      Matmul Parameters Setup
 ////////////////////////////////////////////////////////////////////////////
 // NOTE: Only supports matmuls where output is blocks of 16 x 16 tiles (ie. multiples of 16*32 x 16*32)
 // NOTE: Maximum number of tiles in output is 120 * 16^2 = 30,720 (eg. [1, 1, 5120, 6144])
 
+enum class Activation { None, ReLU, GeLU, SiLU };
+
+// Fused epilogue of the compute kernel: out = activation(A * B + bias)
+struct MatmulEpilogue {
+    bool fuse_bias = false;
+    Activation activation = Activation::None;
+};
+
+// Data formats of the operands, e.g. Float16_b activations against pre-quantised Bfp8_b / Bfp4_b weights
+struct MatmulDataFormats {
+    tt::DataFormat in0 = tt::DataFormat::Float16_b;
+    tt::DataFormat in1 = tt::DataFormat::Float16_b;
+    tt::DataFormat out = tt::DataFormat::Float16_b;
+};
+
+MatmulDataFormats uniform_data_formats(tt::DataFormat data_format) {
+    return {.in0 = data_format, .in1 = data_format, .out = data_format};
+}
+
+
+// Compute kernel variant of a plan
+struct MatmulKernelConfig {
+    bool packer_l1_acc = false;  // accumulate partials in L1 instead of reloading them every K-block
+    bool matmul_block = false;   // one matmul_block call per subblock and inner dim step instead of per-tile calls
+    uint32_t subblock_choice = 0;  // index into the subblock shapes that divide the per-core block
+    bool untilize_out = false;     // row-major output, untilized on device (Float16_b only)
+    bool tilize_in0 = false;       // row-major A, tilized by the compute kernel (Float16_b only)
+    bool tilize_in1 = false;       // row-major B, tilized by the compute kernel (Float16_b only)
+    McastLayout mcast_layout = McastLayout::Auto;  // Auto: picked by get_mcast_blocking from the shape
+    bool in0_sharded = false;      // A block-sharded in L1 instead of DRAM interleaved (2D, tile layout, B == 1)
+    bool out_sharded = false;      // output block-sharded in L1 and left there for the next op (2D, B == 1)
+    uint32_t num_out_blocks_h = 0;  // output blocks per core along M, 0 for both: picked by plan_out_blocks
+    uint32_t num_out_blocks_w = 0;  // output blocks per core along N
+};
+
 bool verbose = true;
+bool validate = true;
+bool warmup = false;  // compile the served variants ahead of time, see warmup_matmul_mcast
+bool benchmark_packer_l1_acc = false;  // reload vs packer L1 accumulation across K
+bool benchmark_subblocks = false;      // TFLOPS per subblock shape, tile and block mode
+bool benchmark_untilize_out = false;   // tile output + host untilize vs row-major output from device
+bool benchmark_tilize_in = false;      // host tilize vs device tilize of a row-major A
+bool benchmark_data_formats = false;   // accuracy and throughput per in0 / in1 / out format combination
+bool benchmark_mcast_layouts = false;  // 2D vs 1D mcast on decode / projection shapes, next to the planner pick
+bool benchmark_sharded = false;        // DRAM interleaved vs L1-sharded in0 / out on 256..2048 square shapes
+bool benchmark_dram_sharded = false;   // 1D in0 mcast vs DRAM-sharded weights on M = 32 decode shapes, GB/s of B
+bool benchmark_out_blocks = false;     // output blocks per core on 2048..8192 square shapes, next to the planner pick
+bool plan_input_layout = false;        // let the planner pick host or device tilize for the inputs
+bool device_tilize_in1 = false;        // the planner may also tilize B on device, weights are usually pre-tilized
+std::string warmup_manifest_path = "matmul_mcast_warmup.manifest";
 constexpr uint32_t NUMBER_OF_EXECUTIONS = 1;
 
-constexpr dim = 3072 
-
 /* Create source data */
 constexpr uint32_t M = 3072;  // user-defined
 constexpr uint32_t K = 3072;  // user-defined
@@ -42,8 +110,11 @@ constexpr uint32_t N = 3072;  // user-defined
 constexpr uint32_t B = 1;    // user-defined
 
 
-tt::DataFormat cb_data_format = tt::DataFormat::Float16_b;
+MatmulDataFormats data_formats = {
+    .in0 = tt::DataFormat::Float16_b, .in1 = tt::DataFormat::Float16_b, .out = tt::DataFormat::Float16_b};
 MathFidelity math_fidelity = MathFidelity::HiFi4;
+MatmulEpilogue epilogue = {.fuse_bias = false, .activation = Activation::None};  // user-defined
+MatmulKernelConfig kernel_config = {};  // kernel features are off unless enabled on the command line
 
 
 // auto compute_with_storage_grid_size = device->compute_with_storage_grid_size();
@@ -63,42 +134,332 @@ constexpr std::array<std::tuple<uint32_t, uint32_t>, 20> SUBBLOCK_HW_CHOICES = {
 
 
 std::tuple<uint32_t, uint32_t> get_subblock_sizes(
-    uint32_t m_tiles_per_core, uint32_t n_tiles_per_core, bool out_sharded=false, bool fp32_dest_acc_en=false){
+    uint32_t m_tiles_per_core,
+    uint32_t n_tiles_per_core,
+    bool out_sharded=false,
+    bool fp32_dest_acc_en=false,
+    uint32_t choice=0){
+    uint32_t index = 0;
     for (auto& subblock_hw : SUBBLOCK_HW_CHOICES) {
         auto out_subblock_h = std::get<0>(subblock_hw);
         auto out_subblock_w = std::get<1>(subblock_hw);
+        // A sharded output is the out CB itself, the subblocks must come out in row-major tile order
+        if (out_sharded and out_subblock_w != n_tiles_per_core and out_subblock_h != 1) {
+            continue;
+        }
         if (m_tiles_per_core % out_subblock_h == 0 and n_tiles_per_core % out_subblock_w == 0) {
-            return {out_subblock_h, out_subblock_w};
+            if (index >= choice) {
+                return {out_subblock_h, out_subblock_w};
+            }
+            index++;
         }
     }
     // Default return value if no condition is met
     return {1, 1};
 }
 
-void matmul_multicore_reuse_mcast(
-    std::vector<bfloat16>& a,
-    std::vector<bfloat16>& b,
-    std::vector<bfloat16>& output,
-    bool bcast_batch,
+/*
+ * Per-core blocking of the mcast planner: one per_core_M x per_core_N block per core on a num_cores_c x
+ * num_cores_r grid, computed as num_out_blocks_h x num_out_blocks_w output blocks (subblocks are those of one
+ * output block). Every output block runs the whole K loop.
+ */
+struct McastBlocking {
+    McastLayout layout;
+    uint32_t in0_block_w;
+    uint32_t per_core_M;
+    uint32_t per_core_N;
+    uint32_t out_subblock_h;
+    uint32_t out_subblock_w;
+    uint32_t num_cores_c;
+    uint32_t num_cores_r;
+    uint32_t num_out_blocks_h = 1;
+    uint32_t num_out_blocks_w = 1;
+};
+
+// 2D: one K-block per core column, M split over the rows and N over the columns of the full grid
+bool mcast_2d_blocking_exists(uint32_t M, uint32_t N, uint32_t K) {
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Nt = N / TILE_WIDTH;
+    uint32_t Kt = K / TILE_WIDTH;
+    return Mt % num_cores_y == 0 and Nt % num_cores_x == 0 and Kt % num_cores_x == 0 and Mt >= num_cores_y and
+           Nt >= num_cores_x and Kt >= num_cores_x;
+}
+
+McastBlocking get_mcast_blocking_2d(uint32_t M, uint32_t N, uint32_t K) {
+    // Test default values
+    uint32_t in0_block_w_div = 1;
+
+    McastBlocking blocking;
+    blocking.layout = McastLayout::Mcast2D;
+    blocking.in0_block_w = K / num_cores_x / 32 / in0_block_w_div;
+    blocking.per_core_M = M / num_cores_y / 32;
+    blocking.per_core_N = N / num_cores_x / 32;
+    blocking.num_cores_c = num_cores_x;
+    blocking.num_cores_r = num_cores_y;
+    return blocking;
+}
+
+// The in0 / in1 blocks of a 1D core hold all of M / N, so K-blocks are capped instead of one per core column
+constexpr uint32_t MCAST_1D_MAX_IN0_BLOCK_W = 8;
+
+/*
+ * 1D: the split dimension (N when in0 is mcasted, M when in1 is) is cut into the fewest blocks that fill the
+ * grid, laid out row by row. The cores must form a rectangle, the mcast goes to all of them.
+ */
+McastBlocking get_mcast_blocking_1d(uint32_t M, uint32_t N, uint32_t K, bool mcast_in0) {
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Nt = N / TILE_WIDTH;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t split_t = mcast_in0 ? Nt : Mt;
+    uint32_t num_cores = num_cores_x * num_cores_y;
+
+    uint32_t per_core_split = split_t;
+    for (uint32_t per_core = 1; per_core <= split_t; per_core++) {
+        uint32_t num_blocks = split_t / per_core;
+        if (split_t % per_core == 0 and num_blocks <= num_cores and
+            (num_blocks <= num_cores_x or num_blocks % num_cores_x == 0)) {
+            per_core_split = per_core;
+            break;
+        }
+    }
+    uint32_t num_blocks = split_t / per_core_split;
+
+    McastBlocking blocking;
+    blocking.layout = mcast_in0 ? McastLayout::Mcast1DIn0 : McastLayout::Mcast1DIn1;
+    blocking.in0_block_w = 1;
+    for (uint32_t w = std::min(Kt, MCAST_1D_MAX_IN0_BLOCK_W); w > 0; w--) {
+        if (Kt % w == 0) {
+            blocking.in0_block_w = w;
+            break;
+        }
+    }
+    blocking.per_core_M = mcast_in0 ? Mt : per_core_split;
+    blocking.per_core_N = mcast_in0 ? per_core_split : Nt;
+    blocking.num_cores_c = std::min(num_blocks, num_cores_x);
+    blocking.num_cores_r = num_blocks / blocking.num_cores_c;
+    return blocking;
+}
+
+// At most this many tile rows of M, the weights dominate the traffic and a bank's shard is a single stream
+constexpr uint32_t DRAM_SHARDED_MAX_MT = 4;
+
+// DramSharded: one worker per DRAM bank, each with all of M and the N columns of its bank's shard
+McastBlocking get_mcast_blocking_dram_sharded(uint32_t M, uint32_t N, uint32_t K, uint32_t num_dram_banks) {
+    McastBlocking blocking = get_mcast_blocking_1d(M, N, K, true);
+    blocking.layout = McastLayout::DramSharded;
+    blocking.per_core_N = N / TILE_WIDTH / num_dram_banks;
+    blocking.num_cores_c = num_dram_banks;
+    blocking.num_cores_r = 1;
+    return blocking;
+}
+
+/*
+ * Auto takes DramSharded for small M when N splits over the DRAM banks and the caller allows it (B == 1, tile
+ * layout and interleaved inputs, interleaved output). Otherwise it takes the layout with the least matmul work
+ * per core, then the least input tiles per core. The 2D blocking only exists when M, N and K split evenly over
+ * the grid, which rules it out for M or N below 32 rows per core row / column (decode, projections).
+ */
+McastBlocking get_mcast_blocking(
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t num_dram_banks,
+    uint32_t subblock_choice=0,
+    McastLayout layout=McastLayout::Auto,
+    bool out_sharded=false,
+    bool allow_dram_sharded=true) {
+    McastBlocking blocking;
+    switch (layout) {
+        case McastLayout::Mcast2D: blocking = get_mcast_blocking_2d(M, N, K); break;
+        case McastLayout::Mcast1DIn0: blocking = get_mcast_blocking_1d(M, N, K, true); break;
+        case McastLayout::Mcast1DIn1: blocking = get_mcast_blocking_1d(M, N, K, false); break;
+        case McastLayout::DramSharded: blocking = get_mcast_blocking_dram_sharded(M, N, K, num_dram_banks); break;
+        default: {
+            if (allow_dram_sharded and not out_sharded and M / TILE_HEIGHT <= DRAM_SHARDED_MAX_MT and
+                (N / TILE_WIDTH) % num_dram_banks == 0) {
+                blocking = get_mcast_blocking_dram_sharded(M, N, K, num_dram_banks);
+                break;
+            }
+            auto cost = [](const McastBlocking& b) {
+                return std::make_pair(b.per_core_M * b.per_core_N, b.per_core_M + b.per_core_N);
+            };
+            blocking = get_mcast_blocking_1d(M, N, K, true);
+            McastBlocking blocking_in1 = get_mcast_blocking_1d(M, N, K, false);
+            if (cost(blocking_in1) < cost(blocking)) {
+                blocking = blocking_in1;
+            }
+            if (mcast_2d_blocking_exists(M, N, K)) {
+                McastBlocking blocking_2d = get_mcast_blocking_2d(M, N, K);
+                if (not(cost(blocking) < cost(blocking_2d))) {
+                    blocking = blocking_2d;
+                }
+            }
+        }
+    }
+    auto matmul_params =
+        get_subblock_sizes(blocking.per_core_M, blocking.per_core_N, out_sharded, false, subblock_choice);
+    blocking.out_subblock_h = std::get<0>(matmul_params);
+    blocking.out_subblock_w = std::get<1>(matmul_params);
+    return blocking;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                      Runtime Arguments
+////////////////////////////////////////////////////////////////////////////
+// McastRuntimeArgsParams and McastRuntimeArgsBuilder: mcast_runtime_args.hpp
+
+std::map<string, string> get_activation_defines(Activation activation) {
+    using ttnn::operations::unary::UnaryOpType;
+    namespace unary_utils = ttnn::operations::unary::utils;
+    switch (activation) {
+        case Activation::ReLU: return unary_utils::get_defines(UnaryOpType::RELU, std::nullopt, "ACTIVATION", "i");
+        case Activation::GeLU:
+            // fast_and_approximate_mode
+            return unary_utils::get_defines(UnaryOpType::GELU, std::vector<float>{1.0f}, "ACTIVATION", "i");
+        case Activation::SiLU: return unary_utils::get_defines(UnaryOpType::SILU, std::nullopt, "ACTIVATION", "i");
+        default: return {};
+    }
+}
+
+// The packer accumulates into L1 in the partials format, bfp partials would lose precision on every block
+tt::DataFormat get_interm_cb_data_format(tt::DataFormat cb_data_format, bool packer_l1_acc) {
+    if (packer_l1_acc and (cb_data_format == tt::DataFormat::Bfp8_b or cb_data_format == tt::DataFormat::Bfp4_b)) {
+        return tt::DataFormat::Float16_b;
+    }
+    return cb_data_format;
+}
+
+// L1 taken by the CBs of create_matmul_mcast_program on every core
+uint32_t get_mcast_cb_l1_size(
+    const McastBlocking& blocking,
+    const MatmulDataFormats& data_formats,
+    const MatmulEpilogue& epilogue,
+    const MatmulKernelConfig& kernel_config) {
+    uint32_t in0_single_tile_size = detail::TileSize(data_formats.in0);
+    uint32_t out_single_tile_size = detail::TileSize(data_formats.out);
+    uint32_t out_block_h = blocking.per_core_M / blocking.num_out_blocks_h;
+    uint32_t out_block_w = blocking.per_core_N / blocking.num_out_blocks_w;
+    uint32_t in0_CB_size = out_block_h * blocking.in0_block_w * 2 * in0_single_tile_size;
+    uint32_t in1_CB_size = out_block_w * blocking.in0_block_w * 2 * detail::TileSize(data_formats.in1);
+    uint32_t out_block_tiles = out_block_h * out_block_w;
+    bool out_double_buffer = blocking.num_out_blocks_h * blocking.num_out_blocks_w > 1;
+    uint32_t out_CB_tiles = out_double_buffer ? out_block_tiles * 2 : out_block_tiles;
+
+    uint32_t cb_l1_size = in0_CB_size + in1_CB_size + out_CB_tiles * out_single_tile_size;
+    tt::DataFormat interm0_data_format = get_interm_cb_data_format(data_formats.out, kernel_config.packer_l1_acc);
+    if (interm0_data_format != data_formats.out or kernel_config.untilize_out or out_double_buffer) {
+        cb_l1_size += out_block_tiles * detail::TileSize(interm0_data_format);
+    }
+    if (epilogue.fuse_bias) {
+        cb_l1_size += blocking.per_core_N * in0_single_tile_size +
+                      blocking.out_subblock_h * blocking.out_subblock_w * out_single_tile_size;
+    }
+    if (kernel_config.tilize_in0) {
+        cb_l1_size += in0_CB_size;
+    }
+    if (kernel_config.tilize_in1) {
+        cb_l1_size += in1_CB_size;
+    }
+    // The sharded output is the out CB, the in0 shard comes on top of the double-buffered c_0
+    if (kernel_config.in0_sharded) {
+        cb_l1_size += in0_CB_size / 2;
+    }
+    return cb_l1_size;
+}
+
+/*
+ * Splits the per-core block into output blocks until the CBs fit in l1_free. Smaller blocks shrink the in0 /
+ * in1 / out CBs, but every extra output block column re-reads the core's in0 rows and every extra row its in1
+ * columns, so the split with the least input tiles moved is taken among those that fit. More than one block
+ * double-buffers the out CB so the writer drains block i while block i + 1 is computed.
+ * Explicit num_out_blocks_h / num_out_blocks_w in the kernel config are taken as is.
+ */
+void plan_out_blocks(
+    McastBlocking& blocking,
+    const MatmulDataFormats& data_formats,
+    const MatmulEpilogue& epilogue,
+    const MatmulKernelConfig& kernel_config,
+    uint32_t l1_free) {
+    auto set_out_blocks = [&](uint32_t num_out_blocks_h, uint32_t num_out_blocks_w) {
+        blocking.num_out_blocks_h = num_out_blocks_h;
+        blocking.num_out_blocks_w = num_out_blocks_w;
+        auto matmul_params = get_subblock_sizes(
+            blocking.per_core_M / num_out_blocks_h,
+            blocking.per_core_N / num_out_blocks_w,
+            kernel_config.out_sharded,
+            false,
+            kernel_config.subblock_choice);
+        blocking.out_subblock_h = std::get<0>(matmul_params);
+        blocking.out_subblock_w = std::get<1>(matmul_params);
+    };
+    if (kernel_config.num_out_blocks_h != 0 or kernel_config.num_out_blocks_w != 0) {
+        set_out_blocks(std::max(1u, kernel_config.num_out_blocks_h), std::max(1u, kernel_config.num_out_blocks_w));
+        return;
+    }
+    set_out_blocks(1, 1);
+    // The sharded operands and the DRAM-sharded reader are laid out for the whole per-core block
+    bool splittable = blocking.layout != McastLayout::DramSharded and not kernel_config.in0_sharded and
+                      not kernel_config.out_sharded;
+    if (not splittable or get_mcast_cb_l1_size(blocking, data_formats, epilogue, kernel_config) <= l1_free) {
+        return;
+    }
+    std::pair<uint32_t, uint32_t> best = {1, 1};
+    uint64_t best_input_tiles = std::numeric_limits<uint64_t>::max();
+    for (uint32_t h = 1; h <= blocking.per_core_M; h++) {
+        for (uint32_t w = 1; w <= blocking.per_core_N; w++) {
+            if (blocking.per_core_M % h != 0 or blocking.per_core_N % w != 0 or h * w == 1) {
+                continue;
+            }
+            set_out_blocks(h, w);
+            // Input tiles per K-block step, the same K loop runs once per output block
+            uint64_t input_tiles = (uint64_t)blocking.per_core_M * w + (uint64_t)blocking.per_core_N * h;
+            if (get_mcast_cb_l1_size(blocking, data_formats, epilogue, kernel_config) <= l1_free and
+                input_tiles < best_input_tiles) {
+                best = {h, w};
+                best_input_tiles = input_tiles;
+            }
+        }
+    }
+    set_out_blocks(best.first, best.second);
+}
+
+struct McastProgram {
+    Program program;
+    McastRuntimeArgsParams runtime_args_params;  // buffer addresses and bcast_batch are filled in by the caller
+    std::array<KernelHandle, McastRuntimeArgsBuilder::NUM_GROUPS> reader_kernel_ids;
+    std::array<KernelHandle, McastRuntimeArgsBuilder::NUM_GROUPS> writer_kernel_ids;
+    // L1 block-sharded operands, the CBs on top of them are created with the program
+    std::shared_ptr<Buffer> in0_shard_buffer;
+    std::shared_ptr<Buffer> out_shard_buffer;
+    // DramSharded: in1 shards in DRAM, the worker of each bank in bank order and the other cores of their box
+    std::shared_ptr<Buffer> in1_shard_buffer;
+    std::vector<CoreCoord> dram_sharded_workers;
+    std::vector<CoreCoord> dram_sharded_idle_cores;
+};
+
+/*
+ * CBs, kernels and semaphores for one matmul variant, without DRAM buffers or runtime args.
+ * Kernel binaries only depend on what is created here, so this is also what the warmup compiles.
+ * L1-sharded operands are allocated here, their CBs are globally allocated on top of the shards.
+ */
+McastProgram create_matmul_mcast_program(
+    Device* device,
     uint32_t M,
     uint32_t N,
     uint32_t K,
     uint32_t B,
-    tt::DataFormat cb_data_format,
+    const MatmulDataFormats& data_formats,
     MathFidelity math_fidelity,
-    Device* device,
-    uint32_t repeat_n=1,
+    const MatmulEpilogue& epilogue={},
+    const MatmulKernelConfig& kernel_config={},
     bool verbose=false) {
-    /*
-     * Setup program to execute along with its buffers and kernels to use
-     * Core range is just single core
-     */
     auto t1 = high_resolution_clock::now();
-    CommandQueue& cq = device->command_queue();
-    Program program{};
+    McastProgram mcast;
+    Program& program = mcast.program;
 
-    uint32_t single_tile_size = detail::TileSize(cb_data_format);
-    // uint32_t single_tile_size = 2 * 1024;
+    uint32_t in0_single_tile_size = detail::TileSize(data_formats.in0);
+    uint32_t in1_single_tile_size = detail::TileSize(data_formats.in1);
+    uint32_t out_single_tile_size = detail::TileSize(data_formats.out);
 
     auto t2 = high_resolution_clock::now();
     duration<double, std::milli> duration = t2 - t1;
@@ -133,19 +494,31 @@ void matmul_multicore_reuse_mcast(
     // uint32_t out_subblock_h = std::get<2>(matmul_params);
     // uint32_t out_subblock_w = std::get<3>(matmul_params);
     
-    // Test default values 
-    uint32_t in0_block_w_div = 1;
-    uint32_t num_out_blocks_h = 1;
-    uint32_t num_out_blocks_w = 1;
-
-    uint32_t in0_block_w = K / num_cores_x / 32 / in0_block_w_div;
-    uint32_t per_core_M = M / num_cores_y / 32;
-    uint32_t per_core_N = N / num_cores_x/ 32;
+    bool allow_dram_sharded =
+        B == 1 and not kernel_config.tilize_in0 and not kernel_config.tilize_in1 and not kernel_config.in0_sharded;
+    McastBlocking blocking = get_mcast_blocking(
+        M,
+        N,
+        K,
+        device->num_dram_channels(),
+        kernel_config.subblock_choice,
+        kernel_config.mcast_layout,
+        kernel_config.out_sharded,
+        allow_dram_sharded);
+    uint32_t l1_free = device->l1_size_per_core() - device->get_base_allocator_addr(HalMemType::L1);
+    plan_out_blocks(blocking, data_formats, epilogue, kernel_config, l1_free);
+    uint32_t in0_block_w = blocking.in0_block_w;
+    uint32_t per_core_M = blocking.per_core_M;
+    uint32_t per_core_N = blocking.per_core_N;
+    uint32_t out_subblock_h = blocking.out_subblock_h;
+    uint32_t out_subblock_w = blocking.out_subblock_w;
+    uint32_t num_out_blocks_h = blocking.num_out_blocks_h;
+    uint32_t num_out_blocks_w = blocking.num_out_blocks_w;
     uint32_t out_block_h = per_core_M / num_out_blocks_h;
     uint32_t out_block_w = per_core_N / num_out_blocks_w;
-    auto matmul_params = get_subblock_sizes(per_core_M, per_core_N);
-    uint32_t out_subblock_h = std::get<0>(matmul_params);
-    uint32_t out_subblock_w = std::get<1>(matmul_params);
+    bool out_blocks = num_out_blocks_h * num_out_blocks_w > 1;
+    bool mcast_1d = blocking.layout == McastLayout::Mcast1DIn0 or blocking.layout == McastLayout::Mcast1DIn1;
+    bool dram_sharded = blocking.layout == McastLayout::DramSharded;
 
     if (verbose){
         log_info(tt::LogVerif, " -- Metalium Core Sizing --");
@@ -156,30 +529,79 @@ void matmul_multicore_reuse_mcast(
             per_core_N,
             out_subblock_h,
             out_subblock_w);
+        log_info(
+            tt::LogVerif,
+            " -- num_out_blocks_h= {} -- num_out_blocks_w= {} --",
+            num_out_blocks_h,
+            num_out_blocks_w);
+        log_info(
+            tt::LogVerif,
+            " -- layout= {} -- cores= {}x{} --",
+            blocking.layout == McastLayout::Mcast2D      ? "2D"
+            : blocking.layout == McastLayout::Mcast1DIn0 ? "1D in0 mcast"
+            : blocking.layout == McastLayout::Mcast1DIn1 ? "1D in1 mcast"
+                                                         : "DRAM sharded",
+            blocking.num_cores_c,
+            blocking.num_cores_r);
     }
 
     TT_ASSERT(Mt % per_core_M == 0);
     TT_ASSERT(Nt % per_core_N == 0);
     TT_ASSERT(Kt % in0_block_w == 0);
-
-    uint32_t in0_block_tiles = per_core_M * in0_block_w;
+    TT_FATAL(
+        per_core_M % num_out_blocks_h == 0 and per_core_N % num_out_blocks_w == 0,
+        "{}x{} output blocks do not divide the {}x{} per-core block",
+        num_out_blocks_h,
+        num_out_blocks_w,
+        per_core_M,
+        per_core_N);
+    TT_FATAL(
+        not kernel_config.untilize_out or data_formats.out == tt::DataFormat::Float16_b,
+        "Row-major output is only supported for Float16_b");
+    TT_FATAL(
+        not kernel_config.tilize_in0 or data_formats.in0 == tt::DataFormat::Float16_b,
+        "Row-major in0 is only supported for Float16_b");
+    TT_FATAL(
+        not kernel_config.tilize_in1 or data_formats.in1 == tt::DataFormat::Float16_b,
+        "Row-major in1 is only supported for Float16_b");
+    bool in0_sharded = kernel_config.in0_sharded;
+    bool out_sharded = kernel_config.out_sharded;
+    TT_FATAL(
+        not(in0_sharded or out_sharded) or (blocking.layout == McastLayout::Mcast2D and B == 1),
+        "L1-sharded operands are only supported for the 2D layout with B == 1");
+    TT_FATAL(
+        not dram_sharded or allow_dram_sharded,
+        "DRAM-sharded weights are only supported with B == 1 and tile layout, interleaved inputs");
+    TT_FATAL(
+        not dram_sharded or Nt % blocking.num_cores_c == 0,
+        "DRAM-sharded weights need the {} tile columns of N to split over the {} DRAM banks",
+        Nt,
+        blocking.num_cores_c);
+    TT_FATAL(not in0_sharded or not kernel_config.tilize_in0, "Sharded in0 must be in tile layout");
+    TT_FATAL(not out_sharded or not kernel_config.untilize_out, "Sharded output must be in tile layout");
+    TT_FATAL(
+        not out_blocks or not(in0_sharded or out_sharded or dram_sharded),
+        "Output blocks are not supported with sharded operands");
+
+    uint32_t in0_block_tiles = out_block_h * in0_block_w;
     uint32_t in0_CB_tiles = in0_block_tiles * 2;  // double buffer
-    uint32_t in0_CB_size = in0_CB_tiles * single_tile_size;
-    uint32_t in1_block_tiles = per_core_N * in0_block_w;
+    uint32_t in0_CB_size = in0_CB_tiles * in0_single_tile_size;
+    uint32_t in1_block_tiles = out_block_w * in0_block_w;
     uint32_t in1_CB_tiles = in1_block_tiles * 2;  // double buffer
-    uint32_t in1_CB_size = in1_CB_tiles * single_tile_size;
-    uint32_t out_block_tiles = per_core_M * per_core_N;
-    uint32_t out_CB_tiles = out_block_tiles;  // No double buffer
-    uint32_t out_CB_size = out_CB_tiles * single_tile_size;
+    uint32_t in1_CB_size = in1_CB_tiles * in1_single_tile_size;
+    uint32_t out_block_tiles = out_block_h * out_block_w;
+    // Double buffer across output blocks: the writer drains block i while block i + 1 is computed
+    uint32_t out_CB_tiles = out_blocks ? out_block_tiles * 2 : out_block_tiles;
+    uint32_t out_CB_size = out_CB_tiles * out_single_tile_size;
 
     // Compute kernel compile time args
     uint32_t num_blocks = (Kt / in0_block_w);
 
-    uint32_t in0_num_subblocks = (per_core_M / out_subblock_h);
+    uint32_t in0_num_subblocks = (out_block_h / out_subblock_h);
     uint32_t in0_block_num_tiles = out_subblock_h * in0_block_w * in0_num_subblocks;
     uint32_t in0_subblock_num_tiles = out_subblock_h * in0_block_w;
 
-    uint32_t in1_num_subblocks = (per_core_N / out_subblock_w);
+    uint32_t in1_num_subblocks = (out_block_w / out_subblock_w);
     uint32_t in1_block_num_tiles = out_subblock_w * in0_block_w * in1_num_subblocks;
     uint32_t in1_per_core_w = out_subblock_w * in1_num_subblocks;
 
@@ -200,7 +622,7 @@ void matmul_multicore_reuse_mcast(
         out_subblock_h,          // out_subblock_h
         out_subblock_w,          // out_subblock_w
         out_subblock_num_tiles,  // out_subblock_num_tiles
-        B                        // batch
+        B * num_out_blocks_h * num_out_blocks_w  // batch, every output block is a matmul of its own
     };
 
     /*
@@ -212,7 +634,24 @@ void matmul_multicore_reuse_mcast(
     uint32_t num_blocks_total = num_blocks_y * num_blocks_x;
     TT_ASSERT(num_blocks_total <= num_cores_x * num_cores_y);
     CoreCoord start_core = {0, 0};
-    CoreCoord core_range = bmm_op_utils::get_core_range(num_blocks_y, num_blocks_x, num_cores_y, num_cores_x);
+    CoreCoord core_range = {blocking.num_cores_c, blocking.num_cores_r};
+    if (dram_sharded) {
+        // Bounding box of the workers closest to each bank, the in0 mcast covers all of it
+        mcast.dram_sharded_workers = device->get_optimal_dram_bank_to_logical_worker_assignment();
+        TT_ASSERT(mcast.dram_sharded_workers.size() == num_blocks_total);
+        CoreCoord box_end = mcast.dram_sharded_workers[0];
+        start_core = mcast.dram_sharded_workers[0];
+        for (const CoreCoord& worker : mcast.dram_sharded_workers) {
+            start_core = {std::min(start_core.x, worker.x), std::min(start_core.y, worker.y)};
+            box_end = {std::max(box_end.x, worker.x), std::max(box_end.y, worker.y)};
+        }
+        core_range = {box_end.x - start_core.x + 1, box_end.y - start_core.y + 1};
+    } else if (not mcast_1d) {
+        core_range = bmm_op_utils::get_core_range(num_blocks_y, num_blocks_x, num_cores_y, num_cores_x);
+    }
+    TT_ASSERT(not mcast_1d or core_range.x * core_range.y == num_blocks_total);
+    // Core x of a row holds K-block x of the row, so there are as many K-blocks as cores in a row
+    TT_FATAL(not in0_sharded or num_blocks == core_range.x, "Sharded in0 needs one K-block per core column");
 
     uint32_t start_core_x = start_core.x;
     uint32_t start_core_y = start_core.y;
@@ -223,6 +662,23 @@ void matmul_multicore_reuse_mcast(
         {(std::size_t)start_core_x, (std::size_t)start_core_y},
         {(std::size_t)start_core_x + num_cores_c - 1, (std::size_t)start_core_y + num_cores_r - 1});
 
+    // Cores that compute an output block: all of them, except for DramSharded where only the workers do
+    CoreRangeSet compute_cores(all_cores);
+    if (dram_sharded) {
+        std::set<CoreRange> worker_ranges;
+        for (const CoreCoord& worker : mcast.dram_sharded_workers) {
+            worker_ranges.insert(CoreRange(worker));
+        }
+        compute_cores = CoreRangeSet(worker_ranges);
+        for (std::size_t y = start_core_y; y < start_core_y + num_cores_r; y++) {
+            for (std::size_t x = start_core_x; x < start_core_x + num_cores_c; x++) {
+                if (worker_ranges.count(CoreRange(CoreCoord(x, y))) == 0) {
+                    mcast.dram_sharded_idle_cores.push_back({x, y});
+                }
+            }
+        }
+    }
+
     CoreRange left_column(
         {(std::size_t)start_core_x, (std::size_t)start_core_y},
         {(std::size_t)start_core_x, (std::size_t)start_core_y + num_cores_r - 1});
@@ -246,78 +702,171 @@ void matmul_multicore_reuse_mcast(
         {(std::size_t)start_core_x + 1, (std::size_t)start_core_y + 1},
         {(std::size_t)start_core_x + num_cores_c - 1, (std::size_t)start_core_y + num_cores_r - 1});
 
+    // 1D: the first core sends, every other core of the rectangle receives
+    std::set<CoreRange> receiver_ranges_1d;
+    if (num_cores_c > 1) {
+        receiver_ranges_1d.insert(in0_receiver_in1_sender);
+    }
+    if (num_cores_r > 1) {
+        receiver_ranges_1d.insert(CoreRange(
+            {(std::size_t)start_core_x, (std::size_t)start_core_y + 1},
+            {(std::size_t)start_core_x + num_cores_c - 1, (std::size_t)start_core_y + num_cores_r - 1}));
+    }
+    CoreRangeSet receivers_1d(receiver_ranges_1d);
+
+    // Block sharded over the cores of the program: core (x, y) holds K-block x of block row y of in0, and output
+    // block (x, y)
+    auto create_shard_buffer = [&](uint32_t rows_t,
+                                   uint32_t cols_t,
+                                   uint32_t shard_h_t,
+                                   uint32_t shard_w_t,
+                                   uint32_t single_tile_size) {
+        tt_metal::ShardedBufferConfig shard_config{
+            .device = device,
+            .size = single_tile_size * rows_t * cols_t,
+            .page_size = single_tile_size,
+            .buffer_type = tt_metal::BufferType::L1,
+            .buffer_layout = TensorMemoryLayout::BLOCK_SHARDED,
+            .shard_parameters = ShardSpecBuffer(
+                CoreRangeSet(all_cores),
+                {shard_h_t * TILE_HEIGHT, shard_w_t * TILE_WIDTH},
+                ShardOrientation::ROW_MAJOR,
+                false,
+                {TILE_HEIGHT, TILE_WIDTH},
+                {rows_t, cols_t})};
+        return CreateBuffer(shard_config);
+    };
+    if (in0_sharded) {
+        mcast.in0_shard_buffer = create_shard_buffer(Mt, Kt, per_core_M, in0_block_w, in0_single_tile_size);
+    }
+    if (out_sharded) {
+        mcast.out_shard_buffer = create_shard_buffer(Mt, Nt, per_core_M, per_core_N, out_single_tile_size);
+    }
+    // Width sharded over the DRAM banks: bank i holds columns [i * per_core_N, (i + 1) * per_core_N) of all of K,
+    // so each K-block of a shard is one contiguous read
+    if (dram_sharded) {
+        tt_metal::ShardedBufferConfig in1_shard_config{
+            .device = device,
+            .size = in1_single_tile_size * Kt * Nt,
+            .page_size = in1_single_tile_size,
+            .buffer_type = tt_metal::BufferType::DRAM,
+            .buffer_layout = TensorMemoryLayout::WIDTH_SHARDED,
+            .shard_parameters = ShardSpecBuffer(
+                CoreRangeSet(CoreRange({0, 0}, {blocking.num_cores_c - 1, 0})),
+                {Kt * TILE_HEIGHT, per_core_N * TILE_WIDTH},
+                ShardOrientation::ROW_MAJOR,
+                false,
+                {TILE_HEIGHT, TILE_WIDTH},
+                {Kt, Nt})};
+        mcast.in1_shard_buffer = CreateBuffer(in1_shard_config);
+    }
+
     t2 = high_resolution_clock::now();
     duration = t2 - t1;
     if (verbose){
         log_info(tt::LogVerif, "Multi core prep: {} ms", duration.count());
     }
 
-    //////////////////////////////////////////////////
-    /*
-     * Create DRAM Buffers for input and output vectors
-     * Writing data from input vectors to source buffers
-     */
-
     t1 = high_resolution_clock::now();
 
-    uint32_t dram_buffer_A_size =
-        single_tile_size * Mt * Kt;  // num_tiles of FP16_B, hard-coded in the reader/writer kernels
-    uint32_t dram_buffer_B_size =
-        single_tile_size * Nt * Kt;  // num_tiles of FP16_B, hard-coded in the reader/writer kernels
-    uint32_t dram_buffer_C_size =
-        single_tile_size * Mt * Nt;  // num_tiles of FP16_B, hard-coded in the reader/writer kernels
-    tt_metal::InterleavedBufferConfig dram_config_A{
-        .device = device,
-        .size = dram_buffer_A_size,
-        .page_size = single_tile_size,
-        .buffer_type = tt_metal::BufferType::DRAM};
-
-    tt_metal::InterleavedBufferConfig dram_config_B{
-        .device = device,
-        .size = dram_buffer_B_size,
-        .page_size = single_tile_size,
-        .buffer_type = tt_metal::BufferType::DRAM};
-
-    tt_metal::InterleavedBufferConfig dram_config_C{
-        .device = device,
-        .size = dram_buffer_C_size,
-        .page_size = single_tile_size,
-        .buffer_type = tt_metal::BufferType::DRAM};
-
-    auto src0_dram_buffer = CreateBuffer(dram_config_A);
-    auto src1_dram_buffer = CreateBuffer(dram_config_B);
-    auto dst_dram_buffer = CreateBuffer(dram_config_C);
-    uint32_t src0_addr = src0_dram_buffer->address();
-    uint32_t src1_addr = src1_dram_buffer->address();
-    uint32_t dst_addr = dst_dram_buffer->address();
-
     /*
      * Config of Circular Buffer in the device L1
      * input tiles count is = 2 because it's single tile process, and double-buffer
      */
+    // in0 goes to every core, with DramSharded the mcast also lands on the idle cores of the box
     uint32_t src0_cb_index = CBIndex::c_0;  // 0
-    CircularBufferConfig cb_src0_config = CircularBufferConfig(in0_CB_size, {{src0_cb_index, cb_data_format}})
-                                              .set_page_size(src0_cb_index, single_tile_size);
+    CircularBufferConfig cb_src0_config = CircularBufferConfig(in0_CB_size, {{src0_cb_index, data_formats.in0}})
+                                              .set_page_size(src0_cb_index, in0_single_tile_size);
     auto cb_src0 = tt_metal::CreateCircularBuffer(program, all_cores, cb_src0_config);
 
     uint32_t src1_cb_index = CBIndex::c_1;  // 1
-    CircularBufferConfig cb_src1_config = CircularBufferConfig(in1_CB_size, {{src1_cb_index, cb_data_format}})
-                                              .set_page_size(src1_cb_index, single_tile_size);
-    auto cb_src1 = tt_metal::CreateCircularBuffer(program, all_cores, cb_src1_config);
+    CircularBufferConfig cb_src1_config = CircularBufferConfig(in1_CB_size, {{src1_cb_index, data_formats.in1}})
+                                              .set_page_size(src1_cb_index, in1_single_tile_size);
+    auto cb_src1 = tt_metal::CreateCircularBuffer(program, compute_cores, cb_src1_config);
+
+    // The core's in0 shard, mcasted along the row into c_0 by reader_bmm_mcast
+    if (in0_sharded) {
+        uint32_t src0_shard_cb_index = CBIndex::c_2;
+        CircularBufferConfig cb_src0_shard_config =
+            CircularBufferConfig(in0_block_tiles * in0_single_tile_size, {{src0_shard_cb_index, data_formats.in0}})
+                .set_page_size(src0_shard_cb_index, in0_single_tile_size)
+                .set_globally_allocated_address(*mcast.in0_shard_buffer);
+        auto cb_src0_shard = tt_metal::CreateCircularBuffer(program, all_cores, cb_src0_shard_config);
+    }
+
+    // Row-major blocks as read (and mcasted) by reader_bmm_mcast, tilized into c_0 / c_1 by the compute kernel
+    if (kernel_config.tilize_in0) {
+        uint32_t src0_row_major_cb_index = CBIndex::c_4;
+        CircularBufferConfig cb_src0_row_major_config =
+            CircularBufferConfig(in0_CB_size, {{src0_row_major_cb_index, data_formats.in0}})
+                .set_page_size(src0_row_major_cb_index, in0_single_tile_size);
+        auto cb_src0_row_major = tt_metal::CreateCircularBuffer(program, all_cores, cb_src0_row_major_config);
+    }
+    if (kernel_config.tilize_in1) {
+        uint32_t src1_row_major_cb_index = CBIndex::c_5;
+        CircularBufferConfig cb_src1_row_major_config =
+            CircularBufferConfig(in1_CB_size, {{src1_row_major_cb_index, data_formats.in1}})
+                .set_page_size(src1_row_major_cb_index, in1_single_tile_size);
+        auto cb_src1_row_major = tt_metal::CreateCircularBuffer(program, compute_cores, cb_src1_row_major_config);
+    }
 
     uint32_t output_cb_index = tt::CBIndex::c_16;
     uint32_t interm0_cb_index = 24;
-    std::map<uint8_t, tt::DataFormat> output_cb_data_format_spec{
-        {output_cb_index, cb_data_format}, {interm0_cb_index, cb_data_format}};
-    CircularBufferConfig cb_output_config = CircularBufferConfig(out_CB_size, output_cb_data_format_spec)
-                                                .set_page_size(output_cb_index, single_tile_size)
-                                                .set_page_size(interm0_cb_index, single_tile_size);
-    auto cb_output = tt_metal::CreateCircularBuffer(program, CoreRangeSet({all_cores}), cb_output_config);
+    tt::DataFormat interm0_data_format = get_interm_cb_data_format(data_formats.out, kernel_config.packer_l1_acc);
+    // Untilize reads the interm CB a row of subblocks at a time while writing rows of the out CB,
+    // so the two can not share memory. Neither can a double-buffered out CB, the partials of block i + 1 would
+    // land on the output of block i.
+    if (interm0_data_format != data_formats.out or kernel_config.untilize_out or out_blocks) {
+        CircularBufferConfig cb_output_config =
+            CircularBufferConfig(out_CB_size, {{output_cb_index, data_formats.out}})
+                .set_page_size(output_cb_index, out_single_tile_size);
+        if (out_sharded) {
+            cb_output_config.set_globally_allocated_address(*mcast.out_shard_buffer);
+        }
+        auto cb_output = tt_metal::CreateCircularBuffer(program, compute_cores, cb_output_config);
+
+        // Exactly one output block, the packer accumulates every K-block onto the same tiles
+        uint32_t interm0_single_tile_size = detail::TileSize(interm0_data_format);
+        CircularBufferConfig cb_interm0_config =
+            CircularBufferConfig(out_block_tiles * interm0_single_tile_size, {{interm0_cb_index, interm0_data_format}})
+                .set_page_size(interm0_cb_index, interm0_single_tile_size);
+        auto cb_interm0 = tt_metal::CreateCircularBuffer(program, compute_cores, cb_interm0_config);
+    } else {
+        std::map<uint8_t, tt::DataFormat> output_cb_data_format_spec{
+            {output_cb_index, data_formats.out}, {interm0_cb_index, data_formats.out}};
+        CircularBufferConfig cb_output_config = CircularBufferConfig(out_CB_size, output_cb_data_format_spec)
+                                                    .set_page_size(output_cb_index, out_single_tile_size)
+                                                    .set_page_size(interm0_cb_index, out_single_tile_size);
+        // The partials are packed into the shard too, the last K-block overwrites them with the output
+        if (out_sharded) {
+            cb_output_config.set_globally_allocated_address(*mcast.out_shard_buffer);
+        }
+        auto cb_output = tt_metal::CreateCircularBuffer(program, compute_cores, cb_output_config);
+    }
+
+    if (epilogue.fuse_bias) {
+        // Bias row tiles of the core's output columns, read once by the writer, stored like the activations
+        uint32_t bias_cb_index = CBIndex::c_3;
+        CircularBufferConfig cb_bias_config =
+            CircularBufferConfig(per_core_N * in0_single_tile_size, {{bias_cb_index, data_formats.in0}})
+                .set_page_size(bias_cb_index, in0_single_tile_size);
+        auto cb_bias = tt_metal::CreateCircularBuffer(program, compute_cores, cb_bias_config);
+
+        // Matmul result of one subblock before the bias add
+        uint32_t mm_bias_intermediate_cb_index = CBIndex::c_25;
+        CircularBufferConfig cb_mm_bias_intermediate_config =
+            CircularBufferConfig(
+                out_subblock_h * out_subblock_w * out_single_tile_size,
+                {{mm_bias_intermediate_cb_index, data_formats.out}})
+                .set_page_size(mm_bias_intermediate_cb_index, out_single_tile_size);
+        auto cb_mm_bias_intermediate =
+            tt_metal::CreateCircularBuffer(program, compute_cores, cb_mm_bias_intermediate_config);
+    }
 
     t2 = high_resolution_clock::now();
     duration = t2 - t1;
     if (verbose){
-        log_info(tt::LogVerif, "Create CB and DRAM buffers: {} ms", duration.count());
+        log_info(tt::LogVerif, "Create CBs: {} ms", duration.count());
     }
 
     ////////////////////////////
@@ -326,290 +875,1912 @@ void matmul_multicore_reuse_mcast(
      */
     t1 = high_resolution_clock::now();
 
-    bool src0_is_dram = src0_dram_buffer->buffer_type() == tt_metal::BufferType::DRAM ? 1 : 0;
-    bool src1_is_dram = src1_dram_buffer->buffer_type() == tt_metal::BufferType::DRAM ? 1 : 0;
+    // All buffers are DRAM interleaved (see matmul_multicore_reuse_mcast)
+    bool src0_is_dram = true;
+    bool src1_is_dram = true;
     std::vector<uint32_t> reader_compile_time_args = {(uint32_t)src0_is_dram, (uint32_t)src1_is_dram};
 
-    bool dst_is_dram = dst_dram_buffer->buffer_type() == tt_metal::BufferType::DRAM ? 1 : 0;
+    bool dst_is_dram = true;
     // std::vector<uint32_t> writer_compile_time_args = {(std::uint32_t) output_cb_index, (uint32_t)dst_is_dram};
     std::vector<uint32_t> writer_compile_time_args = {(uint32_t)dst_is_dram};
 
+    std::map<string, string> writer_defines;
+    std::map<string, string> mm_kernel_defines;
+    std::string writer_kernel_path =
+        "tt_metal/programming_examples/matmul_common/kernels/dataflow/writer_bmm_tile_layout.cpp";
+    std::string mm_kernel_path = "tt_metal/programming_examples/matmul_common/kernels/compute/bmm_large_block_zm.cpp";
+    if (epilogue.fuse_bias) {
+        bool bias_is_dram = true;
+        writer_compile_time_args.push_back((uint32_t)bias_is_dram);
+        writer_defines["FUSE_BIAS"] = "1";
+        mm_kernel_defines["FUSE_BIAS"] = "1";
+        writer_kernel_path = std::string(MATMUL_KERNELS_DIR) + "dataflow/writer_bmm_tile_layout_bias.cpp";
+    }
+    if (epilogue.activation != Activation::None) {
+        mm_kernel_defines.merge(get_activation_defines(epilogue.activation));
+    }
+    if (out_blocks) {
+        // The upstream writer has no output blocks, its local copy does
+        writer_kernel_path = std::string(MATMUL_KERNELS_DIR) + "dataflow/writer_bmm_tile_layout_bias.cpp";
+        writer_defines["OUT_NUM_BLOCKS_H"] = std::to_string(num_out_blocks_h);
+        writer_defines["OUT_NUM_BLOCKS_W"] = std::to_string(num_out_blocks_w);
+        mm_kernel_defines["OUT_NUM_BLOCKS_W"] = std::to_string(num_out_blocks_w);
+    }
+    if (kernel_config.packer_l1_acc) {
+        mm_kernel_defines["PACKER_L1_ACC"] = "1";
+    }
+    if (kernel_config.untilize_out) {
+        mm_kernel_defines["UNTILIZE_OUT"] = "1";
+        writer_kernel_path = std::string(MATMUL_KERNELS_DIR) + "dataflow/writer_bmm_row_major.cpp";
+    }
+    if (out_sharded) {
+        // Reads the bias with FUSE_BIAS, otherwise only waits for the output block
+        writer_kernel_path = std::string(MATMUL_KERNELS_DIR) + "dataflow/writer_bmm_sharded.cpp";
+    }
+    if (kernel_config.tilize_in0) {
+        mm_kernel_defines["TILIZE_IN0"] = "1";
+    }
+    if (kernel_config.tilize_in1) {
+        mm_kernel_defines["TILIZE_IN1"] = "1";
+    }
+    // bmm_large_block_zm reloads the partials without reconfiguring srcA from the in1 format
+    bool mixed_data_formats = data_formats.in0 != data_formats.in1 or data_formats.in0 != data_formats.out;
+    if (kernel_config.matmul_block) {
+        // Same compile args and CBs as the per-tile kernel below
+        mm_kernel_path = std::string(COMPUTE_MM_KERNELS_DIR) + "bmm_large_block_zm_fused_bias_activation_block.cpp";
+    } else if (
+        epilogue.fuse_bias or epilogue.activation != Activation::None or kernel_config.packer_l1_acc or
+        kernel_config.untilize_out or kernel_config.tilize_in0 or kernel_config.tilize_in1 or mixed_data_formats) {
+        // Same compile args as bmm_large_block_zm, plus the FUSE_BIAS / SFPU_OP_*_ACTIVATION epilogue,
+        // PACKER_L1_ACC, UNTILIZE_OUT and TILIZE_IN0 / TILIZE_IN1
+        mm_kernel_path = std::string(COMPUTE_MM_KERNELS_DIR) + "bmm_large_block_zm_fused_bias_activation.cpp";
+    }
+
     /*
      * Create Kernels (Reader, Writer, Compute)
      */
     // Create reader and writer kernels per core group
 
-    auto mm_reader_kernel_in0_sender_in1_sender_id = tt_metal::CreateKernel(
-        program,
-        "tt_metal/programming_examples/matmul_common/kernels/dataflow/reader_bmm_tile_layout_in0_sender_in1_sender.cpp",
-        in0_sender_in1_sender,
-        tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_1,
-            .noc = tt_metal::NOC::RISCV_0_default,
-            .compile_args = reader_compile_time_args});
-
-    auto mm_reader_kernel_in0_sender_in1_receiver_id = tt_metal::CreateKernel(
-        program,
-        "tt_metal/programming_examples/matmul_common/kernels/dataflow/"
-        "reader_bmm_tile_layout_in0_sender_in1_receiver.cpp",
-        in0_sender_in1_receiver,
-        tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_1,
-            .noc = tt_metal::NOC::RISCV_0_default,
-            .compile_args = reader_compile_time_args});
-
-    auto mm_reader_kernel_in0_receiver_in1_sender_id = tt_metal::CreateKernel(
-        program,
-        "tt_metal/programming_examples/matmul_common/kernels/dataflow/"
-        "reader_bmm_tile_layout_in0_receiver_in1_sender.cpp",
-        in0_receiver_in1_sender,
-        tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_1,
-            .noc = tt_metal::NOC::RISCV_1_default,
-            .compile_args = reader_compile_time_args});
-
-    auto mm_reader_kernel_in0_receiver_in1_receiver_id = tt_metal::CreateKernel(
-        program,
-        "tt_metal/programming_examples/matmul_common/kernels/dataflow/"
-        "reader_bmm_tile_layout_in0_receiver_in1_receiver.cpp",
-        in0_receiver_in1_receiver,
-        tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_1,
-            .noc = tt_metal::NOC::RISCV_1_default,
-            .compile_args = reader_compile_time_args});
-
-    auto unary_writer_kernel_noc0_id = tt_metal::CreateKernel(
-        program,
-        "tt_metal/programming_examples/matmul_common/kernels/dataflow/writer_bmm_tile_layout.cpp",
-        all_except_left_column,
-        tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_0,
-            .noc = tt_metal::NOC::RISCV_0_default,
-            .compile_args = writer_compile_time_args});
-
-    auto unary_writer_kernel_noc1_id = tt_metal::CreateKernel(
-        program,
-        "tt_metal/programming_examples/matmul_common/kernels/dataflow/writer_bmm_tile_layout.cpp",
-        left_column,
-        tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_0,
-            .noc = tt_metal::NOC::RISCV_1_default,
-            .compile_args = writer_compile_time_args});
+    // The upstream readers only take interleaved tile layout inputs, 2D mcast and one output block per core,
+    // reader_bmm_mcast is all four of them with the role, the layout, the mcast mode, the in0 sharding and the
+    // output blocks as compile time args
+    bool row_major_inputs = kernel_config.tilize_in0 or kernel_config.tilize_in1;
+    // reader_bmm_mcast mcast modes: 0 every core reads its own blocks, 1 mcast to the other cores of the
+    // row / column, 2 mcast to a rectangle that includes the sender
+    uint32_t in0_mcast_mode = 1;
+    uint32_t in1_mcast_mode = 1;
+    if (mcast_1d) {
+        in0_mcast_mode = blocking.layout == McastLayout::Mcast1DIn0 ? 2 : 0;
+        in1_mcast_mode = blocking.layout == McastLayout::Mcast1DIn1 ? 2 : 0;
+    }
+    auto create_reader_kernel = [&](const std::string& reader_kernel_name,
+                                    const auto& cores,
+                                    bool in0_sender,
+                                    bool in1_sender,
+                                    tt_metal::NOC noc) {
+        std::string reader_kernel_path =
+            "tt_metal/programming_examples/matmul_common/kernels/dataflow/" + reader_kernel_name;
+        std::vector<uint32_t> compile_args = reader_compile_time_args;
+        if (row_major_inputs or mcast_1d or in0_sharded or out_blocks) {
+            reader_kernel_path = std::string(MATMUL_KERNELS_DIR) + "dataflow/reader_bmm_mcast.cpp";
+            compile_args.insert(
+                compile_args.end(),
+                {(uint32_t)in0_sender,
+                 (uint32_t)in1_sender,
+                 (uint32_t)kernel_config.tilize_in0,
+                 (uint32_t)kernel_config.tilize_in1,
+                 in0_mcast_mode,
+                 in1_mcast_mode,
+                 (uint32_t)in0_sharded,
+                 num_out_blocks_h,
+                 num_out_blocks_w});
+        }
+        return tt_metal::CreateKernel(
+            program,
+            reader_kernel_path,
+            cores,
+            tt_metal::DataMovementConfig{
+                .processor = tt_metal::DataMovementProcessor::RISCV_1, .noc = noc, .compile_args = compile_args});
+    };
+
+    if (dram_sharded) {
+        // The first worker reads and mcasts in0, the other workers receive it, every worker streams its in1 shard.
+        // Group 0: in0 sender, 1: in0 receivers, 2: idle cores of the box; writers only on the workers.
+        // in0 is not read by the idle cores, their reader is on the opposite NOC like the receivers.
+        std::string reader_kernel_path = std::string(MATMUL_KERNELS_DIR) + "dataflow/reader_bmm_dram_sharded.cpp";
+        std::vector<CoreCoord>& workers = mcast.dram_sharded_workers;
+        std::set<CoreRange> receiver_ranges;
+        for (std::size_t i = 1; i < workers.size(); i++) {
+            receiver_ranges.insert(CoreRange(workers[i]));
+        }
+        std::set<CoreRange> idle_ranges;
+        for (const CoreCoord& core : mcast.dram_sharded_idle_cores) {
+            idle_ranges.insert(CoreRange(core));
+        }
+        auto create_dram_sharded_reader_kernel = [&](const CoreRangeSet& cores, uint32_t role, tt_metal::NOC noc) {
+            return tt_metal::CreateKernel(
+                program,
+                reader_kernel_path,
+                cores,
+                tt_metal::DataMovementConfig{
+                    .processor = tt_metal::DataMovementProcessor::RISCV_1,
+                    .noc = noc,
+                    .compile_args = {(uint32_t)src0_is_dram, role}});
+        };
+        mcast.reader_kernel_ids.fill(
+            create_dram_sharded_reader_kernel(CoreRangeSet(CoreRange(workers[0])), 0, tt_metal::NOC::RISCV_0_default));
+        if (not receiver_ranges.empty()) {
+            mcast.reader_kernel_ids[1] =
+                create_dram_sharded_reader_kernel(CoreRangeSet(receiver_ranges), 1, tt_metal::NOC::RISCV_1_default);
+        }
+        if (not idle_ranges.empty()) {
+            mcast.reader_kernel_ids[2] =
+                create_dram_sharded_reader_kernel(CoreRangeSet(idle_ranges), 2, tt_metal::NOC::RISCV_1_default);
+        }
+        mcast.writer_kernel_ids.fill(tt_metal::CreateKernel(
+            program,
+            writer_kernel_path,
+            compute_cores,
+            tt_metal::DataMovementConfig{
+                .processor = tt_metal::DataMovementProcessor::RISCV_0,
+                .noc = tt_metal::NOC::RISCV_0_default,
+                .compile_args = writer_compile_time_args,
+                .defines = writer_defines}));
+    } else if (mcast_1d) {
+        // Sender on RISCV_0_default, receivers and writers on the opposite NOC. Unused groups keep the sender ids,
+        // McastRuntimeArgsBuilder::set skips them
+        bool in0_sender_1d = blocking.layout == McastLayout::Mcast1DIn1;
+        bool in1_sender_1d = blocking.layout == McastLayout::Mcast1DIn0;
+        auto mm_reader_kernel_sender_id = create_reader_kernel(
+            "reader_bmm_mcast.cpp", in0_sender_in1_sender, true, true, tt_metal::NOC::RISCV_0_default);
+        auto unary_writer_kernel_sender_id = tt_metal::CreateKernel(
+            program,
+            writer_kernel_path,
+            in0_sender_in1_sender,
+            tt_metal::DataMovementConfig{
+                .processor = tt_metal::DataMovementProcessor::RISCV_0,
+                .noc = tt_metal::NOC::RISCV_1_default,
+                .compile_args = writer_compile_time_args,
+                .defines = writer_defines});
+        mcast.reader_kernel_ids.fill(mm_reader_kernel_sender_id);
+        mcast.writer_kernel_ids.fill(unary_writer_kernel_sender_id);
+        if (num_cores_c * num_cores_r > 1) {
+            uint32_t receiver_group = in1_sender_1d ? 2 : 1;
+            mcast.reader_kernel_ids[receiver_group] = create_reader_kernel(
+                "reader_bmm_mcast.cpp",
+                receivers_1d,
+                in0_sender_1d,
+                in1_sender_1d,
+                tt_metal::NOC::RISCV_1_default);
+            mcast.writer_kernel_ids[receiver_group] = tt_metal::CreateKernel(
+                program,
+                writer_kernel_path,
+                receivers_1d,
+                tt_metal::DataMovementConfig{
+                    .processor = tt_metal::DataMovementProcessor::RISCV_0,
+                    .noc = tt_metal::NOC::RISCV_0_default,
+                    .compile_args = writer_compile_time_args,
+                    .defines = writer_defines});
+        }
+    } else {
+        auto mm_reader_kernel_in0_sender_in1_sender_id = create_reader_kernel(
+            "reader_bmm_tile_layout_in0_sender_in1_sender.cpp",
+            in0_sender_in1_sender,
+            true,
+            true,
+            tt_metal::NOC::RISCV_0_default);
+
+        auto mm_reader_kernel_in0_sender_in1_receiver_id = create_reader_kernel(
+            "reader_bmm_tile_layout_in0_sender_in1_receiver.cpp",
+            in0_sender_in1_receiver,
+            true,
+            false,
+            tt_metal::NOC::RISCV_0_default);
+
+        auto mm_reader_kernel_in0_receiver_in1_sender_id = create_reader_kernel(
+            "reader_bmm_tile_layout_in0_receiver_in1_sender.cpp",
+            in0_receiver_in1_sender,
+            false,
+            true,
+            tt_metal::NOC::RISCV_1_default);
+
+        auto mm_reader_kernel_in0_receiver_in1_receiver_id = create_reader_kernel(
+            "reader_bmm_tile_layout_in0_receiver_in1_receiver.cpp",
+            in0_receiver_in1_receiver,
+            false,
+            false,
+            tt_metal::NOC::RISCV_1_default);
+
+        auto unary_writer_kernel_noc0_id = tt_metal::CreateKernel(
+            program,
+            writer_kernel_path,
+            all_except_left_column,
+            tt_metal::DataMovementConfig{
+                .processor = tt_metal::DataMovementProcessor::RISCV_0,
+                .noc = tt_metal::NOC::RISCV_0_default,
+                .compile_args = writer_compile_time_args,
+                .defines = writer_defines});
+
+        auto unary_writer_kernel_noc1_id = tt_metal::CreateKernel(
+            program,
+            writer_kernel_path,
+            left_column,
+            tt_metal::DataMovementConfig{
+                .processor = tt_metal::DataMovementProcessor::RISCV_0,
+                .noc = tt_metal::NOC::RISCV_1_default,
+                .compile_args = writer_compile_time_args,
+                .defines = writer_defines});
+
+        // Indexed by McastRuntimeArgsBuilder group: readers on RISCV_0_default for the left column, writers the
+        // opposite NOC
+        mcast.reader_kernel_ids = {
+            mm_reader_kernel_in0_sender_in1_sender_id,
+            mm_reader_kernel_in0_sender_in1_receiver_id,
+            mm_reader_kernel_in0_receiver_in1_sender_id,
+            mm_reader_kernel_in0_receiver_in1_receiver_id};
+        mcast.writer_kernel_ids = {
+            unary_writer_kernel_noc1_id,
+            unary_writer_kernel_noc1_id,
+            unary_writer_kernel_noc0_id,
+            unary_writer_kernel_noc0_id};
+    }
 
     // Create compute kernel
     auto mm_kernel_id = tt_metal::CreateKernel(
         program,
-        "tt_metal/programming_examples/matmul_common/kernels/compute/bmm_large_block_zm.cpp",
-        all_cores,
-        tt_metal::ComputeConfig{.math_fidelity = math_fidelity, .compile_args = compute_kernel_args});
+        mm_kernel_path,
+        compute_cores,
+        tt_metal::ComputeConfig{
+            .math_fidelity = math_fidelity, .compile_args = compute_kernel_args, .defines = mm_kernel_defines});
 
     auto in0_mcast_sender_semaphore_id = tt_metal::CreateSemaphore(program, all_cores, INVALID);
     auto in0_mcast_receiver_semaphore_id = tt_metal::CreateSemaphore(program, all_cores, INVALID);
     auto in1_mcast_sender_semaphore_id = tt_metal::CreateSemaphore(program, all_cores, INVALID);
     auto in1_mcast_receiver_semaphore_id = tt_metal::CreateSemaphore(program, all_cores, INVALID);
 
-    /*
-     * Kernels - Runtime arguments
-     */
-    std::vector<KernelHandle> reader_kernel_ids;
-    std::vector<KernelHandle> writer_kernel_ids;
-    for (int core_idx_y = 0; core_idx_y < num_cores_r; core_idx_y++) {
-        for (int core_idx_x = 0; core_idx_x < num_cores_c; core_idx_x++) {
-            CoreCoord core = {(std::size_t)start_core_x + core_idx_x, (std::size_t)start_core_y + core_idx_y};
-
-            CoreCoord left_core = {(std::size_t)start_core_x, (std::size_t)core.y};
-            CoreCoord left_core_plus_one = {(std::size_t)start_core_x + 1, (std::size_t)core.y};
-            CoreCoord right_core = {(std::size_t)start_core_x + num_cores_c - 1, (std::size_t)core.y};
-            CoreCoord top_core = {(std::size_t)core.x, (std::size_t)start_core_y};
-            CoreCoord top_core_plus_one = {(std::size_t)core.x, (std::size_t)start_core_y + 1};
-            CoreCoord bottom_core = {(std::size_t)core.x, (std::size_t)start_core_y + num_cores_r - 1};
-
-            auto left_core_physical = device->worker_core_from_logical_core(left_core);
-            auto left_core_plus_one_physical = device->worker_core_from_logical_core(left_core_plus_one);
-            auto right_core_physical = device->worker_core_from_logical_core(right_core);
-            auto top_core_physical = device->worker_core_from_logical_core(top_core);
-            auto top_core_plus_one_physical = device->worker_core_from_logical_core(top_core_plus_one);
-            auto bottom_core_physical = device->worker_core_from_logical_core(bottom_core);
-
-            std::vector<uint32_t> mm_reader_args = {
-                (std::uint32_t)src0_dram_buffer->address(),   // in0_buffer_addr
-                (std::uint32_t)Kt * per_core_M * core_idx_y,  // in0_buffer_start_tile_id
-                (std::uint32_t)1,                             // in0_buffer_stride_w
-                (std::uint32_t)Kt,                            // in0_buffer_stride_h
-                (std::uint32_t)in0_block_w,                   // in0_buffer_next_block_stride
-
-                (std::uint32_t)in0_block_w,               // in0_block_w
-                (std::uint32_t)per_core_M,                // in0_block_h
-                (std::uint32_t)in0_block_w * per_core_M,  // in0_block_num_tiles
-
-                (std::uint32_t)src1_dram_buffer->address(),  // in1_buffer_addr
-                (std::uint32_t)per_core_N * core_idx_x,      // in1_buffer_start_tile_id
-                (std::uint32_t)1,                            // in1_buffer_stride_w
-                (std::uint32_t)Nt,                           // in1_buffer_stride_h
-                (std::uint32_t)in0_block_w * Nt,             // in1_buffer_next_block_stride
-
-                (std::uint32_t)per_core_N,                // in1_block_w
-                (std::uint32_t)in0_block_w,               // in1_block_h
-                (std::uint32_t)per_core_N * in0_block_w,  // in1_block_num_tiles
-
-                (std::uint32_t)Kt / in0_block_w,  // num_blocks
-
-                (std::uint32_t)right_core_physical.x,          // in0_mcast_dest_noc_start_x
-                (std::uint32_t)right_core_physical.y,          // in0_mcast_dest_noc_start_y
-                (std::uint32_t)left_core_plus_one_physical.x,  // in0_mcast_dest_noc_end_x
-                (std::uint32_t)left_core_plus_one_physical.y,  // in0_mcast_dest_noc_end_y
-                (std::uint32_t)(num_cores_c - 1),              // in0_mcast_num_dests
-                (std::uint32_t)left_core_physical.x,           // in0_mcast_sender_noc_x
-                (std::uint32_t)left_core_physical.y,           // in0_mcast_sender_noc_y
-                (std::uint32_t)in0_mcast_sender_semaphore_id,
-                (std::uint32_t)in0_mcast_receiver_semaphore_id,
-
-                (std::uint32_t)bottom_core_physical.x,        // in0_mcast_dest_noc_start_x
-                (std::uint32_t)bottom_core_physical.y,        // in0_mcast_dest_noc_start_y
-                (std::uint32_t)top_core_plus_one_physical.x,  // in0_mcast_dest_noc_end_x
-                (std::uint32_t)top_core_plus_one_physical.y,  // in0_mcast_dest_noc_end_y
-                (std::uint32_t)(num_cores_r - 1),             // in0_mcast_num_dests
-                (std::uint32_t)top_core_physical.x,           // in0_mcast_sender_noc_x
-                (std::uint32_t)top_core_physical.y,           // in0_mcast_sender_noc_y
-                (std::uint32_t)in1_mcast_sender_semaphore_id,
-                (std::uint32_t)in1_mcast_receiver_semaphore_id,
-
-                (std::uint32_t)Mt * Kt,     // MtKt
-                (std::uint32_t)Kt * Nt,     // KtNt
-                (std::uint32_t)B,           // batch
-                (std::uint32_t)bcast_batch  // bcast_B
-            };
+    mcast.runtime_args_params = McastRuntimeArgsParams{
+        .Mt = Mt,
+        .Nt = Nt,
+        .Kt = Kt,
+        .B = B,
+        .in0_block_w = in0_block_w,
+        .per_core_M = per_core_M,
+        .per_core_N = per_core_N,
+        .out_subblock_h = out_subblock_h,
+        .out_subblock_w = out_subblock_w,
+        .start_core = start_core,
+        .num_cores_c = num_cores_c,
+        .num_cores_r = num_cores_r,
+        .in0_mcast_sender_semaphore_id = in0_mcast_sender_semaphore_id,
+        .in0_mcast_receiver_semaphore_id = in0_mcast_receiver_semaphore_id,
+        .in1_mcast_sender_semaphore_id = in1_mcast_sender_semaphore_id,
+        .in1_mcast_receiver_semaphore_id = in1_mcast_receiver_semaphore_id,
+        .fuse_bias = epilogue.fuse_bias,
+        .layout = blocking.layout,
+        .in0_sharded = in0_sharded,
+        .num_out_blocks_h = num_out_blocks_h,
+        .num_out_blocks_w = num_out_blocks_w};
 
-            std::vector<uint32_t> writer_args = {
-                (std::uint32_t)dst_dram_buffer->address(),                              // out_buffer_addr
-                (std::uint32_t)core_idx_x * per_core_N + core_idx_y * per_core_M * Nt,  // out_buffer_start_tile_id
-                (std::uint32_t)1,                                                       // out_buffer_stride_w
-                (std::uint32_t)Nt,                                                      // out_buffer_stride_h
-                (std::uint32_t)out_subblock_w,       // out_buffer_next_subblock_stride_w
-                (std::uint32_t)out_subblock_h * Nt,  // out_buffer_next_subblock_stride_h
-
-                (std::uint32_t)out_subblock_w,                     // out_subblock_w
-                (std::uint32_t)out_subblock_h,                     // out_subblock_h
-                (std::uint32_t)(out_subblock_w * out_subblock_h),  // out_subblocks_w * out_subblocks_h
-                (std::uint32_t)(per_core_N / out_subblock_w),      // out_num_subblocks_w
-                (std::uint32_t)(per_core_M / out_subblock_h),      // out_num_subblocks_h
-
-                (std::uint32_t)Mt * Nt,  // MtNt
-                (std::uint32_t)B         // batch
-            };
 
-            if (core_idx_x == 0 and core_idx_y == 0) {
-                tt_metal::SetRuntimeArgs(
-                    program, mm_reader_kernel_in0_sender_in1_sender_id, core, mm_reader_args);      // RISCV_0_default
-                tt_metal::SetRuntimeArgs(program, unary_writer_kernel_noc1_id, core, writer_args);  // RISCV_1_default
-                reader_kernel_ids.push_back(mm_reader_kernel_in0_sender_in1_sender_id);
-                writer_kernel_ids.push_back(unary_writer_kernel_noc1_id);
-            } else if (core_idx_x == 0 and core_idx_y != 0) {
-                tt_metal::SetRuntimeArgs(
-                    program, mm_reader_kernel_in0_sender_in1_receiver_id, core, mm_reader_args);    // RISCV_0_default
-                tt_metal::SetRuntimeArgs(program, unary_writer_kernel_noc1_id, core, writer_args);  // RISCV_1_default
-                reader_kernel_ids.push_back(mm_reader_kernel_in0_sender_in1_receiver_id);
-                writer_kernel_ids.push_back(unary_writer_kernel_noc1_id);
-            } else if (core_idx_x != 0 and core_idx_y == 0) {
-                tt_metal::SetRuntimeArgs(
-                    program, mm_reader_kernel_in0_receiver_in1_sender_id, core, mm_reader_args);    // RISCV_1_default
-                tt_metal::SetRuntimeArgs(program, unary_writer_kernel_noc0_id, core, writer_args);  // RISCV_0_default
-                reader_kernel_ids.push_back(mm_reader_kernel_in0_receiver_in1_sender_id);
-                writer_kernel_ids.push_back(unary_writer_kernel_noc0_id);
-            } else {
-                tt_metal::SetRuntimeArgs(
-                    program, mm_reader_kernel_in0_receiver_in1_receiver_id, core, mm_reader_args);  // RISCV_1_default
-                tt_metal::SetRuntimeArgs(program, unary_writer_kernel_noc0_id, core, writer_args);  // RISCV_0_default
-                reader_kernel_ids.push_back(mm_reader_kernel_in0_receiver_in1_receiver_id);
-                writer_kernel_ids.push_back(unary_writer_kernel_noc0_id);
-            }
-        }
-    }
     t2 = high_resolution_clock::now();
     duration = t2 - t1;
     if (verbose){
-        log_info(tt::LogVerif, "Kernel compilation: {} ms", duration.count());
+        log_info(tt::LogVerif, "Create kernels: {} ms", duration.count());
     }
+    return mcast;
+}
 
-    /* Launch program & read in output buffer result into the host vector */
-    std::chrono::duration<double, std::milli> tot_duration(0);
-
-    EnqueueWriteBuffer(cq, src0_dram_buffer, a.data(), false);
-    EnqueueWriteBuffer(cq, src1_dram_buffer, b.data(), false);
+/*
+ * DramSharded runtime args, one core at a time: worker i streams the shard of bank i and writes output block i,
+ * the idle cores of the box get the same in0 mcast args. Few cores, so no arena like McastRuntimeArgsBuilder.
+ */
+void set_dram_sharded_runtime_args(Device* device, McastProgram& mcast) {
+    const McastRuntimeArgsParams& p = mcast.runtime_args_params;
+    const CoreCoordTable& coords = CoreCoordTable::get(device);
+    const CoreCoord& mcast_start = coords.physical(p.start_core.x, p.start_core.y);
+    const CoreCoord& mcast_end =
+        coords.physical(p.start_core.x + p.num_cores_c - 1, p.start_core.y + p.num_cores_r - 1);
+    const CoreCoord& sender = coords.physical(mcast.dram_sharded_workers[0].x, mcast.dram_sharded_workers[0].y);
+
+    auto reader_args = [&](uint32_t bank_id) {
+        return std::vector<uint32_t>{
+            p.src0_addr,                                  // in0_buffer_addr
+            p.Kt,                                         // in0_buffer_stride_h
+            p.in0_block_w,                                // in0_block_w
+            p.per_core_M,                                 // in0_block_h
+            p.in0_block_w * p.per_core_M,                 // in0_block_num_tiles
+            p.Kt / p.in0_block_w,                         // num_blocks
+            p.src1_addr,                                  // in1_buffer_addr
+            bank_id,                                      // in1_dram_bank_id
+            p.in0_block_w * p.per_core_N,                 // in1_block_num_tiles
+            (uint32_t)mcast_end.x,                        // in0_mcast_dest_noc_start_x
+            (uint32_t)mcast_end.y,                        // in0_mcast_dest_noc_start_y
+            (uint32_t)mcast_start.x,                      // in0_mcast_dest_noc_end_x
+            (uint32_t)mcast_start.y,                      // in0_mcast_dest_noc_end_y
+            p.num_cores_c * p.num_cores_r - 1,            // in0_mcast_num_dests
+            (uint32_t)sender.x,                           // in0_mcast_sender_noc_x
+            (uint32_t)sender.y,                           // in0_mcast_sender_noc_y
+            p.in0_mcast_sender_semaphore_id,
+            p.in0_mcast_receiver_semaphore_id};
+    };
 
-    t1 = high_resolution_clock::now();
-    for (int i = 0; i < repeat_n; i++){
-        EnqueueProgram(cq, program, false);
-        EnqueueReadBuffer(cq, dst_dram_buffer, output.data(), true);
+    std::vector<uint32_t> writer_args(MCAST_WRITER_NUM_ARGS + (p.fuse_bias ? MCAST_WRITER_BIAS_NUM_ARGS : 0));
+    for (uint32_t bank_id = 0; bank_id < mcast.dram_sharded_workers.size(); bank_id++) {
+        const CoreCoord& worker = mcast.dram_sharded_workers[bank_id];
+        uint32_t group_idx = bank_id == 0 ? 0 : 1;
+        tt_metal::SetRuntimeArgs(mcast.program, mcast.reader_kernel_ids[group_idx], worker, reader_args(bank_id));
+        McastRuntimeArgsBuilder::fill_writer_args(writer_args.data(), p, bank_id, 0);
+        tt_metal::SetRuntimeArgs(mcast.program, mcast.writer_kernel_ids[group_idx], worker, writer_args);
+    }
+    for (const CoreCoord& core : mcast.dram_sharded_idle_cores) {
+        tt_metal::SetRuntimeArgs(mcast.program, mcast.reader_kernel_ids[2], core, reader_args(0));
     }
-
-    t2 = high_resolution_clock::now();
-    duration = t2 - t1;
-    tot_duration = duration + tot_duration;
-    log_info(tt::LogVerif, "Program duration mean over {} repeats: {} ms", repeat_n, tot_duration.count() / repeat_n);
 }
 
-///////////////////////////////////////
-
-int main(int argc, char** argv) {
-    bool pass = true;
+/*
+ * Host vectors are bfloat16 in tile layout, Bfp operands are packed per tile before the upload (pre-quantised
+ * weights would come packed already)
+ */
+std::vector<uint32_t> pack_bfloat16_tiles(const std::vector<bfloat16>& tiles, tt::DataFormat data_format) {
+    std::vector<float> tiles_fp32(tiles.size());
+    std::transform(tiles.begin(), tiles.end(), tiles_fp32.begin(), [](bfloat16 x) { return x.to_float(); });
+    switch (data_format) {
+        case tt::DataFormat::Float16_b: return pack_bfloat16_vec_into_uint32_vec(tiles);
+        case tt::DataFormat::Bfp8_b:
+            return pack_fp32_vec_as_bfp8_tiles(tiles_fp32, /*row_major_input=*/false, /*is_exp_a=*/false);
+        case tt::DataFormat::Bfp4_b:
+            return pack_fp32_vec_as_bfp4_tiles(tiles_fp32, /*row_major_input=*/false, /*is_exp_a=*/false);
+        default: TT_THROW("Unsupported operand data format {}", (uint32_t)data_format);
+    }
+}
 
-    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
-        TT_THROW("Test not supported w/ slow dispatch, exiting");
+std::vector<bfloat16> unpack_bfloat16_tiles(const std::vector<uint32_t>& packed, tt::DataFormat data_format) {
+    std::vector<float> tiles_fp32;
+    switch (data_format) {
+        case tt::DataFormat::Float16_b: return unpack_uint32_vec_into_bfloat16_vec(packed);
+        case tt::DataFormat::Bfp8_b:
+            tiles_fp32 = unpack_bfp8_tiles_into_float_vec(packed, /*row_major_output=*/false, /*is_exp_a=*/false);
+            break;
+        case tt::DataFormat::Bfp4_b:
+            tiles_fp32 = unpack_bfp4_tiles_into_float_vec(packed, /*row_major_output=*/false, /*is_exp_a=*/false);
+            break;
+        default: TT_THROW("Unsupported operand data format {}", (uint32_t)data_format);
     }
+    return std::vector<bfloat16>(tiles_fp32.begin(), tiles_fp32.end());
+}
 
-    try {
-        /* Silicon accelerator setup */
-        constexpr int device_id = 0;
-        Device* device = CreateDevice(device_id);
-        device->enable_program_cache();
+/*
+ * Program of create_matmul_mcast_program with its DRAM buffers and runtime args: ready to run once the inputs
+ * are written
+ */
+struct McastMatmul {
+    McastProgram mcast;
+    std::shared_ptr<Buffer> src0_dram_buffer;
+    std::shared_ptr<Buffer> src1_dram_buffer;
+    std::shared_ptr<Buffer> dst_dram_buffer;
+    std::shared_ptr<Buffer> bias_dram_buffer;
+    uint32_t dram_buffer_C_size;
+};
+
+McastMatmul setup_matmul_mcast(
+    bool bcast_batch,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t B,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    const MatmulEpilogue& epilogue,
+    const MatmulKernelConfig& kernel_config,
+    Device* device,
+    bool verbose=false) {
+    McastMatmul mm{.mcast = create_matmul_mcast_program(
+                       device, M, N, K, B, data_formats, math_fidelity, epilogue, kernel_config, verbose)};
+    McastProgram& mcast = mm.mcast;
+    Program& program = mcast.program;
 
-        constexpr uint32_t single_tile_size = 2 * 1024;
-        uint32_t dram_buffer_A_size = single_tile_size * Mt * Kt;  // num_tiles of FP16_B
-        uint32_t dram_buffer_B_size = single_tile_size * Nt * Kt;  // num_tiles of FP16_B
-        uint32_t dram_buffer_C_size = single_tile_size * Mt * Nt;  // num_tiles of FP16_B
+    //////////////////////////////////////////////////
+    /*
+     * Create DRAM Buffers for input and output vectors
+     * Writing data from input vectors to source buffers
+     */
 
-        /* input vectors */
-        std::vector<bfloat16> src0_vec = create_random_vector_of_bfloat16_native(dram_buffer_A_size, 1, 123, -0.4);
-        std::vector<bfloat16> src1_vec = create_random_vector_of_bfloat16_native(dram_buffer_B_size, 1, 12522, -0.3);
-        /* Getting number of milliseconds as a double. */
+    auto t1 = high_resolution_clock::now();
 
-        /* Input vector tilizing */
-        auto t1 = high_resolution_clock::now();
-        tilize(src0_vec, M, K);
-        tilize(src1_vec, K, N);
-        auto t2 = high_resolution_clock::now();
-        duration<double, std::milli> til_dur = t2 - t1;
-        log_info(tt::LogVerif, "Time tilizing of vectors: {} ms", til_dur.count());
+    uint32_t in0_single_tile_size = detail::TileSize(data_formats.in0);
+    uint32_t in1_single_tile_size = detail::TileSize(data_formats.in1);
+    uint32_t out_single_tile_size = detail::TileSize(data_formats.out);
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
 
-        /* Calling the MatMul host program. Read in result into a host vector */
-        std::vector<bfloat16> result_vec(dram_buffer_C_size / sizeof(bfloat16));
-        duration<double, std::milli> tot_duration(0);
-        
-        t1 = high_resolution_clock::now();
-        matmul_multicore_reuse_mcast(src0_vec, src1_vec, result_vec, false, M, N, K, B, cb_data_format, math_fidelity, device, verbose=verbose);
-        t2 = high_resolution_clock::now();
-        duration<double, std::milli> fr_dur = t2 - t1;
-        log_info(tt::LogVerif, "First execution mm: {} ms", fr_dur.count());
+    uint32_t dram_buffer_A_size = in0_single_tile_size * Mt * Kt;
+    uint32_t dram_buffer_B_size = in1_single_tile_size * Nt * Kt;
+    uint32_t dram_buffer_C_size = out_single_tile_size * Mt * Nt;
+    // Row-major inputs: one page per row, read by reader_bmm_mcast
+    uint32_t src0_page_size = kernel_config.tilize_in0 ? K * sizeof(bfloat16) : in0_single_tile_size;
+    uint32_t src1_page_size = kernel_config.tilize_in1 ? N * sizeof(bfloat16) : in1_single_tile_size;
+    tt_metal::InterleavedBufferConfig dram_config_A{
+        .device = device,
+        .size = dram_buffer_A_size,
+        .page_size = src0_page_size,
+        .buffer_type = tt_metal::BufferType::DRAM};
 
-        // for (int i = 0; i < NUMBER_OF_EXECUTIONS; i++){
-        t1 = high_resolution_clock::now();
-        matmul_multicore_reuse_mcast(src0_vec, src1_vec, result_vec, false, M, N, K, B, cb_data_format, math_fidelity, device, NUMBER_OF_EXECUTIONS, verbose);
-        t2 = high_resolution_clock::now();
-        duration<double, std::milli> sr_dur = t2 - t1;
-        log_info(tt::LogVerif, "Second execution mm: {} ms", sr_dur.count());
-        // log_info(tt::LogVerif, "Time mm: {} ms", duration.count());
-        // tot_duration = duration + tot_duration;
+    tt_metal::InterleavedBufferConfig dram_config_B{
+        .device = device,
+        .size = dram_buffer_B_size,
+        .page_size = src1_page_size,
+        .buffer_type = tt_metal::BufferType::DRAM};
 
-        tot_duration = fr_dur + til_dur;
-        log_info(tt::LogVerif, "Time til + fr mm: {} ms", tot_duration.count());
-        untilize(result_vec, M, N);
-        // }
+    // Row-major output: one page per row, written by writer_bmm_row_major
+    uint32_t dst_page_size = kernel_config.untilize_out ? N * sizeof(bfloat16) : out_single_tile_size;
+    tt_metal::InterleavedBufferConfig dram_config_C{
+        .device = device,
+        .size = dram_buffer_C_size,
+        .page_size = dst_page_size,
+        .buffer_type = tt_metal::BufferType::DRAM};
 
-        log_info(tt::LogVerif, "Tot duration mean: {} ms", (tot_duration.count() / NUMBER_OF_EXECUTIONS));
-        log_info(tt::LogVerif, "Output vector of size {}", result_vec.size());
+    // Sharded operands live in the L1 shards allocated with the program, written and read back the same way
+    auto src0_dram_buffer = kernel_config.in0_sharded ? mcast.in0_shard_buffer : CreateBuffer(dram_config_A);
+    auto src1_dram_buffer = mcast.in1_shard_buffer ? mcast.in1_shard_buffer : CreateBuffer(dram_config_B);
+    auto dst_dram_buffer = kernel_config.out_sharded ? mcast.out_shard_buffer : CreateBuffer(dram_config_C);
+
+    std::shared_ptr<Buffer> bias_dram_buffer;
+    if (epilogue.fuse_bias) {
+        tt_metal::InterleavedBufferConfig dram_config_bias{
+            .device = device,
+            .size = in0_single_tile_size * Nt,  // one row of tiles, bias in the first row of each tile
+            .page_size = in0_single_tile_size,
+            .buffer_type = tt_metal::BufferType::DRAM};
+        bias_dram_buffer = CreateBuffer(dram_config_bias);
+    }
 
-        pass &= CloseDevice(device);
+    auto t2 = high_resolution_clock::now();
+    duration<double, std::milli> duration = t2 - t1;
+    if (verbose){
+        log_info(tt::LogVerif, "Create DRAM buffers: {} ms", duration.count());
+    }
+
+    /*
+     * Kernels - Runtime arguments
+     */
+    t1 = high_resolution_clock::now();
+    McastRuntimeArgsParams& runtime_args_params = mcast.runtime_args_params;
+    runtime_args_params.src0_addr = src0_dram_buffer->address();
+    runtime_args_params.src1_addr = src1_dram_buffer->address();
+    runtime_args_params.dst_addr = dst_dram_buffer->address();
+    runtime_args_params.bcast_batch = bcast_batch;
+    if (epilogue.fuse_bias) {
+        runtime_args_params.bias_addr = bias_dram_buffer->address();
+    }
+
+    if (runtime_args_params.layout == McastLayout::DramSharded) {
+        set_dram_sharded_runtime_args(device, mcast);
+    } else {
+        McastRuntimeArgsBuilder runtime_args_builder;
+        runtime_args_builder.build(device, runtime_args_params);
+        runtime_args_builder.set(program, mcast.reader_kernel_ids, mcast.writer_kernel_ids);
+    }
+    t2 = high_resolution_clock::now();
+    duration = t2 - t1;
+    if (verbose){
+        log_info(tt::LogVerif, "Runtime args: {} ms", duration.count());
+    }
+
+    mm.src0_dram_buffer = src0_dram_buffer;
+    mm.src1_dram_buffer = src1_dram_buffer;
+    mm.dst_dram_buffer = dst_dram_buffer;
+    mm.bias_dram_buffer = bias_dram_buffer;
+    mm.dram_buffer_C_size = dram_buffer_C_size;
+    return mm;
+}
+
+// Program of setup_matmul_mcast with the packed Bfp operands of the last upload
+struct McastPlanState {
+    McastMatmul mm;
+    MatmulDataFormats data_formats;
+    std::vector<uint32_t> a_packed;
+    std::vector<uint32_t> b_packed;
+    std::vector<uint32_t> bias_packed;
+    std::vector<uint32_t> output_packed;
+};
+
+matmul::MatmulPlan make_plan(
+    Device* device,
+    const matmul::MatmulShape& shape,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    const MatmulEpilogue& epilogue,
+    const MatmulKernelConfig& kernel_config,
+    bool verbose) {
+    auto state = std::make_shared<McastPlanState>(McastPlanState{
+        .mm = setup_matmul_mcast(
+            shape.bcast_batch,
+            shape.M,
+            shape.N,
+            shape.K,
+            shape.B,
+            data_formats,
+            math_fidelity,
+            epilogue,
+            kernel_config,
+            device,
+            verbose),
+        .data_formats = data_formats});
+
+    matmul::MatmulPlan plan;
+    plan.variant = "multi_core_reuse_mcast";
+    plan.shape = shape;
+    plan.device = device;
+    plan.grid_x = state->mm.mcast.runtime_args_params.num_cores_c;
+    plan.grid_y = state->mm.mcast.runtime_args_params.num_cores_r;
+    plan.in0_format = data_formats.in0;
+    plan.in1_format = data_formats.in1;
+    plan.out_format = data_formats.out;
+    plan.math_fidelity = math_fidelity;
+    plan.state = state;
+    plan.program = &state->mm.mcast.program;
+
+    // Bfp operands are packed on the host, the packed vectors stay in the state until the next upload
+    auto write_operand = [](CommandQueue& cq,
+                            std::shared_ptr<Buffer>& buffer,
+                            const std::vector<bfloat16>& host,
+                            tt::DataFormat data_format,
+                            std::vector<uint32_t>& packed) {
+        if (data_format == tt::DataFormat::Float16_b) {
+            matmul::write_bfloat16(cq, buffer, host);
+        } else {
+            packed = pack_bfloat16_tiles(host, data_format);
+            EnqueueWriteBuffer(cq, buffer, packed.data(), false);
+        }
+    };
+    plan.write_a = [state = state.get(), write_operand](CommandQueue& cq, const std::vector<bfloat16>& a) {
+        write_operand(cq, state->mm.src0_dram_buffer, a, state->data_formats.in0, state->a_packed);
+    };
+    plan.write_b = [state = state.get(), write_operand](CommandQueue& cq, const std::vector<bfloat16>& b) {
+        write_operand(cq, state->mm.src1_dram_buffer, b, state->data_formats.in1, state->b_packed);
+    };
+    if (epilogue.fuse_bias) {
+        plan.write_bias = [state = state.get(), write_operand](CommandQueue& cq, const std::vector<bfloat16>& bias) {
+            write_operand(cq, state->mm.bias_dram_buffer, bias, state->data_formats.in0, state->bias_packed);
+        };
+    }
+    plan.read_c = [state = state.get()](CommandQueue& cq, std::vector<bfloat16>& output) {
+        if (state->data_formats.out == tt::DataFormat::Float16_b) {
+            matmul::read_bfloat16(cq, state->mm.dst_dram_buffer, output);
+            return;
+        }
+        state->output_packed.resize(state->mm.dram_buffer_C_size / sizeof(uint32_t));
+        EnqueueReadBuffer(cq, state->mm.dst_dram_buffer, state->output_packed.data(), true);
+        TRACE_ZONE("unpack");
+        output = unpack_bfloat16_tiles(state->output_packed, state->data_formats.out);
+    };
+    return plan;
+}
+
+matmul::MatmulPlan make_plan(Device* device, const matmul::MatmulShape& shape) {
+    return make_plan(device, shape, {}, MathFidelity::HiFi4, {}, {}, false);
+}
+
+// The default plan takes any tile-aligned shape whose circular buffers fit L1, output blocks included
+bool supports_shape(Device* device, const matmul::MatmulShape& shape) {
+    if (shape.M % TILE_HEIGHT != 0 or shape.N % TILE_WIDTH != 0 or shape.K % TILE_WIDTH != 0) {
+        return false;
+    }
+    MatmulDataFormats data_formats;
+    MatmulEpilogue epilogue;
+    MatmulKernelConfig kernel_config;
+    McastBlocking blocking = get_mcast_blocking(
+        shape.M, shape.N, shape.K, device->num_dram_channels(), 0, McastLayout::Auto, false, shape.B == 1);
+    uint32_t l1_free = device->l1_size_per_core() - device->get_base_allocator_addr(HalMemType::L1);
+    plan_out_blocks(blocking, data_formats, epilogue, kernel_config, l1_free);
+    return get_mcast_cb_l1_size(blocking, data_formats, epilogue, kernel_config) <= l1_free;
+}
+
+/*
+ * Mean time of repeat_n runs of a plan, EnqueueProgram plus the blocking output read, after a single upload
+ * of the operands
+ */
+double matmul_multicore_reuse_mcast(
+    matmul::MatmulPlan& plan,
+    const std::vector<bfloat16>& a,
+    const std::vector<bfloat16>& b,
+    std::vector<bfloat16>& output,
+    uint32_t repeat_n=1) {
+    matmul::write_inputs(plan, a, b);
+
+    auto t1 = high_resolution_clock::now();
+    for (int i = 0; i < repeat_n; i++){
+        matmul::run(plan, output);
+    }
+    auto t2 = high_resolution_clock::now();
+    duration<double, std::milli> tot_duration = t2 - t1;
+    log_info(tt::LogVerif, "Program duration mean over {} repeats: {} ms", repeat_n, tot_duration.count() / repeat_n);
+    return tot_duration.count() / repeat_n;
+}
+
+double matmul_multicore_reuse_mcast(
+    std::vector<bfloat16>& a,
+    std::vector<bfloat16>& b,
+    std::vector<bfloat16>& bias,  // tilized [32, N], bias in row 0; unused unless epilogue.fuse_bias
+    std::vector<bfloat16>& output,
+    bool bcast_batch,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t B,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    const MatmulEpilogue& epilogue,
+    const MatmulKernelConfig& kernel_config,
+    Device* device,
+    uint32_t repeat_n=1,
+    bool verbose=false) {
+    matmul::MatmulPlan plan = [&] {
+        TRACE_ZONE("plan");
+        return make_plan(
+            device,
+            {.M = M, .N = N, .K = K, .B = B, .bcast_batch = bcast_batch},
+            data_formats,
+            math_fidelity,
+            epilogue,
+            kernel_config,
+            verbose);
+    }();
+    if (epilogue.fuse_bias) {
+        matmul::write_bias(plan, bias);
+    }
+    return matmul_multicore_reuse_mcast(plan, a, b, output, repeat_n);
+}
+
+matmul_bench::MatmulRunner make_bench_runner(Device* device, const matmul_bench::MatmulInputs& inputs) {
+    return matmul_bench::make_plan_runner(make_plan(device, {.M = inputs.M, .N = inputs.N, .K = inputs.K}), inputs);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                      Input Layout
+////////////////////////////////////////////////////////////////////////////
+/*
+ * tilize() split over host threads: every row of tiles is a contiguous range of the output
+ */
+void tilize_parallel(std::vector<bfloat16>& input, uint32_t m, uint32_t n, uint32_t num_threads) {
+    TT_FATAL(m % TILE_HEIGHT == 0 and n % TILE_WIDTH == 0, "Tilize needs whole tiles");
+    std::vector<bfloat16> tilized_input(input.size());
+    uint32_t num_tile_rows = input.size() / n / TILE_HEIGHT;  // batches are stacked rows of tiles
+
+    auto tilize_tile_rows = [&](uint32_t begin, uint32_t end) {
+        timeline::set_thread_name("tilize worker");
+        TRACE_ZONE("tilize rows");
+        for (uint32_t tile_row = begin; tile_row < end; tile_row++) {
+            bfloat16* dst = tilized_input.data() + tile_row * TILE_HEIGHT * n;
+            for (uint32_t tile_col = 0; tile_col < n / TILE_WIDTH; tile_col++) {
+                for (uint32_t face = 0; face < 4; face++) {
+                    uint32_t face_row = tile_row * TILE_HEIGHT + face / 2 * FACE_HEIGHT;
+                    uint32_t face_col = tile_col * TILE_WIDTH + face % 2 * FACE_WIDTH;
+                    for (uint32_t r = 0; r < FACE_HEIGHT; r++) {
+                        const bfloat16* src = input.data() + (face_row + r) * n + face_col;
+                        dst = std::copy(src, src + FACE_WIDTH, dst);
+                    }
+                }
+            }
+        }
+    };
+
+    num_threads = std::max(1u, std::min(num_threads, num_tile_rows));
+    uint32_t tile_rows_per_thread = (num_tile_rows + num_threads - 1) / num_threads;
+    std::vector<std::thread> threads;
+    for (uint32_t begin = 0; begin < num_tile_rows; begin += tile_rows_per_thread) {
+        threads.emplace_back(tilize_tile_rows, begin, std::min(begin + tile_rows_per_thread, num_tile_rows));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    input = std::move(tilized_input);
+}
+
+/*
+ * Cost model of plan_input_tilize: the host tilize is a strided copy that scales with the host threads, the
+ * device tilize adds to the compute kernel of every core that receives the operand. Measured on the device by
+ * calibrate_tilize_cost.
+ */
+struct TilizeCost {
+    double host_gb_per_s_per_thread;
+    double device_ns_per_tile;  // tilized on one core
+};
+
+// Blocking of the default plan of a shape, output blocks included
+McastBlocking get_planned_blocking(
+    Device* device,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    const MatmulDataFormats& data_formats,
+    const MatmulEpilogue& epilogue,
+    const MatmulKernelConfig& kernel_config) {
+    McastBlocking blocking = get_mcast_blocking(
+        M,
+        N,
+        K,
+        device->num_dram_channels(),
+        kernel_config.subblock_choice,
+        kernel_config.mcast_layout,
+        kernel_config.out_sharded);
+    uint32_t l1_free = device->l1_size_per_core() - device->get_base_allocator_addr(HalMemType::L1);
+    plan_out_blocks(blocking, data_formats, epilogue, kernel_config, l1_free);
+    return blocking;
+}
+
+/*
+ * Measures the TilizeCost on a 1024 x 1024 x 1024 matmul: the host tilize of A on one thread, and the time a
+ * TILIZE_IN0 run adds over the tile layout run (both from the same upload) per in0 tile tilized on a core
+ */
+TilizeCost calibrate_tilize_cost(
+    Device* device, MathFidelity math_fidelity, MatmulKernelConfig kernel_config, uint32_t repeat_n=5) {
+    constexpr uint32_t single_tile_size = 2 * 1024;
+    constexpr uint32_t size = 1024;
+    constexpr uint32_t size_tiles = size / TILE_WIDTH;
+    MatmulDataFormats data_formats = uniform_data_formats(tt::DataFormat::Float16_b);
+    std::vector<bfloat16> a =
+        create_random_vector_of_bfloat16_native(single_tile_size * size_tiles * size_tiles, 1, 123, -0.4);
+    std::vector<bfloat16> b =
+        create_random_vector_of_bfloat16_native(single_tile_size * size_tiles * size_tiles, 1, 12522, -0.3);
+    std::vector<bfloat16> output(size * size);
+
+    TilizeCost cost;
+    duration<double, std::milli> host_duration(0);
+    for (uint32_t i = 0; i < repeat_n; i++) {
+        std::vector<bfloat16> a_in = a;
+        auto t1 = high_resolution_clock::now();
+        tilize_parallel(a_in, size, size, 1);
+        host_duration += high_resolution_clock::now() - t1;
+    }
+    double host_ms = host_duration.count() / repeat_n;
+    cost.host_gb_per_s_per_thread = double(size) * size * sizeof(bfloat16) / (host_ms * 1e6);
+
+    std::vector<bfloat16> a_tilized = a;
+    std::vector<bfloat16> b_tilized = b;
+    tilize(a_tilized, size, size);
+    tilize(b_tilized, size, size);
+    kernel_config.tilize_in1 = false;
+    std::array<double, 2> mean_ms;
+    McastBlocking blocking;
+    for (bool tilize_in0 : {false, true}) {
+        kernel_config.tilize_in0 = tilize_in0;
+        blocking = get_planned_blocking(device, size, size, size, data_formats, {}, kernel_config);
+        matmul::MatmulPlan plan = make_plan(
+            device, {.M = size, .N = size, .K = size}, data_formats, math_fidelity, {}, kernel_config, false);
+        const std::vector<bfloat16>& a_in = tilize_in0 ? a : a_tilized;
+        // The first run pays for the kernel compilation
+        matmul_multicore_reuse_mcast(plan, a_in, b_tilized, output);
+        mean_ms[tilize_in0] = matmul_multicore_reuse_mcast(plan, a_in, b_tilized, output, repeat_n);
+    }
+    uint32_t per_core_tiles = blocking.per_core_M * size_tiles * blocking.num_out_blocks_w;
+    cost.device_ns_per_tile = std::max(0.0, mean_ms[1] - mean_ms[0]) * 1e6 / per_core_tiles;
+    log_info(
+        tt::LogVerif,
+        "Tilize cost: host {:.3f} GB/s per thread, device {:.1f} ns per tile ({} ms tile layout, {} ms tilize_in0)",
+        cost.host_gb_per_s_per_thread,
+        cost.device_ns_per_tile,
+        mean_ms[0],
+        mean_ms[1]);
+    return cost;
+}
+
+/*
+ * Picks host or device tilize for A (and B when allowed). An input is uploaded row-major and tilized by the
+ * compute kernel when its staging CB fits in L1 and the per-core tilize is estimated, from the measured cost,
+ * to be faster than tilizing the whole input with host_threads threads.
+ */
+MatmulKernelConfig plan_input_tilize(
+    Device* device,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    const MatmulDataFormats& data_formats,
+    const MatmulEpilogue& epilogue,
+    MatmulKernelConfig kernel_config,
+    const TilizeCost& cost,
+    bool allow_tilize_in1,
+    uint32_t host_threads,
+    bool verbose=false) {
+    kernel_config.tilize_in0 = false;
+    kernel_config.tilize_in1 = false;
+
+    McastBlocking blocking = get_planned_blocking(device, M, N, K, data_formats, epilogue, kernel_config);
+    uint32_t l1_free = device->l1_size_per_core() - device->get_base_allocator_addr(HalMemType::L1);
+    uint32_t Kt = K / TILE_WIDTH;
+    // The DRAM-sharded reader takes tile layout inputs only
+    if (blocking.layout == McastLayout::DramSharded) {
+        return kernel_config;
+    }
+
+    auto plan_operand = [&](bool& tilize_in, uint32_t rows, uint32_t cols, uint32_t per_core_tiles) {
+        double host_ms = (double)rows * cols * sizeof(bfloat16) / (cost.host_gb_per_s_per_thread * 1e6) /
+                         host_threads;
+        double device_ms = per_core_tiles * cost.device_ns_per_tile / 1e6;
+        tilize_in = true;
+        bool fits = get_mcast_cb_l1_size(blocking, data_formats, epilogue, kernel_config) <= l1_free;
+        tilize_in = fits and device_ms < host_ms;
+        if (verbose) {
+            log_info(
+                tt::LogVerif,
+                "Tilize {}x{}: host {} ms on {} threads, device {} ms, staging CB {} -> {}",
+                rows,
+                cols,
+                host_ms,
+                host_threads,
+                device_ms,
+                fits ? "fits" : "does not fit",
+                tilize_in ? "device" : "host");
+        }
+    };
+    // Row-major operands are bfloat16 on the host and in DRAM, a sharded in0 is in tile layout
+    if (data_formats.in0 == tt::DataFormat::Float16_b and not kernel_config.in0_sharded) {
+        plan_operand(kernel_config.tilize_in0, M, K, blocking.per_core_M * Kt * blocking.num_out_blocks_w);
+    }
+    if (allow_tilize_in1 and data_formats.in1 == tt::DataFormat::Float16_b) {
+        plan_operand(kernel_config.tilize_in1, K, N, blocking.per_core_N * Kt * blocking.num_out_blocks_h);
+    }
+    return kernel_config;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                      Warmup
+////////////////////////////////////////////////////////////////////////////
+struct MatmulVariant {
+    uint32_t M;
+    uint32_t N;
+    uint32_t K;
+    uint32_t B;
+    MatmulDataFormats data_formats;
+    MathFidelity math_fidelity;
+    MatmulEpilogue epilogue = {};
+    MatmulKernelConfig kernel_config = {};
+
+    std::string key() const {
+        return fmt::format(
+            "{}x{}x{}x{}_df{}-{}-{}_mf{}_bias{}_act{}_l1acc{}_block{}_sb{}_untilize{}_tilize{}{}_mcast{}_shard{}{}"
+            "_ob{}x{}",
+            M,
+            N,
+            K,
+            B,
+            (uint32_t)data_formats.in0,
+            (uint32_t)data_formats.in1,
+            (uint32_t)data_formats.out,
+            (uint32_t)math_fidelity,
+            (uint32_t)epilogue.fuse_bias,
+            (uint32_t)epilogue.activation,
+            (uint32_t)kernel_config.packer_l1_acc,
+            (uint32_t)kernel_config.matmul_block,
+            kernel_config.subblock_choice,
+            (uint32_t)kernel_config.untilize_out,
+            (uint32_t)kernel_config.tilize_in0,
+            (uint32_t)kernel_config.tilize_in1,
+            (uint32_t)kernel_config.mcast_layout,
+            (uint32_t)kernel_config.in0_sharded,
+            (uint32_t)kernel_config.out_sharded,
+            kernel_config.num_out_blocks_h,
+            kernel_config.num_out_blocks_w);
+    }
+};
+
+struct WarmupResult {
+    MatmulVariant variant;
+    double compile_ms;  // 0 when warm
+    bool warm;  // compiled by an earlier process with the same build key and still in the kernel cache, skipped
+};
+
+// Output directories of the compiled kernels of a program in the persistent kernel cache
+std::vector<std::string> kernel_binary_dirs(Device* device, Program& program) {
+    std::vector<std::string> dirs;
+    for (KernelHandle kernel_id = 0; kernel_id < program.num_kernels(); kernel_id++) {
+        auto kernel = detail::GetKernel(program, kernel_id);
+        dirs.push_back(device->build_env().get_out_kernel_root_path() + kernel->get_full_kernel_name());
+    }
+    return dirs;
+}
+
+/*
+ * Compiles the kernels of every variant ahead of time, so the first EnqueueProgram of a served shape does not pay
+ * for the JIT. Binaries go to the persistent kernel cache, and the manifest (build key, then per variant its key,
+ * compile ms and kernel binary directories) records which variants later processes find warm: those whose
+ * directories are all still in the cache are skipped. The manifest keeps the entries of earlier processes with
+ * the same build key, another build key starts it over.
+ *
+ * The cold programs are created one after the other on this thread, since creating one allocates the L1 shards
+ * on the device. They are then compiled on up to max_threads threads, one Program per thread at a time: the JIT
+ * build of a kernel hash shared by two variants happens once, the other compile waits for its binary. The threads
+ * are joined before the manifest is touched.
+ */
+std::vector<WarmupResult> warmup_matmul_mcast(
+    Device* device,
+    const std::vector<MatmulVariant>& variants,
+    const std::string& manifest_path,
+    uint32_t max_threads=4) {
+    detail::EnablePersistentKernelCache();
+
+    // Variant key -> compile ms of the process that compiled it and its kernel binary directories
+    std::map<std::string, std::pair<double, std::vector<std::string>>> manifest;
+    std::ifstream manifest_in(manifest_path);
+    std::string token;
+    uint32_t manifest_build_key;
+    if (manifest_in >> token >> manifest_build_key and token == "build_key" and
+        manifest_build_key == device->build_key()) {
+        std::string key;
+        double compile_ms;
+        uint32_t num_dirs;
+        while (manifest_in >> key >> compile_ms >> num_dirs) {
+            std::vector<std::string> dirs(num_dirs);
+            for (auto& dir : dirs) {
+                manifest_in >> dir;
+            }
+            manifest[key] = {compile_ms, dirs};
+        }
+    }
+    manifest_in.close();
+    auto in_kernel_cache = [&manifest](const std::string& key) {
+        auto it = manifest.find(key);
+        return it != manifest.end() and not it->second.second.empty() and
+               std::all_of(it->second.second.begin(), it->second.second.end(), [](const std::string& dir) {
+                   return std::filesystem::is_directory(dir);
+               });
+    };
+
+    auto t1 = high_resolution_clock::now();
+    std::vector<WarmupResult> results;
+    std::vector<McastProgram> cold_programs;
+    std::vector<size_t> cold_results;
+    results.reserve(variants.size());
+    for (const auto& variant : variants) {
+        std::string key = variant.key();
+        if (in_kernel_cache(key)) {
+            results.push_back({variant, 0, true});
+            log_info(tt::LogVerif, "Warmup {}: warm, skipped", key);
+            continue;
+        }
+        cold_programs.push_back(create_matmul_mcast_program(
+            device,
+            variant.M,
+            variant.N,
+            variant.K,
+            variant.B,
+            variant.data_formats,
+            variant.math_fidelity,
+            variant.epilogue,
+            variant.kernel_config));
+        cold_results.push_back(results.size());
+        results.push_back({variant, 0, false});
+    }
+
+    std::atomic<size_t> next_program = 0;
+    std::vector<std::exception_ptr> errors(cold_programs.size());
+    auto compile_programs = [&]() {
+        for (size_t i = next_program++; i < cold_programs.size(); i = next_program++) {
+            auto t1 = high_resolution_clock::now();
+            try {
+                detail::CompileProgram(device, cold_programs[i].program);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            duration<double, std::milli> compile_duration = high_resolution_clock::now() - t1;
+            results[cold_results[i]].compile_ms = compile_duration.count();
+        }
+    };
+    std::vector<std::thread> threads;
+    uint32_t num_threads = std::min<size_t>(std::max(max_threads, 1u), cold_programs.size());
+    for (uint32_t i = 0; i < num_threads; i++) {
+        threads.emplace_back(compile_programs);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    for (size_t i = 0; i < cold_programs.size(); i++) {
+        const WarmupResult& result = results[cold_results[i]];
+        std::string key = result.variant.key();
+        manifest[key] = {result.compile_ms, kernel_binary_dirs(device, cold_programs[i].program)};
+        log_info(tt::LogVerif, "Warmup {}: {} ms (cold)", key, result.compile_ms);
+    }
+    auto t2 = high_resolution_clock::now();
+    duration<double, std::milli> duration = t2 - t1;
+    log_info(
+        tt::LogVerif,
+        "Warmup of {} variants, {} cold on {} threads: {} ms",
+        variants.size(),
+        cold_programs.size(),
+        num_threads,
+        duration.count());
+
+    std::ofstream manifest_out(manifest_path);
+    manifest_out << "build_key " << device->build_key() << "\n";
+    for (const auto& [key, entry] : manifest) {
+        manifest_out << key << " " << entry.first << " " << entry.second.size();
+        for (const auto& dir : entry.second) {
+            manifest_out << " " << dir;
+        }
+        manifest_out << "\n";
+    }
+    return results;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                      Benchmarks
+////////////////////////////////////////////////////////////////////////////
+/*
+ * Mean program time of one plan on random inputs, after an untimed run that pays for the kernel compilation.
+ * Timed like matmul_multicore_reuse_mcast: EnqueueProgram plus the blocking output read
+ */
+double time_matmul_mcast(
+    Device* device,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    const MatmulKernelConfig& kernel_config,
+    uint32_t repeat_n) {
+    constexpr uint32_t single_tile_size = 2 * 1024;  // host vectors are bfloat16, enough for any data format
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
+    std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+    std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.3);
+    std::vector<bfloat16> output(single_tile_size * Mt * Nt / sizeof(bfloat16));
+
+    matmul::MatmulPlan plan =
+        make_plan(device, {.M = M, .N = N, .K = K}, data_formats, math_fidelity, {}, kernel_config, false);
+    double mean_ms = 0;
+    for (uint32_t runs : {1u, repeat_n}) {
+        mean_ms = matmul_multicore_reuse_mcast(plan, a, b, output, runs);
+    }
+    return mean_ms;
+}
+
+/*
+ * Reload path against packer L1 accumulation over K. The reload path packs every partial to L1 and copies
+ * it back to dst once per K-block, L1 accumulation reloads it only for the last block.
+ * NOTE: the planner splits K over num_cores_x blocks, so K grows the block width, not the block count
+ */
+void benchmark_packer_l1_acc_sweep(
+    Device* device,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    constexpr uint32_t sweep_M = 512;
+    constexpr uint32_t sweep_N = 512;
+    for (uint32_t sweep_K : {1024, 2048, 4096, 8192}) {
+        std::array<double, 2> mean_ms;
+        for (bool l1_acc : {false, true}) {
+            kernel_config.packer_l1_acc = l1_acc;
+            mean_ms[l1_acc] = time_matmul_mcast(
+                device, sweep_M, sweep_N, sweep_K, data_formats, math_fidelity, kernel_config, repeat_n);
+        }
+        log_info(
+            tt::LogVerif,
+            "K = {}: reload {} ms, packer L1 acc {} ms, speedup {:.3f}x",
+            sweep_K,
+            mean_ms[0],
+            mean_ms[1],
+            mean_ms[0] / mean_ms[1]);
+    }
+}
+
+/*
+ * End-to-end output path: tile layout output untilized on the host against row-major output from
+ * the device (UNTILIZE_OUT compute kernel and writer_bmm_row_major), both timed up to a row-major host vector
+ */
+void benchmark_untilize_out_saving(
+    Device* device,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    constexpr uint32_t single_tile_size = 2 * 1024;
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
+    std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+    std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.3);
+    std::vector<bfloat16> output(single_tile_size * Mt * Nt / sizeof(bfloat16));
+
+    MatmulDataFormats data_formats = uniform_data_formats(tt::DataFormat::Float16_b);
+    std::array<double, 2> mean_ms;
+    for (bool untilize_out : {false, true}) {
+        kernel_config.untilize_out = untilize_out;
+        matmul::MatmulPlan plan =
+            make_plan(device, {.M = M, .N = N, .K = K}, data_formats, math_fidelity, {}, kernel_config, false);
+        // Untimed run pays for the kernel compilation
+        matmul::execute(plan, a, b, output);
+
+        duration<double, std::milli> tot_duration(0);
+        for (uint32_t i = 0; i < repeat_n; i++) {
+            auto t1 = high_resolution_clock::now();
+            matmul::execute(plan, a, b, output);
+            if (not untilize_out) {
+                untilize(output, M, N);
+            }
+            auto t2 = high_resolution_clock::now();
+            tot_duration += t2 - t1;
+        }
+        mean_ms[untilize_out] = tot_duration.count() / repeat_n;
+    }
+    log_info(
+        tt::LogVerif,
+        "Row-major output: tile + host untilize {} ms, device untilize {} ms, saving {} ms",
+        mean_ms[0],
+        mean_ms[1],
+        mean_ms[0] - mean_ms[1]);
+}
+
+/*
+ * TFLOPS of every subblock shape the planner can pick for M x N x K, per-tile matmul_tiles against matmul_block
+ */
+void benchmark_subblock_sweep(
+    Device* device,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    McastBlocking blocking = get_mcast_blocking(
+        M, N, K, device->num_dram_channels(), 0, kernel_config.mcast_layout, kernel_config.out_sharded);
+    uint32_t per_core_M = blocking.per_core_M;
+    uint32_t per_core_N = blocking.per_core_N;
+    double num_ops = 2.0 * M * N * K;
+
+    uint32_t choice = 0;
+    for (auto& subblock_hw : SUBBLOCK_HW_CHOICES) {
+        auto out_subblock_h = std::get<0>(subblock_hw);
+        auto out_subblock_w = std::get<1>(subblock_hw);
+        if (per_core_M % out_subblock_h != 0 or per_core_N % out_subblock_w != 0) {
+            continue;
+        }
+        if (kernel_config.out_sharded and out_subblock_w != per_core_N and out_subblock_h != 1) {
+            continue;
+        }
+        kernel_config.subblock_choice = choice++;
+
+        std::array<double, 2> tflops;
+        for (bool matmul_block : {false, true}) {
+            kernel_config.matmul_block = matmul_block;
+            double mean_ms = time_matmul_mcast(device, M, N, K, data_formats, math_fidelity, kernel_config, repeat_n);
+            tflops[matmul_block] = num_ops / (mean_ms / 1000) / 1e12;
+        }
+        log_info(
+            tt::LogVerif,
+            "Subblock {}x{}: tile {:.3f} TFLOPS, block {:.3f} TFLOPS",
+            out_subblock_h,
+            out_subblock_w,
+            tflops[0],
+            tflops[1]);
+    }
+}
+
+/*
+ * TFLOPS of each mcast layout on skinny shapes (M of one to eight tiles against a wide N, and the transpose),
+ * next to the layout get_mcast_blocking picks. 2D is skipped where its blocking does not exist.
+ */
+void benchmark_mcast_layout_sweep(
+    Device* device,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    constexpr std::array<std::tuple<uint32_t, uint32_t, uint32_t>, 6> shapes = {{
+        {32, 3072, 3072}, {64, 3072, 3072}, {128, 4096, 1024}, {256, 4096, 1024}, {3072, 64, 3072}, {3072, 3072, 3072},
+    }};
+    // Row-major inputs are a planner decision of their own, keep them out of the comparison
+    kernel_config.tilize_in0 = false;
+    kernel_config.tilize_in1 = false;
+    for (auto [m, n, k] : shapes) {
+        double num_ops = 2.0 * m * n * k;
+        std::array<double, 3> tflops = {0, 0, 0};
+        std::array<McastLayout, 3> layouts = {McastLayout::Mcast2D, McastLayout::Mcast1DIn0, McastLayout::Mcast1DIn1};
+        for (uint32_t i = 0; i < layouts.size(); i++) {
+            if (layouts[i] == McastLayout::Mcast2D and not mcast_2d_blocking_exists(m, n, k)) {
+                continue;
+            }
+            kernel_config.mcast_layout = layouts[i];
+            double mean_ms = time_matmul_mcast(device, m, n, k, data_formats, math_fidelity, kernel_config, repeat_n);
+            tflops[i] = num_ops / (mean_ms / 1000) / 1e12;
+        }
+        McastLayout pick = get_mcast_blocking(m, n, k, device->num_dram_channels()).layout;
+        log_info(
+            tt::LogVerif,
+            "{}x{}x{}: 2D {:.3f} TFLOPS, 1D in0 {:.3f} TFLOPS, 1D in1 {:.3f} TFLOPS, planner picks {}",
+            m,
+            n,
+            k,
+            tflops[0],
+            tflops[1],
+            tflops[2],
+            pick == McastLayout::Mcast2D      ? "2D"
+            : pick == McastLayout::Mcast1DIn0 ? "1D in0"
+            : pick == McastLayout::Mcast1DIn1 ? "1D in1"
+                                              : "DRAM sharded");
+    }
+}
+
+/*
+ * DRAM interleaved against L1 block-sharded in0 and output on the small square shapes, where the DRAM round
+ * trip of A and C is a large part of the program time. Times include the output read back, as everywhere else.
+ */
+void benchmark_sharded_sweep(
+    Device* device,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    kernel_config.mcast_layout = McastLayout::Mcast2D;
+    kernel_config.tilize_in0 = false;
+    kernel_config.untilize_out = false;
+    for (uint32_t size : {256u, 512u, 1024u, 2048u}) {
+        double num_ops = 2.0 * size * size * size;
+        std::array<double, 3> tflops;
+        std::array<std::pair<bool, bool>, 3> shardings = {{{false, false}, {true, false}, {true, true}}};
+        for (uint32_t i = 0; i < shardings.size(); i++) {
+            kernel_config.in0_sharded = shardings[i].first;
+            kernel_config.out_sharded = shardings[i].second;
+            double mean_ms =
+                time_matmul_mcast(device, size, size, size, data_formats, math_fidelity, kernel_config, repeat_n);
+            tflops[i] = num_ops / (mean_ms / 1000) / 1e12;
+        }
+        log_info(
+            tt::LogVerif,
+            "{}^3: interleaved {:.3f} TFLOPS, sharded in0 {:.3f} TFLOPS, sharded in0 + out {:.3f} TFLOPS",
+            size,
+            tflops[0],
+            tflops[1],
+            tflops[2]);
+    }
+}
+
+const char* data_format_name(tt::DataFormat data_format) {
+    switch (data_format) {
+        case tt::DataFormat::Float16_b: return "Float16_b";
+        case tt::DataFormat::Bfp8_b: return "Bfp8_b";
+        case tt::DataFormat::Bfp4_b: return "Bfp4_b";
+        default: return "other";
+    }
+}
+
+/*
+ * 2D on the large square shapes, where the whole per-core block no longer fits in L1: fixed 1x1, 2x2 and 4x4
+ * output blocks (when they fit) against the plan_out_blocks pick
+ */
+void benchmark_out_blocks_sweep(
+    Device* device,
+    const MatmulDataFormats& data_formats,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    uint32_t l1_free = device->l1_size_per_core() - device->get_base_allocator_addr(HalMemType::L1);
+    kernel_config.mcast_layout = McastLayout::Mcast2D;
+    kernel_config.tilize_in0 = false;
+    kernel_config.tilize_in1 = false;
+    for (uint32_t size : {2048u, 4096u, 8192u}) {
+        double num_ops = 2.0 * size * size * size;
+        for (uint32_t num_out_blocks : {1u, 2u, 4u, 0u}) {
+            kernel_config.num_out_blocks_h = num_out_blocks;
+            kernel_config.num_out_blocks_w = num_out_blocks;
+            McastBlocking blocking = get_mcast_blocking(
+                size, size, size, device->num_dram_channels(), kernel_config.subblock_choice, McastLayout::Mcast2D);
+            plan_out_blocks(blocking, data_formats, {}, kernel_config, l1_free);
+            if (blocking.per_core_M % blocking.num_out_blocks_h != 0 or
+                blocking.per_core_N % blocking.num_out_blocks_w != 0 or
+                get_mcast_cb_l1_size(blocking, data_formats, {}, kernel_config) > l1_free) {
+                log_info(
+                    tt::LogVerif, "{}^3 with {}x{} output blocks: does not fit", size, num_out_blocks, num_out_blocks);
+                continue;
+            }
+            double mean_ms =
+                time_matmul_mcast(device, size, size, size, data_formats, math_fidelity, kernel_config, repeat_n);
+            log_info(
+                tt::LogVerif,
+                "{}^3 with {}{}x{} output blocks: {:.3f} TFLOPS",
+                size,
+                num_out_blocks == 0 ? "planned " : "",
+                blocking.num_out_blocks_h,
+                blocking.num_out_blocks_w,
+                num_ops / (mean_ms / 1000) / 1e12);
+        }
+    }
+}
+
+/*
+ * End-to-end input path of a row-major A: host tilize on host_threads threads against device tilize
+ * (reader_bmm_mcast and TILIZE_IN0), both timed from the row-major host vector, next to the planner pick
+ */
+void benchmark_tilize_in_sweep(
+    Device* device,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t host_threads,
+    uint32_t repeat_n=10) {
+    constexpr uint32_t single_tile_size = 2 * 1024;
+    constexpr uint32_t sweep_N = 1024;
+    constexpr uint32_t sweep_K = 1024;
+    MatmulDataFormats data_formats = uniform_data_formats(tt::DataFormat::Float16_b);
+    TilizeCost cost = calibrate_tilize_cost(device, math_fidelity, kernel_config);
+    kernel_config.tilize_in1 = false;
+    for (uint32_t sweep_M : {512, 1024, 2048}) {
+        uint32_t Mt = sweep_M / TILE_HEIGHT;
+        uint32_t Kt = sweep_K / TILE_WIDTH;
+        uint32_t Nt = sweep_N / TILE_WIDTH;
+        std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+        std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.3);
+        std::vector<bfloat16> output(single_tile_size * Mt * Nt / sizeof(bfloat16));
+
+        MatmulKernelConfig planned = plan_input_tilize(
+            device, sweep_M, sweep_N, sweep_K, data_formats, {}, kernel_config, cost, false, host_threads);
+
+        std::array<double, 2> mean_ms;
+        for (bool tilize_in0 : {false, true}) {
+            kernel_config.tilize_in0 = tilize_in0;
+            matmul::MatmulPlan plan = make_plan(
+                device,
+                {.M = sweep_M, .N = sweep_N, .K = sweep_K},
+                data_formats,
+                math_fidelity,
+                {},
+                kernel_config,
+                false);
+            // Untimed run pays for the kernel compilation
+            matmul::execute(plan, a, b, output);
+
+            duration<double, std::milli> tot_duration(0);
+            for (uint32_t i = 0; i < repeat_n; i++) {
+                std::vector<bfloat16> a_in = a;
+                auto t1 = high_resolution_clock::now();
+                if (not tilize_in0) {
+                    tilize_parallel(a_in, sweep_M, sweep_K, host_threads);
+                }
+                matmul::execute(plan, a_in, b, output);
+                auto t2 = high_resolution_clock::now();
+                tot_duration += t2 - t1;
+            }
+            mean_ms[tilize_in0] = tot_duration.count() / repeat_n;
+        }
+        log_info(
+            tt::LogVerif,
+            "M = {}: host tilize ({} threads) {} ms, device tilize {} ms, planner picks {}",
+            sweep_M,
+            host_threads,
+            mean_ms[0],
+            mean_ms[1],
+            planned.tilize_in0 ? "device" : "host");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                      Validation
+////////////////////////////////////////////////////////////////////////////
+float apply_activation(float x, Activation activation) {
+    switch (activation) {
+        case Activation::ReLU: return std::max(x, 0.0f);
+        case Activation::GeLU: return 0.5f * x * (1.0f + std::erf(x / std::sqrt(2.0f)));
+        case Activation::SiLU: return x / (1.0f + std::exp(-x));
+        default: return x;
+    }
+}
+
+/*
+ * matmul::sampled_pcc of activation(A * B + bias) against the device output, row-major operands
+ */
+float sampled_reference_pcc(
+    const std::vector<bfloat16>& a,
+    const std::vector<bfloat16>& b,
+    const std::vector<bfloat16>& bias,
+    const std::vector<bfloat16>& output,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    const MatmulEpilogue& epilogue,
+    uint32_t num_samples=matmul::VALIDATION_SAMPLES) {
+    auto reference_epilogue = [&bias, &epilogue](float acc, uint32_t n) {
+        if (epilogue.fuse_bias) {
+            acc += bias[n].to_float();
+        }
+        return apply_activation(acc, epilogue.activation);
+    };
+    return matmul::sampled_pcc(a, b, output, M, N, K, num_samples, reference_epilogue);
+}
+
+/*
+ * Decode shapes, where reading B once is the whole cost: 1D in0 mcast (B interleaved over the banks, every core
+ * reading its columns) against DRAM-sharded B, for bfloat16 and bfp8 weights. The weight bandwidth is the size
+ * of B over the program time, to compare with the DRAM peak of the device. Fails when either output is off the
+ * CPU reference.
+ */
+bool benchmark_dram_sharded_sweep(
+    Device* device,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    constexpr uint32_t single_tile_size = 2 * 1024;
+    constexpr uint32_t sweep_M = 32;
+    // K x N, N a multiple of 32 * 12 (the Wormhole DRAM banks), shapes that do not split on this device are skipped
+    constexpr std::array<std::pair<uint32_t, uint32_t>, 4> shapes = {{
+        {2304, 1536}, {4096, 3072}, {4096, 6144}, {8192, 12288}}};
+    kernel_config.tilize_in0 = false;
+    kernel_config.tilize_in1 = false;
+    kernel_config.untilize_out = false;
+    std::vector<bfloat16> bias;  // no epilogue
+    bool pass = true;
+    for (auto [k, n] : shapes) {
+        if ((n / TILE_WIDTH) % device->num_dram_channels() != 0) {
+            continue;
+        }
+        uint32_t Mt = sweep_M / TILE_HEIGHT;
+        uint32_t Kt = k / TILE_WIDTH;
+        uint32_t Nt = n / TILE_WIDTH;
+        std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+        std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.3);
+        std::vector<bfloat16> a_tilized = a;
+        std::vector<bfloat16> b_tilized = b;
+        tilize(a_tilized, sweep_M, k);
+        tilize(b_tilized, k, n);
+        double num_ops = 2.0 * sweep_M * n * k;
+        for (tt::DataFormat in1_format : {tt::DataFormat::Float16_b, tt::DataFormat::Bfp8_b}) {
+            MatmulDataFormats data_formats = uniform_data_formats(tt::DataFormat::Float16_b);
+            data_formats.in1 = in1_format;
+            double weight_bytes = (double)Kt * Nt * detail::TileSize(in1_format);
+            std::array<McastLayout, 2> layouts = {McastLayout::Mcast1DIn0, McastLayout::DramSharded};
+            std::array<double, 2> mean_ms;
+            std::array<float, 2> pcc;
+            for (uint32_t i = 0; i < layouts.size(); i++) {
+                kernel_config.mcast_layout = layouts[i];
+                std::vector<bfloat16> output(single_tile_size * Mt * Nt / sizeof(bfloat16));
+                matmul::MatmulPlan plan = make_plan(
+                    device, {.M = sweep_M, .N = n, .K = k}, data_formats, math_fidelity, {}, kernel_config, false);
+                for (uint32_t runs : {1u, repeat_n}) {
+                    mean_ms[i] = matmul_multicore_reuse_mcast(plan, a_tilized, b_tilized, output, runs);
+                }
+                untilize(output, sweep_M, n);
+                pcc[i] = sampled_reference_pcc(a, b, bias, output, sweep_M, n, k, {});
+                pass &= pcc[i] >= matmul::VALIDATION_PCC;
+            }
+            log_info(
+                tt::LogVerif,
+                "{}x{}x{} in1 {}: 1D in0 {:.3f} TFLOPS {:.1f} GB/s PCC {:.5f}, DRAM sharded {:.3f} TFLOPS {:.1f} GB/s "
+                "PCC {:.5f}",
+                sweep_M,
+                n,
+                k,
+                data_format_name(in1_format),
+                num_ops / (mean_ms[0] / 1000) / 1e12,
+                weight_bytes / (mean_ms[0] * 1e6),
+                pcc[0],
+                num_ops / (mean_ms[1] / 1000) / 1e12,
+                weight_bytes / (mean_ms[1] * 1e6),
+                pcc[1]);
+        }
+    }
+    return pass;
+}
+
+/*
+ * Accuracy and throughput of Float16_b activations against Float16_b, Bfp8_b and Bfp4_b weights, with a Float16_b
+ * or Bfp8_b output. PCC is against the CPU reference of the unquantised inputs, TFLOPS from time_matmul_mcast timing
+ */
+void benchmark_data_format_combinations(
+    Device* device,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    MathFidelity math_fidelity,
+    MatmulKernelConfig kernel_config,
+    uint32_t repeat_n=10) {
+    constexpr uint32_t single_tile_size = 2 * 1024;
+    uint32_t Mt = M / TILE_HEIGHT;
+    uint32_t Kt = K / TILE_WIDTH;
+    uint32_t Nt = N / TILE_WIDTH;
+    std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+    std::vector<bfloat16> b = create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.3);
+    std::vector<bfloat16> a_tilized = a;
+    std::vector<bfloat16> b_tilized = b;
+    tilize(a_tilized, M, K);
+    tilize(b_tilized, K, N);
+    std::vector<bfloat16> bias;  // no epilogue
+    double num_ops = 2.0 * M * N * K;
+
+    // Tile layout in and out, the row-major paths are Float16_b only
+    kernel_config.untilize_out = false;
+    kernel_config.tilize_in0 = false;
+    kernel_config.tilize_in1 = false;
+    for (tt::DataFormat in1_data_format : {tt::DataFormat::Float16_b, tt::DataFormat::Bfp8_b, tt::DataFormat::Bfp4_b}) {
+        for (tt::DataFormat out_data_format : {tt::DataFormat::Float16_b, tt::DataFormat::Bfp8_b}) {
+            MatmulDataFormats data_formats = {
+                .in0 = tt::DataFormat::Float16_b, .in1 = in1_data_format, .out = out_data_format};
+            std::vector<bfloat16> output(single_tile_size * Mt * Nt / sizeof(bfloat16));
+            matmul::MatmulPlan plan =
+                make_plan(device, {.M = M, .N = N, .K = K}, data_formats, math_fidelity, {}, kernel_config, false);
+            double mean_ms = 0;
+            for (uint32_t runs : {1u, repeat_n}) {
+                mean_ms = matmul_multicore_reuse_mcast(plan, a_tilized, b_tilized, output, runs);
+            }
+            untilize(output, M, N);
+            float pcc = sampled_reference_pcc(a, b, bias, output, M, N, K, {});
+            log_info(
+                tt::LogVerif,
+                "in0 {} in1 {} out {}: {} ms, {:.3f} TFLOPS, PCC {:.5f}",
+                data_format_name(data_formats.in0),
+                data_format_name(data_formats.in1),
+                data_format_name(data_formats.out),
+                mean_ms,
+                num_ops / (mean_ms / 1000) / 1e12,
+                pcc);
+        }
+    }
+}
+
+/*
+ * A kernel feature run on the device by validate_feature_cases: the config, epilogue and formats that enable its
+ * defines in the kernels, and the shape when the feature needs one of its own (a zero M, N or K takes the shape
+ * validate_feature_cases is called with)
+ */
+struct FeatureCase {
+    std::string name;
+    uint32_t M = 0;
+    uint32_t N = 0;
+    uint32_t K = 0;
+    MatmulKernelConfig kernel_config = {};
+    MatmulEpilogue epilogue = {};
+    MatmulDataFormats data_formats = {};
+    MathFidelity math_fidelity = MathFidelity::HiFi4;
+};
+
+// The DRAM-sharded cases take N from the bank count of the device
+std::vector<FeatureCase> feature_cases(Device* device) {
+    uint32_t dram_sharded_N = 8 * TILE_WIDTH * device->num_dram_channels();
+    return {
+        {.name = "baseline"},
+        {.name = "packer L1 acc", .kernel_config = {.packer_l1_acc = true}},
+        {.name = "packer L1 acc, matmul_block", .kernel_config = {.packer_l1_acc = true, .matmul_block = true}},
+        {.name = "bias", .epilogue = {.fuse_bias = true}},
+        {.name = "ReLU", .epilogue = {.activation = Activation::ReLU}},
+        {.name = "GeLU", .epilogue = {.activation = Activation::GeLU}},
+        {.name = "SiLU", .epilogue = {.activation = Activation::SiLU}},
+        {.name = "bias, GeLU", .epilogue = {.fuse_bias = true, .activation = Activation::GeLU}},
+        {.name = "bias, SiLU, packer L1 acc",
+         .kernel_config = {.packer_l1_acc = true},
+         .epilogue = {.fuse_bias = true, .activation = Activation::SiLU}},
+        {.name = "row-major output", .kernel_config = {.untilize_out = true}},
+        {.name = "row-major output, matmul_block, bias",
+         .kernel_config = {.matmul_block = true, .untilize_out = true},
+         .epilogue = {.fuse_bias = true}},
+        {.name = "2x2 output blocks", .kernel_config = {.num_out_blocks_h = 2, .num_out_blocks_w = 2}},
+        {.name = "2x1 output blocks, packer L1 acc, bias, GeLU",
+         .kernel_config = {.packer_l1_acc = true, .num_out_blocks_h = 2, .num_out_blocks_w = 1},
+         .epilogue = {.fuse_bias = true, .activation = Activation::GeLU}},
+        {.name = "1x2 output blocks, matmul_block, row-major output",
+         .kernel_config = {.matmul_block = true, .untilize_out = true, .num_out_blocks_h = 1, .num_out_blocks_w = 2}},
+        {.name = "Bfp8_b B", .data_formats = {.in1 = tt::DataFormat::Bfp8_b}},
+        {.name = "Bfp8_b output", .data_formats = {.out = tt::DataFormat::Bfp8_b}},
+        {.name = "Bfp8_b A, B and output, LoFi",
+         .data_formats = uniform_data_formats(tt::DataFormat::Bfp8_b),
+         .math_fidelity = MathFidelity::LoFi},
+        {.name = "row-major A", .kernel_config = {.tilize_in0 = true}},
+        {.name = "row-major B", .kernel_config = {.tilize_in1 = true}},
+        {.name = "row-major A and B, packer L1 acc, bias",
+         .kernel_config = {.packer_l1_acc = true, .tilize_in0 = true, .tilize_in1 = true},
+         .epilogue = {.fuse_bias = true}},
+        // L1 block-sharded A and output, 2D only. The sharded output is read back from its L1 shard buffer
+        {.name = "L1-sharded A", .kernel_config = {.mcast_layout = McastLayout::Mcast2D, .in0_sharded = true}},
+        {.name = "L1-sharded output", .kernel_config = {.mcast_layout = McastLayout::Mcast2D, .out_sharded = true}},
+        {.name = "L1-sharded A and output, packer L1 acc, bias",
+         .kernel_config =
+             {.packer_l1_acc = true, .mcast_layout = McastLayout::Mcast2D, .in0_sharded = true, .out_sharded = true},
+         .epilogue = {.fuse_bias = true}},
+        // The 1D layouts on the shapes Auto gives them: decode for in0 mcast, few N columns for in1 mcast. An in1
+        // block holds all of N, so in1 mcast on a decode shape stays at a moderate N to fit L1
+        {.name = "1D in0 mcast, decode",
+         .M = 32,
+         .N = 2048,
+         .K = 1024,
+         .kernel_config = {.mcast_layout = McastLayout::Mcast1DIn0}},
+        {.name = "1D in0 mcast, decode, packer L1 acc, bias, GeLU",
+         .M = 64,
+         .N = 2048,
+         .K = 1024,
+         .kernel_config = {.packer_l1_acc = true, .mcast_layout = McastLayout::Mcast1DIn0},
+         .epilogue = {.fuse_bias = true, .activation = Activation::GeLU}},
+        {.name = "1D in1 mcast, decode",
+         .M = 64,
+         .N = 512,
+         .K = 1024,
+         .kernel_config = {.mcast_layout = McastLayout::Mcast1DIn1}},
+        {.name = "1D in1 mcast, narrow N, matmul_block, bias",
+         .M = 2048,
+         .N = 64,
+         .K = 1024,
+         .kernel_config = {.matmul_block = true, .mcast_layout = McastLayout::Mcast1DIn1},
+         .epilogue = {.fuse_bias = true}},
+        // DRAM-sharded B: reader_bmm_dram_sharded.cpp and its per-bank runtime args
+        {.name = "DRAM-sharded B, decode",
+         .M = 32,
+         .N = dram_sharded_N,
+         .K = 1024,
+         .kernel_config = {.mcast_layout = McastLayout::DramSharded}},
+        {.name = "DRAM-sharded Bfp8_b B, decode, bias",
+         .M = 64,
+         .N = dram_sharded_N,
+         .K = 1024,
+         .kernel_config = {.mcast_layout = McastLayout::DramSharded},
+         .epilogue = {.fuse_bias = true},
+         .data_formats = {.in1 = tt::DataFormat::Bfp8_b}},
+    };
+}
+
+/*
+ * One run of each feature case on an M x N x K matmul (or the case's own shape), checked against the CPU
+ * reference. The inputs are tilized on the host unless the case tilizes them on device, the output untilized
+ * unless the device does
+ */
+bool validate_feature_cases(Device* device, uint32_t default_M, uint32_t default_N, uint32_t default_K) {
+    constexpr uint32_t single_tile_size = 2 * 1024;
+    bool pass = true;
+    for (const FeatureCase& feature : feature_cases(device)) {
+        TRACE_ZONE("feature case");
+        uint32_t M = feature.M ? feature.M : default_M;
+        uint32_t N = feature.N ? feature.N : default_N;
+        uint32_t K = feature.K ? feature.K : default_K;
+        uint32_t Mt = M / TILE_HEIGHT;
+        uint32_t Kt = K / TILE_WIDTH;
+        uint32_t Nt = N / TILE_WIDTH;
+        std::vector<bfloat16> a = create_random_vector_of_bfloat16_native(single_tile_size * Mt * Kt, 1, 123, -0.4);
+        std::vector<bfloat16> b =
+            create_random_vector_of_bfloat16_native(single_tile_size * Kt * Nt, 1, 12522, -0.3);
+        std::vector<bfloat16> bias = create_random_vector_of_bfloat16_native(single_tile_size * Nt, 1, 7, -0.5);
+        std::fill(bias.begin() + N, bias.end(), bfloat16(0.0f));
+
+        std::vector<bfloat16> a_device = a;
+        std::vector<bfloat16> b_device = b;
+        if (not feature.kernel_config.tilize_in0) {
+            tilize(a_device, M, K);
+        }
+        if (not feature.kernel_config.tilize_in1) {
+            tilize(b_device, K, N);
+        }
+        matmul::MatmulPlan plan = make_plan(
+            device,
+            {.M = M, .N = N, .K = K},
+            feature.data_formats,
+            feature.math_fidelity,
+            feature.epilogue,
+            feature.kernel_config,
+            false);
+        if (feature.epilogue.fuse_bias) {
+            std::vector<bfloat16> bias_tilized = bias;
+            tilize(bias_tilized, TILE_HEIGHT, N);
+            matmul::write_bias(plan, bias_tilized);
+        }
+        std::vector<bfloat16> output(size_t(M) * N);
+        double ms = matmul_multicore_reuse_mcast(plan, a_device, b_device, output);
+        if (not feature.kernel_config.untilize_out) {
+            untilize(output, M, N);
+        }
+        float pcc = sampled_reference_pcc(a, b, bias, output, M, N, K, feature.epilogue);
+        log_info(
+            tt::LogVerif, "{}, {}x{}x{}: {} ms, PCC against CPU reference {:.5f}", feature.name, M, N, K, ms, pcc);
+        pass &= pcc >= matmul::VALIDATION_PCC;
+    }
+    return pass;
+}
+
+}  // namespace multi_core_reuse_mcast
+
+using namespace multi_core_reuse_mcast;
+
+///////////////////////////////////////
+// Usage example:
+//   ./metal-matmul-multicore-reuse-mcast
+//     --packer-l1-acc (accumulate partials in L1 across K-blocks)
+//     --matmul-block (one matmul_block call per subblock)
+//     --subblock-choice <index into the subblock shapes, default: 0>
+//     --untilize-out (row-major output from the device)
+//     --plan-input-layout (host or device tilize of the inputs, from a measured tilize cost)
+//     --warmup (compile the served variants ahead of time into the persistent kernel cache)
+//     --warmup-manifest <path of the warmup manifest, default: matmul_mcast_warmup.manifest>
+// Every kernel feature is off by default. With validate, each feature case also runs once on 1024 x 1024 x 1024
+// (or the shape of the case) and is checked against the CPU reference.
+///////////////////////////////////////
+
+#ifndef MATMUL_NO_MAIN
+int main(int argc, char** argv) {
+    bool pass = true;
+
+    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
+        TT_THROW("Test not supported w/ slow dispatch, exiting");
+    }
+
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+    auto has_option = [&args](const string& name) { return std::find(args.begin(), args.end(), name) != args.end(); };
+    kernel_config.packer_l1_acc = has_option("--packer-l1-acc");
+    kernel_config.matmul_block = has_option("--matmul-block");
+    kernel_config.subblock_choice = std::stoul(get_option("--subblock-choice", "0"));
+    kernel_config.untilize_out = has_option("--untilize-out");
+    plan_input_layout = has_option("--plan-input-layout");
+    warmup = has_option("--warmup");
+    warmup_manifest_path = get_option("--warmup-manifest", warmup_manifest_path);
+
+    std::string trace_path = timeline::enable_from_env();
+
+    try {
+        /* Silicon accelerator setup */
+        constexpr int device_id = 0;
+        Device* device = CreateDevice(device_id);
+        device->enable_program_cache();
+
+        if (validate) {
+            pass &= validate_feature_cases(device, 1024, 1024, 1024);
+        }
+
+        uint32_t host_threads = std::max(1u, std::thread::hardware_concurrency());
+        if (plan_input_layout) {
+            TilizeCost cost = calibrate_tilize_cost(device, math_fidelity, kernel_config);
+            kernel_config = plan_input_tilize(
+                device, M, N, K, data_formats, epilogue, kernel_config, cost, device_tilize_in1, host_threads, verbose);
+        }
+
+        if (warmup) {
+            // Served variants: M, N, K, B, data format, math fidelity, epilogue, kernel config
+            std::vector<MatmulVariant> served_variants = {
+                {M, N, K, B, data_formats, math_fidelity, epilogue, kernel_config},
+                {M, N, K, B, uniform_data_formats(tt::DataFormat::Float16_b), MathFidelity::HiFi4, {.fuse_bias = true, .activation = Activation::GeLU}},
+                {M, N, K, B, uniform_data_formats(tt::DataFormat::Float16_b), MathFidelity::HiFi2},
+                {M, N, K, B, uniform_data_formats(tt::DataFormat::Bfp8_b), MathFidelity::LoFi},
+                {M, N, K, B, {.in0 = tt::DataFormat::Float16_b, .in1 = tt::DataFormat::Bfp8_b, .out = tt::DataFormat::Float16_b}, MathFidelity::LoFi},
+                {2048, 2048, 2048, B, uniform_data_formats(tt::DataFormat::Float16_b), MathFidelity::HiFi4},
+            };
+            warmup_matmul_mcast(device, served_variants, warmup_manifest_path);
+        }
+
+        if (benchmark_packer_l1_acc) {
+            benchmark_packer_l1_acc_sweep(device, data_formats, math_fidelity, kernel_config);
+        }
+        if (benchmark_subblocks) {
+            benchmark_subblock_sweep(device, M, N, K, data_formats, math_fidelity, kernel_config);
+        }
+        if (benchmark_untilize_out) {
+            benchmark_untilize_out_saving(device, M, N, K, math_fidelity, kernel_config);
+        }
+        if (benchmark_tilize_in) {
+            benchmark_tilize_in_sweep(device, math_fidelity, kernel_config, host_threads);
+        }
+        if (benchmark_data_formats) {
+            benchmark_data_format_combinations(device, M, N, K, math_fidelity, kernel_config);
+        }
+        if (benchmark_mcast_layouts) {
+            benchmark_mcast_layout_sweep(device, data_formats, math_fidelity, kernel_config);
+        }
+        if (benchmark_sharded) {
+            benchmark_sharded_sweep(device, data_formats, math_fidelity, kernel_config);
+        }
+        if (benchmark_dram_sharded) {
+            pass &= benchmark_dram_sharded_sweep(device, math_fidelity, kernel_config);
+        }
+        if (benchmark_out_blocks) {
+            benchmark_out_blocks_sweep(device, data_formats, math_fidelity, kernel_config);
+        }
+
+        constexpr uint32_t single_tile_size = 2 * 1024;
+        uint32_t dram_buffer_A_size = single_tile_size * Mt * Kt;  // num_tiles of FP16_B
+        uint32_t dram_buffer_B_size = single_tile_size * Nt * Kt;  // num_tiles of FP16_B
+        uint32_t dram_buffer_C_size = single_tile_size * Mt * Nt;  // num_tiles of FP16_B
+
+        /* input vectors */
+        std::vector<bfloat16> src0_vec = create_random_vector_of_bfloat16_native(dram_buffer_A_size, 1, 123, -0.4);
+        std::vector<bfloat16> src1_vec = create_random_vector_of_bfloat16_native(dram_buffer_B_size, 1, 12522, -0.3);
+        /* Getting number of milliseconds as a double. */
+
+        /* Bias as a [32, N] tile row, only the first row is used */
+        std::vector<bfloat16> bias_vec = create_random_vector_of_bfloat16_native(single_tile_size * Nt, 1, 7, -0.5);
+        std::fill(bias_vec.begin() + N, bias_vec.end(), bfloat16(0.0f));
+
+        /* Row major copies for the CPU reference */
+        std::vector<bfloat16> src0_rm, src1_rm, bias_rm;
+        if (validate) {
+            src0_rm = src0_vec;
+            src1_rm = src1_vec;
+            bias_rm = bias_vec;
+        }
+
+        /* Input vector tilizing, row-major inputs are tilized on device */
+        auto t1 = high_resolution_clock::now();
+        {
+            TRACE_ZONE("tilize");
+            if (not kernel_config.tilize_in0) {
+                tilize_parallel(src0_vec, M, K, host_threads);
+            }
+            if (not kernel_config.tilize_in1) {
+                tilize_parallel(src1_vec, K, N, host_threads);
+            }
+            tilize(bias_vec, TILE_HEIGHT, N);
+        }
+        auto t2 = high_resolution_clock::now();
+        duration<double, std::milli> til_dur = t2 - t1;
+        log_info(tt::LogVerif, "Time tilizing of vectors: {} ms", til_dur.count());
+
+        /* Calling the MatMul host program. Read in result into a host vector */
+        std::vector<bfloat16> result_vec(dram_buffer_C_size / sizeof(bfloat16));
+        duration<double, std::milli> tot_duration(0);
+        
+        t1 = high_resolution_clock::now();
+        matmul::MatmulPlan plan = [&] {
+            TRACE_ZONE("plan");
+            return make_plan(
+                device,
+                {.M = M, .N = N, .K = K, .B = B},
+                data_formats,
+                math_fidelity,
+                epilogue,
+                kernel_config,
+                verbose);
+        }();
+        if (epilogue.fuse_bias) {
+            matmul::write_bias(plan, bias_vec);
+        }
+        matmul_multicore_reuse_mcast(plan, src0_vec, src1_vec, result_vec);
+        t2 = high_resolution_clock::now();
+        duration<double, std::milli> fr_dur = t2 - t1;
+        log_info(tt::LogVerif, "First execution mm: {} ms", fr_dur.count());
+
+        // for (int i = 0; i < NUMBER_OF_EXECUTIONS; i++){
+        t1 = high_resolution_clock::now();
+        matmul_multicore_reuse_mcast(plan, src0_vec, src1_vec, result_vec, NUMBER_OF_EXECUTIONS);
+        t2 = high_resolution_clock::now();
+        duration<double, std::milli> sr_dur = t2 - t1;
+        log_info(tt::LogVerif, "Second execution mm: {} ms", sr_dur.count());
+        // log_info(tt::LogVerif, "Time mm: {} ms", duration.count());
+        // tot_duration = duration + tot_duration;
+
+        tot_duration = fr_dur + til_dur;
+        log_info(tt::LogVerif, "Time til + fr mm: {} ms", tot_duration.count());
+        if (not kernel_config.untilize_out) {
+            t1 = high_resolution_clock::now();
+            {
+                TRACE_ZONE("untilize");
+                untilize(result_vec, M, N);
+            }
+            t2 = high_resolution_clock::now();
+            duration<double, std::milli> until_dur = t2 - t1;
+            log_info(tt::LogVerif, "Time untilizing of output: {} ms", until_dur.count());
+        }
+        // }
+
+        log_info(tt::LogVerif, "Tot duration mean: {} ms", (tot_duration.count() / NUMBER_OF_EXECUTIONS));
+        log_info(tt::LogVerif, "Output vector of size {}", result_vec.size());
+
+        if (validate) {
+            TRACE_ZONE("validate");
+            float pcc = sampled_reference_pcc(src0_rm, src1_rm, bias_rm, result_vec, M, N, K, epilogue);
+            log_info(tt::LogVerif, "PCC against CPU reference: {}", pcc);
+            pass &= pcc >= matmul::VALIDATION_PCC;
+        }
+
+        pass &= CloseDevice(device);
+
+        if (not trace_path.empty() and timeline::write_host_trace(trace_path)) {
+            log_info(tt::LogVerif, "Host trace written to {}", trace_path);
+        }
 
     } catch (const std::exception& e) {
         tt::log_error(tt::LogTest, "Test failed with exception!");
@@ -627,4 +2798,5 @@ int main(int argc, char** argv) {
     TT_ASSERT(pass);
 
     return 0;
-}
\ No newline at end of file
+}
+#endif  // MATMUL_NO_MAIN
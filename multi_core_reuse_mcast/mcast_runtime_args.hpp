@@ -0,0 +1,383 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/assert.hpp"
+#include "tt_metal/common/core_coord.hpp"
+#include "tt_metal/impl/device/device.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Reader / writer runtime args of the mcast matmul (2D and 1D layouts), built
+// per core group and set in bulk. Only depends on the logical -> physical core
+// mapping, so tests/test_mcast_runtime_args.cpp checks it against fixed args
+// without a device.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace multi_core_reuse_mcast {
+
+using tt::tt_metal::Device;
+using tt::tt_metal::KernelHandle;
+using tt::tt_metal::Program;
+
+/*
+ * Mcast scheme of a plan. 2D: the left column mcasts in0 along its row and the top row mcasts in1 along its
+ * column. 1D: one core mcasts in0 (or in1) to the whole grid and every core reads its own slice of the other
+ * operand, N (or M) is split over all the cores. DramSharded: in1 is width-sharded over the DRAM banks, the
+ * worker next to each bank streams its shard while in0 is mcasted to all the workers (small M decode).
+ */
+enum class McastLayout { Auto, Mcast2D, Mcast1DIn0, Mcast1DIn1, DramSharded };
+
+constexpr uint32_t MCAST_READER_NUM_ARGS = 39;  // plus 1 + num_cores_c with a sharded in0
+constexpr uint32_t MCAST_WRITER_NUM_ARGS = 13;
+constexpr uint32_t MCAST_WRITER_BIAS_NUM_ARGS = 3;
+
+struct McastRuntimeArgsParams {
+    uint32_t src0_addr;
+    uint32_t src1_addr;
+    uint32_t dst_addr;
+    uint32_t Mt;
+    uint32_t Nt;
+    uint32_t Kt;
+    uint32_t B;
+    bool bcast_batch;
+    uint32_t in0_block_w;
+    uint32_t per_core_M;
+    uint32_t per_core_N;
+    uint32_t out_subblock_h;
+    uint32_t out_subblock_w;
+    CoreCoord start_core;
+    uint32_t num_cores_c;
+    uint32_t num_cores_r;
+    uint32_t in0_mcast_sender_semaphore_id;
+    uint32_t in0_mcast_receiver_semaphore_id;
+    uint32_t in1_mcast_sender_semaphore_id;
+    uint32_t in1_mcast_receiver_semaphore_id;
+    bool fuse_bias = false;
+    uint32_t bias_addr = 0;
+    McastLayout layout = McastLayout::Mcast2D;  // 1D: num_cores_c x num_cores_r blocks laid out row by row
+    bool in0_sharded = false;
+    uint32_t num_out_blocks_h = 1;  // the in0 / in1 / subblock args are those of one output block
+    uint32_t num_out_blocks_w = 1;
+};
+
+/*
+ * Logical -> physical worker coordinates for the whole logical grid, built once per device.
+ * Replaces the six worker_core_from_logical_core calls per core in the runtime args loop.
+ */
+class CoreCoordTable {
+public:
+    static const CoreCoordTable& get(Device* device) {
+        static std::unordered_map<chip_id_t, CoreCoordTable> tables;
+        auto it = tables.find(device->id());
+        if (it == tables.end()) {
+            it = tables.emplace(device->id(), CoreCoordTable(device)).first;
+        }
+        return it->second;
+    }
+
+    // Table of an explicit logical -> physical mapping, physical[y * grid_size.x + x]
+    CoreCoordTable(CoreCoord grid_size, std::vector<CoreCoord> physical) :
+        grid_size_(grid_size), physical_(std::move(physical)) {
+        TT_FATAL(physical_.size() == grid_size_.x * grid_size_.y, "Core table does not cover the grid");
+    }
+
+    const CoreCoord& physical(std::size_t x, std::size_t y) const {
+        TT_ASSERT(x < grid_size_.x and y < grid_size_.y);
+        return physical_[y * grid_size_.x + x];
+    }
+
+private:
+    explicit CoreCoordTable(Device* device) : grid_size_(device->logical_grid_size()) {
+        physical_.reserve(grid_size_.x * grid_size_.y);
+        for (std::size_t y = 0; y < grid_size_.y; y++) {
+            for (std::size_t x = 0; x < grid_size_.x; x++) {
+                physical_.push_back(device->worker_core_from_logical_core({x, y}));
+            }
+        }
+    }
+
+    CoreCoord grid_size_;
+    std::vector<CoreCoord> physical_;
+};
+
+/*
+ * Cores are grouped by mcast role, which is also the unit a reader/writer kernel is created on:
+ * 0: in0 sender / in1 sender, 1: in0 sender / in1 receiver, 2: in0 receiver / in1 sender, 3: in0 receiver / in1 receiver
+ * In 1D a core that reads its own slice of the operand that is not mcasted counts as its sender.
+ * Args live in an arena reused across build calls on the same builder (only reallocated when the grid changes),
+ * and each group is set with a single bulk SetRuntimeArgs.
+ */
+class McastRuntimeArgsBuilder {
+public:
+    static constexpr uint32_t NUM_GROUPS = 4;
+
+    struct Group {
+        std::vector<CoreCoord> cores;
+        std::vector<std::vector<uint32_t>> reader_args;
+        std::vector<std::vector<uint32_t>> writer_args;
+    };
+
+    static uint32_t group_index(uint32_t core_idx_x, uint32_t core_idx_y) {
+        return (core_idx_x != 0) * 2 + (core_idx_y != 0);
+    }
+
+    // 1D: core 0 is the sender of the mcasted operand, the others receive it and read the other one
+    static uint32_t group_index_1d(McastLayout layout, uint32_t core_idx) {
+        if (core_idx == 0) {
+            return 0;
+        }
+        return layout == McastLayout::Mcast1DIn0 ? 2 : 1;
+    }
+
+    void build(Device* device, const McastRuntimeArgsParams& p) { build(CoreCoordTable::get(device), p); }
+
+    void build(const CoreCoordTable& coords, const McastRuntimeArgsParams& p) {
+        resize(p.num_cores_c, p.num_cores_r, p.fuse_bias, p.layout, p.in0_sharded);
+
+        std::array<uint32_t, NUM_GROUPS> next = {0, 0, 0, 0};
+        for (uint32_t core_idx_y = 0; core_idx_y < p.num_cores_r; core_idx_y++) {
+            for (uint32_t core_idx_x = 0; core_idx_x < p.num_cores_c; core_idx_x++) {
+                // Output block of the core: its grid position in 2D, its index along the split dimension in 1D
+                uint32_t core_idx = core_idx_y * p.num_cores_c + core_idx_x;
+                uint32_t block_idx_x = core_idx_x;
+                uint32_t block_idx_y = core_idx_y;
+                uint32_t group_idx = group_index(core_idx_x, core_idx_y);
+                if (p.layout != McastLayout::Mcast2D) {
+                    block_idx_x = p.layout == McastLayout::Mcast1DIn0 ? core_idx : 0;
+                    block_idx_y = p.layout == McastLayout::Mcast1DIn1 ? core_idx : 0;
+                    group_idx = group_index_1d(p.layout, core_idx);
+                }
+                Group& group = groups_[group_idx];
+                uint32_t slot = next[group_idx]++;
+                CoreCoord core = {p.start_core.x + core_idx_x, p.start_core.y + core_idx_y};
+                group.cores[slot] = core;
+                fill_reader_args(group.reader_args[slot].data(), coords, p, core, block_idx_x, block_idx_y);
+                fill_writer_args(group.writer_args[slot].data(), p, block_idx_x, block_idx_y);
+            }
+        }
+    }
+
+    void set(
+        Program& program,
+        const std::array<KernelHandle, NUM_GROUPS>& reader_kernel_ids,
+        const std::array<KernelHandle, NUM_GROUPS>& writer_kernel_ids) const {
+        for (uint32_t i = 0; i < NUM_GROUPS; i++) {
+            if (groups_[i].cores.empty()) {
+                continue;
+            }
+            tt::tt_metal::SetRuntimeArgs(program, reader_kernel_ids[i], groups_[i].cores, groups_[i].reader_args);
+            tt::tt_metal::SetRuntimeArgs(program, writer_kernel_ids[i], groups_[i].cores, groups_[i].writer_args);
+        }
+    }
+
+    const Group& group(uint32_t i) const { return groups_[i]; }
+
+    static void fill_writer_args(
+        uint32_t* args, const McastRuntimeArgsParams& p, uint32_t core_idx_x, uint32_t core_idx_y) {
+        args[0] = p.dst_addr;                                                 // out_buffer_addr
+        args[1] = core_idx_x * p.per_core_N + core_idx_y * p.per_core_M * p.Nt;  // out_buffer_start_tile_id
+        args[2] = 1;                                                          // out_buffer_stride_w
+        args[3] = p.Nt;                                                       // out_buffer_stride_h
+        args[4] = p.out_subblock_w;                                           // out_buffer_next_subblock_stride_w
+        args[5] = p.out_subblock_h * p.Nt;                                    // out_buffer_next_subblock_stride_h
+
+        args[6] = p.out_subblock_w;                                           // out_subblock_w
+        args[7] = p.out_subblock_h;                                           // out_subblock_h
+        args[8] = p.out_subblock_w * p.out_subblock_h;                        // out_subblocks_w * out_subblocks_h
+        args[9] = p.per_core_N / p.num_out_blocks_w / p.out_subblock_w;       // out_num_subblocks_w
+        args[10] = p.per_core_M / p.num_out_blocks_h / p.out_subblock_h;      // out_num_subblocks_h
+
+        args[11] = p.Mt * p.Nt;                                               // MtNt
+        args[12] = p.B;                                                       // batch
+
+        if (p.fuse_bias) {
+            args[13] = p.bias_addr;                                           // bias_buffer_addr
+            args[14] = core_idx_x * p.per_core_N;                             // bias_buffer_start_tile_id
+            args[15] = p.per_core_N;                                          // bias_num_tiles
+        }
+    }
+
+private:
+    // Only reallocates when the grid changes
+    void resize(uint32_t num_cores_c, uint32_t num_cores_r, bool fuse_bias, McastLayout layout, bool in0_sharded) {
+        if (num_cores_c == num_cores_c_ and num_cores_r == num_cores_r_ and fuse_bias == fuse_bias_ and
+            layout == layout_ and in0_sharded == in0_sharded_) {
+            return;
+        }
+        num_cores_c_ = num_cores_c;
+        num_cores_r_ = num_cores_r;
+        fuse_bias_ = fuse_bias;
+        layout_ = layout;
+        in0_sharded_ = in0_sharded;
+        uint32_t reader_num_args = MCAST_READER_NUM_ARGS + (in0_sharded ? 1 + num_cores_c : 0);
+        uint32_t writer_num_args = MCAST_WRITER_NUM_ARGS + (fuse_bias ? MCAST_WRITER_BIAS_NUM_ARGS : 0);
+        std::array<uint32_t, NUM_GROUPS> sizes = {
+            1, num_cores_r - 1, num_cores_c - 1, (num_cores_c - 1) * (num_cores_r - 1)};
+        if (layout != McastLayout::Mcast2D) {
+            uint32_t num_receivers = num_cores_c * num_cores_r - 1;
+            sizes = {
+                1,
+                layout == McastLayout::Mcast1DIn1 ? num_receivers : 0,
+                layout == McastLayout::Mcast1DIn0 ? num_receivers : 0,
+                0};
+        }
+        for (uint32_t i = 0; i < NUM_GROUPS; i++) {
+            groups_[i].cores.resize(sizes[i]);
+            groups_[i].reader_args.assign(sizes[i], std::vector<uint32_t>(reader_num_args));
+            groups_[i].writer_args.assign(sizes[i], std::vector<uint32_t>(writer_num_args));
+        }
+    }
+
+    static void fill_reader_args(
+        uint32_t* args,
+        const CoreCoordTable& coords,
+        const McastRuntimeArgsParams& p,
+        const CoreCoord& core,
+        uint32_t core_idx_x,
+        uint32_t core_idx_y) {
+        if (p.layout != McastLayout::Mcast2D) {
+            fill_reader_args_1d(args, coords, p, core_idx_x, core_idx_y);
+            return;
+        }
+        const CoreCoord& left_core_physical = coords.physical(p.start_core.x, core.y);
+        const CoreCoord& left_core_plus_one_physical = coords.physical(p.start_core.x + 1, core.y);
+        const CoreCoord& right_core_physical = coords.physical(p.start_core.x + p.num_cores_c - 1, core.y);
+        const CoreCoord& top_core_physical = coords.physical(core.x, p.start_core.y);
+        const CoreCoord& top_core_plus_one_physical = coords.physical(core.x, p.start_core.y + 1);
+        const CoreCoord& bottom_core_physical = coords.physical(core.x, p.start_core.y + p.num_cores_r - 1);
+
+        args[0] = p.src0_addr;                           // in0_buffer_addr
+        args[1] = p.Kt * p.per_core_M * core_idx_y;      // in0_buffer_start_tile_id
+        args[2] = 1;                                     // in0_buffer_stride_w
+        args[3] = p.Kt;                                  // in0_buffer_stride_h
+        args[4] = p.in0_block_w;                         // in0_buffer_next_block_stride
+
+        args[5] = p.in0_block_w;                         // in0_block_w
+        args[6] = p.per_core_M / p.num_out_blocks_h;     // in0_block_h
+        args[7] = p.in0_block_w * args[6];               // in0_block_num_tiles
+
+        args[8] = p.src1_addr;                           // in1_buffer_addr
+        args[9] = p.per_core_N * core_idx_x;             // in1_buffer_start_tile_id
+        args[10] = 1;                                    // in1_buffer_stride_w
+        args[11] = p.Nt;                                 // in1_buffer_stride_h
+        args[12] = p.in0_block_w * p.Nt;                 // in1_buffer_next_block_stride
+
+        args[13] = p.per_core_N / p.num_out_blocks_w;    // in1_block_w
+        args[14] = p.in0_block_w;                        // in1_block_h
+        args[15] = args[13] * p.in0_block_w;             // in1_block_num_tiles
+
+        args[16] = p.Kt / p.in0_block_w;                 // num_blocks
+
+        args[17] = right_core_physical.x;                // in0_mcast_dest_noc_start_x
+        args[18] = right_core_physical.y;                // in0_mcast_dest_noc_start_y
+        args[19] = left_core_plus_one_physical.x;        // in0_mcast_dest_noc_end_x
+        args[20] = left_core_plus_one_physical.y;        // in0_mcast_dest_noc_end_y
+        args[21] = p.num_cores_c - 1;                    // in0_mcast_num_dests
+        args[22] = left_core_physical.x;                 // in0_mcast_sender_noc_x
+        args[23] = left_core_physical.y;                 // in0_mcast_sender_noc_y
+        args[24] = p.in0_mcast_sender_semaphore_id;
+        args[25] = p.in0_mcast_receiver_semaphore_id;
+
+        args[26] = bottom_core_physical.x;               // in1_mcast_dest_noc_start_x
+        args[27] = bottom_core_physical.y;               // in1_mcast_dest_noc_start_y
+        args[28] = top_core_plus_one_physical.x;         // in1_mcast_dest_noc_end_x
+        args[29] = top_core_plus_one_physical.y;         // in1_mcast_dest_noc_end_y
+        args[30] = p.num_cores_r - 1;                    // in1_mcast_num_dests
+        args[31] = top_core_physical.x;                  // in1_mcast_sender_noc_x
+        args[32] = top_core_physical.y;                  // in1_mcast_sender_noc_y
+        args[33] = p.in1_mcast_sender_semaphore_id;
+        args[34] = p.in1_mcast_receiver_semaphore_id;
+
+        args[35] = p.Mt * p.Kt;                          // MtKt
+        args[36] = p.Kt * p.Nt;                          // KtNt
+        args[37] = p.B;                                  // batch
+        args[38] = p.bcast_batch;                        // bcast_B
+
+        if (p.in0_sharded) {
+            // The whole row receives, sender included, from core block of the row for K-block block
+            args[19] = left_core_physical.x;             // in0_mcast_dest_noc_end_x
+            args[20] = left_core_physical.y;             // in0_mcast_dest_noc_end_y
+            args[39] = core_idx_x;                       // in0_shard_core_idx
+            for (uint32_t x = 0; x < p.num_cores_c; x++) {
+                args[40 + x] = coords.physical(p.start_core.x + x, core.y).x;  // in0_mcast_sender_noc_x per block
+            }
+        }
+    }
+
+    /*
+     * Same args as 2D for the block (block_idx_x, block_idx_y). The mcasted operand goes from the first core to
+     * the whole rectangle, sender included (reader_bmm_mcast loops it back), the other mcast args are unused.
+     */
+    static void fill_reader_args_1d(
+        uint32_t* args,
+        const CoreCoordTable& coords,
+        const McastRuntimeArgsParams& p,
+        uint32_t block_idx_x,
+        uint32_t block_idx_y) {
+        const CoreCoord& first_core_physical = coords.physical(p.start_core.x, p.start_core.y);
+        const CoreCoord& last_core_physical =
+            coords.physical(p.start_core.x + p.num_cores_c - 1, p.start_core.y + p.num_cores_r - 1);
+        uint32_t mcast_args_start = p.layout == McastLayout::Mcast1DIn0 ? 17 : 26;
+        uint32_t unused_args_start = p.layout == McastLayout::Mcast1DIn0 ? 26 : 17;
+
+        args[0] = p.src0_addr;                           // in0_buffer_addr
+        args[1] = p.Kt * p.per_core_M * block_idx_y;     // in0_buffer_start_tile_id
+        args[2] = 1;                                     // in0_buffer_stride_w
+        args[3] = p.Kt;                                  // in0_buffer_stride_h
+        args[4] = p.in0_block_w;                         // in0_buffer_next_block_stride
+
+        args[5] = p.in0_block_w;                         // in0_block_w
+        args[6] = p.per_core_M / p.num_out_blocks_h;     // in0_block_h
+        args[7] = p.in0_block_w * args[6];               // in0_block_num_tiles
+
+        args[8] = p.src1_addr;                           // in1_buffer_addr
+        args[9] = p.per_core_N * block_idx_x;            // in1_buffer_start_tile_id
+        args[10] = 1;                                    // in1_buffer_stride_w
+        args[11] = p.Nt;                                 // in1_buffer_stride_h
+        args[12] = p.in0_block_w * p.Nt;                 // in1_buffer_next_block_stride
+
+        args[13] = p.per_core_N / p.num_out_blocks_w;    // in1_block_w
+        args[14] = p.in0_block_w;                        // in1_block_h
+        args[15] = args[13] * p.in0_block_w;             // in1_block_num_tiles
+
+        args[16] = p.Kt / p.in0_block_w;                 // num_blocks
+
+        uint32_t* mcast_args = args + mcast_args_start;
+        mcast_args[0] = last_core_physical.x;            // mcast_dest_noc_start_x
+        mcast_args[1] = last_core_physical.y;            // mcast_dest_noc_start_y
+        mcast_args[2] = first_core_physical.x;           // mcast_dest_noc_end_x
+        mcast_args[3] = first_core_physical.y;           // mcast_dest_noc_end_y
+        mcast_args[4] = p.num_cores_c * p.num_cores_r - 1;  // mcast_num_dests, the sender is not counted
+        mcast_args[5] = first_core_physical.x;           // mcast_sender_noc_x
+        mcast_args[6] = first_core_physical.y;           // mcast_sender_noc_y
+        mcast_args[7] = p.layout == McastLayout::Mcast1DIn0 ? p.in0_mcast_sender_semaphore_id
+                                                            : p.in1_mcast_sender_semaphore_id;
+        mcast_args[8] = p.layout == McastLayout::Mcast1DIn0 ? p.in0_mcast_receiver_semaphore_id
+                                                            : p.in1_mcast_receiver_semaphore_id;
+        std::fill(args + unused_args_start, args + unused_args_start + 9, 0);
+
+        args[35] = p.Mt * p.Kt;                          // MtKt
+        args[36] = p.Kt * p.Nt;                          // KtNt
+        args[37] = p.B;                                  // batch
+        args[38] = p.bcast_batch;                        // bcast_B
+    }
+
+    uint32_t num_cores_c_ = 0;
+    uint32_t num_cores_r_ = 0;
+    bool fuse_bias_ = false;
+    McastLayout layout_ = McastLayout::Mcast2D;
+    bool in0_sharded_ = false;
+    std::array<Group, NUM_GROUPS> groups_;
+};
+
+}  // namespace multi_core_reuse_mcast
@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../mcast_runtime_args.hpp"
+
+using namespace multi_core_reuse_mcast;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// McastRuntimeArgsBuilder against fixed reader / writer args, no device. The
+// 8 x 8 logical grid maps to physical cores like a harvested Wormhole: x
+// skips physical column 5, y skips physical row 6, so a wrong logical ->
+// physical lookup shows up in the mcast coordinates.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+CoreCoordTable harvested_core_table() {
+    CoreCoord grid = {8, 8};
+    vector<CoreCoord> physical;
+    for (std::size_t y = 0; y < grid.y; y++) {
+        for (std::size_t x = 0; x < grid.x; x++) {
+            physical.push_back({x + 1 + (x >= 4), y + 1 + (y >= 5)});
+        }
+    }
+    return CoreCoordTable(grid, physical);
+}
+
+bool check(const std::string& name, const vector<uint32_t>& args, const vector<uint32_t>& expected) {
+    if (args.size() != expected.size()) {
+        log_error(tt::LogTest, "{}: {} args, expected {}", name, args.size(), expected.size());
+        return false;
+    }
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] != expected[i]) {
+            log_error(tt::LogTest, "{}: arg {} is {}, expected {}", name, i, args[i], expected[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 2 x 2 grid at logical (3, 0), across the skipped physical column, fused bias
+bool check_2d(const CoreCoordTable& coords) {
+    McastRuntimeArgsParams p = {
+        .src0_addr = 0x1000,
+        .src1_addr = 0x2000,
+        .dst_addr = 0x3000,
+        .Mt = 4,
+        .Nt = 4,
+        .Kt = 4,
+        .B = 1,
+        .bcast_batch = false,
+        .in0_block_w = 2,
+        .per_core_M = 2,
+        .per_core_N = 2,
+        .out_subblock_h = 2,
+        .out_subblock_w = 1,
+        .start_core = {3, 0},
+        .num_cores_c = 2,
+        .num_cores_r = 2,
+        .in0_mcast_sender_semaphore_id = 1,
+        .in0_mcast_receiver_semaphore_id = 2,
+        .in1_mcast_sender_semaphore_id = 3,
+        .in1_mcast_receiver_semaphore_id = 4,
+        .fuse_bias = true,
+        .bias_addr = 0x4000};
+    McastRuntimeArgsBuilder builder;
+    builder.build(coords, p);
+
+    bool pass = true;
+    for (uint32_t i = 0; i < McastRuntimeArgsBuilder::NUM_GROUPS; i++) {
+        pass &= builder.group(i).cores.size() == 1;
+    }
+    if (not pass) {
+        log_error(tt::LogTest, "2D: expected one core per group");
+        return false;
+    }
+    pass &= builder.group(0).cores[0] == CoreCoord{3, 0};
+    pass &= builder.group(3).cores[0] == CoreCoord{4, 1};
+
+    // In0 and in1 receiver (4, 1): its row's sender is (3, 1), its column's (4, 0)
+    const auto& receiver = builder.group(3);
+    pass &= check(
+        "2D reader (4, 1)",
+        receiver.reader_args[0],
+        {0x1000, 8,  1, 4, 2, 2, 2, 4, 0x2000, 2, 1, 4, 8, 2, 2, 4, 2, 6, 2, 6,
+         2,      1,  4, 2, 1, 2, 6, 2, 6,      2, 1, 6, 1, 3, 4, 16, 16, 1, 0});
+    pass &= check(
+        "2D writer (4, 1)", receiver.writer_args[0], {0x3000, 10, 1, 4, 1, 8, 1, 2, 2, 2, 1, 16, 1, 0x4000, 2, 2});
+
+    // In0 and in1 sender (3, 0)
+    const auto& sender = builder.group(0);
+    pass &= check(
+        "2D reader (3, 0)",
+        sender.reader_args[0],
+        {0x1000, 0,  1, 4, 2, 2, 2, 4, 0x2000, 0, 1, 4, 8, 2, 2, 4, 2, 6, 1, 6,
+         1,      1,  4, 1, 1, 2, 4, 2, 4,      2, 1, 4, 1, 3, 4, 16, 16, 1, 0});
+    pass &= check(
+        "2D writer (3, 0)", sender.writer_args[0], {0x3000, 0, 1, 4, 1, 8, 1, 2, 2, 2, 1, 16, 1, 0x4000, 0, 2});
+    return pass;
+}
+
+// 4 x 1 grid with in0 mcasted from core 0, every core reads its own N slice of in1
+bool check_1d_in0(const CoreCoordTable& coords) {
+    McastRuntimeArgsParams p = {
+        .src0_addr = 0x1000,
+        .src1_addr = 0x2000,
+        .dst_addr = 0x3000,
+        .Mt = 2,
+        .Nt = 8,
+        .Kt = 4,
+        .B = 1,
+        .bcast_batch = false,
+        .in0_block_w = 4,
+        .per_core_M = 2,
+        .per_core_N = 2,
+        .out_subblock_h = 2,
+        .out_subblock_w = 2,
+        .start_core = {0, 0},
+        .num_cores_c = 4,
+        .num_cores_r = 1,
+        .in0_mcast_sender_semaphore_id = 1,
+        .in0_mcast_receiver_semaphore_id = 2,
+        .in1_mcast_sender_semaphore_id = 3,
+        .in1_mcast_receiver_semaphore_id = 4,
+        .layout = McastLayout::Mcast1DIn0};
+    McastRuntimeArgsBuilder builder;
+    builder.build(coords, p);
+
+    const auto& receivers = builder.group(2);
+    if (builder.group(0).cores.size() != 1 or receivers.cores.size() != 3 or not builder.group(1).cores.empty() or
+        not builder.group(3).cores.empty()) {
+        log_error(tt::LogTest, "1D in0: expected one sender and three in0 receivers");
+        return false;
+    }
+    // Core 2 is the second receiver, the in1 mcast args are zeroed
+    bool pass = receivers.cores[1] == CoreCoord{2, 0};
+    pass &= check(
+        "1D in0 reader (2, 0)",
+        receivers.reader_args[1],
+        {0x1000, 0, 1, 4, 4, 4, 2, 8, 0x2000, 4, 1, 8, 32, 2, 4, 8, 1, 4, 1, 1,
+         1,      3, 1, 1, 1, 2, 0, 0, 0,      0, 0, 0, 0,  0, 0, 8, 32, 1, 0});
+    pass &= check("1D in0 writer (2, 0)", receivers.writer_args[1], {0x3000, 4, 1, 8, 2, 16, 2, 2, 4, 1, 1, 16, 1});
+    return pass;
+}
+
+}  // namespace
+
+int main() {
+    CoreCoordTable coords = harvested_core_table();
+    bool pass = check_2d(coords);
+    pass &= check_1d_in0(coords);
+    if (not pass) {
+        log_error(tt::LogTest, "Mcast runtime args do not match the expected args");
+        return 1;
+    }
+    log_info(tt::LogTest, "Mcast runtime args match");
+    return 0;
+}
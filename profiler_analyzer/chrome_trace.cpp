@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "chrome_trace.hpp"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+using std::string;
+using std::vector;
+
+namespace profiler {
+
+ChromeTraceAlignment append_device_events(
+    const ProfileData& data,
+    const Report& report,
+    const string& anchor,
+    vector<timeline::TraceEvent>& events,
+    vector<timeline::TraceTrack>& tracks) {
+    ChromeTraceAlignment alignment;
+    alignment.clock_mhz = data.clock_mhz > 0 ? data.clock_mhz : 1000;
+
+    // Host anchors in time order, events may hold zones of several threads
+    vector<double> anchors;
+    for (const auto& event : events) {
+        if (event.pid == timeline::HOST_PID and event.name == anchor) {
+            anchors.push_back(event.ts_us);
+        }
+    }
+    std::sort(anchors.begin(), anchors.end());
+    alignment.num_anchors = anchors.size();
+
+    // Host timebase of each run's t0
+    vector<double> run_offset_us(report.runs.size());
+    for (size_t r = 0; r < report.runs.size(); r++) {
+        if (r < anchors.size()) {
+            run_offset_us[r] = anchors[r];
+            alignment.anchored_runs++;
+        } else if (r > 0) {
+            run_offset_us[r] =
+                run_offset_us[r - 1] + (report.runs[r].t0 - report.runs[r - 1].t0) / alignment.clock_mhz;
+        }
+    }
+
+    // One row per (core, RISC), ordered by core then RISC name
+    std::map<std::tuple<uint32_t, uint32_t, string>, uint32_t> rows;
+    for (const auto& zone : data.zones) {
+        rows.emplace(std::make_tuple(zone.core_y, zone.core_x, data.risc_names[zone.risc]), 0);
+    }
+    uint32_t tid = 0;
+    for (auto& [key, row_tid] : rows) {
+        const auto& [core_y, core_x, risc] = key;
+        row_tid = ++tid;
+        tracks.push_back(
+            {DEVICE_PID,
+             row_tid,
+             "device",
+             "core (" + std::to_string(core_x) + ", " + std::to_string(core_y) + ") " + risc});
+    }
+
+    events.reserve(events.size() + data.zones.size());
+    for (const auto& zone : data.zones) {
+        const uint64_t t0 = report.runs[zone.run].t0;
+        timeline::TraceEvent event;
+        event.name = data.zone_names[zone.name];
+        event.category = "device";
+        event.pid = DEVICE_PID;
+        event.tid = rows[std::make_tuple(zone.core_y, zone.core_x, data.risc_names[zone.risc])];
+        event.ts_us = run_offset_us[zone.run] + (zone.start - t0) / alignment.clock_mhz;
+        event.dur_us = (zone.end - zone.start) / alignment.clock_mhz;
+        events.push_back(std::move(event));
+    }
+    return alignment;
+}
+
+}  // namespace profiler
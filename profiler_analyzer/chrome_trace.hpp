@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../common/trace_zones.hpp"
+#include "profile_analyzer.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Device zones of the profiler log as Chrome trace events, on the timebase of
+// the host zones recorded with TRACE_ZONE (common/trace_zones.hpp).
+//
+// Device stamps count cycles since the reset of each chip and the host has no
+// way to read that clock, so the two timelines are aligned per run: the t0 of
+// the n-th device run is placed at the start of the n-th host zone named
+// anchor ("enqueue" by default, EnqueueProgram of that run). Within a run the
+// device zones keep their cycle-accurate spacing, converted with the chip
+// clock of the log header. Runs without a matching anchor follow the previous
+// run at their device spacing; without host zones the device timeline starts
+// at 0.
+//
+// Every (core, RISC) gets its own row of the "device" process, pid 1.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace profiler {
+
+constexpr uint32_t DEVICE_PID = 1;
+
+struct ChromeTraceAlignment {
+    uint32_t anchored_runs = 0;  // device runs placed on a host anchor zone
+    uint32_t num_anchors = 0;    // host zones named anchor
+    double clock_mhz = 0;        // used for the conversion, the log's or 1000 when it has none
+};
+
+ChromeTraceAlignment append_device_events(
+    const ProfileData& data,
+    const Report& report,
+    const std::string& anchor,
+    std::vector<timeline::TraceEvent>& events,
+    std::vector<timeline::TraceTrack>& tracks);
+
+}  // namespace profiler
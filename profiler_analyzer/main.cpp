@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chrome_trace.hpp"
+#include "profile_analyzer.hpp"
+
+using std::string;
+using std::vector;
+
+// profiler-analyzer <profile_log_device.csv> [--json <path>|-] [--per-core]
+//                   [--chrome-trace <path> [--host-trace <MATMUL_TRACE file>] [--anchor <host zone>]]
+int main(int argc, char** argv) {
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+    auto has_option = [&args](const string& name) { return std::find(args.begin(), args.end(), name) != args.end(); };
+
+    if (args.empty() or args[0].rfind("--", 0) == 0) {
+        std::fprintf(
+            stderr,
+            "usage: profiler-analyzer <profile_log_device.csv> [--json <path>|-] [--per-core]\n"
+            "                         [--chrome-trace <path> [--host-trace <path>] [--anchor <host zone>]]\n");
+        return 2;
+    }
+    string json_path = get_option("--json", "");
+    bool per_core = has_option("--per-core");
+    string chrome_trace_path = get_option("--chrome-trace", "");
+    string host_trace_path = get_option("--host-trace", "");
+    string anchor = get_option("--anchor", "enqueue");
+
+    profiler::ProfileData data;
+    string error;
+    if (not profiler::read_profile_log(args[0], data, error)) {
+        std::fprintf(stderr, "error: %s: %s\n", args[0].c_str(), error.c_str());
+        return 1;
+    }
+    profiler::Report report = profiler::analyze(data);
+
+    if (not chrome_trace_path.empty()) {
+        vector<timeline::TraceEvent> events;
+        vector<timeline::TraceTrack> tracks;
+        if (not host_trace_path.empty()) {
+            std::ifstream host_trace(host_trace_path);
+            if (not host_trace or not timeline::read_chrome_trace(host_trace, events, tracks)) {
+                std::fprintf(stderr, "error: cannot read the host trace %s\n", host_trace_path.c_str());
+                return 1;
+            }
+        }
+        auto alignment = profiler::append_device_events(data, report, anchor, events, tracks);
+        if (not host_trace_path.empty() and alignment.anchored_runs != report.runs.size()) {
+            std::fprintf(
+                stderr,
+                "warning: %u \"%s\" zones in the host trace for %zu device runs, "
+                "%zu runs placed at their device spacing\n",
+                alignment.num_anchors,
+                anchor.c_str(),
+                report.runs.size(),
+                report.runs.size() - alignment.anchored_runs);
+        }
+        std::ofstream chrome_trace(chrome_trace_path);
+        if (not chrome_trace) {
+            std::fprintf(stderr, "error: cannot write %s\n", chrome_trace_path.c_str());
+            return 1;
+        }
+        timeline::write_chrome_trace(chrome_trace, events, tracks);
+    }
+
+    if (json_path == "-") {
+        profiler::write_json(std::cout, report, per_core);
+        return 0;
+    }
+    print_summary(stdout, report, per_core);
+    if (not json_path.empty()) {
+        std::ofstream json(json_path);
+        if (not json) {
+            std::fprintf(stderr, "error: cannot write %s\n", json_path.c_str());
+            return 1;
+        }
+        profiler::write_json(json, report, per_core);
+    }
+    return 0;
+}
@@ -0,0 +1,549 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "profile_analyzer.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace profiler {
+
+namespace {
+
+string_view trim(string_view s) {
+    while (not s.empty() and (s.front() == ' ' or s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (not s.empty() and (s.back() == ' ' or s.back() == '\t' or s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+void split_fields(string_view line, vector<string_view>& fields) {
+    fields.clear();
+    size_t pos = 0;
+    while (true) {
+        size_t comma = line.find(',', pos);
+        if (comma == string_view::npos) {
+            fields.push_back(trim(line.substr(pos)));
+            return;
+        }
+        fields.push_back(trim(line.substr(pos, comma - pos)));
+        pos = comma + 1;
+    }
+}
+
+bool parse_uint(string_view s, uint64_t& value) {
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() and ptr == s.data() + s.size();
+}
+
+uint16_t intern(string_view s, vector<string>& names, std::unordered_map<string, uint16_t>& ids) {
+    auto it = ids.find(string(s));
+    if (it != ids.end()) {
+        return it->second;
+    }
+    uint16_t id = names.size();
+    names.emplace_back(s);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+bool ends_with(const string& s, string_view suffix) {
+    return s.size() >= suffix.size() and s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// One ZONE_START / ZONE_END row
+struct Stamp {
+    uint64_t time;
+    uint64_t run_id;
+    uint64_t run_host_id;
+    uint16_t name;
+    bool is_start;
+};
+
+struct OpenZone {
+    uint16_t name;
+    uint32_t run;
+    uint64_t start;
+};
+
+uint64_t overlap(uint64_t a_start, uint64_t a_end, uint64_t b_start, uint64_t b_end) {
+    uint64_t start = std::max(a_start, b_start);
+    uint64_t end = std::min(a_end, b_end);
+    return end > start ? end - start : 0;
+}
+
+}  // namespace
+
+bool read_profile_log(std::istream& in, ProfileData& data, string& error) {
+    string line;
+    if (not std::getline(in, line)) {
+        error = "empty log";
+        return false;
+    }
+    auto arch_pos = line.find("ARCH: ");
+    auto freq_pos = line.find("CHIP_FREQ[MHz]: ");
+    if (arch_pos != string::npos) {
+        data.arch = line.substr(arch_pos + 6, line.find(',', arch_pos) - arch_pos - 6);
+    }
+    if (freq_pos != string::npos) {
+        data.clock_mhz = std::atof(line.c_str() + freq_pos + 16);
+    }
+
+    // Columns by name, the order has changed between tt-metal versions
+    if (not std::getline(in, line)) {
+        error = "missing column names";
+        return false;
+    }
+    vector<string_view> fields;
+    split_fields(line, fields);
+    auto column = [&fields](string_view name) -> int {
+        auto it = std::find(fields.begin(), fields.end(), name);
+        return it == fields.end() ? -1 : static_cast<int>(it - fields.begin());
+    };
+    const int col_x = column("core_x");
+    const int col_y = column("core_y");
+    const int col_risc = column("RISC processor type");
+    const int col_time = column("time[cycles since reset]");
+    const int col_run = column("run ID");
+    const int col_run_host = column("run host ID");
+    const int col_zone = column("zone name");
+    const int col_type = column("type");
+    if (col_x < 0 or col_y < 0 or col_risc < 0 or col_time < 0 or col_zone < 0 or col_type < 0) {
+        error = "unexpected column names: " + line;
+        return false;
+    }
+    const size_t min_fields =
+        std::max({col_x, col_y, col_risc, col_time, col_run, col_run_host, col_zone, col_type}) + 1;
+
+    std::unordered_map<string, uint16_t> risc_ids;
+    std::unordered_map<string, uint16_t> zone_ids;
+    std::map<std::tuple<uint32_t, uint32_t, uint16_t>, vector<Stamp>> stamps;  // per (core_x, core_y, risc)
+    while (std::getline(in, line)) {
+        data.num_rows++;
+        split_fields(line, fields);
+        if (fields.size() < min_fields) {
+            continue;
+        }
+        const string_view type = fields[col_type];
+        const bool is_start = type == "ZONE_START";
+        if (not is_start and type != "ZONE_END") {
+            continue;
+        }
+        uint64_t core_x, core_y, time;
+        uint64_t run_id = 0;
+        uint64_t run_host_id = 0;
+        if (not parse_uint(fields[col_x], core_x) or not parse_uint(fields[col_y], core_y) or
+            not parse_uint(fields[col_time], time)) {
+            continue;
+        }
+        if (col_run >= 0) {
+            parse_uint(fields[col_run], run_id);
+        }
+        if (col_run_host >= 0) {
+            parse_uint(fields[col_run_host], run_host_id);
+        }
+        uint16_t risc = intern(fields[col_risc], data.risc_names, risc_ids);
+        uint16_t name = intern(fields[col_zone], data.zone_names, zone_ids);
+        auto key = std::make_tuple(static_cast<uint32_t>(core_x), static_cast<uint32_t>(core_y), risc);
+        stamps[key].push_back({time, run_id, run_host_id, name, is_start});
+    }
+
+    // The profiler dumps the stamps grouped by timer, not in time order: pair them once sorted
+    std::map<std::tuple<uint64_t, uint64_t, uint32_t>, uint32_t> run_keys;  // -> provisional run id
+    vector<OpenZone> stack;
+    for (auto& [key, risc_stamps] : stamps) {
+        const auto [core_x, core_y, risc] = key;
+        std::stable_sort(risc_stamps.begin(), risc_stamps.end(), [](const Stamp& a, const Stamp& b) {
+            return a.time < b.time;
+        });
+        std::map<std::pair<uint64_t, uint64_t>, uint32_t> top_level_count;  // per (run ID, run host ID)
+        stack.clear();
+        for (const Stamp& stamp : risc_stamps) {
+            if (stamp.is_start) {
+                uint32_t run;
+                if (stack.empty()) {
+                    uint32_t occurrence = top_level_count[{stamp.run_id, stamp.run_host_id}]++;
+                    auto [it, inserted] = run_keys.emplace(
+                        std::make_tuple(stamp.run_id, stamp.run_host_id, occurrence), run_keys.size());
+                    run = it->second;
+                } else {
+                    run = stack.back().run;
+                }
+                stack.push_back({stamp.name, run, stamp.time});
+                continue;
+            }
+
+            // Innermost open zone of that name, anything opened after it was never closed
+            auto it = std::find_if(
+                stack.rbegin(), stack.rend(), [&stamp](const OpenZone& zone) { return zone.name == stamp.name; });
+            if (it == stack.rend()) {
+                data.unmatched_ends++;
+                continue;
+            }
+            size_t depth = stack.size() - 1 - (it - stack.rbegin());
+            data.unclosed_starts += stack.size() - 1 - depth;
+            const OpenZone& open = stack[depth];
+            data.zones.push_back(ZoneRecord{
+                core_x, core_y, risc, stamp.name, static_cast<uint16_t>(depth), open.run, open.start, stamp.time});
+            stack.resize(depth);
+        }
+        data.unclosed_starts += stack.size();
+    }
+
+    // Runs numbered in (run ID, run host ID, occurrence) order
+    vector<uint32_t> run_index(run_keys.size());
+    uint32_t index = 0;
+    for (const auto& [key, provisional] : run_keys) {
+        run_index[provisional] = index++;
+    }
+    for (auto& zone : data.zones) {
+        zone.run = run_index[zone.run];
+    }
+    data.num_runs = run_keys.size();
+    if (data.zones.empty()) {
+        error = "no complete zones";
+        return false;
+    }
+    return true;
+}
+
+bool read_profile_log(const string& path, ProfileData& data, string& error) {
+    std::ifstream file(path);
+    if (not file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return read_profile_log(file, data, error);
+}
+
+DurationStats compute_stats(vector<double> values) {
+    DurationStats stats;
+    if (values.empty()) {
+        return stats;
+    }
+    std::sort(values.begin(), values.end());
+    // Nearest rank
+    auto percentile = [&values](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    };
+    stats.count = values.size();
+    stats.min = values.front();
+    stats.max = values.back();
+    stats.median = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    double sum = 0;
+    for (double value : values) {
+        sum += value;
+    }
+    stats.mean = sum / values.size();
+    double sq_sum = 0;
+    for (double value : values) {
+        sq_sum += (value - stats.mean) * (value - stats.mean);
+    }
+    stats.stddev = std::sqrt(sq_sum / values.size());
+    return stats;
+}
+
+Report analyze(const ProfileData& data) {
+    Report report;
+    report.arch = data.arch;
+    report.clock_mhz = data.clock_mhz;
+    report.num_rows = data.num_rows;
+    report.num_zones = data.zones.size();
+    report.unmatched_ends = data.unmatched_ends;
+    report.unclosed_starts = data.unclosed_starts;
+
+    std::map<std::pair<string, string>, vector<double>> durations;
+    for (const auto& zone : data.zones) {
+        durations[{data.risc_names[zone.risc], data.zone_names[zone.name]}].push_back(zone.end - zone.start);
+    }
+    for (auto& [key, values] : durations) {
+        report.zone_stats.push_back({key.first, key.second, compute_stats(std::move(values))});
+    }
+
+    // Kernel zones when the firmware emitted them, the top-level zones otherwise
+    bool has_kernel_zones = std::any_of(data.zones.begin(), data.zones.end(), [&data](const ZoneRecord& zone) {
+        return ends_with(data.zone_names[zone.name], "-KERNEL");
+    });
+    auto is_kernel = [&](const ZoneRecord& zone) {
+        return has_kernel_zones ? ends_with(data.zone_names[zone.name], "-KERNEL") : zone.depth == 0;
+    };
+    auto is_fw = [&](const ZoneRecord& zone) {
+        return zone.depth == 0;
+    };
+
+    struct Interval {
+        uint64_t start = UINT64_MAX;
+        uint64_t end = 0;
+        void add(uint64_t s, uint64_t e) {
+            start = std::min(start, s);
+            end = std::max(end, e);
+        }
+        bool valid() const { return start < end; }
+        uint64_t length() const { return valid() ? end - start : 0; }
+    };
+    struct CoreRun {
+        Interval kernel;
+        Interval reader;
+        Interval writer;
+        Interval compute;
+        uint64_t last_end = 0;
+        uint16_t last_risc = 0;
+    };
+
+    vector<std::map<std::pair<uint32_t, uint32_t>, CoreRun>> runs(data.num_runs);
+    vector<Interval> run_fw(data.num_runs);
+    std::map<std::pair<uint32_t, uint32_t>, bool> cores;
+    for (const auto& zone : data.zones) {
+        cores[{zone.core_x, zone.core_y}] = true;
+        CoreRun& core = runs[zone.run][{zone.core_x, zone.core_y}];
+        if (is_fw(zone)) {
+            run_fw[zone.run].add(zone.start, zone.end);
+            if (zone.end >= core.last_end) {
+                core.last_end = zone.end;
+                core.last_risc = zone.risc;
+            }
+        }
+        if (not is_kernel(zone)) {
+            continue;
+        }
+        const string& risc = data.risc_names[zone.risc];
+        core.kernel.add(zone.start, zone.end);
+        if (risc == "NCRISC") {
+            core.reader.add(zone.start, zone.end);
+        } else if (risc == "BRISC") {
+            core.writer.add(zone.start, zone.end);
+        } else if (risc.rfind("TRISC", 0) == 0) {
+            core.compute.add(zone.start, zone.end);
+        }
+    }
+    report.num_cores = cores.size();
+
+    vector<double> run_t0_to_end, run_start_skew, run_imbalance;
+    for (uint32_t r = 0; r < data.num_runs; r++) {
+        RunReport run;
+        run.run = r;
+        run.t0 = run_fw[r].start;
+        run.t0_to_any_riscfw_end = run_fw[r].length();
+
+        uint64_t first_start = UINT64_MAX, last_start = 0, first_end = UINT64_MAX, last_end = 0;
+        vector<double> spans;
+        double reader_hidden = 0, writer_hidden = 0, reader_exposed = 0, writer_exposed = 0;
+        uint32_t num_reader = 0, num_writer = 0;
+        for (const auto& [coord, core] : runs[r]) {
+            if (core.last_end >= run.critical_end + run.t0) {
+                run.critical_core_x = coord.first;
+                run.critical_core_y = coord.second;
+                run.critical_risc = data.risc_names[core.last_risc];
+                run.critical_end = core.last_end - run.t0;
+            }
+            if (not core.kernel.valid()) {
+                continue;
+            }
+            CoreRunReport core_report;
+            core_report.core_x = coord.first;
+            core_report.core_y = coord.second;
+            core_report.kernel_start = core.kernel.start - run.t0;
+            core_report.kernel_end = core.kernel.end - run.t0;
+            first_start = std::min(first_start, core.kernel.start);
+            last_start = std::max(last_start, core.kernel.start);
+            first_end = std::min(first_end, core.kernel.end);
+            last_end = std::max(last_end, core.kernel.end);
+            spans.push_back(core.kernel.length());
+
+            if (core.compute.valid() and core.reader.valid()) {
+                uint64_t hidden = overlap(core.reader.start, core.reader.end, core.compute.start, core.compute.end);
+                core_report.reader_hidden = static_cast<double>(hidden) / core.reader.length();
+                core_report.reader_exposed = core.reader.length() - hidden;
+                reader_hidden += core_report.reader_hidden;
+                reader_exposed += core_report.reader_exposed;
+                num_reader++;
+            }
+            if (core.compute.valid() and core.writer.valid()) {
+                uint64_t hidden = overlap(core.writer.start, core.writer.end, core.compute.start, core.compute.end);
+                core_report.writer_hidden = static_cast<double>(hidden) / core.writer.length();
+                core_report.writer_exposed = core.writer.length() - hidden;
+                writer_hidden += core_report.writer_hidden;
+                writer_exposed += core_report.writer_exposed;
+                num_writer++;
+            }
+            run.cores.push_back(core_report);
+        }
+        if (not spans.empty()) {
+            run.start_skew = last_start - first_start;
+            run.end_skew = last_end - first_end;
+            DurationStats span_stats = compute_stats(spans);
+            run.load_imbalance = span_stats.mean > 0 ? span_stats.max / span_stats.mean : 0;
+            run.span_cv = span_stats.mean > 0 ? span_stats.stddev / span_stats.mean : 0;
+        }
+        if (num_reader != 0) {
+            run.reader_hidden = reader_hidden / num_reader;
+            run.reader_exposed = reader_exposed / num_reader;
+        }
+        if (num_writer != 0) {
+            run.writer_hidden = writer_hidden / num_writer;
+            run.writer_exposed = writer_exposed / num_writer;
+        }
+        run_t0_to_end.push_back(run.t0_to_any_riscfw_end);
+        run_start_skew.push_back(run.start_skew);
+        run_imbalance.push_back(run.load_imbalance);
+        report.runs.push_back(std::move(run));
+    }
+    report.t0_to_any_riscfw_end = compute_stats(run_t0_to_end);
+    report.start_skew = compute_stats(run_start_skew);
+    report.load_imbalance = compute_stats(run_imbalance);
+    return report;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Output
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+string json_string(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' or c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+string json_number(double value) {
+    if (not std::isfinite(value)) {
+        return "null";
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.10g", value);
+    return buf;
+}
+
+string json_stats(const DurationStats& stats) {
+    return "{\"count\": " + std::to_string(stats.count) + ", \"min\": " + json_number(stats.min) +
+           ", \"median\": " + json_number(stats.median) + ", \"p99\": " + json_number(stats.p99) +
+           ", \"max\": " + json_number(stats.max) + ", \"mean\": " + json_number(stats.mean) +
+           ", \"stddev\": " + json_number(stats.stddev) + "}";
+}
+
+}  // namespace
+
+void write_json(std::ostream& out, const Report& report, bool per_core) {
+    out << "{\n";
+    out << "  \"arch\": " << json_string(report.arch) << ",\n";
+    out << "  \"clock_mhz\": " << json_number(report.clock_mhz) << ",\n";
+    out << "  \"num_rows\": " << report.num_rows << ",\n";
+    out << "  \"num_zones\": " << report.num_zones << ",\n";
+    out << "  \"unmatched_ends\": " << report.unmatched_ends << ",\n";
+    out << "  \"unclosed_starts\": " << report.unclosed_starts << ",\n";
+    out << "  \"num_cores\": " << report.num_cores << ",\n";
+    out << "  \"num_runs\": " << report.runs.size() << ",\n";
+    out << "  \"t0_to_any_riscfw_end\": " << json_stats(report.t0_to_any_riscfw_end) << ",\n";
+    out << "  \"start_skew\": " << json_stats(report.start_skew) << ",\n";
+    out << "  \"load_imbalance\": " << json_stats(report.load_imbalance) << ",\n";
+
+    out << "  \"zones\": [";
+    for (size_t i = 0; i < report.zone_stats.size(); i++) {
+        const auto& zone = report.zone_stats[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"risc\": " << json_string(zone.risc)
+            << ", \"name\": " << json_string(zone.name) << ", \"cycles\": " << json_stats(zone.cycles) << "}";
+    }
+    out << "\n  ],\n";
+
+    out << "  \"runs\": [";
+    for (size_t i = 0; i < report.runs.size(); i++) {
+        const auto& run = report.runs[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"run\": " << run.run << ", \"t0\": " << run.t0
+            << ", \"t0_to_any_riscfw_end\": " << run.t0_to_any_riscfw_end
+            << ", \"critical_core\": [" << run.critical_core_x << ", " << run.critical_core_y << "]"
+            << ", \"critical_risc\": " << json_string(run.critical_risc)
+            << ", \"critical_end\": " << run.critical_end << ", \"start_skew\": " << run.start_skew
+            << ", \"end_skew\": " << run.end_skew << ", \"load_imbalance\": " << json_number(run.load_imbalance)
+            << ", \"span_cv\": " << json_number(run.span_cv)
+            << ", \"reader_hidden\": " << json_number(run.reader_hidden)
+            << ", \"writer_hidden\": " << json_number(run.writer_hidden)
+            << ", \"reader_exposed\": " << json_number(run.reader_exposed)
+            << ", \"writer_exposed\": " << json_number(run.writer_exposed);
+        if (per_core) {
+            out << ", \"cores\": [";
+            for (size_t c = 0; c < run.cores.size(); c++) {
+                const auto& core = run.cores[c];
+                out << (c == 0 ? "\n" : ",\n") << "      {\"core\": [" << core.core_x << ", " << core.core_y
+                    << "], \"kernel_start\": " << core.kernel_start << ", \"kernel_end\": " << core.kernel_end
+                    << ", \"reader_hidden\": " << json_number(core.reader_hidden)
+                    << ", \"writer_hidden\": " << json_number(core.writer_hidden)
+                    << ", \"reader_exposed\": " << core.reader_exposed
+                    << ", \"writer_exposed\": " << core.writer_exposed << "}";
+            }
+            out << "\n    ]";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void print_summary(FILE* out, const Report& report, bool per_core) {
+    std::fprintf(out, "arch %s @ %.0f MHz: %lu rows, %lu zones, %u cores, %zu runs\n", report.arch.c_str(),
+        report.clock_mhz, static_cast<unsigned long>(report.num_rows), static_cast<unsigned long>(report.num_zones),
+        report.num_cores, report.runs.size());
+    if (report.unmatched_ends != 0 or report.unclosed_starts != 0) {
+        std::fprintf(out, "warning: %lu unmatched ZONE_END, %lu unclosed ZONE_START\n",
+            static_cast<unsigned long>(report.unmatched_ends), static_cast<unsigned long>(report.unclosed_starts));
+    }
+
+    std::fprintf(out, "\n%-10s %-16s %8s %12s %12s %12s %12s %12s\n", "risc", "zone", "count", "min", "median", "p99",
+        "max", "stddev");
+    for (const auto& zone : report.zone_stats) {
+        const auto& s = zone.cycles;
+        std::fprintf(out, "%-10s %-16s %8lu %12.0f %12.0f %12.0f %12.0f %12.1f\n", zone.risc.c_str(), zone.name.c_str(),
+            static_cast<unsigned long>(s.count), s.min, s.median, s.p99, s.max, s.stddev);
+    }
+
+    std::fprintf(out, "\n%-4s %14s %10s %10s %10s %10s %9s %8s %8s %10s %10s\n", "run", "t0_to_fw_end", "critical",
+        "risc", "start_skew", "end_skew", "imbalance", "rd_hid", "wr_hid", "rd_exposed", "wr_exposed");
+    for (const auto& run : report.runs) {
+        char critical[24];
+        std::snprintf(critical, sizeof(critical), "%u,%u", run.critical_core_x, run.critical_core_y);
+        std::fprintf(out, "%-4u %14lu %10s %10s %10lu %10lu %9.3f %7.1f%% %7.1f%% %10.0f %10.0f\n", run.run,
+            static_cast<unsigned long>(run.t0_to_any_riscfw_end), critical, run.critical_risc.c_str(),
+            static_cast<unsigned long>(run.start_skew), static_cast<unsigned long>(run.end_skew), run.load_imbalance,
+            run.reader_hidden * 100, run.writer_hidden * 100, run.reader_exposed, run.writer_exposed);
+        if (per_core) {
+            for (const auto& core : run.cores) {
+                std::fprintf(out, "     core %2u,%-2u kernel [%lu, %lu] reader hidden %.1f%% writer hidden %.1f%%\n",
+                    core.core_x, core.core_y, static_cast<unsigned long>(core.kernel_start),
+                    static_cast<unsigned long>(core.kernel_end), core.reader_hidden * 100, core.writer_hidden * 100);
+            }
+        }
+    }
+    const auto& t = report.t0_to_any_riscfw_end;
+    std::fprintf(
+        out,
+        "\nt0 to any riscfw end: median %.0f cycles (%.2f us), min %.0f, p99 %.0f, stddev %.1f\n",
+        t.median,
+        report.clock_mhz > 0 ? t.median / report.clock_mhz : 0.0, t.min, t.p99, t.stddev);
+}
+
+}  // namespace profiler
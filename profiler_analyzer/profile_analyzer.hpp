@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Offline analyzer for the device profiler log (profile_log_device.csv).
+//
+// The log holds one ZONE_START / ZONE_END stamp per row, per core and RISC.
+// read_profile_log streams it row by row, keeping only the zone stamps. They are
+// dumped grouped by timer rather than in time order, so the stamps of each
+// (core, RISC) are sorted by time and then paired into zones with a stack,
+// nested zones keep their parent. The run ID column
+// is 0 for every launch of test_compute_mm, so a top-level zone (the firmware
+// zone) is given to the n-th run of its (core, RISC), and nested zones inherit
+// the run of their parent.
+//
+// analyze() then reports, per run and over all runs:
+//   - duration distributions of every (RISC, zone name);
+//   - "t0 to any riscfw end", the definition test_compute_mm uses;
+//   - the critical-path core (latest end) and the RISC that ends last on it;
+//   - start skew of the cores' kernels;
+//   - reader (NCRISC), compute (TRISCs) and writer (BRISC) overlap per core;
+//   - load imbalance of the per-core kernel spans.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace profiler {
+
+struct ZoneRecord {
+    uint32_t core_x = 0;
+    uint32_t core_y = 0;
+    uint16_t risc = 0;  // index into ProfileData::risc_names
+    uint16_t name = 0;  // index into ProfileData::zone_names
+    uint16_t depth = 0;
+    uint32_t run = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+};
+
+struct ProfileData {
+    std::string arch;
+    double clock_mhz = 0;
+    std::vector<std::string> risc_names;
+    std::vector<std::string> zone_names;
+    std::vector<ZoneRecord> zones;
+    uint32_t num_runs = 0;
+    uint64_t num_rows = 0;
+    uint64_t unmatched_ends = 0;   // ZONE_END without an open zone of the same name
+    uint64_t unclosed_starts = 0;  // ZONE_START still open at the end of the log
+};
+
+bool read_profile_log(std::istream& in, ProfileData& data, std::string& error);
+bool read_profile_log(const std::string& path, ProfileData& data, std::string& error);
+
+struct DurationStats {
+    uint64_t count = 0;
+    double min = 0;
+    double median = 0;
+    double p99 = 0;
+    double max = 0;
+    double mean = 0;
+    double stddev = 0;
+};
+
+DurationStats compute_stats(std::vector<double> values);
+
+struct ZoneStats {
+    std::string risc;
+    std::string name;
+    DurationStats cycles;
+};
+
+struct CoreRunReport {
+    uint32_t core_x = 0;
+    uint32_t core_y = 0;
+    uint64_t kernel_start = 0;  // relative to the run's t0
+    uint64_t kernel_end = 0;
+    double reader_hidden = 0;  // share of the reader kernel under the compute kernel
+    double writer_hidden = 0;
+    uint64_t reader_exposed = 0;  // reader / writer cycles outside of the compute kernel
+    uint64_t writer_exposed = 0;
+};
+
+struct RunReport {
+    uint32_t run = 0;
+    uint64_t t0 = 0;
+    uint64_t t0_to_any_riscfw_end = 0;
+    uint32_t critical_core_x = 0;
+    uint32_t critical_core_y = 0;
+    std::string critical_risc;
+    uint64_t critical_end = 0;  // relative to t0
+    uint64_t start_skew = 0;
+    uint64_t end_skew = 0;
+    double load_imbalance = 0;  // slowest core span / mean core span
+    double span_cv = 0;         // stddev / mean of the core spans
+    double reader_hidden = 0;   // means over the cores
+    double writer_hidden = 0;
+    double reader_exposed = 0;
+    double writer_exposed = 0;
+    std::vector<CoreRunReport> cores;
+};
+
+struct Report {
+    std::string arch;
+    double clock_mhz = 0;
+    uint64_t num_rows = 0;
+    uint64_t num_zones = 0;
+    uint64_t unmatched_ends = 0;
+    uint64_t unclosed_starts = 0;
+    uint32_t num_cores = 0;
+    std::vector<ZoneStats> zone_stats;
+    std::vector<RunReport> runs;
+    DurationStats t0_to_any_riscfw_end;
+    DurationStats start_skew;
+    DurationStats load_imbalance;
+};
+
+Report analyze(const ProfileData& data);
+
+void write_json(std::ostream& out, const Report& report, bool per_core);
+void print_summary(FILE* out, const Report& report, bool per_core);
+
+}  // namespace profiler
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "profile_analyzer.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// The analyzer on the checked-in test_compute_mm device log: 3 launches of the
+// 88 core program, 5280 zone stamps that all pair up into zones.
+//
+// The expected cycles follow get_t0_to_any_riscfw_end_cycle: per run, the first
+// *-FW zone start on any core to the last *-FW zone end, the n-th FW zone of a
+// RISC being its n-th run. They and the BRISC-FW durations were computed from
+// the CSV independently of the analyzer.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool check(const char* name, uint64_t value, uint64_t expected) {
+    if (value != expected) {
+        std::fprintf(
+            stderr, "%s is %llu, expected %llu\n", name, (unsigned long long)value, (unsigned long long)expected);
+        return false;
+    }
+    return true;
+}
+
+// DurationStats fields, whole cycles on this log
+bool check_stat(const char* name, double value, double expected) {
+    if (value != expected) {
+        std::fprintf(stderr, "%s is %.3f, expected %.3f\n", name, value, expected);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+// test-profile-analyzer <profile_log_device.csv>
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: test-profile-analyzer <profile_log_device.csv>\n");
+        return 2;
+    }
+    profiler::ProfileData data;
+    std::string error;
+    if (not profiler::read_profile_log(std::string(argv[1]), data, error)) {
+        std::fprintf(stderr, "error: %s: %s\n", argv[1], error.c_str());
+        return 1;
+    }
+    profiler::Report report = profiler::analyze(data);
+
+    bool pass = check("rows", report.num_rows, 5280);
+    pass &= check("cores", report.num_cores, 88);
+    pass &= check("runs", report.runs.size(), 3);
+    pass &= check("zones", report.num_zones, 2640);
+    pass &= check("unmatched ends", report.unmatched_ends, 0);
+    pass &= check("unclosed starts", report.unclosed_starts, 0);
+    constexpr uint64_t expected_t0_to_any_riscfw_end[] = {3671676, 3671762, 3671835};
+    for (const auto& run : report.runs) {
+        pass &= check("cores of a run", run.cores.size(), 88);
+        if (run.run < 3) {
+            pass &= check("t0 to any riscfw end", run.t0_to_any_riscfw_end, expected_t0_to_any_riscfw_end[run.run]);
+        }
+    }
+    pass &= check_stat("median t0 to any riscfw end", report.t0_to_any_riscfw_end.median, 3671762);
+
+    const profiler::ZoneStats* brisc_fw = nullptr;
+    for (const auto& zone : report.zone_stats) {
+        if (zone.risc == "BRISC" and zone.name == "BRISC-FW") {
+            brisc_fw = &zone;
+        }
+    }
+    if (brisc_fw == nullptr) {
+        std::fprintf(stderr, "no BRISC-FW zone statistics\n");
+        pass = false;
+    } else {
+        pass &= check("BRISC-FW zones", brisc_fw->cycles.count, 264);
+        pass &= check_stat("BRISC-FW min", brisc_fw->cycles.min, 3610510);
+        pass &= check_stat("BRISC-FW median", brisc_fw->cycles.median, 3611189);
+        pass &= check_stat("BRISC-FW max", brisc_fw->cycles.max, 3611439);
+        pass &= check_stat("BRISC-FW mean", brisc_fw->cycles.mean, 3611155);
+    }
+    if (not pass) {
+        std::fprintf(stderr, "Profile analyzer report does not match the checked-in log\n");
+        return 1;
+    }
+    std::printf("Profile analyzer report matches the checked-in log\n");
+    return 0;
+}
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "regression_gate.hpp"
+
+using std::string;
+using std::vector;
+
+// regression-gate <results.csv|results.json> [--history <path>] [--arch <name>] [--alpha <p>] [--min-effect <ratio>]
+//                 [--window <runs>] [--update | --accept] [--label <name>] [--json <path>|-]
+//
+// Exit status: 0 no regression, 1 at least one regression, 2 bad input.
+// --update appends the results that did not regress to the history, --accept appends all of them (a slowdown that
+// is expected, e.g. a new dtype path, becomes the new baseline).
+int main(int argc, char** argv) {
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+    auto has_option = [&args](const string& name) { return std::find(args.begin(), args.end(), name) != args.end(); };
+    // The whole value must be a number, stod alone would abort on "abc" and take "0.1x"
+    auto get_number = [&get_option](const string& name, const string& default_value, double& value) {
+        string text = get_option(name, default_value);
+        try {
+            size_t end = 0;
+            value = std::stod(text, &end);
+            if (end == text.size()) {
+                return true;
+            }
+        } catch (const std::exception&) {
+        }
+        std::fprintf(stderr, "error: %s %s is not a number\n", name.c_str(), text.c_str());
+        return false;
+    };
+
+    if (args.empty() or args[0].rfind("--", 0) == 0) {
+        std::fprintf(
+            stderr,
+            "usage: regression-gate <results.csv|results.json> [--history <path>] [--arch <name>] [--alpha <p>]\n"
+            "                       [--min-effect <ratio>] [--window <runs>] [--update | --accept] [--label <name>]\n"
+            "                       [--json <path>|-]\n");
+        return 2;
+    }
+    string history_path = get_option("--history", "matmul_bench_history.csv");
+    string arch = get_option("--arch", "unknown");
+    string json_path = get_option("--json", "");
+    string label = get_option("--label", "");
+    bool update = has_option("--update");
+    bool accept = has_option("--accept");
+    regression_gate::GateOptions options;
+    double window = 0;
+    if (not get_number("--alpha", "0.01", options.alpha) or
+        not get_number("--min-effect", "0.02", options.min_effect) or not get_number("--window", "10", window)) {
+        return 2;
+    }
+    if (window < 1 or window > UINT32_MAX or window != std::floor(window)) {
+        std::fprintf(stderr, "error: --window %.17g is not a positive number of runs\n", window);
+        return 2;
+    }
+    options.window = static_cast<uint32_t>(window);
+
+    vector<regression_gate::BenchRecord> results, history;
+    string error;
+    if (not regression_gate::read_results(args[0], arch, results, error)) {
+        std::fprintf(stderr, "error: %s: %s\n", args[0].c_str(), error.c_str());
+        return 2;
+    }
+    if (not regression_gate::read_history(history_path, history, error)) {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 2;
+    }
+    auto comparisons = regression_gate::compare(history, results, options);
+
+    if (json_path == "-") {
+        regression_gate::write_json(std::cout, comparisons, options);
+    } else {
+        regression_gate::print_report(stdout, comparisons, options);
+        if (not json_path.empty()) {
+            std::ofstream json(json_path);
+            if (not json) {
+                std::fprintf(stderr, "error: cannot write %s\n", json_path.c_str());
+                return 2;
+            }
+            regression_gate::write_json(json, comparisons, options);
+        }
+    }
+
+    bool regressed = false;
+    vector<regression_gate::BenchRecord> accepted;
+    for (size_t i = 0; i < results.size(); i++) {
+        bool is_regression = comparisons[i].verdict == regression_gate::Verdict::Regression;
+        regressed |= is_regression;
+        if (accept or not is_regression) {
+            accepted.push_back(results[i]);
+        }
+    }
+    if (update or accept) {
+        char timestamp[32];
+        std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        if (not regression_gate::append_history(history_path, accepted, timestamp, label, error)) {
+            std::fprintf(stderr, "error: %s\n", error.c_str());
+            return 2;
+        }
+        std::fprintf(
+            json_path == "-" ? stderr : stdout,
+            "%zu of %zu result(s) added to %s\n",
+            accepted.size(),
+            results.size(),
+            history_path.c_str());
+    }
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,689 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "regression_gate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <sstream>
+#include <tuple>
+
+using std::string;
+using std::vector;
+
+namespace regression_gate {
+
+string BenchKey::to_string() const {
+    return arch + "/" + variant + "/" + std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n) + "/" +
+           dtype + "/" + math_fidelity;
+}
+
+bool BenchKey::operator<(const BenchKey& other) const {
+    return std::tie(arch, variant, m, k, n, dtype, math_fidelity) <
+           std::tie(other.arch, other.variant, other.m, other.k, other.n, other.dtype, other.math_fidelity);
+}
+
+bool BenchKey::operator==(const BenchKey& other) const {
+    return std::tie(arch, variant, m, k, n, dtype, math_fidelity) ==
+           std::tie(other.arch, other.variant, other.m, other.k, other.n, other.dtype, other.math_fidelity);
+}
+
+namespace {
+
+string trim(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+// RFC 4180 fields, quoted fields may hold commas and doubled quotes
+vector<string> split_csv_line(const string& line) {
+    vector<string> fields;
+    string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' and i + 1 < line.size() and line[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(trim(field));
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(trim(field));
+    return fields;
+}
+
+string csv_field(const string& field) {
+    if (field.find_first_of(",\"") == string::npos) {
+        return field;
+    }
+    string quoted = "\"";
+    for (char c : field) {
+        quoted += c == '"' ? string("\"\"") : string(1, c);
+    }
+    return quoted + "\"";
+}
+
+// "DataType.BFLOAT16" -> "BFLOAT16", "MathFidelity.HiFi4" -> "HiFi4"
+string strip_enum_prefix(const string& value) {
+    size_t dot = value.rfind('.');
+    return dot == string::npos ? value : value.substr(dot + 1);
+}
+
+bool parse_samples(const string& text, vector<double>& samples) {
+    std::istringstream in(text);
+    double value;
+    while (in >> value) {
+        samples.push_back(value);
+    }
+    return in.eof() and not samples.empty();
+}
+
+bool parse_uint(const string& s, uint32_t& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(s.c_str(), &end, 10);
+    if (s.empty() or *end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Value of "key": in one object of the JSON written by matmul_bench::write_json (one result per line)
+bool find_json_field(const string& line, const string& key, string& value) {
+    size_t pos = line.find("\"" + key + "\": ");
+    if (pos == string::npos) {
+        return false;
+    }
+    pos += key.size() + 4;
+    if (line[pos] == '"') {
+        size_t end = line.find('"', pos + 1);
+        value = line.substr(pos + 1, end - pos - 1);
+    } else if (line[pos] == '[' or line[pos] == '{') {
+        size_t end = line.find(line[pos] == '[' ? ']' : '}', pos);
+        value = line.substr(pos + 1, end - pos - 1);
+    } else {
+        size_t end = line.find_first_of(",}", pos);
+        value = line.substr(pos, end - pos);
+    }
+    return true;
+}
+
+bool read_json_results(
+    std::istream& in, const string& default_arch, vector<BenchRecord>& records, string& error) {
+    string line, value;
+    uint32_t line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        if (line.find("\"conf\": ") == string::npos) {
+            continue;
+        }
+        BenchRecord record;
+        BenchKey& key = record.key;
+        string m, k, n;
+        if (not find_json_field(line, "conf", key.variant) or not find_json_field(line, "m", m) or
+            not find_json_field(line, "k", k) or not find_json_field(line, "n", n) or
+            not find_json_field(line, "dtype", key.dtype) or
+            not find_json_field(line, "math_fidelity", key.math_fidelity) or not parse_uint(m, key.m) or
+            not parse_uint(k, key.k) or not parse_uint(n, key.n)) {
+            error = "line " + std::to_string(line_number) + ": missing conf / m / k / n / dtype / math_fidelity";
+            return false;
+        }
+        if (not find_json_field(line, "arch", key.arch) or key.arch.empty()) {
+            key.arch = default_arch;
+        }
+        if (find_json_field(line, "samples_us", value)) {
+            std::replace(value.begin(), value.end(), ',', ' ');
+            parse_samples(value, record.samples_us);
+        }
+        if (record.samples_us.empty() and find_json_field(line, "time_us", value)) {
+            string mean;
+            if (find_json_field("{" + value + "}", "mean", mean)) {
+                parse_samples(mean, record.samples_us);
+            }
+        }
+        if (record.samples_us.empty()) {
+            error = "line " + std::to_string(line_number) + ": no samples_us or time_us.mean";
+            return false;
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+bool read_csv_results(
+    std::istream& in, const string& default_arch, vector<BenchRecord>& records, string& error) {
+    string line;
+    if (not std::getline(in, line)) {
+        error = "empty file";
+        return false;
+    }
+    vector<string> header = split_csv_line(line);
+    auto column = [&header](const string& name) -> int {
+        auto it = std::find(header.begin(), header.end(), name);
+        return it == header.end() ? -1 : static_cast<int>(it - header.begin());
+    };
+    // test_mm_op.py writes k and n in the rows only
+    bool insert_kn = column("k") < 0 and column("n") < 0 and column("m") >= 0;
+    if (insert_kn) {
+        header.insert(header.begin() + column("m") + 1, {"k", "n"});
+    }
+    const int col_conf = column("conf");
+    const int col_m = column("m");
+    const int col_k = column("k");
+    const int col_n = column("n");
+    const int col_dtype = column("dtype");
+    const int col_fidelity = column("math_fidelity");
+    const int col_avg = column("inference_time_avg");
+    const int col_trace = column("use_trace");
+    const int col_arch = column("arch");
+    const int col_samples = column("inference_time_samples");
+    if (col_conf < 0 or col_m < 0 or col_dtype < 0 or col_fidelity < 0 or col_avg < 0) {
+        error = "expected the host-perf columns conf, m, k, n, dtype, math_fidelity, inference_time_avg";
+        return false;
+    }
+
+    uint32_t line_number = 1;
+    while (std::getline(in, line)) {
+        line_number++;
+        if (trim(line).empty()) {
+            continue;
+        }
+        vector<string> fields = split_csv_line(line);
+        if (fields.size() < header.size() - (col_samples >= 0 ? 1 : 0)) {
+            error = "line " + std::to_string(line_number) + ": " + std::to_string(fields.size()) + " fields, " +
+                    std::to_string(header.size()) + " columns";
+            return false;
+        }
+        fields.resize(header.size());
+        BenchRecord record;
+        BenchKey& key = record.key;
+        key.variant = fields[col_conf];
+        if (col_trace >= 0 and fields[col_trace] == "True") {
+            key.variant += "+trace";
+        }
+        key.arch = col_arch >= 0 and not fields[col_arch].empty() ? fields[col_arch] : default_arch;
+        key.dtype = strip_enum_prefix(fields[col_dtype]);
+        key.math_fidelity = strip_enum_prefix(fields[col_fidelity]);
+        if (not parse_uint(fields[col_m], key.m) or not parse_uint(fields[col_k], key.k) or
+            not parse_uint(fields[col_n], key.n)) {
+            error = "line " + std::to_string(line_number) + ": bad m / k / n";
+            return false;
+        }
+        if (col_samples < 0 or not parse_samples(fields[col_samples], record.samples_us)) {
+            record.samples_us.clear();
+            if (not parse_samples(fields[col_avg], record.samples_us)) {
+                error = "line " + std::to_string(line_number) + ": bad inference_time_avg";
+                return false;
+            }
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+}  // namespace
+
+bool read_results(std::istream& in, const string& default_arch, vector<BenchRecord>& records, string& error) {
+    int c = in.peek();
+    while (c == ' ' or c == '\n' or c == '\r' or c == '\t') {
+        in.get();
+        c = in.peek();
+    }
+    if (c == '[') {
+        return read_json_results(in, default_arch, records, error);
+    }
+    return read_csv_results(in, default_arch, records, error);
+}
+
+bool read_results(const string& path, const string& default_arch, vector<BenchRecord>& records, string& error) {
+    std::ifstream file(path);
+    if (not file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return read_results(file, default_arch, records, error);
+}
+
+namespace {
+
+const vector<string> HISTORY_COLUMNS = {
+    "timestamp", "label", "arch", "variant", "m", "k", "n", "dtype", "math_fidelity", "samples_us"};
+
+}  // namespace
+
+bool read_history(const string& path, vector<BenchRecord>& records, string& error) {
+    std::ifstream file(path);
+    if (not file) {
+        return true;  // no history yet
+    }
+    string line;
+    if (not std::getline(file, line) or split_csv_line(line) != HISTORY_COLUMNS) {
+        error = path + ": not a regression_gate history file";
+        return false;
+    }
+    uint32_t line_number = 1;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (trim(line).empty()) {
+            continue;
+        }
+        vector<string> fields = split_csv_line(line);
+        BenchRecord record;
+        if (fields.size() != HISTORY_COLUMNS.size() or not parse_uint(fields[4], record.key.m) or
+            not parse_uint(fields[5], record.key.k) or not parse_uint(fields[6], record.key.n) or
+            not parse_samples(fields[9], record.samples_us)) {
+            error = path + ":" + std::to_string(line_number) + ": malformed line";
+            return false;
+        }
+        record.timestamp = fields[0];
+        record.label = fields[1];
+        record.key.arch = fields[2];
+        record.key.variant = fields[3];
+        record.key.dtype = fields[7];
+        record.key.math_fidelity = fields[8];
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+bool append_history(
+    const string& path,
+    const vector<BenchRecord>& records,
+    const string& timestamp,
+    const string& label,
+    string& error) {
+    bool exists = static_cast<bool>(std::ifstream(path));
+    std::ofstream file(path, std::ios::app);
+    if (not file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    auto write_row = [&file](const vector<string>& fields) {
+        for (size_t i = 0; i < fields.size(); i++) {
+            file << (i == 0 ? "" : ",") << csv_field(fields[i]);
+        }
+        file << "\n";
+    };
+    if (not exists) {
+        write_row(HISTORY_COLUMNS);
+    }
+    for (const auto& record : records) {
+        string samples;
+        char buf[32];
+        for (double sample : record.samples_us) {
+            std::snprintf(buf, sizeof(buf), "%.3f", sample);
+            samples += (samples.empty() ? "" : " ") + string(buf);
+        }
+        const BenchKey& key = record.key;
+        write_row(
+            {timestamp,
+             label,
+             key.arch,
+             key.variant,
+             std::to_string(key.m),
+             std::to_string(key.k),
+             std::to_string(key.n),
+             key.dtype,
+             key.math_fidelity,
+             samples});
+    }
+    return static_cast<bool>(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Statistics
+////////////////////////////////////////////////////////////////////////////////
+double median(vector<double> values) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    if (values.size() % 2 == 1) {
+        return values[mid];
+    }
+    double upper = values[mid];
+    double lower = *std::max_element(values.begin(), values.begin() + mid);
+    return (lower + upper) / 2;
+}
+
+namespace {
+
+// Exact upper tail P(U >= u) of the Mann-Whitney U of a sample of size m against one of size n, no ties
+double exact_upper_tail(uint32_t m, uint32_t n, double u) {
+    // counts[i][j][v]: orderings of i values of the first sample and j of the second with U = v
+    const uint32_t max_u = m * n;
+    vector<vector<vector<double>>> counts(m + 1, vector<vector<double>>(n + 1));
+    for (uint32_t i = 0; i <= m; i++) {
+        for (uint32_t j = 0; j <= n; j++) {
+            counts[i][j].assign(i * j + 1, 0);
+            if (i == 0 or j == 0) {
+                counts[i][j][0] = 1;
+                continue;
+            }
+            // Largest value from the first sample: it beats all j of the second; otherwise it beats nothing
+            for (uint32_t v = 0; v <= i * j; v++) {
+                double count = 0;
+                if (v >= j and v - j <= (i - 1) * j) {
+                    count += counts[i - 1][j][v - j];
+                }
+                if (v <= i * (j - 1)) {
+                    count += counts[i][j - 1][v];
+                }
+                counts[i][j][v] = count;
+            }
+        }
+    }
+    double total = 0, tail = 0;
+    for (uint32_t v = 0; v <= max_u; v++) {
+        total += counts[m][n][v];
+        if (v + 1e-9 >= u) {
+            tail += counts[m][n][v];
+        }
+    }
+    return tail / total;
+}
+
+double log_binomial(uint32_t n, uint32_t k) {
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+}  // namespace
+
+MannWhitney mann_whitney(const vector<double>& base, const vector<double>& test) {
+    MannWhitney result;
+    const size_t n_base = base.size();
+    const size_t n_test = test.size();
+    if (n_base == 0 or n_test == 0) {
+        return result;
+    }
+
+    // Midranks of the pooled sample
+    vector<std::pair<double, bool>> pooled;  // (value, from test)
+    for (double value : base) {
+        pooled.push_back({value, false});
+    }
+    for (double value : test) {
+        pooled.push_back({value, true});
+    }
+    std::sort(pooled.begin(), pooled.end());
+    const size_t total = pooled.size();
+    double rank_sum_test = 0;
+    double tie_term = 0;  // sum of t^3 - t over the tie groups
+    for (size_t i = 0; i < total;) {
+        size_t j = i;
+        while (j < total and pooled[j].first == pooled[i].first) {
+            j++;
+        }
+        double midrank = (i + 1 + j) / 2.0;
+        for (size_t r = i; r < j; r++) {
+            if (pooled[r].second) {
+                rank_sum_test += midrank;
+            }
+        }
+        double t = j - i;
+        tie_term += t * t * t - t;
+        i = j;
+    }
+    result.u = rank_sum_test - n_test * (n_test + 1) / 2.0;
+    const double n_pairs = static_cast<double>(n_base) * n_test;
+    result.cliffs_delta = 2 * result.u / n_pairs - 1;
+    // One-sided p of the most extreme ordering, all orderings being equally likely under H0
+    result.min_p = std::exp(-log_binomial(total, n_test));
+
+    constexpr size_t EXACT_MAX_TOTAL = 50;
+    if (tie_term == 0 and total <= EXACT_MAX_TOTAL) {
+        result.exact = true;
+        result.p_greater = exact_upper_tail(n_test, n_base, result.u);
+        result.p_less = exact_upper_tail(n_test, n_base, n_pairs - result.u);
+        return result;
+    }
+
+    double mean = n_pairs / 2;
+    double variance = n_pairs / 12 * ((total + 1) - tie_term / (static_cast<double>(total) * (total - 1)));
+    if (variance <= 0) {
+        return result;  // every value tied
+    }
+    double sigma = std::sqrt(variance);
+    // Continuity correction
+    double z_greater = (result.u - mean - 0.5) / sigma;
+    double z_less = (mean - result.u - 0.5) / sigma;
+    // The approximation is poor in the tails of small tied samples, it never beats the exact bound
+    result.p_greater = std::max(result.min_p, 0.5 * std::erfc(z_greater / std::sqrt(2.0)));
+    result.p_less = std::max(result.min_p, 0.5 * std::erfc(z_less / std::sqrt(2.0)));
+    return result;
+}
+
+BootstrapInterval bootstrap_median_ratio(
+    const vector<double>& base, const vector<double>& test, double confidence, uint32_t resamples, uint64_t seed) {
+    BootstrapInterval interval;
+    double base_median = median(base);
+    if (base.empty() or test.empty() or base_median <= 0) {
+        return interval;
+    }
+    interval.ratio = median(test) / base_median;
+    interval.low = interval.high = interval.ratio;
+    if (resamples == 0) {
+        return interval;
+    }
+
+    std::mt19937_64 rng(seed);
+    auto resample_median = [&rng](const vector<double>& values, vector<double>& scratch) {
+        std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+        for (double& value : scratch) {
+            value = values[pick(rng)];
+        }
+        return median(scratch);
+    };
+    vector<double> base_scratch(base.size()), test_scratch(test.size());
+    vector<double> ratios;
+    ratios.reserve(resamples);
+    for (uint32_t i = 0; i < resamples; i++) {
+        double b = resample_median(base, base_scratch);
+        double t = resample_median(test, test_scratch);
+        if (b > 0) {
+            ratios.push_back(t / b);
+        }
+    }
+    if (ratios.empty()) {
+        return interval;
+    }
+    std::sort(ratios.begin(), ratios.end());
+    auto percentile = [&ratios](double p) {
+        size_t index = std::min(ratios.size() - 1, static_cast<size_t>(p * ratios.size()));
+        return ratios[index];
+    };
+    interval.low = percentile((1 - confidence) / 2);
+    interval.high = percentile(1 - (1 - confidence) / 2);
+    return interval;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Gate
+////////////////////////////////////////////////////////////////////////////////
+const char* verdict_name(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::New: return "new";
+        case Verdict::Ok: return "ok";
+        case Verdict::Faster: return "faster";
+        case Verdict::Underpowered: return "underpowered";
+        case Verdict::Regression: return "REGRESSION";
+    }
+    return "";
+}
+
+vector<Comparison> compare(
+    const vector<BenchRecord>& history, const vector<BenchRecord>& results, const GateOptions& options) {
+    // History in file order, the last `window` runs of each key make its baseline
+    std::map<BenchKey, vector<const BenchRecord*>> runs;
+    for (const auto& record : history) {
+        runs[record.key].push_back(&record);
+    }
+
+    vector<Comparison> comparisons;
+    for (const auto& result : results) {
+        Comparison comparison;
+        comparison.key = result.key;
+        comparison.new_samples = result.samples_us.size();
+        comparison.new_median_us = median(result.samples_us);
+
+        vector<double> baseline;
+        auto it = runs.find(result.key);
+        if (it != runs.end()) {
+            const auto& key_runs = it->second;
+            size_t first = key_runs.size() > options.window ? key_runs.size() - options.window : 0;
+            for (size_t r = first; r < key_runs.size(); r++) {
+                baseline.insert(baseline.end(), key_runs[r]->samples_us.begin(), key_runs[r]->samples_us.end());
+                comparison.baseline_runs++;
+            }
+        }
+        comparison.baseline_samples = baseline.size();
+        if (baseline.empty()) {
+            comparisons.push_back(comparison);
+            continue;
+        }
+        comparison.baseline_median_us = median(baseline);
+        comparison.test = mann_whitney(baseline, result.samples_us);
+        // Seeded per key so a rerun of the gate gives the same intervals
+        uint64_t seed = options.seed ^ std::hash<string>{}(result.key.to_string());
+        comparison.ratio =
+            bootstrap_median_ratio(baseline, result.samples_us, options.confidence, options.resamples, seed);
+
+        double change = comparison.ratio.ratio - 1;
+        if (comparison.test.p_greater < options.alpha and change >= options.min_effect) {
+            comparison.verdict = Verdict::Regression;
+        } else if (comparison.test.p_less < options.alpha and change <= -options.min_effect) {
+            comparison.verdict = Verdict::Faster;
+        } else if (comparison.test.min_p >= options.alpha and change >= options.min_effect) {
+            // Slower, but the test could not have rejected with this few samples
+            comparison.verdict = Verdict::Underpowered;
+        } else {
+            comparison.verdict = Verdict::Ok;
+        }
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+void print_report(FILE* out, const vector<Comparison>& comparisons, const GateOptions& options) {
+    std::fprintf(
+        out,
+        "alpha %.3g, min effect %.1f%%, baseline: last %u runs, %.0f%% bootstrap intervals\n\n",
+        options.alpha,
+        options.min_effect * 100,
+        options.window,
+        options.confidence * 100);
+    std::fprintf(
+        out,
+        "%-12s %-64s %9s %12s %12s %8s %19s %10s %7s\n",
+        "verdict",
+        "key",
+        "base n",
+        "base med us",
+        "new med us",
+        "change",
+        "interval",
+        "p (slower)",
+        "delta");
+    for (const auto& c : comparisons) {
+        string base_n = std::to_string(c.baseline_runs) + "/" + std::to_string(c.baseline_samples);
+        if (c.verdict == Verdict::New) {
+            std::fprintf(
+                out,
+                "%-12s %-64s %9s %12s %12.2f\n",
+                verdict_name(c.verdict),
+                c.key.to_string().c_str(),
+                base_n.c_str(),
+                "-",
+                c.new_median_us);
+            continue;
+        }
+        char interval[32];
+        std::snprintf(
+            interval, sizeof(interval), "[%+.1f%%, %+.1f%%]", (c.ratio.low - 1) * 100, (c.ratio.high - 1) * 100);
+        std::fprintf(
+            out,
+            "%-12s %-64s %9s %12.2f %12.2f %+7.1f%% %19s %10.2g %+7.3f\n",
+            verdict_name(c.verdict),
+            c.key.to_string().c_str(),
+            base_n.c_str(),
+            c.baseline_median_us,
+            c.new_median_us,
+            (c.ratio.ratio - 1) * 100,
+            interval,
+            c.test.p_greater,
+            c.test.cliffs_delta);
+    }
+    uint32_t regressions = std::count_if(comparisons.begin(), comparisons.end(), [](const Comparison& c) {
+        return c.verdict == Verdict::Regression;
+    });
+    uint32_t underpowered = std::count_if(comparisons.begin(), comparisons.end(), [](const Comparison& c) {
+        return c.verdict == Verdict::Underpowered;
+    });
+    std::fprintf(
+        out,
+        "\n%u regression(s), %u underpowered slowdown(s), %zu key(s)\n",
+        regressions,
+        underpowered,
+        comparisons.size());
+}
+
+namespace {
+
+string json_number(double value) {
+    if (not std::isfinite(value)) {
+        return "null";
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", value);
+    return buf;
+}
+
+}  // namespace
+
+void write_json(std::ostream& out, const vector<Comparison>& comparisons, const GateOptions& options) {
+    out << "{\n  \"alpha\": " << json_number(options.alpha) << ", \"min_effect\": " << json_number(options.min_effect)
+        << ", \"window\": " << options.window << ", \"confidence\": " << json_number(options.confidence) << ",\n";
+    out << "  \"comparisons\": [";
+    for (size_t i = 0; i < comparisons.size(); i++) {
+        const Comparison& c = comparisons[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"key\": \"" << c.key.to_string() << "\", \"arch\": \"" << c.key.arch
+            << "\", \"variant\": \"" << c.key.variant << "\", \"m\": " << c.key.m << ", \"k\": " << c.key.k
+            << ", \"n\": " << c.key.n << ", \"dtype\": \"" << c.key.dtype << "\", \"math_fidelity\": \""
+            << c.key.math_fidelity << "\", \"verdict\": \"" << verdict_name(c.verdict) << "\""
+            << ", \"baseline_runs\": " << c.baseline_runs << ", \"baseline_samples\": " << c.baseline_samples
+            << ", \"new_samples\": " << c.new_samples
+            << ", \"baseline_median_us\": " << json_number(c.baseline_median_us)
+            << ", \"new_median_us\": " << json_number(c.new_median_us)
+            << ", \"median_ratio\": " << json_number(c.ratio.ratio)
+            << ", \"median_ratio_interval\": [" << json_number(c.ratio.low) << ", " << json_number(c.ratio.high)
+            << "], \"mann_whitney_u\": " << json_number(c.test.u)
+            << ", \"p_slower\": " << json_number(c.test.p_greater) << ", \"p_faster\": " << json_number(c.test.p_less)
+            << ", \"exact\": " << (c.test.exact ? "true" : "false")
+            << ", \"cliffs_delta\": " << json_number(c.test.cliffs_delta) << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+}  // namespace regression_gate
@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Statistical regression gate for the matmul benchmarks.
+//
+// Results are read from the CSV / JSON of bench/ (metal-matmul-bench) or the
+// host-perf CSV of test_mm_op.py. They are compared with a local history of
+// earlier runs of the same key: (arch, variant, M x K x N, dtype, math
+// fidelity). The baseline of a key pools the repetitions of its last `window`
+// accepted runs.
+//
+// A key regresses when a one-sided Mann-Whitney U test says the new times are
+// larger (p < alpha) and the median slowdown is at least min_effect. The effect
+// is reported as the median ratio with a bootstrap confidence interval and as
+// Cliff's delta. Rows that only carry a mean (test_mm_op.py) are one sample: the
+// test cannot reach alpha until the baseline has enough runs, such keys are
+// reported as underpowered rather than passed silently.
+//
+// Everything runs offline on the files, no device or tt-metal needed.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace regression_gate {
+
+struct BenchKey {
+    std::string arch;
+    std::string variant;  // conf, "+trace" when test_mm_op.py ran it with a trace
+    uint32_t m = 0;
+    uint32_t k = 0;
+    uint32_t n = 0;
+    std::string dtype;          // BFLOAT16 / BFLOAT8_B / BFLOAT4_B
+    std::string math_fidelity;  // LoFi / HiFi2 / HiFi3 / HiFi4
+
+    std::string to_string() const;
+    bool operator<(const BenchKey& other) const;
+    bool operator==(const BenchKey& other) const;
+};
+
+struct BenchRecord {
+    BenchKey key;
+    std::vector<double> samples_us;  // repetitions, or the mean alone
+    std::string timestamp;           // history only
+    std::string label;
+};
+
+/*
+ * Results of one benchmark run. The format is taken from the content: a JSON array of metal-matmul-bench, or a
+ * CSV with the test_mm_op.py host-perf columns (its header line leaves out k and n, the rows have them).
+ * default_arch is used for rows without an arch column.
+ */
+bool read_results(
+    std::istream& in, const std::string& default_arch, std::vector<BenchRecord>& records, std::string& error);
+bool read_results(
+    const std::string& path, const std::string& default_arch, std::vector<BenchRecord>& records, std::string& error);
+
+// History file: one CSV line per (run, key), appended to by append_history
+bool read_history(const std::string& path, std::vector<BenchRecord>& records, std::string& error);
+bool append_history(
+    const std::string& path,
+    const std::vector<BenchRecord>& records,
+    const std::string& timestamp,
+    const std::string& label,
+    std::string& error);
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Statistics
+////////////////////////////////////////////////////////////////////////////////
+double median(std::vector<double> values);
+
+struct MannWhitney {
+    double u = 0;              // of the new sample, ties count 1/2
+    double p_greater = 1;      // H1: new times stochastically larger (slower)
+    double p_less = 1;         // H1: new times stochastically smaller (faster)
+    double min_p = 1;          // smallest p-value these sample sizes can give
+    bool exact = false;        // exact distribution (no ties, small samples), normal approximation otherwise
+    double cliffs_delta = 0;   // P(new > base) - P(new < base), in [-1, 1]
+};
+
+MannWhitney mann_whitney(const std::vector<double>& base, const std::vector<double>& test);
+
+struct BootstrapInterval {
+    double ratio = 1;  // median(test) / median(base)
+    double low = 1;
+    double high = 1;
+};
+
+// Percentile interval of median(test) / median(base), resampling both samples
+BootstrapInterval bootstrap_median_ratio(
+    const std::vector<double>& base,
+    const std::vector<double>& test,
+    double confidence,
+    uint32_t resamples,
+    uint64_t seed);
+
+////////////////////////////////////////////////////////////////////////////////
+//                      Gate
+////////////////////////////////////////////////////////////////////////////////
+struct GateOptions {
+    double alpha = 0.01;
+    double min_effect = 0.02;  // relative median slowdown under which a significant change is still noise
+    uint32_t window = 10;      // history runs per key in the baseline
+    double confidence = 0.95;
+    uint32_t resamples = 2000;
+    uint64_t seed = 0;
+};
+
+enum class Verdict { New, Ok, Faster, Underpowered, Regression };
+
+const char* verdict_name(Verdict verdict);
+
+struct Comparison {
+    BenchKey key;
+    Verdict verdict = Verdict::New;
+    uint32_t baseline_runs = 0;
+    uint32_t baseline_samples = 0;
+    uint32_t new_samples = 0;
+    double baseline_median_us = 0;
+    double new_median_us = 0;
+    MannWhitney test;
+    BootstrapInterval ratio;
+};
+
+std::vector<Comparison> compare(
+    const std::vector<BenchRecord>& history, const std::vector<BenchRecord>& results, const GateOptions& options);
+
+void print_report(FILE* out, const std::vector<Comparison>& comparisons, const GateOptions& options);
+void write_json(std::ostream& out, const std::vector<Comparison>& comparisons, const GateOptions& options);
+
+}  // namespace regression_gate
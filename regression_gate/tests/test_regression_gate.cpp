@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "regression_gate.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// The gate statistics on samples with known answers: the exact Mann-Whitney
+// tail, the tie-corrected normal approximation, Cliff's delta and the seeded
+// bootstrap interval of the median ratio. The normal tails were computed
+// separately from the same formula (midranks, tie-corrected variance,
+// continuity correction).
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool check(const char* name, double value, double expected, double rel_tol = 1e-9) {
+    if (std::fabs(value - expected) > rel_tol * std::fabs(expected)) {
+        std::fprintf(stderr, "%s is %.17g, expected %.17g\n", name, value, expected);
+        return false;
+    }
+    return true;
+}
+
+bool check(const char* name, bool value, bool expected) {
+    if (value != expected) {
+        std::fprintf(stderr, "%s is %s, expected %s\n", name, value ? "true" : "false", expected ? "true" : "false");
+        return false;
+    }
+    return true;
+}
+
+std::vector<double> range(double first, uint32_t count) {
+    std::vector<double> values;
+    for (uint32_t i = 0; i < count; i++) {
+        values.push_back(first + i);
+    }
+    return values;
+}
+
+bool test_exact() {
+    // Every new time above every baseline time: the most extreme of the C(10, 5) = 252 orderings
+    regression_gate::MannWhitney slower = regression_gate::mann_whitney(range(1, 5), range(6, 5));
+    bool pass = check("exact", slower.exact, true);
+    pass &= check("U of {6..10} against {1..5}", slower.u, 25);
+    pass &= check("p greater of {6..10} against {1..5}", slower.p_greater, 1.0 / 252);
+    pass &= check("p less of {6..10} against {1..5}", slower.p_less, 1);
+    pass &= check("min p of 5 against 5", slower.min_p, 1.0 / 252);
+    pass &= check("Cliff's delta of {6..10} against {1..5}", slower.cliffs_delta, 1);
+
+    regression_gate::MannWhitney faster = regression_gate::mann_whitney(range(6, 5), range(1, 5));
+    pass &= check("p less of {1..5} against {6..10}", faster.p_less, 1.0 / 252);
+    pass &= check("Cliff's delta of {1..5} against {6..10}", faster.cliffs_delta, -1);
+
+    // One swap from the extreme: U = 24 and U = 25 are one ordering each
+    regression_gate::MannWhitney swapped = regression_gate::mann_whitney({1, 2, 3, 4, 6}, {5, 7, 8, 9, 10});
+    pass &= check("U of one swap", swapped.u, 24);
+    pass &= check("p greater of one swap", swapped.p_greater, 2.0 / 252);
+    pass &= check("Cliff's delta of one swap", swapped.cliffs_delta, 23.0 / 25);
+    return pass;
+}
+
+bool test_normal_tail() {
+    // 60 values are past the exact distribution
+    regression_gate::MannWhitney large = regression_gate::mann_whitney(range(0, 30), range(30, 30));
+    bool pass = check("exact on 30 against 30", large.exact, false);
+    pass &= check("U of 30 against 30", large.u, 900);
+    pass &= check("p greater of 30 against 30", large.p_greater, 1.5099296795810756e-11, 1e-6);
+
+    // Ties take the normal approximation with the tie-corrected variance at any size
+    regression_gate::MannWhitney tied =
+        regression_gate::mann_whitney({10, 11, 11, 12, 12, 12, 13}, {12, 13, 13, 14, 14, 15, 16});
+    pass &= check("exact with ties", tied.exact, false);
+    pass &= check("U with ties", tied.u, 45.5);
+    pass &= check("p greater with ties", tied.p_greater, 0.0038299942933681646, 1e-6);
+    pass &= check("Cliff's delta with ties", tied.cliffs_delta, 6.0 / 7);
+
+    // All tied: no evidence either way
+    regression_gate::MannWhitney constant = regression_gate::mann_whitney({5, 5, 5}, {5, 5, 5});
+    pass &= check("p greater of constant samples", constant.p_greater, 1);
+    pass &= check("Cliff's delta of constant samples", constant.cliffs_delta, 0);
+    return pass;
+}
+
+bool test_bootstrap() {
+    // Constant samples: every resample has the same ratio
+    regression_gate::BootstrapInterval constant =
+        regression_gate::bootstrap_median_ratio({100, 100, 100}, {110, 110, 110}, 0.95, 500, 7);
+    bool pass = check("ratio of constant samples", constant.ratio, 1.1);
+    pass &= check("low of constant samples", constant.low, 1.1);
+    pass &= check("high of constant samples", constant.high, 1.1);
+
+    // Every new time above every baseline time: each resampled ratio lies in [110 / 109, 119 / 100]
+    std::vector<double> base = range(100, 10), test = range(110, 10);
+    regression_gate::BootstrapInterval interval = regression_gate::bootstrap_median_ratio(base, test, 0.95, 2000, 42);
+    pass &= check("ratio of the medians", interval.ratio, 114.5 / 104.5);
+    if (not(110.0 / 109 <= interval.low and interval.low <= interval.ratio and interval.ratio <= interval.high and
+            interval.high <= 119.0 / 100)) {
+        std::fprintf(
+            stderr, "interval [%g, %g] of ratio %g is out of bounds\n", interval.low, interval.high, interval.ratio);
+        pass = false;
+    }
+
+    // The seed fixes the interval
+    regression_gate::BootstrapInterval again = regression_gate::bootstrap_median_ratio(base, test, 0.95, 2000, 42);
+    pass &= check("low with the same seed", again.low, interval.low, 0);
+    pass &= check("high with the same seed", again.high, interval.high, 0);
+    return pass;
+}
+
+}  // namespace
+
+int main() {
+    bool pass = test_exact();
+    pass &= test_normal_tail();
+    pass &= test_bootstrap();
+    if (not pass) {
+        std::fprintf(stderr, "Regression gate statistics do not match the known values\n");
+        return 1;
+    }
+    std::printf("Regression gate statistics match the known values\n");
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #include "tt_metal/host_api.hpp"
 #include "tt_metal/common/constants.hpp"
+#include "tt_metal/detail/tt_metal.hpp"
 #include "tt_metal/detail/util.hpp"
 #include "tt_metal/common/bfloat16.hpp"
 #include "tt_metal/common/test_tiles.hpp"
@@ -14,16 +15,24 @@
 
 #include <chrono>
 
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+
 using namespace tt::constants;
 using namespace std;
 using namespace tt;
 using namespace tt::tt_metal;
 
+namespace single_core {
 
-void matmul_single_core(
-    std::vector<bfloat16>& a,
-    std::vector<bfloat16>& b,
-    std::vector<bfloat16>& output,
+struct SingleCoreMatmul {
+    Program program;
+    std::shared_ptr<tt::tt_metal::Buffer> src0_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> src1_dram_buffer;
+    std::shared_ptr<tt::tt_metal::Buffer> dst_dram_buffer;
+};
+
+SingleCoreMatmul create_matmul_single_core(
     bool bcast_batch,
     uint32_t M,
     uint32_t N,
@@ -34,8 +43,8 @@ void matmul_single_core(
      * Setup program to execute along with its buffers and kernels to use
      * Core range is just single core
      */
-    CommandQueue& cq = device->command_queue();
-    Program program{};
+    SingleCoreMatmul mm;
+    Program& program = mm.program;
     CoreRange core({0, 0}, {0, 0});
 
     /*
@@ -86,6 +95,9 @@ void matmul_single_core(
     std::shared_ptr<tt::tt_metal::Buffer> src0_dram_buffer = CreateBuffer(dram_config_A);
     std::shared_ptr<tt::tt_metal::Buffer> src1_dram_buffer = CreateBuffer(dram_config_B);
     std::shared_ptr<tt::tt_metal::Buffer> dst_dram_buffer = CreateBuffer(dram_config_C);
+    mm.src0_dram_buffer = src0_dram_buffer;
+    mm.src1_dram_buffer = src1_dram_buffer;
+    mm.dst_dram_buffer = dst_dram_buffer;
     uint32_t src0_addr = src0_dram_buffer->address();
     uint32_t src1_addr = src1_dram_buffer->address();
     uint32_t dst_addr = dst_dram_buffer->address();
@@ -167,16 +179,60 @@ void matmul_single_core(
         {src0_addr, src1_addr, Mt, Kt, Nt, Mt * Kt, Kt * Nt, B, uint32_t(bcast_batch ? 1 : 0)});
 
     tt_metal::SetRuntimeArgs(program, writer_id, core, {dst_addr, 0, Mt, Kt, Nt, Mt * Kt, Kt * Nt, B});
+    return mm;
+}
+
+matmul::MatmulPlan make_plan(Device* device, const matmul::MatmulShape& shape) {
+    auto mm = std::make_shared<SingleCoreMatmul>(
+        create_matmul_single_core(shape.bcast_batch, shape.M, shape.N, shape.K, shape.B, device));
+
+    matmul::MatmulPlan plan;
+    plan.variant = "single_core";
+    plan.shape = shape;
+    plan.device = device;
+    plan.state = mm;
+    plan.program = &mm->program;
+    plan.write_a = [mm = mm.get()](CommandQueue& cq, const std::vector<bfloat16>& a) {
+        matmul::write_bfloat16(cq, mm->src0_dram_buffer, a);
+    };
+    plan.write_b = [mm = mm.get()](CommandQueue& cq, const std::vector<bfloat16>& b) {
+        matmul::write_bfloat16(cq, mm->src1_dram_buffer, b);
+    };
+    plan.read_c = [mm = mm.get()](CommandQueue& cq, std::vector<bfloat16>& output) {
+        matmul::read_bfloat16(cq, mm->dst_dram_buffer, output);
+    };
+    return plan;
+}
 
-    /* Launch program & read in output buffer result into the host vector */
-    EnqueueWriteBuffer(cq, src0_dram_buffer, a.data(), false);
-    EnqueueWriteBuffer(cq, src1_dram_buffer, b.data(), false);
-    EnqueueProgram(cq, program, false);
-    EnqueueReadBuffer(cq, dst_dram_buffer, output.data(), true);
+bool supports_shape(Device* device, const matmul::MatmulShape& shape) {
+    return shape.M % TILE_HEIGHT == 0 and shape.N % TILE_WIDTH == 0 and shape.K % TILE_WIDTH == 0;
 }
 
+void matmul_single_core(
+    std::vector<bfloat16>& a,
+    std::vector<bfloat16>& b,
+    std::vector<bfloat16>& output,
+    bool bcast_batch,
+    uint32_t M,
+    uint32_t N,
+    uint32_t K,
+    uint32_t B,
+    Device* device) {
+    matmul::MatmulPlan plan = make_plan(device, {.M = M, .N = N, .K = K, .B = B, .bcast_batch = bcast_batch});
+    matmul::execute(plan, a, b, output);
+}
+
+matmul_bench::MatmulRunner make_bench_runner(Device* device, const matmul_bench::MatmulInputs& inputs) {
+    return matmul_bench::make_plan_runner(make_plan(device, {.M = inputs.M, .N = inputs.N, .K = inputs.K}), inputs);
+}
+
+}  // namespace single_core
+
+using namespace single_core;
+
 ///////////////////////////////////////
 
+#ifndef MATMUL_NO_MAIN
 int main(int argc, char** argv) {
     bool pass = true;
 
@@ -214,10 +270,6 @@ int main(int argc, char** argv) {
         std::vector<bfloat16> src0_vec = create_random_vector_of_bfloat16_native(dram_buffer_A_size, 1, 123);
         std::vector<bfloat16> src1_vec = create_random_vector_of_bfloat16_native(dram_buffer_B_size, 1, 12522);
 
-        /* Getting number of milliseconds as a double. */
-        duration<double, std::milli> ms_double_cpu = t2 - t1;
-        log_info(tt::LogVerif, "Time matmul cpu: {} ms", ms_double_cpu.count());
-
         /* Input vector tilizing */
         tilize(src0_vec, M, K);
         tilize(src1_vec, K, N);
@@ -225,8 +277,14 @@ int main(int argc, char** argv) {
         /* Calling the MatMul host program. Read in result into a host vector */
         std::vector<bfloat16> result_vec(dram_buffer_C_size / sizeof(bfloat16));
 
+        auto t1 = high_resolution_clock::now();
+        matmul::MatmulPlan plan = make_plan(device, {.M = M, .N = N, .K = K, .B = B});
+        auto t2 = high_resolution_clock::now();
+        duration<double, std::milli> ms_double_plan = t2 - t1;
+        log_info(tt::LogVerif, "Time plan: {} ms", ms_double_plan.count());
+
         t1 = high_resolution_clock::now();
-        matmul_single_core(src0_vec, src1_vec, result_vec, false, M, N, K, B, device);
+        matmul::execute(plan, src0_vec, src1_vec, result_vec);
         t2 = high_resolution_clock::now();
 
         /* Getting number of milliseconds as a double. */
@@ -254,3 +312,4 @@ int main(int argc, char** argv) {
 
     return 0;
 }
+#endif  // MATMUL_NO_MAIN
@@ -6,27 +6,105 @@
 
 #include "compute_kernel_api/tile_move_copy.h"
 #include "compute_kernel_api/matmul.h"
+#include "compute_kernel_api/pack_untilize.h"
+#include "compute_kernel_api/tilize.h"
 
 #ifdef FUSE_BIAS
 #include "compute_kernel_api/bcast.h"
+
+// Output blocks per core along N, each one a batch of its own: the bias CB holds the row of all of them
+#ifndef OUT_NUM_BLOCKS_W
+#define OUT_NUM_BLOCKS_W 1
+#endif
 #endif
 
 #include "compute_kernel_api/eltwise_unary/sfpu_split_includes.h"
 
 namespace NAMESPACE {
+
+#ifdef UNTILIZE_OUT
+// Untilizes one row of subblocks of the interm CB into out_block_w row-major tiles of the out CB
+template <uint32_t out_subblock_w, uint32_t out_block_w>
+inline void reblock_and_untilize(
+    uint32_t num_out_subblocks_in_col,
+    uint32_t out_subblock_num_tiles,
+    uint32_t out_subblock_h,
+    uint32_t interm_cb_id,
+    uint32_t out_cb_id) {
+    uint32_t num_tiles_in_row_of_subblocks = out_subblock_num_tiles * num_out_subblocks_in_col;
+    cb_wait_front(interm_cb_id, num_tiles_in_row_of_subblocks);
+
+    uint32_t within_block_index = 0;
+    for (uint32_t h = 0; h < out_subblock_h; h++) {
+        uint32_t block_offset = 0;
+
+        cb_reserve_back(out_cb_id, out_block_w);
+        for (uint32_t n = 0; n < num_out_subblocks_in_col; n++) {
+            tile_regs_acquire();
+            for (uint32_t w = 0; w < out_subblock_w; w++) {
+                uint32_t tile_index = block_offset + within_block_index + w;
+                copy_tile(interm_cb_id, tile_index, w);
+            }
+            tile_regs_commit();
+            tile_regs_wait();
+            pack_untilize_dst<out_subblock_w, out_block_w>(out_cb_id, 1, n);
+            tile_regs_release();
+            block_offset += out_subblock_num_tiles;
+        }
+        cb_push_back(out_cb_id, out_block_w);
+
+        within_block_index += out_subblock_w;
+    }
+    cb_pop_front(interm_cb_id, num_tiles_in_row_of_subblocks);
+}
+#endif
+
+#if defined TILIZE_IN0 or defined TILIZE_IN1
+// Tilizes a block_h x block_w tile block, pushed row-major by the reader one row of tiles at a time.
+// srcA and the packer go back to the matmul formats afterwards (in1 and the partials)
+inline void tilize_in(
+    uint32_t in_cb_id,
+    uint32_t block_w,
+    uint32_t block_h,
+    uint32_t out_cb_id,
+    uint32_t matmul_srca_cb_id,
+    uint32_t matmul_pack_cb_id) {
+    PACK((pack_reconfig_data_format(out_cb_id)));
+#ifdef PACKER_L1_ACC
+    PACK((llk_pack_reconfig_l1_acc(0)));
+#endif
+    tilize_init_short_with_dt(matmul_srca_cb_id, in_cb_id, block_w);
+    for (uint32_t h = 0; h < block_h; h++) {
+        cb_wait_front(in_cb_id, block_w);
+        cb_reserve_back(out_cb_id, block_w);
+        tilize_block(in_cb_id, block_w, out_cb_id);
+        cb_push_back(out_cb_id, block_w);
+        cb_pop_front(in_cb_id, block_w);
+    }
+    tilize_uninit_with_dt(in_cb_id, matmul_srca_cb_id);
+    PACK((pack_reconfig_data_format(matmul_pack_cb_id)));
+}
+#endif
+
 void MAIN {
-    uint32_t in0_block_w = get_compile_time_arg_val(0);              // inner block size in tiles
-    uint32_t in0_num_subblocks = get_compile_time_arg_val(1);        // outer row block size (in inner row blocks)
-    uint32_t in0_block_num_tiles = get_compile_time_arg_val(2);      // out_subblock_h*in0_block_w*in0_num_subblocks;
-    uint32_t in0_subblock_num_tiles = get_compile_time_arg_val(3);   // out_subblock_h*in0_block_w
-    uint32_t in1_num_subblocks = get_compile_time_arg_val(4);        // outer column block size (in inner column blocks)
-    uint32_t in1_block_num_tiles = get_compile_time_arg_val(5);      // out_subblock_w*in0_block_w* in1_num_subblocks;
-    uint32_t in1_per_core_w = get_compile_time_arg_val(6);           // out_subblock_w*in1_num_subblocks
-    uint32_t num_blocks = get_compile_time_arg_val(7);               // outer inner dim (in inner dim blocks)
-    uint32_t out_subblock_h = get_compile_time_arg_val(8);           // inner row block size in tiles
-    uint32_t out_subblock_w = get_compile_time_arg_val(9);           // inner column block size in tiles
-    uint32_t out_subblock_num_tiles = get_compile_time_arg_val(10);  // out_subblock_h * out_subblock_w;
-    uint32_t batch = get_compile_time_arg_val(11);                   // batch dim
+    constexpr uint32_t in0_block_w = get_compile_time_arg_val(0);        // inner block size in tiles
+    constexpr uint32_t in0_num_subblocks = get_compile_time_arg_val(1);  // outer row block size (in inner row blocks)
+    constexpr uint32_t in0_block_num_tiles =
+        get_compile_time_arg_val(2);  // out_subblock_h*in0_block_w*in0_num_subblocks;
+    constexpr uint32_t in0_subblock_num_tiles = get_compile_time_arg_val(3);  // out_subblock_h*in0_block_w
+    constexpr uint32_t in1_num_subblocks =
+        get_compile_time_arg_val(4);  // outer column block size (in inner column blocks)
+    constexpr uint32_t in1_block_num_tiles =
+        get_compile_time_arg_val(5);                                  // out_subblock_w*in0_block_w* in1_num_subblocks;
+    constexpr uint32_t in1_per_core_w = get_compile_time_arg_val(6);  // out_subblock_w*in1_num_subblocks
+    constexpr uint32_t num_blocks = get_compile_time_arg_val(7);      // outer inner dim (in inner dim blocks)
+    constexpr uint32_t out_subblock_h = get_compile_time_arg_val(8);  // inner row block size in tiles
+    constexpr uint32_t out_subblock_w = get_compile_time_arg_val(9);  // inner column block size in tiles
+    constexpr uint32_t out_subblock_num_tiles = get_compile_time_arg_val(10);  // out_subblock_h * out_subblock_w;
+    constexpr uint32_t batch = get_compile_time_arg_val(11);                   // batch dim
+
+    constexpr uint32_t out_block_num_tiles = in0_num_subblocks * in1_num_subblocks * out_subblock_num_tiles;
+    constexpr uint32_t out_block_w = out_subblock_w * in1_num_subblocks;
 
     uint32_t in0_cb_id = tt::CBIndex::c_0;
     uint32_t in1_cb_id = tt::CBIndex::c_1;
@@ -34,6 +112,15 @@ void MAIN {
     uint32_t mm_partials_cb_id = tt::CBIndex::c_24;
     uint32_t mm_bias_intermediate_cb_id = tt::CBIndex::c_25;
     uint32_t bias_cb_id = tt::CBIndex::c_3;
+    uint32_t in0_row_major_cb_id = tt::CBIndex::c_4;
+    uint32_t in1_row_major_cb_id = tt::CBIndex::c_5;
+
+#ifdef UNTILIZE_OUT
+    // The final block is packed to the interm CB and untilized into the out CB once it is complete
+    uint32_t untilize_mode_out_cb_id = mm_partials_cb_id;
+#else
+    uint32_t untilize_mode_out_cb_id = out_cb_id;
+#endif
 
 #ifdef FUSE_BIAS
     init_bcast<EltwiseBinaryType::ELWADD, BroadcastType::ROW>(mm_bias_intermediate_cb_id, bias_cb_id);
@@ -49,6 +136,22 @@ void MAIN {
         for (uint32_t block = 0; block < num_blocks; block++) {
             bool last_out = block == (num_blocks - 1);
 
+#ifdef TILIZE_IN0
+            tilize_in(
+                in0_row_major_cb_id,
+                in0_block_w,
+                in0_block_num_tiles / in0_block_w,
+                in0_cb_id,
+                in1_cb_id,
+                mm_partials_cb_id);
+#endif
+#ifdef TILIZE_IN1
+            tilize_in(in1_row_major_cb_id, in1_per_core_w, in0_block_w, in1_cb_id, in1_cb_id, mm_partials_cb_id);
+#endif
+#if defined TILIZE_IN0 or defined TILIZE_IN1
+            // reconfigure init for matmul
+            mm_init_short();
+#endif
             cb_wait_front(in0_cb_id, in0_block_num_tiles);
             cb_wait_front(in1_cb_id, in1_block_num_tiles);
             int in0_index_subblock_offset = 0;
@@ -88,7 +191,13 @@ void MAIN {
                     }
 
                     if (last_out) {
+#ifdef PACKER_L1_ACC
+                        PACK((llk_pack_reconfig_l1_acc(0)));
+#endif
 #ifdef FUSE_BIAS
+#if defined FP32_DEST_ACC_EN or defined PACKER_L1_ACC
+                        PACK((pack_reconfig_data_format(mm_bias_intermediate_cb_id)));
+#endif
                         // Move matmul result to interm buffer
                         cb_reserve_back(mm_bias_intermediate_cb_id, out_subblock_num_tiles);
                         for (uint32_t i = 0; i < out_subblock_num_tiles; i++) {
@@ -104,10 +213,10 @@ void MAIN {
                         // reconfigure unpacker df for src B
                         reconfig_data_format(mm_bias_intermediate_cb_id, bias_cb_id);
                         // reconfigure packer df for out
-                        pack_reconfig_data_format(out_cb_id);
+                        pack_reconfig_data_format(untilize_mode_out_cb_id);
                         acquire_dst();
                         for (uint32_t i = 0, j = 0; j < out_subblock_h; j++) {
-                            uint32_t bcast_tile_idx = in1_index_subblock_offset;
+                            uint32_t bcast_tile_idx = b % OUT_NUM_BLOCKS_W * in1_per_core_w + in1_index_subblock_offset;
                             for (uint32_t k = 0; k < out_subblock_w; k++, i++) {
                                 add_tiles_bcast_rows(mm_bias_intermediate_cb_id, bias_cb_id, i, bcast_tile_idx, i);
                                 bcast_tile_idx++;
@@ -128,26 +237,30 @@ void MAIN {
                         }
 #endif
 
-#if defined FP32_DEST_ACC_EN
-                        PACK((pack_reconfig_data_format(out_cb_id)));
+#if defined FP32_DEST_ACC_EN or defined PACKER_L1_ACC
+                        PACK((pack_reconfig_data_format(untilize_mode_out_cb_id)));
 #endif
                         // Pack out to output buffer
-                        cb_reserve_back(out_cb_id, out_subblock_num_tiles);
+                        cb_reserve_back(untilize_mode_out_cb_id, out_subblock_num_tiles);
                         for (uint32_t i = 0; i < out_subblock_num_tiles; i++) {
-                            pack_tile(i, out_cb_id);
+                            pack_tile(i, untilize_mode_out_cb_id);
                         }
-                        cb_push_back(out_cb_id, out_subblock_num_tiles);
+                        cb_push_back(untilize_mode_out_cb_id, out_subblock_num_tiles);
                     } else {
                         // Wait for tiles in output buffer to be written out since interm and output share memory
                         if (block == 0) {
                             cb_reserve_back(out_cb_id, out_num_tiles_to_wait);
                             out_num_tiles_to_wait += out_subblock_num_tiles;
                         }
-#if defined FP32_DEST_ACC_EN
+#if defined FP32_DEST_ACC_EN or defined PACKER_L1_ACC
                         PACK((pack_reconfig_data_format(mm_partials_cb_id)));
 #endif
                         // Move partial result to interm buffer
                         cb_reserve_back(mm_partials_cb_id, out_subblock_num_tiles);
+#ifdef PACKER_L1_ACC
+                        // First block overwrites the partials, the following ones accumulate onto them
+                        PACK((llk_pack_reconfig_l1_acc(block == 0 ? 0 : 1)));
+#endif
                         for (uint32_t i = 0; i < out_subblock_num_tiles; i++) {
                             pack_tile(i, mm_partials_cb_id);
                         }
@@ -160,13 +273,43 @@ void MAIN {
                 in0_index_subblock_offset += in0_subblock_num_tiles;
             }
 
+#ifdef PACKER_L1_ACC
+            // Partials accumulate in place: pop them so the next block packs onto the same tiles,
+            // only the last block reloads them into dst
+            if (spill and block < num_blocks - 2) {
+                cb_wait_front(mm_partials_cb_id, out_block_num_tiles);
+                cb_pop_front(mm_partials_cb_id, out_block_num_tiles);
+            }
+            if (spill and block == num_blocks - 2) {
+                enable_reload = true;
+            }
+#else
             if (spill) {
                 enable_reload = true;
             }
+#endif
 
             cb_pop_front(in0_cb_id, in0_block_num_tiles);
             cb_pop_front(in1_cb_id, in1_block_num_tiles);
         }
+
+#ifdef UNTILIZE_OUT
+        reconfig_data_format_srca(in1_cb_id, mm_partials_cb_id);
+#if defined FP32_DEST_ACC_EN or defined PACKER_L1_ACC
+        PACK((pack_reconfig_data_format(out_cb_id)));
+#endif
+        pack_untilize_dst_init_short<out_subblock_w, out_block_w>(out_cb_id);
+        copy_tile_to_dst_init_short();
+        for (uint32_t in0_subblock = 0; in0_subblock < in0_num_subblocks; in0_subblock++) {
+            reblock_and_untilize<out_subblock_w, out_block_w>(
+                in1_num_subblocks, out_subblock_num_tiles, out_subblock_h, mm_partials_cb_id, out_cb_id);
+        }
+        pack_untilize_uninit(mm_partials_cb_id);
+
+        // reconfigure init for matmul
+        mm_init_short();
+        reconfig_data_format_srca(mm_partials_cb_id, in1_cb_id);
+#endif
     }
 }
 }  // namespace NAMESPACE
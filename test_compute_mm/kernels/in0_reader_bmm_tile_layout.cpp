@@ -37,6 +37,14 @@ void kernel_main() {
     const uint32_t in0_single_tile_size_bytes = get_tile_size(cb_id_in0);
     uint32_t l1_write_addr_in0;
 
+#ifdef STREAMING
+    // in0 is an interleaved DRAM tensor, read block after block
+    const InterleavedAddrGenFast<true> s0 = {
+        .bank_base_address = in0_tensor_addr,
+        .page_size = in0_single_tile_size_bytes,
+        .data_format = get_dataformat(cb_id_in0)};
+#endif
+
     uint32_t in0_tensor_current_block_start_tile_id = in0_tensor_start_tile_id;
     for (uint32_t block = 0; block < num_blocks; block++) {
         cb_reserve_back(cb_id_in0, in0_block_num_tiles);
@@ -47,10 +55,14 @@ void kernel_main() {
             uint32_t in0_tensor_tile_id = in0_tensor_row_start_tile_id;
 
             for (uint32_t w = 0; w < in0_block_w; w++) {
-                uint32_t l1_buffer_addr = in0_tensor_addr + (in0_tensor_tile_id * in0_single_tile_size_bytes);
-                uint64_t l1_buffer_noc_addr = get_noc_addr(noc_x, noc_y, l1_buffer_addr);
                 if (h < last_block_h) {
+#ifdef STREAMING
+                    noc_async_read_tile(in0_tensor_tile_id, s0, l1_write_addr_in0);
+#else
+                    uint32_t l1_buffer_addr = in0_tensor_addr + (in0_tensor_tile_id * in0_single_tile_size_bytes);
+                    uint64_t l1_buffer_noc_addr = get_noc_addr(noc_x, noc_y, l1_buffer_addr);
                     noc_async_read(l1_buffer_noc_addr, l1_write_addr_in0, in0_single_tile_size_bytes);
+#endif
                 } else {
                     noc_async_read(l1_zeros_addr_in2_noc, l1_write_addr_in0, in0_single_tile_size_bytes);
                 }
@@ -60,8 +72,12 @@ void kernel_main() {
             in0_tensor_row_start_tile_id += in0_tensor_stride_h;
         }
 
+#ifdef STREAMING
+        in0_tensor_current_block_start_tile_id += in0_tensor_next_block_stride;
+#else
         // We commented this line to reuse the first block of in0
         // in0_tensor_current_block_start_tile_id += in0_tensor_next_block_stride;
+#endif
         noc_async_read_barrier();
 
         cb_push_back(cb_id_in0, in0_block_num_tiles);
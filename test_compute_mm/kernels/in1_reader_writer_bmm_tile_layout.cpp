@@ -6,6 +6,35 @@
 
 #include "dataflow_api.h"
 
+#if defined(COALESCE_OUT_WRITES) && defined(STREAMING)
+#error "COALESCE_OUT_WRITES needs the L1 output, consecutive DRAM tiles sit in different banks"
+#endif
+
+#ifdef COALESCE_OUT_WRITES
+FORCE_INLINE void issue_write_run(
+    uint32_t noc_x, uint32_t noc_y, uint32_t l1_read_addr, uint32_t out_addr, uint32_t num_bytes) {
+    if (num_bytes != 0) {
+        noc_async_write(l1_read_addr, get_noc_addr(noc_x, noc_y, out_addr), num_bytes);
+    }
+}
+
+// Sends the open run, then frees the pending tiles once every write reading them has left L1
+FORCE_INLINE void pop_pending_tiles(
+    uint32_t cb_id,
+    uint32_t noc_x,
+    uint32_t noc_y,
+    uint32_t run_l1_read_addr,
+    uint32_t run_out_addr,
+    uint32_t& run_num_bytes,
+    uint32_t& pending_tiles) {
+    issue_write_run(noc_x, noc_y, run_l1_read_addr, run_out_addr, run_num_bytes);
+    run_num_bytes = 0;
+    noc_async_writes_flushed();
+    cb_pop_front(cb_id, pending_tiles);
+    pending_tiles = 0;
+}
+#endif
+
 void kernel_main() {
     // in1 tensor args
     uint32_t in1_tensor_addr = get_arg_val<uint32_t>(0);
@@ -64,6 +93,18 @@ void kernel_main() {
     cb_reserve_back(cb_id_in2, 1);
     uint64_t l1_zeros_addr_in2_noc = get_noc_addr(noc_x, noc_y, in2_cb_addr);
 
+#ifdef STREAMING
+    // in1 and the output are interleaved DRAM tensors, in1 is read block after block
+    const InterleavedAddrGenFast<true> s1 = {
+        .bank_base_address = in1_tensor_addr,
+        .page_size = get_tile_size(cb_id_in1),
+        .data_format = get_dataformat(cb_id_in1)};
+    const InterleavedAddrGenFast<true> s_out = {
+        .bank_base_address = out_tensor_addr,
+        .page_size = single_tile_size_bytes,
+        .data_format = get_dataformat(cb_id_out0)};
+#endif
+
     // in1 reader
     uint32_t l1_write_addr_in1;
     uint32_t in1_tensor_current_block_start_tile_id = in1_tensor_start_tile_id;
@@ -77,7 +118,9 @@ void kernel_main() {
             uint32_t in1_identity_offset = block * in1_block_h + h;
             for (uint32_t w = 0; w < in1_block_w; w++) {
                 if (w < last_block_w) {
-#ifdef IN1_IS_IDENTITY
+#if defined(STREAMING)
+                    noc_async_read_tile(in1_tensor_tile_id, s1, l1_write_addr_in1);
+#elif defined(IN1_IS_IDENTITY)
                     if (w == in1_identity_offset) {
                         uint64_t l1_buffer_noc_addr = get_noc_addr(noc_x, noc_y, in1_tensor_addr);
                         noc_async_read(l1_buffer_noc_addr, l1_write_addr_in1, single_tile_size_bytes);
@@ -93,13 +136,100 @@ void kernel_main() {
             }
             in1_tensor_row_start_tile_id += in1_tensor_stride_h;
         }
+#ifdef STREAMING
+        in1_tensor_current_block_start_tile_id += in1_tensor_next_block_stride;
+#else
         // We commented this line to reuse the first block of in0
         // in1_tensor_current_block_start_tile_id += in1_tensor_next_block_stride;
+#endif
 
         noc_async_read_barrier();
         cb_push_back(cb_id_in1, in1_block_num_tiles);
     }
 
+#ifdef COALESCE_OUT_WRITES
+    // Coalescing writer: tiles that are contiguous both in the out CB and in the output are sent as one write.
+    // Subblocks are only popped, after a flush, once the next one would not fit in the out CB, so the writes
+    // of several subblocks stay in flight. The read pointer only moves on those pops: the host makes sure the
+    // pending tiles never wrap around the end of the CB (OUT_CB_NUM_TILES is its capacity).
+    constexpr uint32_t out_cb_num_tiles = OUT_CB_NUM_TILES;
+    uint32_t out_pending_tiles = 0;
+    uint32_t run_l1_read_addr = 0;
+    uint32_t run_out_addr = 0;
+    uint32_t run_num_bytes = 0;
+
+    uint32_t out_tensor_sbh_start_tile_id = out_tensor_start_tile_id;
+    for (uint32_t sbh = 0; sbh < out_num_nonzero_subblocks_h; sbh++) {
+        uint32_t out_tensor_sbw_start_tile_id = out_tensor_sbh_start_tile_id;
+        for (uint32_t sbw = 0; sbw < out_num_nonzero_subblocks_w; sbw++) {
+            uint32_t out_tensor_sb_row_start_tile_id = out_tensor_sbw_start_tile_id;
+
+            uint32_t out_subblock_h_ = out_subblock_h;
+            uint32_t out_subblock_w_ = out_subblock_w;
+            uint32_t subblock_tiles_addr_skip = 0;
+            if (sbh == out_num_nonzero_subblocks_h - 1) {
+                out_subblock_h_ = out_last_subblock_h;
+            }
+            if (sbw == out_num_nonzero_subblocks_w - 1) {
+                out_subblock_w_ = out_last_subblock_w;
+                subblock_tiles_addr_skip = padded_subblock_tiles_addr_skip;
+            }
+
+            if (out_pending_tiles + out_subblock_tile_count > out_cb_num_tiles) {
+                pop_pending_tiles(
+                    cb_id_out0, noc_x, noc_y, run_l1_read_addr, run_out_addr, run_num_bytes, out_pending_tiles);
+            }
+            cb_wait_front(cb_id_out0, out_pending_tiles + out_subblock_tile_count);
+            uint32_t l1_read_addr = get_read_ptr(cb_id_out0) + out_pending_tiles * single_tile_size_bytes;
+
+            for (uint32_t h = 0; h < out_subblock_h_; h++) {
+                uint32_t out_tensor_tile_id = out_tensor_sb_row_start_tile_id;
+                for (uint32_t w = 0; w < out_subblock_w_; w++) {
+                    uint32_t l1_buffer_addr = out_tensor_addr + (out_tensor_tile_id * single_tile_size_bytes);
+                    if (run_num_bytes != 0 and l1_read_addr == run_l1_read_addr + run_num_bytes and
+                        l1_buffer_addr == run_out_addr + run_num_bytes) {
+                        run_num_bytes += single_tile_size_bytes;
+                    } else {
+                        issue_write_run(noc_x, noc_y, run_l1_read_addr, run_out_addr, run_num_bytes);
+                        run_l1_read_addr = l1_read_addr;
+                        run_out_addr = l1_buffer_addr;
+                        run_num_bytes = single_tile_size_bytes;
+                    }
+
+                    l1_read_addr += single_tile_size_bytes;
+
+                    out_tensor_tile_id += out_tensor_stride_w;
+                }
+                // Skip padded tiles in subblock along row
+                l1_read_addr += subblock_tiles_addr_skip;
+                out_tensor_sb_row_start_tile_id += out_tensor_stride_h;
+            }
+
+            out_pending_tiles += out_subblock_tile_count;
+            out_tensor_sbw_start_tile_id += out_tensor_next_subblock_stride_w;
+        }
+        // Fully padded subblocks along the row are popped with the written ones
+        if (out_pending_tiles + padded_block_tiles_w_skip > out_cb_num_tiles) {
+            pop_pending_tiles(
+                cb_id_out0, noc_x, noc_y, run_l1_read_addr, run_out_addr, run_num_bytes, out_pending_tiles);
+        }
+        cb_wait_front(cb_id_out0, out_pending_tiles + padded_block_tiles_w_skip);
+        out_pending_tiles += padded_block_tiles_w_skip;
+        out_tensor_sbh_start_tile_id += out_tensor_next_subblock_stride_h;
+    }
+    // Row(s) of fully padded subblocks
+    if (out_pending_tiles + padded_block_tiles_h_skip > out_cb_num_tiles) {
+        pop_pending_tiles(
+            cb_id_out0, noc_x, noc_y, run_l1_read_addr, run_out_addr, run_num_bytes, out_pending_tiles);
+    }
+    cb_wait_front(cb_id_out0, out_pending_tiles + padded_block_tiles_h_skip);
+    out_pending_tiles += padded_block_tiles_h_skip;
+
+    // The output has to land before the kernel ends, not only leave the CB
+    issue_write_run(noc_x, noc_y, run_l1_read_addr, run_out_addr, run_num_bytes);
+    noc_async_write_barrier();
+    cb_pop_front(cb_id_out0, out_pending_tiles);
+#else
     // writer
     uint32_t out_tensor_sbh_start_tile_id = out_tensor_start_tile_id;
     for (uint32_t sbh = 0; sbh < out_num_nonzero_subblocks_h; sbh++) {
@@ -124,9 +254,13 @@ void kernel_main() {
             for (uint32_t h = 0; h < out_subblock_h_; h++) {
                 uint32_t out_tensor_tile_id = out_tensor_sb_row_start_tile_id;
                 for (uint32_t w = 0; w < out_subblock_w_; w++) {
+#ifdef STREAMING
+                    noc_async_write_tile(out_tensor_tile_id, s_out, l1_read_addr);
+#else
                     uint32_t l1_buffer_addr = out_tensor_addr + (out_tensor_tile_id * single_tile_size_bytes);
                     uint64_t l1_buffer_noc_addr = get_noc_addr(noc_x, noc_y, l1_buffer_addr);
                     noc_async_write(l1_read_addr, l1_buffer_noc_addr, single_tile_size_bytes);
+#endif
 
                     l1_read_addr += single_tile_size_bytes;
 
@@ -149,4 +283,5 @@ void kernel_main() {
     // Pop row(s) of fully padded subblocks
     cb_wait_front(cb_id_out0, padded_block_tiles_h_skip);
     cb_pop_front(cb_id_out0, padded_block_tiles_h_skip);
+#endif
 }
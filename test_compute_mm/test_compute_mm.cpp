@@ -4,8 +4,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <functional>
 #include <random>
+#include <set>
 
 #include "common/bfloat16.hpp"
 #include "common/bfloat8.hpp"
@@ -29,6 +31,10 @@
 #include "tests/tt_metal/tt_metal/common/matmul_test_utils.hpp"
 #include "tt_metal/common/work_split.hpp"
 
+#include "../common/matmul_validation.hpp"
+#include "../common/matmul_variants.hpp"
+#include "../common/trace_zones.hpp"
+
 using std::vector;
 using namespace tt;
 ////////////////////////////////////////////////////////////////////////////////
@@ -73,8 +79,14 @@ using namespace tt;
 //     --fast-dispatch (set to use fast dispatch mode)
 //     --num-tests <count of tests>
 //     --bypass-check (set to bypass checking performance criteria fulfillment)
+//     --coalesce-writes (set to merge contiguous output tiles into larger writes and defer the write barriers,
+//     then checked and timed against the per-tile writer, multi-core test only)
+//     --streaming (set to keep in0, in1 and the output in DRAM and stream every K-block, with a random in1
+//     validated against a CPU reference, multi-core test only)
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace compute_mm {
+
 ////////////////////////////////////////////////////////////////////////////
 //                      Function Forward Declaration
 ////////////////////////////////////////////////////////////////////////////
@@ -89,6 +101,7 @@ uint32_t get_in0_block_w(
     uint32_t per_core_Nt,
     uint32_t Kt,
     uint32_t single_tile_size,
+    uint32_t interm_single_tile_size,
     uint32_t l1_size,
     uint32_t l1_unreserved_base);
 
@@ -97,6 +110,8 @@ CoreCoord get_core_range(
 
 std::tuple<MathFidelity, bool> get_compute_params(tt::ARCH arch);
 
+tt::DataFormat get_interm_cb_data_format(tt::DataFormat cb_data_format, bool packer_l1);
+
 std::tuple<uint32_t, uint32_t> get_out_subblock_params(uint32_t per_core_Mt, uint32_t per_core_Nt, uint32_t choice);
 
 std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t> get_all_buffers_addresses(
@@ -104,6 +119,7 @@ std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>
     uint32_t per_core_Nt,
     uint32_t in0_block_w,
     uint32_t single_tile_size,
+    uint32_t interm_single_tile_size,
     uint32_t l1_unreserved_base);
 
 std::vector<float> generate_fp32_random(uint32_t num_elems, int32_t rand_max_val);
@@ -180,7 +196,9 @@ tt_metal::Program create_program(
     uint32_t in1_addr,
     uint32_t out_addr,
     bool matmul_block,
-    bool packer_l1_acc);
+    bool packer_l1_acc,
+    bool coalesce_out_writes,
+    bool streaming);
 
 bool validation_single_core(
     const tt::deprecated::Tensor<bfloat16>& tensor_in0,
@@ -215,18 +233,61 @@ bool validation_single_core_fp8(
     uint32_t Kt,
     const std::shared_ptr<tt::tt_metal::Buffer>& out_buffer);
 
+void prepare_streaming_inputs(
+    tt_metal::Device* device,
+    CoreCoord core_range,
+    uint32_t Mt,
+    uint32_t Nt,
+    uint32_t Kt,
+    uint32_t single_tile_size,
+    uint32_t in2_cb_addr,
+    const std::shared_ptr<tt::tt_metal::Buffer>& in0_buffer,
+    const std::shared_ptr<tt::tt_metal::Buffer>& in1_buffer,
+    std::vector<float>& in0_bfp8_unpack,
+    std::vector<float>& in1_bfp8_unpack);
+
+void write_zero_tile(tt_metal::Device* device, CoreCoord core_range, uint32_t single_tile_size, uint32_t in2_cb_addr);
+
+bool validation_streaming(
+    uint32_t Mt,
+    uint32_t Nt,
+    uint32_t Kt,
+    const std::shared_ptr<tt::tt_metal::Buffer>& out_buffer,
+    const std::vector<float>& in0_bfp8_unpack,
+    const std::vector<float>& in1_bfp8_unpack);
+
+bool compare_coalesced_writes(
+    tt_metal::Device* device,
+    tt_metal::Program& coalesced_program,
+    tt_metal::Program& per_tile_program,
+    CoreCoord core_range,
+    uint32_t Mt,
+    uint32_t Nt,
+    uint32_t per_core_Mt,
+    uint32_t per_core_Nt,
+    uint32_t out_addr,
+    uint32_t single_tile_size,
+    uint32_t num_tests,
+    bool fast_dispatch_mode);
+
 std::shared_ptr<tt::tt_metal::Buffer> create_and_transfer_data_sharded_cb(
     tt_metal::Device* device, const vector<uint32_t>& activations, uint32_t Mt, uint32_t Nt);
 
 std::shared_ptr<tt::tt_metal::Buffer> create_and_transfer_data_sharded_cb_fp8(
     tt_metal::Device* device, const vector<uint32_t>& activations, uint32_t Mt, uint32_t Nt);
 
+}  // namespace compute_mm
+
+using namespace compute_mm;
+
 ////////////////////////////////////////////////////////////////////////////
 //                      Main
 ////////////////////////////////////////////////////////////////////////////
+#ifndef MATMUL_NO_MAIN
 int main(int argc, char** argv) {
     bool pass = true;
     bool bypass_check = false;
+    std::string trace_path = timeline::enable_from_env();
     try {
         ////////////////////////////////////////////////////////////////////////////
         //                      Initial Runtime Args Parse
@@ -246,6 +307,8 @@ int main(int argc, char** argv) {
         uint32_t subblock_choice = 0;
         bool single_core = 0;
         bool fast_dispatch_mode = false;
+        bool coalesce_out_writes = false;
+        bool streaming = false;
         try {
             // std::tie(M, input_args) = test_args::get_command_option_uint32_and_remaining_args(input_args, "--m", 11264);
             std::tie(M, input_args) = test_args::get_command_option_uint32_and_remaining_args(input_args, "--m", 4072);
@@ -277,6 +340,12 @@ int main(int argc, char** argv) {
             std::tie(bypass_check, input_args) =
                 test_args::has_command_option_and_remaining_args(input_args, "--bypass-check");
 
+            std::tie(coalesce_out_writes, input_args) =
+                test_args::has_command_option_and_remaining_args(input_args, "--coalesce-writes");
+
+            std::tie(streaming, input_args) =
+                test_args::has_command_option_and_remaining_args(input_args, "--streaming");
+
             test_args::validate_remaining_args(input_args);
         } catch (const std::exception& e) {
             log_error(LogTest, "Command line arguments found exception", e.what());
@@ -284,7 +353,11 @@ int main(int argc, char** argv) {
 
         if (not single_core) {
             TT_ASSERT(dtype == 0, "multi core test only supports bfp8_b");
-            TT_ASSERT(packer_l1 == 0, "multi core test does not support packer_l1 arg");
+        }
+        if (streaming) {
+            TT_FATAL(not single_core, "--streaming is a multi core test option");
+            // Consecutive output tiles sit in different DRAM banks, there is nothing to merge
+            TT_FATAL(not coalesce_out_writes, "--coalesce-writes needs the L1 output, not --streaming");
         }
 
         ////////////////////////////////////////////////////////////////////////////
@@ -339,8 +412,16 @@ int main(int argc, char** argv) {
         uint32_t num_cores_x = grid_size.x;
         uint32_t per_core_Mt = (Mt - 1) / num_cores_y + 1;
         uint32_t per_core_Nt = (Nt - 1) / num_cores_x + 1;
-        uint32_t in0_block_w =
-            get_in0_block_w(per_core_Mt, per_core_Nt, Kt, single_tile_size, l1_size, l1_unreserved_base);
+        // With packer L1 accumulation the partials get their own CB next to the output CB
+        uint32_t interm_single_tile_size = 0;
+        if (not single_core) {
+            tt::DataFormat interm_data_format = get_interm_cb_data_format(data_format, packer_l1);
+            if (interm_data_format != data_format) {
+                interm_single_tile_size = tt_metal::detail::TileSize(interm_data_format);
+            }
+        }
+        uint32_t in0_block_w = get_in0_block_w(
+            per_core_Mt, per_core_Nt, Kt, single_tile_size, interm_single_tile_size, l1_size, l1_unreserved_base);
         if (in0_block_w == 0) {
             log_error(
                 LogTest,
@@ -446,6 +527,19 @@ int main(int argc, char** argv) {
                 auto outputs = pack_fp32_vec_as_bfp8_tiles(output_tilized, true, false);
                 output_buffer = create_and_transfer_data_sharded_cb_fp8(device, outputs, Mt, Nt);
             }
+        } else if (streaming) {
+            // Whole tensors in DRAM, interleaved tile by tile over the banks
+            auto create_dram_buffer = [&](uint32_t num_tiles) {
+                tt_metal::InterleavedBufferConfig dram_config{
+                    .device = device,
+                    .size = num_tiles * single_tile_size,
+                    .page_size = single_tile_size,
+                    .buffer_type = tt_metal::BufferType::DRAM};
+                return tt_metal::CreateBuffer(dram_config);
+            };
+            input_buffer0 = create_dram_buffer(Mt * Kt);
+            input_buffer1 = create_dram_buffer(Kt * Nt);
+            output_buffer = create_dram_buffer(Mt * Nt);
         }
 
         ////////////////////////////////////////////////////////////////////////////
@@ -458,7 +552,13 @@ int main(int argc, char** argv) {
         }
         auto [out_subblock_h, out_subblock_w] = get_out_subblock_params(per_core_Mt, per_core_Nt, subblock_choice);
         auto [in0_cb_addr, in1_cb_addr, in2_cb_addr, out_cb_addr, in0_addr, in1_addr, out_addr] =
-            get_all_buffers_addresses(per_core_Mt, per_core_Nt, in0_block_w, single_tile_size, l1_unreserved_base);
+            get_all_buffers_addresses(
+                per_core_Mt, per_core_Nt, in0_block_w, single_tile_size, interm_single_tile_size, l1_unreserved_base);
+        if (streaming) {
+            in0_addr = input_buffer0->address();
+            in1_addr = input_buffer1->address();
+            out_addr = output_buffer->address();
+        }
 
         if (fp32_dest_acc_en and (out_subblock_h * out_subblock_w > 4)) {
             if (out_subblock_w >= 4) {
@@ -525,7 +625,9 @@ int main(int argc, char** argv) {
                 in1_addr,
                 out_addr,
                 matmul_block,
-                packer_l1);
+                packer_l1,
+                coalesce_out_writes,
+                streaming);
         }
 
         ////////////////////////////////////////////////////////////////////////////
@@ -534,7 +636,22 @@ int main(int argc, char** argv) {
         // for validation
         std::vector<std::vector<float>> in0_bfp8_unpack_slice;
         std::vector<std::vector<float>> in1_bfp8_unpack_slice;
-        if (not single_core) {
+        std::vector<float> in0_bfp8_unpack;
+        std::vector<float> in1_bfp8_unpack;
+        if (streaming) {
+            prepare_streaming_inputs(
+                device,
+                core_range,
+                Mt,
+                Nt,
+                Kt,
+                single_tile_size,
+                in2_cb_addr,
+                input_buffer0,
+                input_buffer1,
+                in0_bfp8_unpack,
+                in1_bfp8_unpack);
+        } else if (not single_core) {
             prepare_inputs(
                 device,
                 core_range,
@@ -556,7 +673,10 @@ int main(int argc, char** argv) {
         ////////////////////////////////////////////////////////////////////////////
         //                      Kernel Execution and Perf Profiling
         ////////////////////////////////////////////////////////////////////////////
-        tt_metal::detail::CompileProgram(device, program);
+        {
+            TRACE_ZONE("compile");
+            tt_metal::detail::CompileProgram(device, program);
+        }
 
         constexpr int giga_byte = 1000000;
         constexpr long long tera_byte = 1000000000000LL;
@@ -592,10 +712,19 @@ int main(int argc, char** argv) {
                 log_debug(LogTest, "calling EnqueueProgram");
                 std::chrono::duration<double, std::nano> duration;
                 auto t_begin = std::chrono::high_resolution_clock::now();
-                EnqueueProgram(device->command_queue(), program, false);
-                Finish(device->command_queue());
+                {
+                    TRACE_ZONE("enqueue");
+                    EnqueueProgram(device->command_queue(), program, false);
+                }
+                {
+                    TRACE_ZONE("finish");
+                    Finish(device->command_queue());
+                }
                 log_debug(LogTest, "EnqueProgram done");
-                tt_metal::DumpDeviceProfileResults(device, program);
+                {
+                    TRACE_ZONE("profiler dump");
+                    tt_metal::DumpDeviceProfileResults(device, program);
+                }
 
                 if (single_core) {
                     uint64_t t0_to_any_riscfw_end = get_t0_to_any_riscfw_end_cycle(device, program);
@@ -615,8 +744,14 @@ int main(int argc, char** argv) {
                     log_debug(LogTest, "calling EnqueueProgram");
                     std::chrono::duration<double, std::nano> duration;
                     auto t_begin = std::chrono::high_resolution_clock::now();
-                    EnqueueProgram(device->command_queue(), program, false);
-                    Finish(device->command_queue());
+                    {
+                        TRACE_ZONE("enqueue");
+                        EnqueueProgram(device->command_queue(), program, false);
+                    }
+                    {
+                        TRACE_ZONE("finish");
+                        Finish(device->command_queue());
+                    }
                     log_debug(LogTest, "EnqueProgram done");
                     auto t_end = std::chrono::high_resolution_clock::now();
                     duration = t_end - t_begin;
@@ -643,29 +778,76 @@ int main(int argc, char** argv) {
         //                      Validation & Teardown
         ////////////////////////////////////////////////////////////////////////////
         bool validation_result = true;
-        if (single_core) {
-            if (dtype == 1) {
-                validation_result =
-                    validation_single_core(tensor_in0_fp16, tensor_in1_fp16, num_blocks, Mt, Nt, Kt, output_buffer);
+        {
+            TRACE_ZONE("validate");
+            if (single_core) {
+                if (dtype == 1) {
+                    validation_result =
+                        validation_single_core(tensor_in0_fp16, tensor_in1_fp16, num_blocks, Mt, Nt, Kt, output_buffer);
+                } else {
+                    validation_result = validation_single_core_fp8(
+                        tensor_in0_fp8, tensor_in1_fp8, num_blocks, Mt, Nt, Kt, output_buffer);
+                }
+            } else if (streaming) {
+                validation_result = validation_streaming(Mt, Nt, Kt, output_buffer, in0_bfp8_unpack, in1_bfp8_unpack);
             } else {
-                validation_result =
-                    validation_single_core_fp8(tensor_in0_fp8, tensor_in1_fp8, num_blocks, Mt, Nt, Kt, output_buffer);
+                validation_result = validation(
+                    device,
+                    core_range,
+                    Mt,
+                    Nt,
+                    Kt,
+                    per_core_Mt,
+                    per_core_Nt,
+                    in0_block_w,
+                    out_addr,
+                    single_tile_size,
+                    fp32_dest_acc_en,
+                    in0_bfp8_unpack_slice,
+                    in1_bfp8_unpack_slice);
+            }
+            if (coalesce_out_writes) {
+                // The per-tile writer on the same inputs, for its output and its time
+                auto per_tile_program = create_program(
+                    device,
+                    data_format,
+                    math_fidelity,
+                    fp32_dest_acc_en,
+                    single_tile_size,
+                    core_range,
+                    Mt,
+                    Nt,
+                    Kt,
+                    in0_block_w,
+                    out_subblock_h,
+                    out_subblock_w,
+                    per_core_Mt,
+                    per_core_Nt,
+                    in0_cb_addr,
+                    in1_cb_addr,
+                    in2_cb_addr,
+                    out_cb_addr,
+                    in0_addr,
+                    in1_addr,
+                    out_addr,
+                    matmul_block,
+                    packer_l1,
+                    /*coalesce_out_writes=*/false,
+                    /*streaming=*/false);
+                validation_result &= compare_coalesced_writes(
+                    device,
+                    program,
+                    per_tile_program,
+                    core_range,
+                    Mt,
+                    Nt,
+                    per_core_Mt,
+                    per_core_Nt,
+                    out_addr,
+                    single_tile_size,
+                    num_tests,
+                    fast_dispatch_mode);
             }
-        } else {
-            validation_result = validation(
-                device,
-                core_range,
-                Mt,
-                Nt,
-                Kt,
-                per_core_Mt,
-                per_core_Nt,
-                in0_block_w,
-                out_addr,
-                single_tile_size,
-                fp32_dest_acc_en,
-                in0_bfp8_unpack_slice,
-                in1_bfp8_unpack_slice);
         }
 
         if ((validation_result == false || performance_result == false) && bypass_check == false) {
@@ -676,12 +858,31 @@ int main(int argc, char** argv) {
                 rmax_per_rpeak * 100);
             pass = false;
         }
+        // A wrong output of the coalesced writer or of streaming is not a performance miss, --bypass-check does not
+        // skip it
+        if (validation_result == false and (coalesce_out_writes or streaming)) {
+            pass = false;
+        }
 
         pass &= tt_metal::CloseDevice(device);
 
+        if (not trace_path.empty() and timeline::write_host_trace(trace_path)) {
+            log_info(LogTest, "Host trace written to {}", trace_path);
+        }
+
         // for csv
         log_info("CSV_MICROBENCHMARK:title:test_compute_mm");
-        log_info("CSV_INPUT:M:{}:N:{}:K:{}:fast-dispatch:{}", M, N, K, fast_dispatch_mode);
+        log_info(
+            "CSV_INPUT:M:{}:N:{}:K:{}:fast-dispatch:{}:packer:{}:block:{}:subblock:{}x{}:streaming:{}",
+            M,
+            N,
+            K,
+            fast_dispatch_mode,
+            packer_l1,
+            matmul_block,
+            out_subblock_h,
+            out_subblock_w,
+            streaming);
         log_info("CSV_OUTPUT:RMax(TFLOPS):{:.2f}", avg_rmax_tflops);
         log_info("CSV_RESULT:pass:{}", pass);
 
@@ -701,6 +902,9 @@ int main(int argc, char** argv) {
 
     return 0;
 }
+#endif  // MATMUL_NO_MAIN
+
+namespace compute_mm {
 
 ////////////////////////////////////////////////////////////////////////////
 //                      Function Implementation
@@ -770,6 +974,7 @@ uint32_t get_in0_block_w(
     uint32_t per_core_Nt,
     uint32_t Kt,
     uint32_t single_tile_size,
+    uint32_t interm_single_tile_size,
     uint32_t l1_size,
     uint32_t l1_unreserved_base) {
     std::vector<uint32_t> in0_block_w_choices = {4, 2, 1};
@@ -785,8 +990,10 @@ uint32_t get_in0_block_w(
         uint32_t in1_cb_size = per_core_Nt * choice * num_buffer * single_tile_size;
         uint32_t in2_cb_size = single_tile_size;
         uint32_t intermediate_cb_size = per_core_Mt * per_core_Nt * single_tile_size;
+        uint32_t packer_l1_interm_cb_size = per_core_Mt * per_core_Nt * interm_single_tile_size;
 
-        uint32_t total_cb_size = in0_cb_size + in1_cb_size + in2_cb_size + intermediate_cb_size;
+        uint32_t total_cb_size =
+            in0_cb_size + in1_cb_size + in2_cb_size + intermediate_cb_size + packer_l1_interm_cb_size;
 
         // only taking first blocks from in0 and in1
         uint32_t per_core_in0_size = per_core_Mt * choice * single_tile_size;
@@ -817,7 +1024,6 @@ std::tuple<MathFidelity, bool> get_compute_params(tt::ARCH arch) {
     bool fp32_dest_acc_en = false;
     if (arch == tt::ARCH::WORMHOLE_B0 or arch == tt::ARCH::BLACKHOLE) {
         math_fidelity = MathFidelity::HiFi2;
-        // TODO: apply packer_l1_acc
         // TODO: need to consider whether to set these variablias as arguments
         fp32_dest_acc_en = false;
     } else if (arch == tt::ARCH::GRAYSKULL) {
@@ -827,6 +1033,15 @@ std::tuple<MathFidelity, bool> get_compute_params(tt::ARCH arch) {
     return {math_fidelity, fp32_dest_acc_en};
 }
 
+tt::DataFormat get_interm_cb_data_format(tt::DataFormat cb_data_format, bool packer_l1) {
+    // The packer accumulates into L1 in the partials format, bfp8 partials would lose precision on every
+    // block, so they are kept in Float16_b and no longer share the output CB
+    if (packer_l1 and cb_data_format == tt::DataFormat::Bfp8_b) {
+        return tt::DataFormat::Float16_b;
+    }
+    return cb_data_format;
+}
+
 std::tuple<uint32_t, uint32_t> get_out_subblock_params(
     uint32_t per_core_Mt, uint32_t per_core_Nt, uint32_t choice = 0) {
     constexpr std::array<std::tuple<uint32_t, uint32_t>, 20> SUBBLOCK_HW_CHOICES = {{
@@ -855,6 +1070,7 @@ std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>
     uint32_t per_core_Nt,
     uint32_t in0_block_w,
     uint32_t single_tile_size,
+    uint32_t interm_single_tile_size,
     uint32_t l1_unreserved_base) {
     uint32_t num_buffer = 2;  // double buffering
     uint32_t in0_cb_addr = l1_unreserved_base;
@@ -865,11 +1081,13 @@ std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>
     uint32_t in2_cb_size = single_tile_size;
     uint32_t out_cb_addr = in2_cb_addr + in2_cb_size;
     uint32_t out_cb_size = per_core_Mt * per_core_Nt * single_tile_size;
+    uint32_t interm_cb_addr = out_cb_addr + out_cb_size;  // only allocated with packer L1 accumulation
+    uint32_t interm_cb_size = per_core_Mt * per_core_Nt * interm_single_tile_size;
 
     uint32_t per_core_in0_tiles = per_core_Mt * in0_block_w;
     uint32_t per_core_in1_tiles = per_core_Nt * in0_block_w;
     uint32_t per_core_out_tiles = per_core_Mt * per_core_Nt;
-    uint32_t in0_addr = out_cb_addr + out_cb_size;
+    uint32_t in0_addr = interm_cb_addr + interm_cb_size;
     uint32_t in1_addr = in0_addr + (per_core_in0_tiles * single_tile_size);
     uint32_t out_addr = in1_addr + (per_core_in1_tiles * single_tile_size);
 
@@ -1039,8 +1257,7 @@ tt_metal::Program create_program_single_core(
     // Create reader and writer kernels per core
     auto mm_in0_reader_kernel_id = tt_metal::CreateKernel(
         program,
-        "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-        "in0_reader_bmm_single_core.cpp",
+        std::string(COMPUTE_MM_KERNELS_DIR) + "in0_reader_bmm_single_core.cpp",
         all_cores,
         tt_metal::DataMovementConfig{
             .processor = tt_metal::DataMovementProcessor::RISCV_1,
@@ -1049,8 +1266,7 @@ tt_metal::Program create_program_single_core(
 
     auto mm_in1_reader_writer_kernel_id = tt_metal::CreateKernel(
         program,
-        "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-        "in1_reader_writer_bmm_single_core.cpp",
+        std::string(COMPUTE_MM_KERNELS_DIR) + "in1_reader_writer_bmm_single_core.cpp",
         all_cores,
         tt_metal::DataMovementConfig{
             .processor = tt_metal::DataMovementProcessor::RISCV_0,
@@ -1069,10 +1285,8 @@ tt_metal::Program create_program_single_core(
     bool math_approx_mode = false;
     auto mm_kernel_id = tt_metal::CreateKernel(
         program,
-        matmul_block ? "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-                       "bmm_large_block_zm_fused_bias_activation_copy.cpp"
-                     : "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-                       "bmm_large_block_zm_fused_bias_activation.cpp",
+        std::string(COMPUTE_MM_KERNELS_DIR) + (matmul_block ? "bmm_large_block_zm_fused_bias_activation_copy.cpp"
+                                                            : "bmm_large_block_zm_fused_bias_activation.cpp"),
         all_cores,
         tt_metal::ComputeConfig{
             .math_fidelity = math_fidelity,
@@ -1107,7 +1321,9 @@ tt_metal::Program create_program(
     uint32_t in1_addr,
     uint32_t out_addr,
     bool matmul_block,
-    bool packer_l1) {
+    bool packer_l1,
+    bool coalesce_out_writes,
+    bool streaming) {
     tt_metal::Program program{};
 
     uint32_t num_buffer = 2;  // double buffer
@@ -1181,29 +1397,57 @@ tt_metal::Program create_program(
 
     uint32_t out_cb_index = tt::CBIndex::c_16;
     uint32_t interm0_cb_index = tt::CBIndex::c_24;
-    std::map<uint8_t, tt::DataFormat> partials_and_out_data_format_spec = {
-        {out_cb_index, cb_data_format}, {interm0_cb_index, cb_data_format}};
-    tt_metal::CircularBufferConfig cb_out_config =
-        tt_metal::CircularBufferConfig(out_CB_size, partials_and_out_data_format_spec)
-            .set_page_size(out_cb_index, single_tile_size)
-            .set_page_size(interm0_cb_index, single_tile_size);
-    auto cb_out = tt_metal::CreateCircularBuffer(program, CoreRangeSet({all_cores}), cb_out_config);
+    tt::DataFormat interm0_data_format = get_interm_cb_data_format(cb_data_format, packer_l1);
+    if (interm0_data_format != cb_data_format) {
+        // Output CB first, the partials CB right after it (see get_all_buffers_addresses)
+        tt_metal::CircularBufferConfig cb_out_config =
+            tt_metal::CircularBufferConfig(out_CB_size, {{out_cb_index, cb_data_format}})
+                .set_page_size(out_cb_index, single_tile_size);
+        auto cb_out = tt_metal::CreateCircularBuffer(program, all_cores, cb_out_config);
+
+        // Exactly one output block, the packer accumulates every K-block onto the same tiles
+        uint32_t interm0_single_tile_size = tt_metal::detail::TileSize(interm0_data_format);
+        tt_metal::CircularBufferConfig cb_interm_config =
+            tt_metal::CircularBufferConfig(
+                out_CB_tiles * interm0_single_tile_size, {{interm0_cb_index, interm0_data_format}})
+                .set_page_size(interm0_cb_index, interm0_single_tile_size);
+        auto cb_interm = tt_metal::CreateCircularBuffer(program, all_cores, cb_interm_config);
+    } else {
+        std::map<uint8_t, tt::DataFormat> partials_and_out_data_format_spec = {
+            {out_cb_index, cb_data_format}, {interm0_cb_index, cb_data_format}};
+        tt_metal::CircularBufferConfig cb_out_config =
+            tt_metal::CircularBufferConfig(out_CB_size, partials_and_out_data_format_spec)
+                .set_page_size(out_cb_index, single_tile_size)
+                .set_page_size(interm0_cb_index, single_tile_size);
+        auto cb_out = tt_metal::CreateCircularBuffer(program, CoreRangeSet({all_cores}), cb_out_config);
+    }
 
     // Create reader and writer kernels per core
+    std::map<string, string> mm_in0_reader_defines;
+    std::map<string, string> mm_in1_reader_writer_defines;
+    if (streaming) {
+        mm_in0_reader_defines["STREAMING"] = "1";
+        mm_in1_reader_writer_defines["STREAMING"] = "1";
+    } else {
+        mm_in1_reader_writer_defines["IN1_IS_IDENTITY"] = "1";
+    }
+    if (coalesce_out_writes) {
+        mm_in1_reader_writer_defines["COALESCE_OUT_WRITES"] = "1";
+        mm_in1_reader_writer_defines["OUT_CB_NUM_TILES"] = std::to_string(out_CB_tiles);
+    }
+
     auto mm_in0_reader_kernel_id = tt_metal::CreateKernel(
         program,
-        "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-        "in0_reader_bmm_tile_layout.cpp",
+        std::string(COMPUTE_MM_KERNELS_DIR) + "in0_reader_bmm_tile_layout.cpp",
         all_cores,
         tt_metal::DataMovementConfig{
-            .processor = tt_metal::DataMovementProcessor::RISCV_1, .noc = tt_metal::NOC::RISCV_0_default});
+            .processor = tt_metal::DataMovementProcessor::RISCV_1,
+            .noc = tt_metal::NOC::RISCV_0_default,
+            .defines = mm_in0_reader_defines});
 
-    std::map<string, string> mm_in1_reader_writer_defines;
-    mm_in1_reader_writer_defines["IN1_IS_IDENTITY"] = "1";
     auto mm_in1_reader_writer_kernel_id = tt_metal::CreateKernel(
         program,
-        "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-        "in1_reader_writer_bmm_tile_layout.cpp",
+        std::string(COMPUTE_MM_KERNELS_DIR) + "in1_reader_writer_bmm_tile_layout.cpp",
         all_cores,
         tt_metal::DataMovementConfig{
             .processor = tt_metal::DataMovementProcessor::RISCV_0,
@@ -1219,10 +1463,8 @@ tt_metal::Program create_program(
     bool math_approx_mode = false;
     auto mm_kernel_id = tt_metal::CreateKernel(
         program,
-        matmul_block ? "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-                       "bmm_large_block_zm_fused_bias_activation_block.cpp"
-                     : "tests/tt_metal/tt_metal/perf_microbenchmark/1_compute_mm/kernels/"
-                       "bmm_large_block_zm_fused_bias_activation.cpp",
+        std::string(COMPUTE_MM_KERNELS_DIR) + (matmul_block ? "bmm_large_block_zm_fused_bias_activation_block.cpp"
+                                                            : "bmm_large_block_zm_fused_bias_activation.cpp"),
         all_cores,
         tt_metal::ComputeConfig{
             .math_fidelity = math_fidelity,
@@ -1254,14 +1496,21 @@ tt_metal::Program create_program(
             CoreCoord core = {(std::size_t)core_idx_x, (std::size_t)core_idx_y};
             auto phy_core = device->worker_core_from_logical_core(core);
 
+            // Without streaming every core reads the first block of its own L1 copy, with it the whole DRAM tensors
+            uint32_t in0_tensor_start_tile_id = streaming ? Kt * per_core_Mt * output_idx_y : 0;
+            uint32_t in0_tensor_stride_h = streaming ? Kt : in0_block_w;
+            uint32_t in1_tensor_start_tile_id = streaming ? per_core_Nt * output_idx_x : 0;
+            uint32_t in1_tensor_next_block_stride = in0_block_w * (streaming ? Nt : per_core_Nt);
+            uint32_t out_tensor_start_tile_id =
+                streaming ? per_core_Nt * output_idx_x + per_core_Mt * Nt * output_idx_y : 0;
+
             // Write runtime args to device
             std::array<uint32_t, 12> mm_in0_reader_args = {
-                (std::uint32_t)in0_addr,     // in0_buffer->address(), // in0_tensor_addr
-                (std::uint32_t)0,            // K * per_core_Mt * output_idx_y, //
-                                             // in0_tensor_start_tile_id
-                (std::uint32_t)1,            // in0_tensor_stride_w
-                (std::uint32_t)in0_block_w,  // K, // in0_tensor_stride_h
-                (std::uint32_t)in0_block_w,  // in0_tensor_next_block_stride
+                (std::uint32_t)in0_addr,                  // in0_buffer->address(), // in0_tensor_addr
+                (std::uint32_t)in0_tensor_start_tile_id,  // in0_tensor_start_tile_id
+                (std::uint32_t)1,                         // in0_tensor_stride_w
+                (std::uint32_t)in0_tensor_stride_h,       // in0_tensor_stride_h
+                (std::uint32_t)in0_block_w,               // in0_tensor_next_block_stride
 
                 (std::uint32_t)in0_block_w,                // in0_block_w
                 (std::uint32_t)per_core_Mt,                // in0_block_h
@@ -1274,18 +1523,20 @@ tt_metal::Program create_program(
 
             uint32_t in1_tensor_stride_h = per_core_Nt;
             uint32_t out_tensor_stride_h = per_core_Nt;
-            if (core_idx_x == core_range.x - 1) {
+            if (streaming) {
+                in1_tensor_stride_h = Nt;
+                out_tensor_stride_h = Nt;
+            } else if (core_idx_x == core_range.x - 1) {
                 in1_tensor_stride_h = last_block_w;
                 out_tensor_stride_h = last_block_w;
             }
 
             std::array<uint32_t, 31> mm_in1_reader_writer_args = {
-                (std::uint32_t)in1_addr,                   // in1_buffer->address(), // in1_tensor_addr
-                (std::uint32_t)0,                          // per_core_Nt * output_idx_x,
-                                                           // //in1_tensor_start_tile_id
-                (std::uint32_t)1,                          // in1_tensor_stride_w
-                (std::uint32_t)in1_tensor_stride_h,        // in1_tensor_stride_h
-                (std::uint32_t)in0_block_w * per_core_Nt,  // in1_tensor_next_block_stride
+                (std::uint32_t)in1_addr,                      // in1_buffer->address(), // in1_tensor_addr
+                (std::uint32_t)in1_tensor_start_tile_id,      // in1_tensor_start_tile_id
+                (std::uint32_t)1,                             // in1_tensor_stride_w
+                (std::uint32_t)in1_tensor_stride_h,           // in1_tensor_stride_h
+                (std::uint32_t)in1_tensor_next_block_stride,  // in1_tensor_next_block_stride
 
                 (std::uint32_t)per_core_Nt,                // in1_block_w
                 (std::uint32_t)in0_block_w,                // in1_block_h
@@ -1298,8 +1549,7 @@ tt_metal::Program create_program(
                 (std::uint32_t)phy_core.y,
 
                 (std::uint32_t)out_addr,                              // out_buffer->address(), // out_tensor_addr
-                (std::uint32_t)0,                                     // output_idx_x * per_core_Nt + output_idx_y *
-                                                                      // per_core_Mt * N, // out_tensor_start_tile_id
+                (std::uint32_t)out_tensor_start_tile_id,              // out_tensor_start_tile_id
                 (std::uint32_t)1,                                     // out_tensor_stride_w
                 (std::uint32_t)out_tensor_stride_h,                   // out_tensor_stride_h
                 (std::uint32_t)out_subblock_w,                        // out_tensor_next_subblock_stride_w
@@ -1684,6 +1934,171 @@ bool validation(
     return pass;
 }
 
+void prepare_streaming_inputs(
+    tt_metal::Device* device,
+    CoreCoord core_range,
+    uint32_t Mt,
+    uint32_t Nt,
+    uint32_t Kt,
+    uint32_t single_tile_size,
+    uint32_t in2_cb_addr,
+    const std::shared_ptr<tt::tt_metal::Buffer>& in0_buffer,
+    const std::shared_ptr<tt::tt_metal::Buffer>& in1_buffer,
+    std::vector<float>& in0_bfp8_unpack,
+    std::vector<float>& in1_bfp8_unpack) {
+    // Zero centered, so the PCC of the output is not dominated by its mean
+    auto generate_input = [](uint32_t rows, uint32_t cols, std::vector<float>& bfp8_unpack) {
+        auto vec = generate_fp32_random(rows * cols, 2);
+        for (auto& value : vec) {
+            value -= 1.0f;
+        }
+        auto tilized = tilize(vec, rows, cols);
+        std::vector<uint32_t> packed =
+            pack_fp32_vec_as_bfp8_tiles(tilized, /*row_major_input=*/true, /*is_exp_a=*/false);
+        // The reference uses the values the device sees
+        bfp8_unpack = untilize(unpack_bfp8_tiles_into_float_vec(packed, true, false), rows, cols);
+        return packed;
+    };
+    tt_metal::detail::WriteToBuffer(in0_buffer, generate_input(Mt * 32, Kt * 32, in0_bfp8_unpack));
+    tt_metal::detail::WriteToBuffer(in1_buffer, generate_input(Kt * 32, Nt * 32, in1_bfp8_unpack));
+    write_zero_tile(device, core_range, single_tile_size, in2_cb_addr);
+}
+
+// Zero tile for the padded rows and columns of the last blocks
+void write_zero_tile(tt_metal::Device* device, CoreCoord core_range, uint32_t single_tile_size, uint32_t in2_cb_addr) {
+    std::vector<uint32_t> in2(single_tile_size / sizeof(uint32_t), 0);
+    for (int r = 0; r < core_range.y; r++) {
+        for (int c = 0; c < core_range.x; c++) {
+            CoreCoord core = {(std::size_t)c, (std::size_t)r};
+            bool pass = tt_metal::detail::WriteToDeviceL1(device, core, in2_cb_addr, in2);
+            TT_ASSERT(pass);
+        }
+    }
+}
+
+/*
+ * CPU reference of in0 * in1 on a random sample of output elements (a full 4072^3 reference is too slow
+ * on the host), compared with the DRAM output by PCC
+ */
+bool validation_streaming(
+    uint32_t Mt,
+    uint32_t Nt,
+    uint32_t Kt,
+    const std::shared_ptr<tt::tt_metal::Buffer>& out_buffer,
+    const std::vector<float>& in0_bfp8_unpack,
+    const std::vector<float>& in1_bfp8_unpack) {
+    constexpr uint32_t num_samples = matmul::VALIDATION_SAMPLES;
+    uint32_t M = Mt * 32;
+    uint32_t N = Nt * 32;
+    uint32_t K = Kt * 32;
+
+    std::vector<uint32_t> result_vec;
+    tt_metal::detail::ReadFromBuffer(out_buffer, result_vec);
+    auto result_untilized = untilize(unpack_bfp8_tiles_into_float_vec(result_vec, true, false), M, N);
+
+    double pcc = matmul::sampled_pcc(
+        [&in0_bfp8_unpack, K](uint32_t m, uint32_t k) { return in0_bfp8_unpack[size_t(m) * K + k]; },
+        [&in1_bfp8_unpack, N](uint32_t k, uint32_t n) { return in1_bfp8_unpack[size_t(k) * N + n]; },
+        [&result_untilized, N](uint32_t m, uint32_t n) { return result_untilized[size_t(m) * N + n]; },
+        M,
+        N,
+        K,
+        num_samples);
+    log_info(LogTest, "Streaming validation: PCC {:.5f} on {} sampled elements", pcc, num_samples);
+    if (pcc < matmul::VALIDATION_PCC) {
+        log_error(
+            LogTest,
+            "validation failed : PCC {:.5f} against the CPU reference, expected >= {}",
+            pcc,
+            matmul::VALIDATION_PCC);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * --coalesce-writes against the per-tile writer: both programs run num_tests times on the inputs already in L1
+ * and must leave bit-identical output tiles on every core. The average time of each writer is logged, from the
+ * device profiler in slow dispatch and the host clock in fast dispatch, like the benchmark runs.
+ */
+bool compare_coalesced_writes(
+    tt_metal::Device* device,
+    tt_metal::Program& coalesced_program,
+    tt_metal::Program& per_tile_program,
+    CoreCoord core_range,
+    uint32_t Mt,
+    uint32_t Nt,
+    uint32_t per_core_Mt,
+    uint32_t per_core_Nt,
+    uint32_t out_addr,
+    uint32_t single_tile_size,
+    uint32_t num_tests,
+    bool fast_dispatch_mode) {
+    int tt_npu_clock = get_tt_npu_clock(device);
+    uint32_t last_block_h = Mt % per_core_Mt == 0 ? per_core_Mt : Mt % per_core_Mt;
+    uint32_t last_block_w = Nt % per_core_Nt == 0 ? per_core_Nt : Nt % per_core_Nt;
+
+    // Average time of num_tests runs, in us
+    auto time_program = [&](tt_metal::Program& program) {
+        std::vector<double> times_us;
+        for (uint32_t i = 0; i < num_tests; ++i) {
+            if (fast_dispatch_mode == false) {
+                detail::LaunchProgram(device, program);
+                uint64_t t0_to_any_riscfw_end = get_t0_to_any_riscfw_end_cycle(device, program);
+                times_us.push_back(static_cast<double>(t0_to_any_riscfw_end) / tt_npu_clock);
+            } else {
+                auto t_begin = std::chrono::high_resolution_clock::now();
+                EnqueueProgram(device->command_queue(), program, false);
+                Finish(device->command_queue());
+                auto t_end = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double, std::micro> duration = t_end - t_begin;
+                times_us.push_back(duration.count());
+            }
+        }
+        return calculate_average(times_us);
+    };
+    auto read_output = [&]() {
+        std::vector<std::vector<uint32_t>> output;
+        for (int r = 0; r < core_range.y; ++r) {
+            for (int c = 0; c < core_range.x; ++c) {
+                CoreCoord core = {(size_t)c, (size_t)r};
+                uint32_t num_r = (r == core_range.y - 1) ? (last_block_h) : (per_core_Mt);
+                uint32_t num_c = (c == core_range.x - 1) ? (last_block_w) : (per_core_Nt);
+                std::vector<uint32_t> result_vec;
+                tt_metal::detail::ReadFromDeviceL1(
+                    device, core, out_addr, num_r * num_c * single_tile_size, result_vec);
+                output.push_back(std::move(result_vec));
+            }
+        }
+        return output;
+    };
+
+    // Both write the same L1 output, the coalesced one is read back before the per-tile program runs
+    double coalesced_us = time_program(coalesced_program);
+    auto coalesced_output = read_output();
+    tt_metal::detail::CompileProgram(device, per_tile_program);
+    double per_tile_us = time_program(per_tile_program);
+    auto per_tile_output = read_output();
+
+    log_info(
+        LogTest,
+        "Output writer: per-tile {:.2f}us, coalesced {:.2f}us ({:.2f}x)",
+        per_tile_us,
+        coalesced_us,
+        per_tile_us / coalesced_us);
+    for (size_t i = 0; i < coalesced_output.size(); ++i) {
+        if (coalesced_output[i] != per_tile_output[i]) {
+            log_error(
+                LogTest,
+                "validation failed : core ({}, {}) output of the coalesced writer differs from the per-tile one",
+                i % core_range.x,
+                i / core_range.x);
+            return false;
+        }
+    }
+    return true;
+}
+
 std::shared_ptr<tt::tt_metal::Buffer> create_and_transfer_data_sharded_cb(
     tt_metal::Device* device, const vector<uint32_t>& activations, uint32_t Mt, uint32_t Nt) {
     uint32_t size_bytes = Mt * tt::constants::TILE_HEIGHT * Nt * tt::constants::TILE_WIDTH * 2;
@@ -1737,3 +2152,121 @@ std::shared_ptr<tt::tt_metal::Buffer> create_and_transfer_data_sharded_cb_fp8(
 
     return input_buffer;
 }
+
+/*
+ * Multi-core --streaming configuration in fast dispatch, on the harness inputs: in0, in1 and the output are
+ * whole tensors in DRAM like in the other variants. The multi-core kernels only take Bfp8_b, so the bfloat16
+ * inputs are packed on the host (outside of the timed runs) and the output is unpacked back.
+ */
+matmul_bench::MatmulRunner make_bench_runner(tt_metal::Device* device, const matmul_bench::MatmulInputs& inputs) {
+    TT_FATAL(
+        inputs.M % constants::TILE_HEIGHT == 0 and inputs.N % constants::TILE_WIDTH == 0 and
+            inputs.K % constants::TILE_WIDTH == 0,
+        "Harness inputs are whole tiles");
+    uint32_t l1_unreserved_base = device->get_base_allocator_addr(HalMemType::L1);
+    const tt::ARCH arch = device->arch();
+    auto [Mt, Nt, Kt] = get_aligned_input_tile_num(inputs.M, inputs.N, inputs.K);
+
+    tt::DataFormat data_format = tt::DataFormat::Bfp8_b;
+    uint32_t single_tile_size = tt_metal::detail::TileSize(data_format);
+    auto grid_size = device->compute_with_storage_grid_size();
+    uint32_t per_core_Mt = (Mt - 1) / grid_size.y + 1;
+    uint32_t per_core_Nt = (Nt - 1) / grid_size.x + 1;
+    uint32_t in0_block_w = get_in0_block_w(
+        per_core_Mt, per_core_Nt, Kt, single_tile_size, 0, get_l1_size(arch), l1_unreserved_base);
+    TT_FATAL(in0_block_w != 0, "M, N, K = {}, {}, {} do not fit in L1", inputs.M, inputs.N, inputs.K);
+    uint32_t num_blocks_y = (Mt - 1) / per_core_Mt + 1;
+    uint32_t num_blocks_x = (Nt - 1) / per_core_Nt + 1;
+    CoreCoord core_range = get_core_range(num_blocks_y, num_blocks_x, grid_size.y, grid_size.x);
+
+    auto create_dram_buffer = [&](uint32_t num_tiles) {
+        tt_metal::InterleavedBufferConfig dram_config{
+            .device = device,
+            .size = num_tiles * single_tile_size,
+            .page_size = single_tile_size,
+            .buffer_type = tt_metal::BufferType::DRAM};
+        return tt_metal::CreateBuffer(dram_config);
+    };
+    auto input_buffer0 = create_dram_buffer(Mt * Kt);
+    auto input_buffer1 = create_dram_buffer(Kt * Nt);
+    auto output_buffer = create_dram_buffer(Mt * Nt);
+
+    auto [math_fidelity, fp32_dest_acc_en] = get_compute_params(arch);
+    TT_FATAL(not fp32_dest_acc_en, "The harness keeps the default subblocks, fp32 dest would need smaller ones");
+    auto [out_subblock_h, out_subblock_w] = get_out_subblock_params(per_core_Mt, per_core_Nt, 0);
+    auto [in0_cb_addr, in1_cb_addr, in2_cb_addr, out_cb_addr, in0_addr, in1_addr, out_addr] =
+        get_all_buffers_addresses(per_core_Mt, per_core_Nt, in0_block_w, single_tile_size, 0, l1_unreserved_base);
+
+    auto program = std::make_shared<tt_metal::Program>(create_program(
+        device,
+        data_format,
+        math_fidelity,
+        fp32_dest_acc_en,
+        single_tile_size,
+        core_range,
+        Mt,
+        Nt,
+        Kt,
+        in0_block_w,
+        out_subblock_h,
+        out_subblock_w,
+        per_core_Mt,
+        per_core_Nt,
+        in0_cb_addr,
+        in1_cb_addr,
+        in2_cb_addr,
+        out_cb_addr,
+        input_buffer0->address(),
+        input_buffer1->address(),
+        output_buffer->address(),
+        /*matmul_block=*/false,
+        /*packer_l1=*/false,
+        /*coalesce_out_writes=*/false,
+        /*streaming=*/true));
+    write_zero_tile(device, core_range, single_tile_size, in2_cb_addr);
+
+    // Harness tiles are in face order, like the bfp8 tiles
+    auto pack_bfp8 = [](const std::vector<bfloat16>& tiles) {
+        std::vector<float> tiles_fp32(tiles.size());
+        std::transform(tiles.begin(), tiles.end(), tiles_fp32.begin(), [](bfloat16 x) { return x.to_float(); });
+        return pack_fp32_vec_as_bfp8_tiles(tiles_fp32, /*row_major_input=*/false, /*is_exp_a=*/false);
+    };
+    auto in0_packed = std::make_shared<std::vector<uint32_t>>(pack_bfp8(inputs.a));
+    auto in1_packed = std::make_shared<std::vector<uint32_t>>(pack_bfp8(inputs.b));
+    auto output_packed = std::make_shared<std::vector<uint32_t>>(Mt * Nt * single_tile_size / sizeof(uint32_t));
+    tt_metal::CommandQueue& cq = device->command_queue();
+
+    matmul_bench::MatmulRunner runner;
+    runner.bench_case.grid_x = core_range.x;
+    runner.bench_case.grid_y = core_range.y;
+    runner.bench_case.dtype = "BFLOAT8_B";
+    runner.bench_case.math_fidelity = math_fidelity == MathFidelity::HiFi2 ? "HiFi2" : "HiFi4";
+    runner.write_in0 = [&cq, input_buffer0, in0_packed] {
+        TRACE_ZONE("upload");
+        EnqueueWriteBuffer(cq, input_buffer0, in0_packed->data(), true);
+    };
+    runner.write_in1 = [&cq, input_buffer1, in1_packed] {
+        TRACE_ZONE("upload");
+        EnqueueWriteBuffer(cq, input_buffer1, in1_packed->data(), true);
+    };
+    runner.compile = [device, program] { tt_metal::detail::CompileProgram(device, *program); };
+    runner.enqueue = [&cq, program] {
+        TRACE_ZONE("enqueue");
+        EnqueueProgram(cq, *program, false);
+    };
+    runner.run = [&cq, program, output_buffer, output_packed] {
+        {
+            TRACE_ZONE("enqueue");
+            EnqueueProgram(cq, *program, false);
+        }
+        TRACE_ZONE("readback");  // waits for the program
+        EnqueueReadBuffer(cq, output_buffer, output_packed->data(), true);
+    };
+    runner.output = [output_packed] {
+        auto tiles_fp32 = unpack_bfp8_tiles_into_float_vec(*output_packed, /*row_major_output=*/false, false);
+        return std::vector<bfloat16>(tiles_fp32.begin(), tiles_fp32.end());
+    };
+    return runner;
+}
+
+}  // namespace compute_mm
@@ -0,0 +1,434 @@
+// SPDX-FileCopyrightText: © 2023 Tenstorrent Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tt_metal/host_api.hpp"
+#include "tt_metal/common/constants.hpp"
+#include "tt_metal/impl/buffers/buffer.hpp"
+#include "tt_metal/impl/device/device.hpp"
+#include "tt_metal/impl/dispatch/command_queue.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../common/matmul_bench.hpp"
+
+using namespace tt::constants;
+using namespace tt;
+using namespace tt::tt_metal;
+using std::string;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+// Host <-> device DRAM transfer bandwidth: EnqueueWriteBuffer and
+// EnqueueReadBuffer swept over
+//   buffer size    --sizes, 2K up to the 18 - 128 MB of the matmul operands
+//   page size      --page-tiles, bfloat16 tiles per page (2 KB each); the
+//                  variants use one tile per page
+//   blocking       blocking: one transfer at a time; non-blocking:
+//                  --queue-depth transfers enqueued, then Finish
+//   host memory    pageable: malloc'd and touched once; pinned: mmap'd with
+//                  MAP_POPULATE, mlock'd and on transparent huge pages
+//   layout         interleaved over the DRAM banks, or width sharded with
+//                  the same number of pages in every bank
+// plus a host memcpy of the same size between two buffers of the same kind.
+//
+// Every transfer stages through the hugepage system memory of the command
+// queue: writes are a host memcpy into it, then the device pulls it over PCIe;
+// reads the other way around. Where the GB/s of a transfer ends up next to the
+// memcpy figure the host copy is the bound; a transfer that gets faster with
+// larger pages is bound by the per-page dispatch work; otherwise it is PCIe.
+// tt-metal cannot DMA from user memory, so "pinned" only changes the source /
+// destination side of the host copy (no page faults, fewer TLB misses).
+//
+// Usage example:
+//   ./metal-transfer-bench
+//     --sizes <comma separated, K / M suffixes, default: 2K,16K,128K,1M,4M,18M,64M,128M>
+//     --page-tiles <comma separated, default: 1,2,4,8,16,32>
+//     --host <pageable,pinned> --layouts <interleaved,sharded> --modes <blocking,non-blocking>
+//     --warmup <untimed transfers, default: 2> --repetitions <timed samples, default: 10>
+//     --queue-depth <transfers per non-blocking sample, default: 4>
+//     --csv <path> (default: transfer_bench.csv)
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr uint32_t TILE_BYTES = TILE_HW * 2;  // bfloat16
+
+enum class HostMemory { Pageable, Pinned };
+enum class Layout { Interleaved, Sharded };
+
+struct TransferConfig {
+    string direction;  // write / read / memcpy
+    Layout layout = Layout::Interleaved;
+    uint32_t page_tiles = 1;
+    HostMemory host = HostMemory::Pageable;
+    bool blocking = true;
+    uint64_t size = 0;
+};
+
+struct TransferResult {
+    TransferConfig config;
+    matmul_bench::BenchStats stats;  // us per transfer
+    double gb_per_s = 0;             // on the median
+    double best_gb_per_s = 0;        // on the min
+};
+
+const char* host_name(HostMemory host) { return host == HostMemory::Pinned ? "pinned" : "pageable"; }
+const char* layout_name(Layout layout) { return layout == Layout::Sharded ? "sharded" : "interleaved"; }
+
+vector<string> split_list(const string& list) {
+    vector<string> items;
+    std::stringstream stream(list);
+    string item;
+    while (std::getline(stream, item, ',')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+uint64_t parse_size(const string& size) {
+    uint64_t value = std::stoull(size);
+    switch (size.back()) {
+        case 'K': return value << 10;
+        case 'M': return value << 20;
+        case 'G': return value << 30;
+        default: return value;
+    }
+}
+
+/*
+ * Host buffer of either kind, filled with a pattern so no page is first touched while timed
+ */
+std::shared_ptr<uint8_t> allocate_host(uint64_t size, HostMemory host) {
+    auto fill = [size](std::shared_ptr<uint8_t> data) {
+        for (uint64_t i = 0; i < size; i++) {
+            data.get()[i] = i * 7 + 1;
+        }
+        return data;
+    };
+    if (host == HostMemory::Pageable) {
+        std::shared_ptr<uint8_t> data(static_cast<uint8_t*>(std::malloc(size)), std::free);
+        TT_FATAL(data != nullptr, "Cannot allocate {} bytes", size);
+        return fill(data);
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    TT_FATAL(mapping != MAP_FAILED, "Cannot map {} bytes", size);
+    madvise(mapping, size, MADV_HUGEPAGE);
+    if (mlock(mapping, size) != 0) {
+        static bool warned = false;
+        if (not warned) {
+            log_warning(tt::LogTest, "mlock failed (RLIMIT_MEMLOCK?), pinned buffers are only prefaulted");
+            warned = true;
+        }
+    }
+    return fill(std::shared_ptr<uint8_t>(static_cast<uint8_t*>(mapping), [size](uint8_t* p) { munmap(p, size); }));
+}
+
+/*
+ * DRAM buffer of size bytes, a whole number of pages (and of pages per bank when sharded)
+ */
+std::shared_ptr<Buffer> create_device_buffer(Device* device, uint64_t size, uint32_t page_tiles, Layout layout) {
+    uint32_t page_size = page_tiles * TILE_BYTES;
+    if (layout == Layout::Interleaved) {
+        tt_metal::InterleavedBufferConfig dram_config{
+            .device = device, .size = size, .page_size = page_size, .buffer_type = tt_metal::BufferType::DRAM};
+        return CreateBuffer(dram_config);
+    }
+
+    uint32_t num_banks = device->num_dram_channels();
+    uint32_t num_pages = size / page_size;
+    uint32_t page_width = page_tiles * TILE_WIDTH;
+    tt_metal::ShardedBufferConfig dram_config{
+        .device = device,
+        .size = size,
+        .page_size = page_size,
+        .buffer_type = tt_metal::BufferType::DRAM,
+        .buffer_layout = TensorMemoryLayout::WIDTH_SHARDED,
+        .shard_parameters = ShardSpecBuffer(
+            CoreRangeSet(CoreRange({0, 0}, {num_banks - 1, 0})),
+            {TILE_HEIGHT, num_pages / num_banks * page_width},
+            ShardOrientation::ROW_MAJOR,
+            false,
+            {TILE_HEIGHT, page_width},
+            {1, num_pages})};
+    return CreateBuffer(dram_config);
+}
+
+/*
+ * us per transfer of every sample: one blocking transfer, or queue_depth non-blocking ones and a Finish
+ */
+vector<double> time_transfers(
+    CommandQueue& cq,
+    std::shared_ptr<Buffer> buffer,
+    uint8_t* host,
+    bool write,
+    bool blocking,
+    uint32_t warmup,
+    uint32_t repetitions,
+    uint32_t queue_depth) {
+    uint32_t transfers_per_sample = blocking ? 1 : queue_depth;
+    auto sample = [&] {
+        for (uint32_t i = 0; i < transfers_per_sample; i++) {
+            if (write) {
+                EnqueueWriteBuffer(cq, buffer, host, blocking);
+            } else {
+                EnqueueReadBuffer(cq, buffer, host, blocking);
+            }
+        }
+        if (not blocking) {
+            Finish(cq);
+        }
+    };
+    for (uint32_t i = 0; i < warmup; i++) {
+        sample();
+    }
+    vector<double> samples_us;
+    samples_us.reserve(repetitions);
+    for (uint32_t i = 0; i < repetitions; i++) {
+        samples_us.push_back(matmul_bench::time_us(sample) / transfers_per_sample);
+    }
+    return samples_us;
+}
+
+TransferResult summarize(const TransferConfig& config, const vector<double>& samples_us) {
+    TransferResult result;
+    result.config = config;
+    result.stats = matmul_bench::compute_stats(samples_us);
+    result.gb_per_s = config.size / (result.stats.median * 1e3);
+    result.best_gb_per_s = config.size / (result.stats.min * 1e3);
+    return result;
+}
+
+void write_csv(std::ostream& out, const vector<TransferResult>& results) {
+    out << "direction,layout,page_tiles,page_bytes,host,blocking,size_bytes,"
+           "min_us,median_us,p99_us,max_us,stddev_us,gb_per_s,best_gb_per_s\n";
+    for (const auto& result : results) {
+        const auto& config = result.config;
+        out << config.direction << "," << (config.direction == "memcpy" ? "host" : layout_name(config.layout)) << ","
+            << config.page_tiles << "," << config.page_tiles * TILE_BYTES << "," << host_name(config.host) << ","
+            << (config.blocking ? "true" : "false") << "," << config.size << "," << result.stats.min << ","
+            << result.stats.median << "," << result.stats.p99 << "," << result.stats.max << ","
+            << result.stats.stddev << "," << result.gb_per_s << "," << result.best_gb_per_s << "\n";
+    }
+}
+
+/*
+ * Where the largest size of each direction ends up against the host memcpy, and how much the page size moves it
+ */
+void log_bounds(const vector<TransferResult>& results) {
+    uint64_t largest = 0;
+    for (const auto& result : results) {
+        largest = std::max(largest, result.config.size);
+    }
+    double memcpy_gb_per_s = 0;
+    for (const auto& result : results) {
+        if (result.config.direction == "memcpy" and result.config.size == largest) {
+            memcpy_gb_per_s = std::max(memcpy_gb_per_s, result.gb_per_s);
+        }
+    }
+    for (const string direction : {"write", "read"}) {
+        const TransferResult* best = nullptr;
+        const TransferResult* worst = nullptr;
+        for (const auto& result : results) {
+            if (result.config.direction != direction or result.config.size != largest) {
+                continue;
+            }
+            if (best == nullptr or result.gb_per_s > best->gb_per_s) {
+                best = &result;
+            }
+            if (worst == nullptr or result.gb_per_s < worst->gb_per_s) {
+                worst = &result;
+            }
+        }
+        if (best == nullptr) {
+            continue;
+        }
+        string bound = "PCIe / device";
+        if (best->gb_per_s >= 0.8 * memcpy_gb_per_s) {
+            bound = "host memcpy";
+        } else if (best->gb_per_s >= 1.5 * worst->gb_per_s) {
+            bound = "page size / dispatch";
+        }
+        log_info(
+            tt::LogTest,
+            "{} of {} MB: best {:.2f} GB/s ({}, pages of {} tiles, {}, {}), worst {:.2f} GB/s, "
+            "host memcpy {:.2f} GB/s: {} bound",
+            direction,
+            largest >> 20,
+            best->gb_per_s,
+            layout_name(best->config.layout),
+            best->config.page_tiles,
+            host_name(best->config.host),
+            best->config.blocking ? "blocking" : "non-blocking",
+            worst->gb_per_s,
+            memcpy_gb_per_s,
+            bound);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool pass = true;
+
+    if (getenv("TT_METAL_SLOW_DISPATCH_MODE") != nullptr) {
+        TT_THROW("Test not supported w/ slow dispatch, exiting");
+    }
+
+    vector<string> args(argv + 1, argv + argc);
+    auto get_option = [&args](const string& name, const string& default_value) -> string {
+        auto it = std::find(args.begin(), args.end(), name);
+        if (it != args.end() and std::next(it) != args.end()) {
+            return *std::next(it);
+        }
+        return default_value;
+    };
+
+    try {
+        vector<uint64_t> sizes;
+        for (const auto& size : split_list(get_option("--sizes", "2K,16K,128K,1M,4M,18M,64M,128M"))) {
+            sizes.push_back(parse_size(size));
+        }
+        vector<uint32_t> page_tiles_list;
+        for (const auto& page_tiles : split_list(get_option("--page-tiles", "1,2,4,8,16,32"))) {
+            page_tiles_list.push_back(std::stoul(page_tiles));
+        }
+        vector<HostMemory> hosts;
+        for (const auto& host : split_list(get_option("--host", "pageable,pinned"))) {
+            TT_FATAL(host == "pageable" or host == "pinned", "Unknown host memory {}", host);
+            hosts.push_back(host == "pinned" ? HostMemory::Pinned : HostMemory::Pageable);
+        }
+        vector<Layout> layouts;
+        for (const auto& layout : split_list(get_option("--layouts", "interleaved,sharded"))) {
+            TT_FATAL(layout == "interleaved" or layout == "sharded", "Unknown layout {}", layout);
+            layouts.push_back(layout == "sharded" ? Layout::Sharded : Layout::Interleaved);
+        }
+        vector<bool> modes;
+        for (const auto& mode : split_list(get_option("--modes", "blocking,non-blocking"))) {
+            TT_FATAL(mode == "blocking" or mode == "non-blocking", "Unknown mode {}", mode);
+            modes.push_back(mode == "blocking");
+        }
+        uint32_t warmup = std::stoul(get_option("--warmup", "2"));
+        uint32_t repetitions = std::stoul(get_option("--repetitions", "10"));
+        uint32_t queue_depth = std::stoul(get_option("--queue-depth", "4"));
+        string csv_path = get_option("--csv", "transfer_bench.csv");
+        TT_FATAL(repetitions > 0 and queue_depth > 0, "At least one timed repetition and one transfer per sample");
+
+        /* Silicon accelerator setup */
+        constexpr int device_id = 0;
+        Device* device = CreateDevice(device_id);
+        CommandQueue& cq = device->command_queue();
+        uint32_t num_banks = device->num_dram_channels();
+
+        vector<TransferResult> results;
+        for (uint64_t size : sizes) {
+            for (HostMemory host : hosts) {
+                auto src = allocate_host(size, host);
+                auto dst = allocate_host(size, host);
+
+                TransferConfig memcpy_config{.direction = "memcpy", .page_tiles = 0, .host = host, .size = size};
+                vector<double> memcpy_us;
+                for (uint32_t i = 0; i < warmup + repetitions; i++) {
+                    double us = matmul_bench::time_us([&] { std::memcpy(dst.get(), src.get(), size); });
+                    if (i >= warmup) {
+                        memcpy_us.push_back(us);
+                    }
+                }
+                results.push_back(summarize(memcpy_config, memcpy_us));
+
+                for (Layout layout : layouts) {
+                    for (uint32_t page_tiles : page_tiles_list) {
+                        // Whole pages, the same number in every bank when sharded
+                        uint64_t granule =
+                            uint64_t(page_tiles) * TILE_BYTES * (layout == Layout::Sharded ? num_banks : 1);
+                        if (size % granule != 0) {
+                            continue;
+                        }
+                        auto buffer = create_device_buffer(device, size, page_tiles, layout);
+                        for (bool write : {true, false}) {
+                            if (not write) {
+                                std::memset(dst.get(), 0, size);
+                            }
+                            for (bool blocking : modes) {
+                                TransferConfig config{
+                                    .direction = write ? "write" : "read",
+                                    .layout = layout,
+                                    .page_tiles = page_tiles,
+                                    .host = host,
+                                    .blocking = blocking,
+                                    .size = size};
+                                results.push_back(summarize(
+                                    config,
+                                    time_transfers(
+                                        cq,
+                                        buffer,
+                                        write ? src.get() : dst.get(),
+                                        write,
+                                        blocking,
+                                        warmup,
+                                        repetitions,
+                                        queue_depth)));
+                                const auto& result = results.back();
+                                log_info(
+                                    tt::LogTest,
+                                    "{} {} B, {}, {} tile pages, {}, {}: {:.2f} us, {:.2f} GB/s",
+                                    config.direction,
+                                    size,
+                                    layout_name(layout),
+                                    page_tiles,
+                                    host_name(host),
+                                    blocking ? "blocking" : "non-blocking",
+                                    result.stats.median,
+                                    result.gb_per_s);
+                            }
+                        }
+                        // The last read brought back what the last write sent
+                        if (std::memcmp(src.get(), dst.get(), size) != 0) {
+                            log_error(
+                                tt::LogTest,
+                                "{} B, {}, {} tile pages: read back differs from the write",
+                                size,
+                                layout_name(layout),
+                                page_tiles);
+                            pass = false;
+                        }
+                    }
+                }
+            }
+        }
+
+        log_bounds(results);
+        if (not csv_path.empty()) {
+            std::ofstream csv(csv_path);
+            write_csv(csv, results);
+            log_info(tt::LogTest, "Results written to {}", csv_path);
+        }
+
+        pass &= CloseDevice(device);
+
+    } catch (const std::exception& e) {
+        tt::log_error(tt::LogTest, "Test failed with exception!");
+        tt::log_error(tt::LogTest, "{}", e.what());
+
+        throw;
+    }
+
+    if (pass) {
+        tt::log_info(tt::LogTest, "Test Passed");
+    } else {
+        TT_THROW("Test Failed");
+    }
+
+    TT_ASSERT(pass);
+
+    return 0;
+}